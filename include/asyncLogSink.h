@@ -0,0 +1,105 @@
+#ifndef ASYNC_LOG_SINK_H_
+#define ASYNC_LOG_SINK_H_
+
+// ------- asyncLogSink.h ------------------------------------------------------
+//
+// Asynchronous backend for okapi::Logger.
+//
+// okapi::Logger writes each log line with fprintf() to a FILE handle while it
+// holds its internal mutex. When that FILE is /ser/sout every task that logs
+// (odometry, chassis PID, motion profile, ...) waits for the serial port.
+//
+// asyncLogSinkOpen() returns a FILE handle which does not touch the device:
+// every line written to it is copied into a small lock-free queue owned by the
+// calling task, and one low priority writer task empties all queues into the
+// real file. The cost for the logging task is a bounded copy; when a queue is
+// full the line is dropped (and counted) instead of blocking. A queue goes
+// back to the pool once its task has been deleted, so the competition tasks
+// PROS recreates on every mode change do not use up the queues.
+//
+// Use it like:
+//   okapi::Logger::setDefaultLogger(std::make_shared<okapi::Logger>(
+//       okapi::TimeUtilFactory::createDefault().getTimer(),
+//       asyncLogSinkOpen("/ser/sout"),
+//       okapi::Logger::LogLevel::info));
+//
+// The Logger closes the FILE when destroyed, which flushes the queues and
+// stops the writer task.
+//
+// Build with -DTHREADS_STD to run it on a PC (std::thread instead of PROS tasks).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#define ASYNC_LOG_MAX_TASKS 8         // tasks that can own a queue at the same time
+#define ASYNC_LOG_QUEUE_SIZE 32       // lines buffered per task (must be power of 2)
+#define ASYNC_LOG_LINE_SIZE 124       // longest line stored, longer lines are split
+#define ASYNC_LOG_WRITER_MS 10        // how often the writer task wakes up
+#define ASYNC_LOG_NAME_SIZE 32        // task name stored per queue, like PROS TASK_NAME_MAX_LEN
+
+#define ASYNC_LOG_MAX_ARGS 6          // arguments stored with a structured record
+
+/**
+ * One argument of a structured record, see robotLog.h.
+ */
+struct AsyncLogArg {
+  enum : std::uint8_t { integer, unsignedInteger, real, literal } type;
+  union {
+    long long i;
+    unsigned long long u;
+    double d;
+    const char *s;                    // must point to a string literal
+  };
+};
+
+/**
+ * A structured log record. The format string is not rendered by the logging
+ * task, the writer task replaces each "{}" in format with the next argument.
+ */
+struct AsyncLogRecord {
+  std::uint32_t timestamp;            // ms, stamped when the record is queued
+  std::uint8_t level;                 // okapi::Logger::LogLevel value
+  std::uint8_t argc;
+  const char *format;                 // must point to a string literal
+  AsyncLogArg args[ASYNC_LOG_MAX_ARGS];
+};
+
+/**
+ * One queued chunk of log output: either pre-formatted text or a structured
+ * record (length == 0).
+ */
+struct AsyncLogEntry {
+  std::uint16_t length;
+  union {
+    char text[ASYNC_LOG_LINE_SIZE];
+    AsyncLogRecord record;
+  };
+};
+
+static_assert(sizeof(AsyncLogRecord) <= ASYNC_LOG_LINE_SIZE, "AsyncLogRecord does not fit an entry");
+
+/**
+ * Opens the asynchronous log sink. Only one sink can be open at a time.
+ *
+ * @param itarget The file the writer task writes to, for example "/ser/sout".
+ * @return A line buffered FILE handle to give to okapi::Logger, or nullptr if the
+ * target could not be opened or a sink is already open.
+ */
+FILE *asyncLogSinkOpen(const char *itarget);
+
+/**
+ * Queues a structured record on the calling task's queue. Stamps the record
+ * with the current time. Never blocks.
+ *
+ * @param irecord The record, format and literal arguments must outlive the sink.
+ * @return false if the sink is not open or the queue is full.
+ */
+bool asyncLogSinkPush(AsyncLogRecord &irecord);
+
+/**
+ * @return The number of lines dropped because a task's queue was full.
+ */
+std::uint32_t asyncLogSinkDropped();
+
+#endif
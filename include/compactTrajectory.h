@@ -0,0 +1,137 @@
+#ifndef COMPACT_TRAJECTORY_H_
+#define COMPACT_TRAJECTORY_H_
+
+// ------- compactTrajectory.h -------------------------------------------------
+//
+// Smaller in-memory form of a pathfinder trajectory.
+//
+// A pathfinder Segment is eight doubles (64 bytes) and a tank path keeps two
+// of them per 10ms step, but following a path only needs the wheel position,
+// velocity and acceleration of both sides and the heading. Those seven values
+// (three for a one sided linear profile) are kept per step, either as floats
+// or as 16 bit fixed point scaled per value to the largest magnitude in the
+// path; dt is the same for every step and is kept once.
+//
+//   bytes per step    tank   linear
+//   full               128       64
+//   float32             28       12
+//   fixed16             14        6
+//
+// fixed16 resolution is (largest value in the path) / 32767, e.g. 0.06 mm/s
+// for a 2 m/s path. Does not use PROS, so it also builds on a PC.
+
+extern "C" {
+#include "okapi/pathfinder/include/pathfinder/structs.h"
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TrajectoryStorage {
+  full,                               // pathfinder Segments as okapi keeps them
+  float32,                            // seven floats per step
+  fixed16                             // seven 16 bit fixed point values per step
+};
+
+/**
+ * The values of one step of a compact trajectory.
+ */
+struct TrajectorySample {
+  double leftPosition{0};             // m
+  double leftVelocity{0};             // m/s
+  double leftAcceleration{0};         // m/s^2
+  double rightPosition{0};
+  double rightVelocity{0};
+  double rightAcceleration{0};
+  double heading{0};                  // radians, as pathfinder gives it
+};
+
+/**
+ * A stored trajectory the controllers can follow: a CompactTrajectory, or see trajectoryView.h.
+ */
+class TrajectorySource {
+  public:
+  virtual ~TrajectorySource() = default;
+
+  /**
+   * @return The number of steps.
+   */
+  virtual int size() const = 0;
+
+  /**
+   * @return The time between two steps in seconds.
+   */
+  virtual double getDt() const = 0;
+
+  /**
+   * @return Whether this is a left / right pair, false for a single trajectory.
+   */
+  virtual bool isPair() const = 0;
+
+  /**
+   * @param i The step, 0 .. size() - 1.
+   * @return The values of that step. A single trajectory only fills the left values.
+   */
+  virtual TrajectorySample get(int i) const = 0;
+
+  /**
+   * @return The heap memory used by this trajectory itself in bytes.
+   */
+  virtual std::size_t memoryUsage() const = 0;
+
+  /**
+   * Unpacks the trajectory into pathfinder Segments. x, y and jerk are not kept and are 0.
+   *
+   * @param oleft Receives size() left segments, or the single trajectory.
+   * @param oright Receives size() right segments, nullptr for a single trajectory.
+   */
+  void toSegments(Segment *oleft, Segment *oright) const;
+};
+
+class CompactTrajectory final : public TrajectorySource {
+  public:
+  CompactTrajectory() = default;
+
+  /**
+   * Packs a left / right trajectory pair, or a single trajectory if iright is nullptr.
+   *
+   * @param ileft The left wheel segments, or the only trajectory.
+   * @param iright The right wheel segments, nullptr for a single trajectory.
+   * @param ilength The number of segments per side.
+   * @param istorage float32 or fixed16, full is treated as float32.
+   */
+  CompactTrajectory(const Segment *ileft,
+                    const Segment *iright,
+                    int ilength,
+                    TrajectoryStorage istorage);
+
+  int size() const override;
+
+  double getDt() const override;
+
+  bool isPair() const override;
+
+  /**
+   * @return How the values are stored.
+   */
+  TrajectoryStorage getStorage() const;
+
+  TrajectorySample get(int i) const override;
+
+  std::size_t memoryUsage() const override;
+
+  protected:
+  static constexpr int pairWidth = 7;
+  static constexpr int singleWidth = 3;
+
+  TrajectoryStorage storage{TrajectoryStorage::float32};
+  int length{0};
+  int width{pairWidth};               // values per step
+  double dt{0};
+  double scale[pairWidth]{};          // fixed16 only: value = raw * scale
+  std::vector<float> floats;          // float32: length * width
+  std::vector<std::int16_t> fixed;    // fixed16: length * width
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef DATA_LOG_WRITER_H_
+#define DATA_LOG_WRITER_H_
+
+// ------- dataLogWriter.h -----------------------------------------------------
+//
+// Background writer of the binary robot data log (dataLoggerFormat.h).
+//
+// robotDataLogger() (dataLogger.cpp) fills in a DataLogRecord and hands it to
+// dataLogWriterPush(), which only copies it into a preallocated ring buffer.
+// A low priority writer task drains the ring buffer and writes the records to
+// the file in large blocks, so a slow SD card never stalls the logging task.
+//
+// Build with -DTHREADS_STD to run it on a PC (std::thread instead of PROS tasks).
+
+#include "dataLoggerFormat.h"
+
+#include <cstdint>
+#include <cstdio>
+
+#define DATA_LOG_RING_SIZE 1024       // records buffered in RAM (must be power of 2)
+#define DATA_LOG_BLOCK_SIZE 64        // records written to the card per fwrite
+#define DATA_LOG_DRAIN_MS 50          // how often the writer task wakes up
+#define DATA_LOG_FLUSH_MS 500         // longest a record waits in RAM for a full block
+
+/**
+ * Starts the writer task. Does nothing if it is already running.
+ *
+ * @param ifile The open log file, the header already written. Stays owned by the caller.
+ * @return false if the writer is already running.
+ */
+bool dataLogWriterStart(FILE *ifile);
+
+/**
+ * Queues a record. Never blocks. Only one task may push at a time.
+ *
+ * @param irecord The record.
+ * @return false if the writer is not running, or if the ring buffer is full; the record is
+ * then dropped and counted.
+ */
+bool dataLogWriterPush(const DataLogRecord &irecord);
+
+/**
+ * Stops the writer task once it has written and flushed every queued record. The file can be
+ * closed afterwards.
+ */
+void dataLogWriterStop();
+
+/**
+ * @return The number of records dropped since the writer was started.
+ */
+std::uint32_t dataLogWriterDropped();
+
+#endif
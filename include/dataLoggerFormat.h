@@ -0,0 +1,53 @@
+#ifndef DATA_LOGGER_FORMAT_H_
+#define DATA_LOGGER_FORMAT_H_
+
+// ------- dataLoggerFormat.h --------------------------------------------------
+//
+// On-disk layout of the binary robot data log written to the USD card by
+// robotDataLogger(). This header only depends on the C++ standard library so
+// the host side decoder (tools/dataLogDecode.cpp) can share it with the robot
+// code - keep it that way.
+//
+// File layout:  DataLogHeader  followed by any number of DataLogRecord entries.
+// All values are little endian (both the V5 and x86 hosts are).
+
+#include <cstdint>
+
+#define DATA_LOG_MAGIC 0x474c444f     // 'ODLG' little endian
+#define DATA_LOG_VERSION 1
+#define DATA_LOG_MOTOR_COUNT 4        // drive base motors recorded per entry
+
+// DataLogRecord markers main.cpp stores so steps can be found in the log
+#define MARK_START 1                  // starting position set
+#define MARK_DRIVE_FORWARD 2          // 1m straight drive finished
+#define MARK_RESET 3                  // odometer reset to 0,0,0
+#define MARK_PIVOT 4                  // 45 degree pivot to 1m, 1m finished
+#define MARK_TURN 5                   // turn to 90 degree heading finished
+#define MARK_TRACE 6                  // encoderTest tick trace sample, pose from the ticks
+
+struct DataLogHeader {
+  std::uint32_t magic;                // always DATA_LOG_MAGIC
+  std::uint16_t version;              // DATA_LOG_VERSION of the writer
+  std::uint16_t recordSize;           // sizeof(DataLogRecord) of the writer
+  std::uint32_t runId;                // RUN_VARIABLE from main.cpp
+  std::uint32_t openedAt;             // ms since system uptime when the file was opened
+  char programVersion[16];            // PROGRAM_VERSION, zero padded
+  char versionDate[16];               // VERSION_DATE, zero padded
+};
+
+struct DataLogRecord {
+  std::uint32_t timestamp;            // ms since system uptime
+  std::uint16_t marker;               // caller supplied marker, 0 == periodic sample
+  std::uint16_t flags;                // reserved, 0
+  float x;                            // odometer x in meters
+  float y;                            // odometer y in meters
+  float theta;                        // odometer heading in degrees
+  std::int32_t encoderLeft;           // tracking wheel ticks
+  std::int32_t encoderRight;
+  std::int32_t motorCurrent[DATA_LOG_MOTOR_COUNT]; // mA - LF, LB, RF, RB
+};
+
+static_assert(sizeof(DataLogHeader) == 48, "DataLogHeader layout changed");
+static_assert(sizeof(DataLogRecord) == 44, "DataLogRecord layout changed");
+
+#endif
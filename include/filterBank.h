@@ -0,0 +1,235 @@
+#ifndef FILTER_BANK_H_
+#define FILTER_BANK_H_
+
+// ------- filterBank.h --------------------------------------------------------
+//
+// Many channels of the same filter, e.g. the velocities of all drive motors or
+// both tracking wheels, updated in one call. A filter object per channel keeps
+// its state scattered over the heap and costs a virtual call per channel; a
+// bank keeps every state variable of all channels next to each other
+// (structure of arrays) and runs the filter math on FILTER_LANE_WIDTH channels
+// at a time with GCC vector extensions.
+//
+// The channels do exactly the operations of the single filters in the same
+// order, so the outputs are bit for bit those of okapi's EmaFilter /
+// DemaFilter and of RunningAverageFilter. On x86 the lanes are SSE2 registers.
+// The V5's NEON has no double precision, so on the brain GCC splits the lanes
+// into VFP double operations; the bank still saves the calls and the scattered
+// loads, and the results stay the same.
+//
+//   EmaFilterBank<4> driveVelocity(0.3);
+//   driveVelocity.filter(velocities);   // double[4] in
+//   driveVelocity.getOutput(2);         // third motor
+
+#include "runningAverageFilter.h"
+
+#include <array>
+#include <cstddef>
+
+#define FILTER_LANE_WIDTH 2           // doubles per vector
+
+typedef double FilterLane __attribute__((vector_size(FILTER_LANE_WIDTH * sizeof(double))));
+
+/**
+ * Lane storage and loading shared by the filter banks.
+ */
+template <std::size_t channels> class FilterBank {
+  static_assert(channels > 0, "A FilterBank needs at least one channel");
+
+  public:
+  /**
+   * @param ichannel The channel.
+   * @return The previous output of that channel.
+   */
+  double getOutput(const std::size_t ichannel) const {
+    return output[ichannel / FILTER_LANE_WIDTH][ichannel % FILTER_LANE_WIDTH];
+  }
+
+  /**
+   * @param ooutputs Receives the previous output of every channel.
+   */
+  void getOutputs(double *ooutputs) const {
+    for (std::size_t c = 0; c < channels; c++) {
+      ooutputs[c] = getOutput(c);
+    }
+  }
+
+  protected:
+  static constexpr std::size_t lanes = (channels + FILTER_LANE_WIDTH - 1) / FILTER_LANE_WIDTH;
+
+  std::array<FilterLane, lanes> output{};
+
+  /**
+   * Copies per channel values into lanes, the padding channels get 0. Forced
+   * inline, at -Os GCC would otherwise make it a call that costs more than the
+   * filter math of a small bank.
+   */
+  __attribute__((always_inline)) static void load(const double *ivalues, std::array<FilterLane, lanes> &olanes) {
+    for (std::size_t c = 0; c < lanes * FILTER_LANE_WIDTH; c++) {
+      olanes[c / FILTER_LANE_WIDTH][c % FILTER_LANE_WIDTH] = c < channels ? ivalues[c] : 0;
+    }
+  }
+
+  /**
+   * Sets one channel of a lane array.
+   */
+  static void set(std::array<FilterLane, lanes> &olanes, const std::size_t ichannel,
+                  const double ivalue) {
+    olanes[ichannel / FILTER_LANE_WIDTH][ichannel % FILTER_LANE_WIDTH] = ivalue;
+  }
+};
+
+/**
+ * okapi::EmaFilter on every channel.
+ */
+template <std::size_t channels> class EmaFilterBank : public FilterBank<channels> {
+  using Base = FilterBank<channels>;
+
+  public:
+  /**
+   * @param ialpha alpha gain of every channel
+   */
+  explicit EmaFilterBank(const double ialpha) {
+    for (std::size_t c = 0; c < channels; c++) {
+      setGains(c, ialpha);
+    }
+  }
+
+  /**
+   * Filters one reading per channel.
+   *
+   * @param ireadings The readings, one per channel.
+   */
+  void filter(const double *ireadings) {
+    std::array<FilterLane, Base::lanes> reading{};
+    Base::load(ireadings, reading);
+
+    for (std::size_t l = 0; l < Base::lanes; l++) {
+      this->output[l] = alpha[l] * reading[l] + oneMinusAlpha[l] * this->output[l];
+    }
+  }
+
+  /**
+   * Set filter gains.
+   *
+   * @param ichannel The channel.
+   * @param ialpha alpha gain
+   */
+  void setGains(const std::size_t ichannel, const double ialpha) {
+    Base::set(alpha, ichannel, ialpha);
+    Base::set(oneMinusAlpha, ichannel, 1.0 - ialpha);
+  }
+
+  protected:
+  std::array<FilterLane, Base::lanes> alpha{};
+  std::array<FilterLane, Base::lanes> oneMinusAlpha{};
+};
+
+/**
+ * okapi::DemaFilter on every channel.
+ */
+template <std::size_t channels> class DemaFilterBank : public FilterBank<channels> {
+  using Base = FilterBank<channels>;
+
+  public:
+  /**
+   * @param ialpha alpha gain of every channel
+   * @param ibeta beta gain of every channel
+   */
+  DemaFilterBank(const double ialpha, const double ibeta) {
+    for (std::size_t c = 0; c < channels; c++) {
+      setGains(c, ialpha, ibeta);
+    }
+  }
+
+  /**
+   * Filters one reading per channel.
+   *
+   * @param ireadings The readings, one per channel.
+   */
+  void filter(const double *ireadings) {
+    std::array<FilterLane, Base::lanes> reading{};
+    Base::load(ireadings, reading);
+
+    for (std::size_t l = 0; l < Base::lanes; l++) {
+      const FilterLane s = alpha[l] * reading[l] + oneMinusAlpha[l] * (outputS[l] + outputB[l]);
+      outputB[l] = beta[l] * (s - outputS[l]) + oneMinusBeta[l] * outputB[l];
+      outputS[l] = s;
+      this->output[l] = outputS[l] + outputB[l];
+    }
+  }
+
+  /**
+   * Set filter gains.
+   *
+   * @param ichannel The channel.
+   * @param ialpha alpha gain
+   * @param ibeta beta gain
+   */
+  void setGains(const std::size_t ichannel, const double ialpha, const double ibeta) {
+    Base::set(alpha, ichannel, ialpha);
+    Base::set(oneMinusAlpha, ichannel, 1.0 - ialpha);
+    Base::set(beta, ichannel, ibeta);
+    Base::set(oneMinusBeta, ichannel, 1.0 - ibeta);
+  }
+
+  protected:
+  std::array<FilterLane, Base::lanes> alpha{};
+  std::array<FilterLane, Base::lanes> oneMinusAlpha{};
+  std::array<FilterLane, Base::lanes> beta{};
+  std::array<FilterLane, Base::lanes> oneMinusBeta{};
+  std::array<FilterLane, Base::lanes> outputS{};
+  std::array<FilterLane, Base::lanes> outputB{};
+};
+
+/**
+ * RunningAverageFilter<n> on every channel, the same running sum and drift correction.
+ */
+template <std::size_t n, std::size_t channels>
+class AverageFilterBank : public FilterBank<channels> {
+  static_assert(n > 0, "AverageFilterBank needs at least one sample");
+  using Base = FilterBank<channels>;
+
+  public:
+  /**
+   * Filters one reading per channel.
+   *
+   * @param ireadings The readings, one per channel.
+   */
+  void filter(const double *ireadings) {
+    std::array<FilterLane, Base::lanes> reading{};
+    Base::load(ireadings, reading);
+
+    auto &oldest = data[index];
+    for (std::size_t l = 0; l < Base::lanes; l++) {
+      sum[l] += reading[l] - oldest[l];
+      oldest[l] = reading[l];
+    }
+
+    if (++index >= n) {
+      index = 0;
+      if (++wraps >= RUNNING_AVERAGE_RESUM_WRAPS) {
+        wraps = 0;
+        sum.fill(FilterLane{});
+        for (std::size_t i = 0; i < n; i++) {
+          for (std::size_t l = 0; l < Base::lanes; l++) {
+            sum[l] += data[i][l];
+          }
+        }
+      }
+    }
+
+    const FilterLane count = FilterLane{} + static_cast<double>(n);
+    for (std::size_t l = 0; l < Base::lanes; l++) {
+      this->output[l] = sum[l] / count;
+    }
+  }
+
+  protected:
+  std::array<std::array<FilterLane, Base::lanes>, n> data{}; // window slot, then channel
+  std::array<FilterLane, Base::lanes> sum{};
+  std::size_t index{0};
+  std::size_t wraps{0};
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef FILTER_PIPELINE_H_
+#define FILTER_PIPELINE_H_
+
+// ------- filterPipeline.h ----------------------------------------------------
+//
+// Compile time alternative to okapi::ComposableFilter. ComposableFilter keeps
+// its stages as a vector of shared_ptr<Filter> and makes a virtual call per
+// stage per reading; FilterPipeline keeps them by value in a tuple and calls
+// each one by its own type, so the stages are inlined into one filter()
+// (with header defined stages such as RunningMedianFilter, RunningAverageFilter
+// and the filters of inlineFilters.h). Only the pipeline itself is an
+// okapi::Filter, so it still plugs into VelMath, PID derivative filters or a
+// ComposableFilter through one virtual call.
+//
+//   auto velFilter = std::make_unique<FilterPipeline<RunningMedianFilter<5>, InlineEmaFilter,
+//                                                    InlineDemaFilter>>(
+//     RunningMedianFilter<5>(), InlineEmaFilter(0.3), InlineDemaFilter(0.2, 0.05));
+
+#include "okapi/api/filter/filter.hpp"
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+template <typename... Stages> class FilterPipeline final : public okapi::Filter {
+  static_assert(sizeof...(Stages) > 0, "FilterPipeline needs at least one stage");
+
+  public:
+  /**
+   * A pipeline which filters every reading with the stages in order.
+   *
+   * @param istages The stages, the first one gets the reading.
+   */
+  explicit FilterPipeline(Stages... istages) : stages(std::move(istages)...) {
+  }
+
+  /**
+   * Filters a value, like a sensor reading.
+   *
+   * @param ireading new measurement
+   * @return filtered result
+   */
+  double filter(const double ireading) override {
+    return filterStages(ireading, std::index_sequence_for<Stages...>{});
+  }
+
+  /**
+   * Returns the previous output from filter.
+   *
+   * @return the previous output from filter
+   */
+  double getOutput() const override {
+    return std::get<sizeof...(Stages) - 1>(stages).getOutput();
+  }
+
+  /**
+   * @return A stage, e.g. to change its gains.
+   */
+  template <std::size_t i> auto &getStage() {
+    return std::get<i>(stages);
+  }
+
+  protected:
+  std::tuple<Stages...> stages;
+
+  template <std::size_t... i>
+  double filterStages(double ireading, std::index_sequence<i...>) {
+    // a qualified call is never virtual
+    ((ireading = std::get<i>(stages).Stages::filter(ireading)), ...);
+    return ireading;
+  }
+};
+
+#endif
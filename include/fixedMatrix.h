@@ -0,0 +1,167 @@
+#ifndef FIXED_MATRIX_H_
+#define FIXED_MATRIX_H_
+
+// ------- fixedMatrix.h -------------------------------------------------------
+//
+// Small dense matrix with its dimensions in the type. The values live in a
+// std::array inside the object, so matrices are plain values on the stack: no
+// heap allocation, and a dimension mismatch is a compile error. Meant for the
+// handful of 2x2 .. 6x6 products of a Kalman filter (kalmanFilter.h), not for
+// large matrices - every product is the plain triple loop.
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+template <std::size_t rows, std::size_t cols> class FixedMatrix {
+  static_assert(rows > 0 && cols > 0, "A FixedMatrix needs at least one row and column");
+
+  public:
+  std::array<double, rows * cols> values{}; // row major
+
+  /**
+   * @return The identity matrix.
+   */
+  static FixedMatrix identity() {
+    static_assert(rows == cols, "Only a square matrix has an identity");
+    FixedMatrix out;
+    for (std::size_t i = 0; i < rows; i++) {
+      out(i, i) = 1;
+    }
+    return out;
+  }
+
+  /**
+   * @return A diagonal matrix with the given values on the diagonal.
+   */
+  static FixedMatrix diagonal(const std::array<double, rows> &idiagonal) {
+    static_assert(rows == cols, "Only a square matrix has a diagonal");
+    FixedMatrix out;
+    for (std::size_t i = 0; i < rows; i++) {
+      out(i, i) = idiagonal[i];
+    }
+    return out;
+  }
+
+  double &operator()(const std::size_t irow, const std::size_t icol) {
+    return values[irow * cols + icol];
+  }
+
+  double operator()(const std::size_t irow, const std::size_t icol) const {
+    return values[irow * cols + icol];
+  }
+
+  /**
+   * Element of a column vector.
+   */
+  double &operator[](const std::size_t irow) {
+    static_assert(cols == 1, "Only a column vector has one index");
+    return values[irow];
+  }
+
+  double operator[](const std::size_t irow) const {
+    static_assert(cols == 1, "Only a column vector has one index");
+    return values[irow];
+  }
+
+  FixedMatrix<cols, rows> transpose() const {
+    FixedMatrix<cols, rows> out;
+    for (std::size_t r = 0; r < rows; r++) {
+      for (std::size_t c = 0; c < cols; c++) {
+        out(c, r) = (*this)(r, c);
+      }
+    }
+    return out;
+  }
+
+  FixedMatrix operator+(const FixedMatrix &other) const {
+    FixedMatrix out;
+    for (std::size_t i = 0; i < rows * cols; i++) {
+      out.values[i] = values[i] + other.values[i];
+    }
+    return out;
+  }
+
+  FixedMatrix operator-(const FixedMatrix &other) const {
+    FixedMatrix out;
+    for (std::size_t i = 0; i < rows * cols; i++) {
+      out.values[i] = values[i] - other.values[i];
+    }
+    return out;
+  }
+
+  FixedMatrix operator*(const double iscale) const {
+    FixedMatrix out;
+    for (std::size_t i = 0; i < rows * cols; i++) {
+      out.values[i] = values[i] * iscale;
+    }
+    return out;
+  }
+
+  template <std::size_t otherCols>
+  FixedMatrix<rows, otherCols> operator*(const FixedMatrix<cols, otherCols> &other) const {
+    FixedMatrix<rows, otherCols> out;
+    for (std::size_t r = 0; r < rows; r++) {
+      for (std::size_t k = 0; k < cols; k++) {
+        const double a = (*this)(r, k);
+        for (std::size_t c = 0; c < otherCols; c++) {
+          out(r, c) += a * other(k, c);
+        }
+      }
+    }
+    return out;
+  }
+
+  /**
+   * Inverts a square matrix by Gauss-Jordan elimination with partial pivoting.
+   *
+   * @param oinverse Receives the inverse.
+   * @return Whether the matrix could be inverted, false if it is (numerically) singular.
+   */
+  bool invert(FixedMatrix &oinverse) const {
+    static_assert(rows == cols, "Only a square matrix has an inverse");
+    FixedMatrix a = *this;
+    oinverse = identity();
+
+    for (std::size_t c = 0; c < cols; c++) {
+      std::size_t pivot = c;
+      for (std::size_t r = c + 1; r < rows; r++) {
+        if (std::abs(a(r, c)) > std::abs(a(pivot, c))) {
+          pivot = r;
+        }
+      }
+      if (!(std::abs(a(pivot, c)) > 1e-300)) {
+        return false;
+      }
+      if (pivot != c) {
+        for (std::size_t k = 0; k < cols; k++) {
+          std::swap(a(pivot, k), a(c, k));
+          std::swap(oinverse(pivot, k), oinverse(c, k));
+        }
+      }
+
+      const double scale = 1 / a(c, c);
+      for (std::size_t k = 0; k < cols; k++) {
+        a(c, k) *= scale;
+        oinverse(c, k) *= scale;
+      }
+
+      for (std::size_t r = 0; r < rows; r++) {
+        const double factor = a(r, c);
+        if (r == c || factor == 0) {
+          continue;
+        }
+        for (std::size_t k = 0; k < cols; k++) {
+          a(r, k) -= factor * a(c, k);
+          oinverse(r, k) -= factor * oinverse(c, k);
+        }
+      }
+    }
+    return true;
+  }
+};
+
+template <std::size_t rows> using FixedVector = FixedMatrix<rows, 1>;
+
+#endif
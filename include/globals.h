@@ -23,18 +23,29 @@ extern pros::ADIEncoder encoderLeft;
 extern pros::ADIEncoder encoderRight;
 
 // ------------ Global accessible Logging functions -------------------------------
-extern void robotDataLogger();
+// Binary data logger to the USD card, see dataLogger.cpp and dataLoggerFormat.h
+extern void robotDataLogger(const okapi::OdomState &state, std::uint16_t marker = 0);
 
 //extern void terminalLogger();     // terminal logger of OKAPI events
-extern bool usdLoggerOpen();      // open a USD file logger
+extern bool usdLoggerOpen(std::uint32_t runId, const char *programVersion,
+                          const char *versionDate);   // open a USD file logger
 extern void usdLoggerClose();     // if USD file logger used close it before exiting program
 
-extern std::ofstream myUsdFile;   // File stream variable
 extern bool usdLogEnable;         // If USD based file logging is active and allowed
 
 // ----------- Global variable to control drive base mode -----------------
 #define ARCADE_MODE false     // run in tankmode - if true arcade mode
 
+// ----------- Global variable to control odometry mode ------------------
+#define ODOM_USE_IMU false    // fuse the IMU heading with the tracking wheels, calibrates
+                              // the IMU in initialize() -- false -- tracking wheels only
+#define ODOM_USE_KALMAN false // Kalman filter of tracking wheels, drive motor encoders
+                              // and IMU, takes precedence over ODOM_USE_IMU
+
+// ----------- Global variable to control path following -----------------
+#define USE_PURE_PURSUIT false  // drive the 1m, 1m move along a pure pursuit path
+                                // false -- driveToPoint turn then drive
+
 // ----------- Global variables to assist in code development ------------
 #define DEBUG true            // turn on DEBUG statements, should be off in final build
 
@@ -0,0 +1,207 @@
+#ifndef HIGH_RATE_ODOMETRY_H_
+#define HIGH_RATE_ODOMETRY_H_
+
+// ------- highRateOdometry.h --------------------------------------------------
+//
+// Two tracking wheel odometry which samples the encoders from its own task at
+// a fixed high rate (200Hz by default), independent of the rate the chassis
+// controller's odometry task calls step() at.
+//
+// Every sample is stamped when it is read and integrated with the real time
+// since the previous sample, so a late sample is neither dropped by a fixed
+// per-step tick limit nor turned into a velocity spike. That time is measured
+// in microseconds: at 200Hz a millisecond clock would be off by up to 20% of
+// the 5ms period, and every velocity estimate with it. The pose is published
+// through a SeqLock: getState() never waits for the integrator task. The last
+// ODOM_HISTORY_SIZE samples are kept in a PoseHistory so getStateAt() can tell
+// where the robot was at an earlier time.
+
+#include "odomArcMath.h"
+#include "poseHistory.h"
+#include "sensorSnapshot.h"
+#include "seqLock.h"
+
+#include "okapi/api/odometry/odometry.hpp"
+#include "okapi/api/units/QFrequency.hpp"
+#include "okapi/api/units/QTime.hpp"
+#include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/timeUtil.hpp"
+
+#include <atomic>
+#include <memory>
+
+#define ODOM_HISTORY_SIZE 512         // samples kept for getStateAt(), ~2.5s at 200Hz
+
+/**
+ * One published odometry sample.
+ */
+struct OdomSample {
+  OdomPose pose;
+  double linearVelocity{0};           // m/s, forward
+  double angularVelocity{0};          // rad/s, clockwise
+  std::uint32_t timestamp{0};         // ms, when the encoders were read
+};
+
+class HighRateOdometry : public okapi::Odometry {
+  public:
+  /**
+   * HighRateOdometry. Tracks the movement of the robot and estimates its position in coordinates
+   * relative to the start (assumed to be (0, 0, 0)). Call `startThread()` to sample at the fixed
+   * rate; until then `step()` samples once per call like TwoEncoderOdometry.
+   *
+   * @param itimeUtil The TimeUtil.
+   * @param imodel The chassis model for reading sensors, {left, right} ticks.
+   * @param ichassisScales The tracking wheel dimensions.
+   * @param isampleRate How often the sampling task reads the encoders.
+   * @param imaximumSpeed Tick rates above this (ticks per second) are treated as sensor glitches.
+   * @param ilogger The logger this instance will log to.
+   */
+  HighRateOdometry(const okapi::TimeUtil &itimeUtil,
+                   const std::shared_ptr<okapi::ReadOnlyChassisModel> &imodel,
+                   const okapi::ChassisScales &ichassisScales,
+                   const okapi::QFrequency &isampleRate = 200 * okapi::Hz,
+                   double imaximumSpeed = 100000,
+                   const std::shared_ptr<okapi::Logger> &ilogger =
+                     okapi::Logger::getDefaultLogger());
+
+  HighRateOdometry(const HighRateOdometry &) = delete;
+  HighRateOdometry &operator=(const HighRateOdometry &) = delete;
+
+  ~HighRateOdometry() override;
+
+  /**
+   * Sets the drive and turn scales.
+   */
+  void setScales(const okapi::ChassisScales &ichassisScales) override;
+
+  /**
+   * Do one odometry step. Does nothing while the sampling task is running.
+   */
+  void step() override;
+
+  /**
+   * Returns the current state. Never blocks.
+   *
+   * @param imode The mode to return the state in.
+   * @return The current state in the given format.
+   */
+  okapi::OdomState
+  getState(const okapi::StateMode &imode = okapi::StateMode::FRAME_TRANSFORMATION) const override;
+
+  /**
+   * Sets a new state to be the current state.
+   *
+   * @param istate The new state in the given format.
+   * @param imode The mode to treat the input state as.
+   */
+  void setState(const okapi::OdomState &istate,
+                const okapi::StateMode &imode = okapi::StateMode::FRAME_TRANSFORMATION) override;
+
+  /**
+   * Returns the state at an earlier time, interpolated between the two samples around it. Never
+   * blocks. Times newer than the last sample give the current state, times older than the kept
+   * history give the oldest state kept. The history is not cleared by setState(), so states from
+   * before a setState() are in the old frame.
+   *
+   * @param itime The time in the okapi timer's (pros::millis()) time base.
+   * @param imode The mode to return the state in.
+   * @return The state at the given time in the given format.
+   */
+  okapi::OdomState
+  getStateAt(const okapi::QTime &itime,
+             const okapi::StateMode &imode = okapi::StateMode::FRAME_TRANSFORMATION) const;
+
+  /**
+   * @return The latest published sample, including velocities. Never blocks.
+   */
+  OdomSample getSample() const;
+
+  /**
+   * @return The internal ChassisModel.
+   */
+  std::shared_ptr<okapi::ReadOnlyChassisModel> getModel() override;
+
+  /**
+   * @return The internal ChassisScales.
+   */
+  okapi::ChassisScales getScales() override;
+
+  /**
+   * Starts the fixed rate sampling task.
+   */
+  void startThread();
+
+  /**
+   * @return The underlying thread handle.
+   */
+  CrossplatformThread *getThread() const;
+
+  protected:
+  std::shared_ptr<okapi::Logger> logger;
+  std::unique_ptr<okapi::AbstractTimer> timer;
+  std::unique_ptr<okapi::AbstractRate> rate;
+  std::shared_ptr<okapi::ReadOnlyChassisModel> model;
+  okapi::ChassisScales chassisScales;
+  const okapi::QFrequency sampleRate;
+  const double maximumSpeed;
+
+  // set when the model can be read without allocating, see sensorSnapshot.h
+  const SensorSnapshotSource *snapshotSource{nullptr};
+
+  // only touched by the task which currently holds writerMutex
+  CrossplatformMutex writerMutex;
+  OdomPose pose;
+  SensorSnapshot ticks;
+  SensorSnapshot lastTicks;
+  std::uint32_t lastTime{0};          // ms, okapi timer time of the last sample
+  std::uint64_t lastMicros{0};        // us, readMicros() time of the last sample
+  bool haveLastSample{false};
+
+  SeqLock<OdomSample> published;
+  PoseHistory<ODOM_HISTORY_SIZE> history;
+
+  std::atomic_bool dtorCalled{false};
+  // written by startThread() while the chassis controller's task may be in step()
+  std::atomic<CrossplatformThread *> task{nullptr};
+
+  static void trampoline(void *context);
+  void loop();
+
+  /**
+   * Reads the encoders once and integrates the movement since the previous sample.
+   */
+  void sample();
+
+  /**
+   * Reads the model's sensors into ticks.
+   */
+  void readSensors();
+
+  /**
+   * @return A microsecond clock for the time between samples, the V5's high resolution timer or
+   * the okapi timer in a THREADS_STD build.
+   */
+  std::uint64_t readMicros() const;
+
+  /**
+   * Does the math for one odom step. Called with writerMutex held.
+   *
+   * @param ipose The pose at the previous sample.
+   * @param ileftDiff The left tick difference since the previous sample.
+   * @param irightDiff The right tick difference since the previous sample.
+   * @param idt The time since the previous sample in seconds.
+   * @return The newly computed pose.
+   */
+  virtual OdomPose
+  odomMathStep(const OdomPose &ipose, double ileftDiff, double irightDiff, double idt);
+
+  /**
+   * Called with writerMutex held after setState() replaced the pose, so subclasses can
+   * re-reference any absolute sensors to the new pose.
+   *
+   * @param ipose The new pose.
+   */
+  virtual void onStateSet(const OdomPose &ipose);
+};
+
+#endif
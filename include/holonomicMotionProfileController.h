@@ -0,0 +1,102 @@
+#ifndef HOLONOMIC_MOTION_PROFILE_CONTROLLER_H_
+#define HOLONOMIC_MOTION_PROFILE_CONTROLLER_H_
+
+// ------- holonomicMotionProfileController.h ----------------------------------
+//
+// MotionProfileController for X drive (XDriveModel, ThreeEncoderXDriveModel)
+// and H drive (HDriveModel) chassis. Paths are generated, stored, loaded from
+// blobs and queued exactly like for a tank chassis, but followed holonomically:
+// the robot keeps the heading it has when a path starts and strafes along the
+// path, every wheel on its own trajectory from HolonomicTrajectory. okapi
+// would follow them with the left and right side like a tank.
+//
+//   auto profile = std::make_shared<HolonomicMotionProfileController>(
+//     okapi::TimeUtilFactory::createDefault(), okapi::PathfinderLimits{1.0, 2.0, 10.0},
+//     std::static_pointer_cast<okapi::XDriveModel>(chassis->getModel()),
+//     chassis->getChassisScales(), chassis->getGearsetRatioPair());
+//   profile->startThread();
+//
+// Of the follower gains kV and kA are used, and kHeading holds the heading
+// with the odometry of setHeadingSource(). kP and kD are ignored (and a path
+// started with them logs a warning): the chassis encoders do not measure every
+// wheel, so there is no wheel position feedback. Queued paths follow each
+// other without stopping but are not blended.
+//
+// The wheel velocities are computed step by step while following and sent to
+// the motors in rpm. A step which needs a wheel faster than the model's
+// maximum velocity slows all wheels down by the same factor, so the robot
+// keeps its direction and only falls behind the profile.
+
+#include "holonomicTrajectory.h"
+#include "motionProfileController.h"
+
+#include "okapi/api/chassis/model/hDriveModel.hpp"
+#include "okapi/api/chassis/model/xDriveModel.hpp"
+
+#include <memory>
+#include <vector>
+
+class HolonomicMotionProfileController : public MotionProfileController {
+  public:
+  /**
+   * A motion profile controller for an X drive.
+   *
+   * @param itimeUtil The TimeUtil.
+   * @param ilimits The default limits.
+   * @param imodel The chassis model.
+   * @param iscales The chassis dimensions, the wheel track is the distance between the left and
+   * right wheels.
+   * @param ipair The gearset.
+   * @param ilogger The logger this instance will log to.
+   */
+  HolonomicMotionProfileController(const okapi::TimeUtil &itimeUtil,
+                                   const okapi::PathfinderLimits &ilimits,
+                                   const std::shared_ptr<okapi::XDriveModel> &imodel,
+                                   const okapi::ChassisScales &iscales,
+                                   const okapi::AbstractMotor::GearsetRatioPair &ipair,
+                                   const std::shared_ptr<okapi::Logger> &ilogger =
+                                     okapi::Logger::getDefaultLogger());
+
+  /**
+   * A motion profile controller for an H drive.
+   *
+   * @param itimeUtil The TimeUtil.
+   * @param ilimits The default limits.
+   * @param imodel The chassis model.
+   * @param iscales The chassis dimensions, the wheel track is the distance between the left and
+   * right wheels.
+   * @param ipair The gearset.
+   * @param ilogger The logger this instance will log to.
+   */
+  HolonomicMotionProfileController(const okapi::TimeUtil &itimeUtil,
+                                   const okapi::PathfinderLimits &ilimits,
+                                   const std::shared_ptr<okapi::HDriveModel> &imodel,
+                                   const okapi::ChassisScales &iscales,
+                                   const okapi::AbstractMotor::GearsetRatioPair &ipair,
+                                   const std::shared_ptr<okapi::Logger> &ilogger =
+                                     okapi::Logger::getDefaultLogger());
+
+  /**
+   * @return The chassis this controller drives.
+   */
+  HolonomicDrive getDrive() const;
+
+  protected:
+  const HolonomicDrive drive;
+  const std::vector<std::shared_ptr<okapi::AbstractMotor>> motors; // in HolonomicTrajectory order
+
+  /**
+   * Sends wheel velocities to the motors, all scaled down if one is faster than the model allows.
+   *
+   * @param ivelocities The wheel velocities in m/s, in HolonomicTrajectory order.
+   */
+  void moveWheels(const double *ivelocities);
+
+  /**
+   * Follows a path and the paths queued after it wheel by wheel.
+   */
+  void executeSinglePath(const TrajectoryPair &path,
+                         std::unique_ptr<okapi::AbstractRate> rate) override;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef HOLONOMIC_TRAJECTORY_H_
+#define HOLONOMIC_TRAJECTORY_H_
+
+// ------- holonomicTrajectory.h -----------------------------------------------
+//
+// Wheel trajectories of a holonomic chassis (X drive or H drive) driving a
+// motion profile path. A tank chassis turns to face along the path; a
+// holonomic one keeps the heading it starts with and strafes instead, so
+// every step of the path's center trajectory becomes a forward and a sideways
+// velocity in the robot's frame, and those the speeds of the wheels.
+//
+// pathfinder's swerve modifier is no help here: it only offsets the wheel
+// positions and keeps the path heading as module angle, which an X or H drive
+// cannot steer. Does not use PROS, so it also builds on a PC.
+
+#include "compactTrajectory.h"
+
+#include <vector>
+
+#define HOLONOMIC_MAX_WHEELS 4        // wheels of the largest supported chassis
+
+enum class HolonomicDrive {
+  xDrive,                             // top left, top right, bottom right, bottom left
+  hDrive                              // left, right, middle
+};
+
+class HolonomicTrajectory {
+  public:
+  /**
+   * Generates the wheel trajectories of a path.
+   *
+   * @param idrive The chassis.
+   * @param ipath The tank trajectory of the path, its center is what the robot follows.
+   * @param idt The time between two steps in s.
+   * @param itrack The distance between the left and right wheels in m.
+   * @param ibackwards Whether the robot drives the path backwards.
+   * @param imirrored Whether the path is mirrored, left becomes right.
+   */
+  HolonomicTrajectory(HolonomicDrive idrive,
+                      const std::vector<TrajectorySample> &ipath,
+                      double idt,
+                      double itrack,
+                      bool ibackwards = false,
+                      bool imirrored = false);
+
+  /**
+   * @return The number of steps.
+   */
+  int size() const;
+
+  /**
+   * @return The time between two steps in s.
+   */
+  double getDt() const;
+
+  /**
+   * @return The number of wheels, 4 for an X drive and 3 for an H drive.
+   */
+  int getWheelCount() const;
+
+  /**
+   * @return The velocity of a wheel in m/s at a step.
+   */
+  double velocity(int istep, int iwheel) const;
+
+  /**
+   * @return The acceleration of a wheel in m/s^2 at a step.
+   */
+  double acceleration(int istep, int iwheel) const;
+
+  /**
+   * @param idrive The chassis.
+   * @return The number of wheels of the chassis.
+   */
+  static int wheelCount(HolonomicDrive idrive);
+
+  /**
+   * The wheel velocities and accelerations of one step of a path, what the constructor stores
+   * for every step, for followers which go step by step.
+   *
+   * @param idrive The chassis.
+   * @param isample The step.
+   * @param ibefore The step before it, or isample itself at the start of the path.
+   * @param iafter The step after it, or isample itself at the end of the path.
+   * @param isteps The number of steps from ibefore to iafter, 0 if the path has one step.
+   * @param istartHeading The heading of the first step of the path, where the robot faces.
+   * @param idt The time between two steps in s.
+   * @param itrack The distance between the left and right wheels in m.
+   * @param ibackwards Whether the robot drives the path backwards.
+   * @param imirrored Whether the path is mirrored, left becomes right.
+   * @param ovelocities Receives wheelCount() wheel velocities in m/s.
+   * @param oaccelerations Receives wheelCount() wheel accelerations in m/s^2.
+   */
+  static void wheelStep(HolonomicDrive idrive,
+                        const TrajectorySample &isample,
+                        const TrajectorySample &ibefore,
+                        const TrajectorySample &iafter,
+                        int isteps,
+                        double istartHeading,
+                        double idt,
+                        double itrack,
+                        bool ibackwards,
+                        bool imirrored,
+                        double *ovelocities,
+                        double *oaccelerations);
+
+  /**
+   * Inverse kinematics, the wheel speeds for a chassis motion. The X drive is square with the
+   * wheels at 45 degrees, a positive wheel speed moves its side forward; the middle wheel of an H
+   * drive moves the robot right. Also works for accelerations.
+   *
+   * @param idrive The chassis.
+   * @param iforward The forward speed in m/s.
+   * @param ileft The sideways speed in m/s, positive to the left.
+   * @param iturn The turn rate in radians/s, counterclockwise.
+   * @param itrack The distance between the left and right wheels in m.
+   * @param owheels Receives wheelCount() wheel speeds in m/s.
+   */
+  static void wheelSpeeds(HolonomicDrive idrive,
+                          double iforward,
+                          double ileft,
+                          double iturn,
+                          double itrack,
+                          double *owheels);
+
+  protected:
+  HolonomicDrive drive;
+  int wheels;
+  int length;
+  double dt;
+  std::vector<float> velocities;      // length * wheels
+  std::vector<float> accelerations;   // length * wheels
+};
+
+#endif
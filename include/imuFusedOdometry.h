@@ -0,0 +1,71 @@
+#ifndef IMU_FUSED_ODOMETRY_H_
+#define IMU_FUSED_ODOMETRY_H_
+
+// ------- imuFusedOdometry.h --------------------------------------------------
+//
+// Tracking wheel odometry whose heading is fused with the V5 inertial sensor
+// through a complementary filter. Over a single sample the encoder heading
+// change is trusted (smooth, no lag); over many samples the estimate is pulled
+// towards the IMU heading, which does not drift when the tracking wheels slip
+// or their track width is slightly off.
+//
+// It samples at a fixed rate like HighRateOdometry, hand it to
+// ChassisControllerBuilder::withOdometry() the same way.
+
+#include "highRateOdometry.h"
+
+#include "okapi/api/device/rotarysensor/continuousRotarySensor.hpp"
+
+class ImuFusedOdometry : public HighRateOdometry {
+  public:
+  /**
+   * IMU fused odometry. Tracks the movement of the robot and estimates its position in coordinates
+   * relative to the start (assumed to be (0, 0, 0)). The IMU must be calibrated before the robot
+   * moves.
+   *
+   * @param itimeUtil The TimeUtil.
+   * @param imodel The chassis model for reading sensors, {left, right} ticks.
+   * @param iimu The heading sensor, degrees clockwise positive (ImuHeadingSensor or okapi::IMU
+   * on the z axis).
+   * @param ichassisScales The tracking wheel dimensions.
+   * @param iimuWeight How strongly the heading is pulled to the IMU per second, in [0, 1]. 0 uses
+   * the encoders only, 1 replaces the encoder heading with the IMU heading every sample.
+   * @param isampleRate How often the sampling task reads the sensors.
+   * @param ilogger The logger this instance will log to.
+   */
+  ImuFusedOdometry(const okapi::TimeUtil &itimeUtil,
+                   const std::shared_ptr<okapi::ReadOnlyChassisModel> &imodel,
+                   const std::shared_ptr<okapi::ContinuousRotarySensor> &iimu,
+                   const okapi::ChassisScales &ichassisScales,
+                   double iimuWeight = 0.9,
+                   const okapi::QFrequency &isampleRate = 200 * okapi::Hz,
+                   const std::shared_ptr<okapi::Logger> &ilogger =
+                     okapi::Logger::getDefaultLogger());
+
+  /**
+   * Computes the complementary filter gain for one sample.
+   *
+   * @param iimuWeight The fraction of the heading error removed per second.
+   * @param idt The sample period in seconds.
+   * @return The fraction of the heading error to remove in this sample.
+   */
+  static double sampleGain(double iimuWeight, double idt);
+
+  protected:
+  std::shared_ptr<okapi::ContinuousRotarySensor> imu;
+  const double imuWeight;
+  double imuOffset{0};                // radians added to the IMU reading to get the odom heading
+  bool haveImuOffset{false};          // offset is taken from the first good IMU reading
+
+  OdomPose
+  odomMathStep(const OdomPose &ipose, double ileftDiff, double irightDiff, double idt) override;
+
+  void onStateSet(const OdomPose &ipose) override;
+
+  /**
+   * @return The IMU heading in radians, or NAN if the IMU could not be read.
+   */
+  double readImu() const;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef IMU_HEADING_SENSOR_H_
+#define IMU_HEADING_SENSOR_H_
+
+// ------- imuHeadingSensor.h --------------------------------------------------
+//
+// The heading of an existing pros::Imu as an okapi ContinuousRotarySensor, the
+// sensor type ImuFusedOdometry and KalmanOdometry read. Unlike okapi::IMU it
+// does not address the port on its own, so the odometry reads the same device
+// object initialize() calibrated (imu_sensor in globals.h).
+
+#include "okapi/api/device/rotarysensor/continuousRotarySensor.hpp"
+#include "pros/imu.hpp"
+
+class ImuHeadingSensor : public okapi::ContinuousRotarySensor {
+  public:
+  /**
+   * @param iimu The IMU, must outlive this sensor.
+   */
+  explicit ImuHeadingSensor(pros::Imu &iimu);
+
+  /**
+   * @return The rotation about the z axis in degrees, clockwise positive, since the last reset(),
+   * or PROS_ERR_F if the IMU could not be read.
+   */
+  double get() const override;
+
+  /**
+   * Sets the current rotation as 0. Only this sensor's reading moves, the IMU is not tared.
+   *
+   * @return 1 or PROS_ERR if the IMU could not be read.
+   */
+  std::int32_t reset() override;
+
+  /**
+   * @return The same as get().
+   */
+  double controllerGet() override;
+
+  protected:
+  pros::Imu &imu;
+  double offset{0};
+};
+
+#endif
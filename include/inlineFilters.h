@@ -0,0 +1,113 @@
+#ifndef INLINE_FILTERS_H_
+#define INLINE_FILTERS_H_
+
+// ------- inlineFilters.h -----------------------------------------------------
+//
+// okapi's EmaFilter and DemaFilter with the same math, but defined in the
+// header. okapi's are compiled into okapilib, so every reading is a call into
+// the library; these can be inlined, which is what makes a FilterPipeline
+// (filterPipeline.h) one loop body. Both are still okapi::Filter and can be
+// used wherever okapi's are.
+
+#include "okapi/api/filter/filter.hpp"
+
+class InlineEmaFilter final : public okapi::Filter {
+  public:
+  /**
+   * Exponential moving average filter.
+   *
+   * @param ialpha alpha gain
+   */
+  explicit InlineEmaFilter(const double ialpha) : alpha(ialpha) {
+  }
+
+  /**
+   * Filters a value, like a sensor reading.
+   *
+   * @param ireading new measurement
+   * @return filtered result
+   */
+  double filter(const double ireading) override {
+    output = alpha * ireading + (1.0 - alpha) * lastOutput;
+    lastOutput = output;
+    return output;
+  }
+
+  /**
+   * Returns the previous output from filter.
+   *
+   * @return the previous output from filter
+   */
+  double getOutput() const override {
+    return output;
+  }
+
+  /**
+   * Set filter gains.
+   *
+   * @param ialpha alpha gain
+   */
+  void setGains(const double ialpha) {
+    alpha = ialpha;
+  }
+
+  protected:
+  double alpha;
+  double output{0};
+  double lastOutput{0};
+};
+
+class InlineDemaFilter final : public okapi::Filter {
+  public:
+  /**
+   * Double exponential moving average filter.
+   *
+   * @param ialpha alpha gain
+   * @param ibeta beta gain
+   */
+  InlineDemaFilter(const double ialpha, const double ibeta) : alpha(ialpha), beta(ibeta) {
+  }
+
+  /**
+   * Filters a value, like a sensor reading.
+   *
+   * @param ireading new measurement
+   * @return filtered result
+   */
+  double filter(const double ireading) override {
+    outputS = alpha * ireading + (1.0 - alpha) * (lastOutputS + lastOutputB);
+    outputB = beta * (outputS - lastOutputS) + (1.0 - beta) * lastOutputB;
+    lastOutputS = outputS;
+    lastOutputB = outputB;
+    return outputS + outputB;
+  }
+
+  /**
+   * Returns the previous output from filter.
+   *
+   * @return the previous output from filter
+   */
+  double getOutput() const override {
+    return outputS + outputB;
+  }
+
+  /**
+   * Set filter gains.
+   *
+   * @param ialpha alpha gain
+   * @param ibeta beta gain
+   */
+  void setGains(const double ialpha, const double ibeta) {
+    alpha = ialpha;
+    beta = ibeta;
+  }
+
+  protected:
+  double alpha, beta;
+  double outputS{0};
+  double lastOutputS{0};
+  double outputB{0};
+  double lastOutputB{0};
+};
+
+#endif
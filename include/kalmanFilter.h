@@ -0,0 +1,157 @@
+#ifndef KALMAN_FILTER_H_
+#define KALMAN_FILTER_H_
+
+// ------- kalmanFilter.h ------------------------------------------------------
+//
+// Extended Kalman filter over an n dimensional state with FixedMatrix math, so
+// the state, the covariance and every intermediate product are fixed size
+// values: nothing is allocated per step. okapi::EKFFilter is the same filter
+// with n = 1 and scalar Q, R and P; this one keeps the cross covariances, so a
+// heading measurement also corrects the position it caused.
+//
+// The caller owns the model: predict() gets the already propagated state and
+// the Jacobian of the propagation, update() gets the innovation (measurement
+// minus predicted measurement, e.g. with angles wrapped) and the Jacobian of
+// the measurement. Measurements of any size m can be mixed in one filter.
+//
+//   KalmanFilter<2> filter(x0, P0);
+//   filter.predict(F * filter.getState(), F, Q);
+//   filter.update<1>(z - H * filter.getState(), H, R);
+
+#include "fixedMatrix.h"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#define KALMAN_FLUSH_BELOW 1e-100     // covariances smaller than this are 0
+
+template <std::size_t n> class KalmanFilter {
+  public:
+  using State = FixedVector<n>;
+  using Covariance = FixedMatrix<n, n>;
+
+  /**
+   * @param istate The initial state.
+   * @param icovariance The covariance of the initial state.
+   */
+  KalmanFilter(const State &istate, const Covariance &icovariance)
+    : state(istate), covariance(icovariance) {
+  }
+
+  /**
+   * Moves the state forward one step.
+   *
+   * @param ipredicted The propagated state, f(x).
+   * @param ijacobian The Jacobian of f at the previous state.
+   * @param iprocessNoise The covariance the step adds, Q.
+   */
+  void predict(const State &ipredicted, const Covariance &ijacobian,
+               const Covariance &iprocessNoise) {
+    state = ipredicted;
+    covariance = ijacobian * covariance * ijacobian.transpose() + iprocessNoise;
+  }
+
+  /**
+   * Adds process noise without moving the state, a random walk (the Jacobian is the identity).
+   * Cheaper than predict() with an identity Jacobian.
+   *
+   * @param iprocessNoise The covariance the step adds, Q.
+   */
+  void diffuse(const Covariance &iprocessNoise) {
+    covariance = covariance + iprocessNoise;
+  }
+
+  /**
+   * Corrects the state with a measurement of size m.
+   *
+   * @param iinnovation The measurement minus the predicted measurement, z - h(x).
+   * @param ijacobian The Jacobian of h at the state, H.
+   * @param inoise The covariance of the measurement, R.
+   * @param igate Measurements whose squared Mahalanobis distance (normalized innovation squared)
+   * is above this are rejected as outliers, e.g. a chi-square quantile for m degrees of freedom.
+   * @return Whether the measurement was used.
+   */
+  template <std::size_t m>
+  bool update(const FixedVector<m> &iinnovation,
+              const FixedMatrix<m, n> &ijacobian,
+              const FixedMatrix<m, m> &inoise,
+              const double igate = std::numeric_limits<double>::infinity()) {
+    const FixedMatrix<n, m> covarianceHt = covariance * ijacobian.transpose();
+    const FixedMatrix<m, m> innovationCovariance = ijacobian * covarianceHt + inoise;
+
+    FixedMatrix<m, m> inverse;
+    if (!innovationCovariance.invert(inverse)) {
+      return false;
+    }
+
+    const FixedVector<m> weighted = inverse * iinnovation;
+    double distance = 0;
+    for (std::size_t i = 0; i < m; i++) {
+      distance += iinnovation[i] * weighted[i];
+    }
+    lastDistance = distance;
+    if (!(distance <= igate)) {
+      return false;
+    }
+
+    const FixedMatrix<n, m> gain = covarianceHt * inverse;
+    state = state + gain * iinnovation;
+    // (I - K H) P, with H P = (P H^T)^T as P is symmetric: n * n * m products instead of n^3
+    covariance = covariance - gain * covarianceHt.transpose();
+
+    // keep P symmetric against rounding. A covariance between states which are
+    // no longer related shrinks every update until it is a subnormal number,
+    // which costs a hundred times more per operation on some FPUs: flush it
+    for (std::size_t r = 0; r < n; r++) {
+      for (std::size_t c = r + 1; c < n; c++) {
+        double mean = (covariance(r, c) + covariance(c, r)) / 2;
+        if (std::abs(mean) < KALMAN_FLUSH_BELOW) {
+          mean = 0;
+        }
+        covariance(r, c) = mean;
+        covariance(c, r) = mean;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @return The current state estimate.
+   */
+  const State &getState() const {
+    return state;
+  }
+
+  /**
+   * @return The covariance of the current state estimate.
+   */
+  const Covariance &getCovariance() const {
+    return covariance;
+  }
+
+  /**
+   * @return The squared Mahalanobis distance of the last measurement given to update().
+   */
+  double getLastDistance() const {
+    return lastDistance;
+  }
+
+  /**
+   * Replaces the state, e.g. after the robot was placed somewhere else.
+   *
+   * @param istate The new state.
+   * @param icovariance The covariance of the new state.
+   */
+  void reset(const State &istate, const Covariance &icovariance) {
+    state = istate;
+    covariance = icovariance;
+  }
+
+  protected:
+  State state;
+  Covariance covariance;
+  double lastDistance{0};
+};
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef KALMAN_ODOMETRY_H_
+#define KALMAN_ODOMETRY_H_
+
+// ------- kalmanOdometry.h ----------------------------------------------------
+//
+// Odometry which estimates the chassis pose and velocity with a Kalman filter
+// (kalmanFilter.h) fusing three sensors instead of trusting one:
+//   - the tracking wheels, the main measurement of speed and turn rate,
+//   - the drive motors' integrated encoders (getSensorVals() of the drive
+//     model), a second, noisier speed measurement which slips,
+//   - the V5 inertial sensor, an absolute heading which does not drift when
+//     the tracking wheels slip or the track width is slightly off.
+//
+// The state is {x, y, theta, v, omega}. Every sample the velocities are
+// predicted as a random walk and corrected with both encoder pairs, then the
+// pose is moved along the arc of the tracking wheel travels (OdomArcMath, like
+// the other odometry classes; the tick counts add up exactly where smoothed
+// velocities would lag) and the heading is corrected with the IMU.
+//
+// A measurement whose innovation is far outside its expected noise
+// (KALMAN_ODOM_GATE) is ignored, so one encoder glitch or a wheel spinning on
+// a field tile does not throw the estimate off; without a good tracking wheel
+// sample the pose moves with the estimated velocities instead. A sensor which
+// disagrees for KALMAN_ODOM_MAX_REJECTS samples in a row is believed again, so
+// a real sudden change (a collision) cannot lock it out for good.
+//
+// Everything is fixed size, a sample allocates nothing when the models are
+// SensorSnapshotSources.
+//
+// It samples at a fixed rate like HighRateOdometry, hand it to
+// ChassisControllerBuilder::withOdometry() the same way.
+
+#include "highRateOdometry.h"
+#include "kalmanFilter.h"
+
+#include "okapi/api/device/rotarysensor/continuousRotarySensor.hpp"
+
+#include <array>
+
+#define KALMAN_ODOM_STATES 5          // x, y, theta, v, omega
+#define KALMAN_ODOM_GATE 25.0         // squared Mahalanobis distance, about 5 sigma
+#define KALMAN_ODOM_MAX_REJECTS 4     // rejected samples in a row before a sensor is trusted anyway
+
+/**
+ * Noise levels of the KalmanOdometry models, all standard deviations.
+ */
+struct KalmanOdometryNoise {
+  double acceleration{3};             // m/s^2, how fast the speed may change
+  double angularAcceleration{15};     // rad/s^2, how fast the turn rate may change
+  double trackingWheel{0.0005};       // m of travel per wheel per sample, about one tick
+  double motorWheel{0.004};           // m of travel per wheel per sample, slip included
+  double imuHeading{0.01};            // rad
+};
+
+class KalmanOdometry : public HighRateOdometry {
+  public:
+  /**
+   * Kalman filter odometry. Tracks the movement of the robot and estimates its position in
+   * coordinates relative to the start (assumed to be (0, 0, 0)). The IMU must be calibrated before
+   * the robot moves.
+   *
+   * @param itimeUtil The TimeUtil.
+   * @param imodel The chassis model for reading the tracking wheels, {left, right} ticks.
+   * @param ichassisScales The tracking wheel dimensions.
+   * @param imotorModel The drive model for reading the motor encoders, {left, right} ticks, or
+   * nullptr to not use them.
+   * @param imotorScales The drive wheel dimensions and motor encoder ticks per rotation.
+   * @param iimu The heading sensor, degrees clockwise positive (ImuHeadingSensor or okapi::IMU on
+   * the z axis), or nullptr to not use one.
+   * @param inoise The noise levels of the sensors and of the motion.
+   * @param isampleRate How often the sampling task reads the sensors.
+   * @param ilogger The logger this instance will log to.
+   */
+  KalmanOdometry(const okapi::TimeUtil &itimeUtil,
+                 const std::shared_ptr<okapi::ReadOnlyChassisModel> &imodel,
+                 const okapi::ChassisScales &ichassisScales,
+                 const std::shared_ptr<okapi::ReadOnlyChassisModel> &imotorModel,
+                 const okapi::ChassisScales &imotorScales,
+                 const std::shared_ptr<okapi::ContinuousRotarySensor> &iimu,
+                 const KalmanOdometryNoise &inoise = KalmanOdometryNoise(),
+                 const okapi::QFrequency &isampleRate = 200 * okapi::Hz,
+                 const std::shared_ptr<okapi::Logger> &ilogger =
+                   okapi::Logger::getDefaultLogger());
+
+  /**
+   * @return The estimated forward speed (m/s) and clockwise turn rate (rad/s) together with their
+   * variances, {v, omega, var v, var omega}. Never blocks.
+   */
+  std::array<double, 4> getVelocityEstimate() const;
+
+  protected:
+  using Filter = KalmanFilter<KALMAN_ODOM_STATES>;
+
+  std::shared_ptr<okapi::ReadOnlyChassisModel> motorModel;
+  okapi::ChassisScales motorScales;
+  std::shared_ptr<okapi::ContinuousRotarySensor> imu;
+  const KalmanOdometryNoise noise;
+
+  // set when the motor model can be read without allocating, see sensorSnapshot.h
+  const SensorSnapshotSource *motorSnapshotSource{nullptr};
+
+  // only touched with writerMutex held
+  Filter filter;
+  SensorSnapshot motorTicks;
+  SensorSnapshot lastMotorTicks;
+  std::uint64_t lastMotorMicros{0};
+  bool haveLastMotorTicks{false};
+  double imuOffset{0};                // radians added to the IMU reading to get the odom heading
+  bool haveImuOffset{false};          // offset is taken from the first good IMU reading
+  std::array<int, 3> rejects{};       // rejected samples in a row: tracking wheels, motors, IMU
+
+  SeqLock<std::array<double, 4>> velocityEstimate;
+
+  OdomPose
+  odomMathStep(const OdomPose &ipose, double ileftDiff, double irightDiff, double idt) override;
+
+  void onStateSet(const OdomPose &ipose) override;
+
+  /**
+   * Corrects the state with a measurement unless it is gated out as an outlier.
+   *
+   * @param iinnovation The measurement minus the predicted measurement.
+   * @param ijacobian The Jacobian of the measurement.
+   * @param inoise The covariance of the measurement.
+   * @param irejects The sensor's count of rejected samples in a row.
+   * @return Whether the measurement was used.
+   */
+  template <std::size_t m>
+  bool update(const FixedVector<m> &iinnovation,
+              const FixedMatrix<m, KALMAN_ODOM_STATES> &ijacobian,
+              const FixedMatrix<m, m> &inoise,
+              int &irejects);
+
+  /**
+   * Corrects v and omega with the tracking wheel tick differences.
+   *
+   * @return Whether the sample was used, false if it was rejected as a glitch.
+   */
+  bool updateTrackingWheels(double ileftDiff, double irightDiff, double idt);
+
+  /**
+   * Moves the pose along the arc of the tracking wheel travels, which adds their noise to it.
+   *
+   * @param ideltaLeft The left wheel travel in meters.
+   * @param ideltaRight The right wheel travel in meters.
+   */
+  void moveByWheels(double ideltaLeft, double ideltaRight);
+
+  /**
+   * Moves the pose along the arc of the estimated velocities, when there is no wheel sample.
+   */
+  void moveByVelocity(double idt);
+
+  /**
+   * Reads the motor encoders and corrects the speed with their travel since they were last read.
+   */
+  void updateMotors();
+
+  /**
+   * Corrects the heading with the IMU.
+   */
+  void updateImu();
+
+  /**
+   * @return The IMU heading in radians, or NAN if there is no IMU or it could not be read.
+   */
+  double readImu() const;
+
+  /**
+   * Reads the motor model's sensors into motorTicks.
+   *
+   * @return Whether there were at least two readings.
+   */
+  bool readMotors();
+
+  /**
+   * @return The covariance of a pose known well after setState().
+   */
+  static Filter::Covariance initialCovariance();
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef LINEAR_MOTION_PROFILE_CONTROLLER_H_
+#define LINEAR_MOTION_PROFILE_CONTROLLER_H_
+
+// ------- linearMotionProfileController.h -------------------------------------
+//
+// okapi's AsyncLinearMotionProfileController (lifts, intakes, anything with a
+// single 1D profile) that can keep its paths as CompactTrajectory and make
+// TrajectoryView variants of them, like MotionProfileController does for the
+// chassis.
+//
+//   auto lift = std::make_shared<LinearMotionProfileController>(
+//     okapi::TimeUtilFactory::createDefault(), okapi::PathfinderLimits{1.0, 2.0, 10.0},
+//     liftMotor, 2_in, okapi::AbstractMotor::gearset::red);
+//   lift->setTrajectoryStorage(TrajectoryStorage::fixed16);
+//   lift->startThread();
+
+#include "trajectoryView.h"
+
+#include "okapi/api/control/async/asyncLinearMotionProfileController.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+
+class LinearMotionProfileController : public okapi::AsyncLinearMotionProfileController {
+  public:
+  using okapi::AsyncLinearMotionProfileController::AsyncLinearMotionProfileController;
+
+  /**
+   * Generates a path like AsyncLinearMotionProfileController::generatePath() and stores it in
+   * the current trajectory storage.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ipathId A unique identifier to save the path with.
+   */
+  void generatePath(std::initializer_list<okapi::QLength> iwaypoints, const std::string &ipathId);
+
+  /**
+   * Removes a path and frees the memory it used, compact or not.
+   *
+   * @param ipathId A unique identifier for the path.
+   * @return true if the path no longer exists, false if it is running.
+   */
+  bool removePath(const std::string &ipathId);
+
+  /**
+   * Sets how paths generated from now on are kept in memory. Existing paths keep the storage
+   * they have. The default, full, keeps okapi's pathfinder Segments.
+   *
+   * @param istorage full, float32 or fixed16.
+   */
+  void setTrajectoryStorage(TrajectoryStorage istorage);
+
+  /**
+   * @return How paths generated from now on are kept in memory.
+   */
+  TrajectoryStorage getTrajectoryStorage() const;
+
+  /**
+   * @param ipathId A unique identifier for the path.
+   * @return The memory the trajectory of the path uses in bytes, 0 if there is no such path.
+   */
+  std::size_t getPathMemory(const std::string &ipathId);
+
+  /**
+   * A view of a stored path for TrajectoryView transforms. A full path is taken over by the view
+   * without copying and is followed from there, also while it runs.
+   *
+   * @param ipathId A unique identifier for the path.
+   * @return The view, empty if there is no such path.
+   */
+  TrajectoryView getView(const std::string &ipathId);
+
+  /**
+   * Stores a view as a path, followed like any other. The view keeps the trajectories
+   * it was made of, even if their own paths are removed.
+   *
+   * @param ipathId A unique identifier to save the path with.
+   * @param iview A view of linear paths.
+   * @return false if the view is empty or not a single trajectory, or if a path with that id is
+   * running.
+   */
+  bool storeView(const std::string &ipathId, const TrajectoryView &iview);
+
+  protected:
+  // compact paths and views have an entry without segments in paths and their
+  // trajectory here, both guarded by currentPathMutex
+  std::atomic<TrajectoryStorage> storage{TrajectoryStorage::full};
+  std::map<std::string, std::shared_ptr<const TrajectorySource>> sharedPaths;
+
+  /**
+   * Moves the segments of a full path into a SegmentTrajectory in sharedPaths, without copying.
+   * currentPathMutex must be locked.
+   *
+   * @return The trajectory of the path, nullptr if there is no such path.
+   */
+  std::shared_ptr<const TrajectorySource> sharePath(const std::string &ipathId);
+
+  /**
+   * Follows a path from its shared trajectory, a full path is shared first.
+   */
+  void executeSinglePath(const TrajectoryPair &path,
+                         std::unique_ptr<okapi::AbstractRate> rate) override;
+};
+
+#endif
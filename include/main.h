@@ -40,6 +40,9 @@
  * You should add more #includes here
  */
 #include "okapi/api.hpp"
+
+// compile-time log levels and structured logging (ROBOT_LOG_DEBUG etc.)
+#include "robotLog.h"
 //#include "pros/api_legacy.h"
 
 /**
@@ -0,0 +1,623 @@
+#ifndef MOTION_PROFILE_CONTROLLER_H_
+#define MOTION_PROFILE_CONTROLLER_H_
+
+// ------- motionProfileController.h -------------------------------------------
+//
+// The project's motion profile controller, okapi's AsyncMotionProfileController
+// with additions:
+//  - paths can come precomputed from a PathBlob (tools/pathGen) instead of
+//    generatePath() in initialize(); a blob path is loaded the first time it
+//    is used, so startup does no spline math at all.
+//  - generatePathAsync() generates paths on a low priority background task,
+//    so the robot can start driving the first path while later ones are still
+//    being generated. setTarget() only waits if its own path is not ready.
+//  - setTrajectoryStorage() keeps paths as CompactTrajectory instead of full
+//    pathfinder Segments, a fifth or a tenth of the memory for long runs.
+//  - setFollowerGains() closes the loop around the profile: velocity and
+//    acceleration feed forward plus wheel position and heading feedback from
+//    the chassis encoders, or the heading from an odometry. okapi's builder
+//    cannot make this class, so the gains are set on the controller.
+//  - generatePathFrom() / moveToField() plan from the robot's odometry pose to
+//    field waypoints, so moves do not need the odometry reset to 0, 0, 0.
+//  - setPathGenerator(PathGenerator::curvature) generates paths with per
+//    point velocity limits from the curvature instead of pathfinder's single
+//    limit, see pathGeneration.h.
+//  - getView() / storeView() make mirrored, backwards, retraced, scaled and
+//    concatenated variants of stored paths without copying them, see
+//    trajectoryView.h.
+//  - queuePath() chains paths without stopping in between: the end of one
+//    path is blended into the start of the next, see queuePath().
+//
+// Compact paths and views have an entry without segments in okapi's paths.
+// okapi's path functions are not virtual, and its storePath() or moveTo()
+// would read such an entry, so okapi's class is a protected base: only the
+// functions of this class handle paths, and the rest of okapi's interface
+// which does not is made public again below. Hand the controller around as a
+// MotionProfileController, not as an okapi controller.
+//
+// Build it directly instead of with AsyncMotionProfileControllerBuilder and
+// call startThread() once, e.g.
+//   auto profile = std::make_shared<MotionProfileController>(
+//     okapi::TimeUtilFactory::createDefault(), okapi::PathfinderLimits{1.0, 2.0, 10.0},
+//     chassis->getModel(), chassis->getChassisScales(), chassis->getGearsetRatioPair());
+//   profile->startThread();
+
+#include "trajectoryView.h"
+#include "pathBlob.h"
+#include "pathGeneration.h"
+#include "sensorSnapshot.h"
+
+#include "okapi/api/control/async/asyncMotionProfileController.hpp"
+#include "okapi/api/odometry/odometry.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FIELD_MOVE_PATH_ID "fieldMove"  // path id moveToField() uses
+#define MOVE_TO_PATH_ID "moveTo"        // path id moveTo() uses
+#define PATH_BLEND_MAX_STEPS 256        // steps of two paths' end and start compared for a blend
+
+/**
+ * Handle of a path queued with MotionProfileController::generatePathAsync().
+ */
+class PathHandle {
+  public:
+  enum class status { pending, ready, failed };
+
+  PathHandle() = default;
+
+  explicit PathHandle(std::shared_ptr<std::atomic<status>> istate);
+
+  /**
+   * @return Whether the path is still being generated, ready, or could not be generated. An
+   * empty handle is failed.
+   */
+  status getStatus() const;
+
+  /**
+   * @return Whether the path has been generated.
+   */
+  bool isReady() const;
+
+  /**
+   * Blocks the current task until the path is generated or generation failed.
+   *
+   * @return Whether the path has been generated.
+   */
+  bool waitUntilReady() const;
+
+  protected:
+  std::shared_ptr<std::atomic<status>> state;
+};
+
+/**
+ * Gains of the MotionProfileController path follower, per wheel side:
+ *   e = profile position - measured position
+ *   v = kV * profile velocity + kA * profile acceleration + kP * e + kD * de/dt
+ * and kHeading * heading error * track / 2 is added to the right side and taken from the left.
+ * v is the wheel velocity in m/s sent to the motors. The defaults are okapi's open loop follower.
+ */
+struct ProfileFollowerGains {
+  double kV{1};                       // feed forward of the profile velocity
+  double kA{0};                       // s, feed forward of the profile acceleration
+  double kP{0};                       // 1/s, on the position error
+  double kD{0};                       // on the velocity error
+  double kHeading{0};                 // 1/s, on the heading error
+};
+
+class MotionProfileController : protected okapi::AsyncMotionProfileController {
+  public:
+  using okapi::AsyncMotionProfileController::AsyncMotionProfileController;
+
+  using okapi::AsyncMotionProfileController::controllerSet;
+  using okapi::AsyncMotionProfileController::flipDisable;
+  using okapi::AsyncMotionProfileController::getError;
+  using okapi::AsyncMotionProfileController::getPaths;
+  using okapi::AsyncMotionProfileController::getProcessValue;
+  using okapi::AsyncMotionProfileController::getTarget;
+  using okapi::AsyncMotionProfileController::getThread;
+  using okapi::AsyncMotionProfileController::isDisabled;
+  using okapi::AsyncMotionProfileController::isSettled;
+  using okapi::AsyncMotionProfileController::reset;
+  using okapi::AsyncMotionProfileController::setMaxVelocity;
+  using okapi::AsyncMotionProfileController::startThread;
+  using okapi::AsyncMotionProfileController::tarePosition;
+  using okapi::AsyncMotionProfileController::waitUntilSettled;
+
+  /**
+   * Stops the background generator, waiting for the path it is working on.
+   */
+  ~MotionProfileController() override;
+
+  /**
+   * Queues a path to be generated on the background generator task and returns at once. Paths
+   * are generated in the order they are queued. A path with the same id replaces the existing
+   * one when it is ready, unless that path is running.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ipathId A unique identifier to save the path with.
+   * @return A handle to wait for or poll the path with.
+   */
+  PathHandle generatePathAsync(const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                               const std::string &ipathId);
+
+  /**
+   * Queues a path to be generated on the background generator task and returns at once.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ipathId A unique identifier to save the path with.
+   * @param ilimits The limits to use for this path only.
+   * @return A handle to wait for or poll the path with.
+   */
+  PathHandle generatePathAsync(const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                               const std::string &ipathId,
+                               const okapi::PathfinderLimits &ilimits);
+
+  /**
+   * Generates a path like AsyncMotionProfileController::generatePath(), but with the current
+   * path generator and the quadrature arc length of PathGeneration, and stores it in the current
+   * trajectory storage.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ipathId A unique identifier to save the path with.
+   */
+  void generatePath(std::initializer_list<okapi::PathfinderPoint> iwaypoints,
+                    const std::string &ipathId);
+
+  /**
+   * Generates a path like AsyncMotionProfileController::generatePath(), but with the current
+   * path generator and the quadrature arc length of PathGeneration, and stores it in the current
+   * trajectory storage.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ipathId A unique identifier to save the path with.
+   * @param ilimits The limits to use for this path only.
+   */
+  void generatePath(std::initializer_list<okapi::PathfinderPoint> iwaypoints,
+                    const std::string &ipathId,
+                    const okapi::PathfinderLimits &ilimits);
+
+  /**
+   * Removes a path and frees the memory it used, compact or not.
+   *
+   * @param ipathId A unique identifier for the path.
+   * @return true if the path no longer exists, false if it is running.
+   */
+  bool removePath(const std::string &ipathId);
+
+  /**
+   * Removes a path even if it is running, like AsyncMotionProfileController::forceRemovePath(),
+   * which disables the controller to stop a running path.
+   *
+   * @param ipathId A unique identifier for the path.
+   */
+  void forceRemovePath(const std::string &ipathId);
+
+  /**
+   * Saves a path to `<ipathId>.<left/right>.csv` like AsyncMotionProfileController::storePath().
+   * Compact paths are written in the same format, with x, y and jerk as 0.
+   *
+   * @param idirectory The directory to store the path files in.
+   * @param ipathId The path ID of the path.
+   */
+  void storePath(const std::string &idirectory, const std::string &ipathId);
+
+  /**
+   * Loads a path saved with storePath() and stores it in the current trajectory storage.
+   *
+   * @param idirectory The directory that the path files are stored in.
+   * @param ipathId The path ID that the paths are stored under (and will be loaded into).
+   */
+  void loadPath(const std::string &idirectory, const std::string &ipathId);
+
+  /**
+   * Sets how paths generated or loaded from now on are kept in memory. Existing paths keep the
+   * storage they have. The default, full, keeps okapi's pathfinder Segments.
+   *
+   * @param istorage full, float32 or fixed16.
+   */
+  void setTrajectoryStorage(TrajectoryStorage istorage);
+
+  /**
+   * @return How paths generated or loaded from now on are kept in memory.
+   */
+  TrajectoryStorage getTrajectoryStorage() const;
+
+  /**
+   * @param ipathId A unique identifier for the path.
+   * @return The memory the trajectories of the path use in bytes, 0 if there is no such path.
+   */
+  std::size_t getPathMemory(const std::string &ipathId);
+
+  /**
+   * A view of a stored path for TrajectoryView transforms. A full path is taken over by the view
+   * without copying and is followed from there, also while it runs.
+   *
+   * @param ipathId A unique identifier for the path.
+   * @return The view, empty if there is no such path.
+   */
+  TrajectoryView getView(const std::string &ipathId);
+
+  /**
+   * Stores a view as a path, followed and queued like any other. The view keeps the trajectories
+   * it was made of, even if their own paths are removed.
+   *
+   * @param ipathId A unique identifier to save the path with.
+   * @param iview A view of tank paths.
+   * @return false if the view is empty or not a pair, or if a path with that id is running.
+   */
+  bool storeView(const std::string &ipathId, const TrajectoryView &iview);
+
+  /**
+   * Generates a path from a robot pose to field waypoints and stores it. Quick enough to run
+   * between two moves; the time it took is logged.
+   *
+   * @param ifrom The robot pose, e.g. chassis->getState(), in okapi's FRAME_TRANSFORMATION mode.
+   * @param iwaypoints The field waypoints to hit after the robot's pose, in the same frame.
+   * @param ipathId A unique identifier to save the path with.
+   * @return Whether the path was generated.
+   */
+  bool generatePathFrom(const okapi::OdomState &ifrom,
+                        const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                        const std::string &ipathId);
+
+  /**
+   * Generates a path from a robot pose to field waypoints and stores it.
+   *
+   * @param ifrom The robot pose, in okapi's FRAME_TRANSFORMATION mode.
+   * @param iwaypoints The field waypoints to hit after the robot's pose, in the same frame.
+   * @param ipathId A unique identifier to save the path with.
+   * @param ilimits The limits to use for this path only.
+   * @return Whether the path was generated.
+   */
+  bool generatePathFrom(const okapi::OdomState &ifrom,
+                        const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                        const std::string &ipathId,
+                        const okapi::PathfinderLimits &ilimits);
+
+  /**
+   * Generates a path from a robot pose to field waypoints and blocks until the robot has
+   * followed it. Does not keep the path.
+   *
+   * @param ifrom The robot pose, e.g. chassis->getState(), in okapi's FRAME_TRANSFORMATION mode.
+   * @param iwaypoints The field waypoints to hit after the robot's pose, in the same frame.
+   */
+  void moveToField(const okapi::OdomState &ifrom,
+                   const std::vector<okapi::PathfinderPoint> &iwaypoints);
+
+  /**
+   * Generates a path from a robot pose to field waypoints and blocks until the robot has
+   * followed it. Does not keep the path.
+   *
+   * @param ifrom The robot pose, in okapi's FRAME_TRANSFORMATION mode.
+   * @param iwaypoints The field waypoints to hit after the robot's pose, in the same frame.
+   * @param ilimits The limits to use for this path only.
+   */
+  void moveToField(const okapi::OdomState &ifrom,
+                   const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                   const okapi::PathfinderLimits &ilimits);
+
+  /**
+   * Generates a path, blocks until the robot has followed it and removes it again, like
+   * AsyncMotionProfileController::moveTo(), with generatePath() of this class.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ibackwards Whether to follow the profile backwards.
+   * @param imirrored Whether to follow the profile mirrored.
+   */
+  void moveTo(std::initializer_list<okapi::PathfinderPoint> iwaypoints,
+              bool ibackwards = false,
+              bool imirrored = false);
+
+  /**
+   * Generates a path, blocks until the robot has followed it and removes it again.
+   *
+   * @param iwaypoints The waypoints to hit on the path.
+   * @param ilimits The limits to use for this path only.
+   * @param ibackwards Whether to follow the profile backwards.
+   * @param imirrored Whether to follow the profile mirrored.
+   */
+  void moveTo(std::initializer_list<okapi::PathfinderPoint> iwaypoints,
+              const okapi::PathfinderLimits &ilimits,
+              bool ibackwards = false,
+              bool imirrored = false);
+
+  /**
+   * Sets the velocity profile generator of paths generated from now on, also by generatePath().
+   *
+   * @param igenerator pathfinder (okapi's, the default) or curvature.
+   */
+  void setPathGenerator(PathGenerator igenerator);
+
+  /**
+   * @return The velocity profile generator of paths generated from now on.
+   */
+  PathGenerator getPathGenerator() const;
+
+  /**
+   * Sets the gains of the path follower, used from the next path on.
+   *
+   * @param igains The gains, ProfileFollowerGains{} for okapi's open loop follower.
+   */
+  void setFollowerGains(const ProfileFollowerGains &igains);
+
+  /**
+   * @return The gains of the path follower.
+   */
+  ProfileFollowerGains getFollowerGains();
+
+  /**
+   * Takes the measured heading for kHeading from an odometry, e.g. one with an IMU, instead of
+   * the difference of the chassis encoders.
+   *
+   * @param iodometry The odometry, nullptr to go back to the encoders.
+   */
+  void setHeadingSource(const std::shared_ptr<okapi::Odometry> &iodometry);
+
+  /**
+   * Sets the blob precomputed paths are loaded from. Paths generated or loaded by other means
+   * take precedence over blob paths with the same id.
+   *
+   * @param iblob The blob, nullptr to stop using one.
+   */
+  void setPathBlob(const std::shared_ptr<PathBlob> &iblob);
+
+  /**
+   * Loads a path from the blob now instead of when it is first used, e.g. so a large path read
+   * from the USD card does not delay the start of the movement. Does nothing if the path is
+   * already loaded.
+   *
+   * @param ipathId The path id in the blob.
+   * @return true if the path is available to setTarget().
+   */
+  bool loadBlobPath(const std::string &ipathId);
+
+  /**
+   * Executes a path with the given ID. Waits if the path is still being generated in the
+   * background, and loads it from the blob first if needed. If a path is running, it is finished
+   * first and this one follows from where it ends, where okapi would drop it. Drops the paths
+   * queued after the running one.
+   *
+   * @param ipathId A unique identifier for the path.
+   */
+  void setTarget(std::string ipathId) override;
+
+  /**
+   * Executes a path with the given ID. Waits if the path is still being generated in the
+   * background, and loads it from the blob first if needed. If a path is running, it is finished
+   * first and this one follows from where it ends, where okapi would drop it. Drops the paths
+   * queued after the running one.
+   *
+   * @param ipathId A unique identifier for the path.
+   * @param ibackwards Whether to follow the profile backwards.
+   * @param imirrored Whether to follow the profile mirrored.
+   */
+  void setTarget(std::string ipathId, bool ibackwards, bool imirrored = false);
+
+  /**
+   * Queues a path to follow after the running one without stopping in between, or starts it
+   * like setTarget() if no path is running. Where the running path slows down to its end and the
+   * next one speeds up from its start, the two are followed at the same time, so the robot keeps
+   * going at about the speed of both. Each wheel still travels both distances, so the next path
+   * should start where the last one ends, with the same heading. The overlap is shortened until
+   * no wheel goes faster than in either path. waitUntilSettled() waits for the whole chain.
+   * A queued path keeps its trajectory even if the path is removed before it runs.
+   *
+   * @param ipathId A unique identifier for the path.
+   * @param ibackwards Whether to follow the profile backwards.
+   * @param imirrored Whether to follow the profile mirrored.
+   */
+  void queuePath(std::string ipathId, bool ibackwards = false, bool imirrored = false);
+
+  /**
+   * Drops the queued paths, the running path is finished.
+   */
+  void clearQueue();
+
+  /**
+   * @return The number of paths queued after the running one.
+   */
+  std::size_t getQueueSize();
+
+  protected:
+  struct PathJob {
+    std::string id;
+    std::vector<Waypoint> waypoints;
+    okapi::PathfinderLimits limits;
+    std::shared_ptr<std::atomic<PathHandle::status>> state;
+    PathGenerator generator{PathGenerator::pathfinder};
+  };
+
+  std::shared_ptr<PathBlob> blob;
+
+  // compact paths and views have an entry without segments in paths and their
+  // trajectory here, both guarded by currentPathMutex
+  std::atomic<TrajectoryStorage> storage{TrajectoryStorage::full};
+  std::atomic<PathGenerator> generator{PathGenerator::pathfinder};
+  std::map<std::string, std::shared_ptr<const TrajectorySource>> sharedPaths;
+
+  struct QueuedPath {
+    std::string id;
+    bool backwards;
+    bool mirrored;
+    std::shared_ptr<const TrajectorySource> trajectory;
+    bool target;                      // set with setTarget() while a path ran, not blended
+  };
+
+  /**
+   * A path while it is being followed.
+   */
+  struct FollowedPath {
+    std::string id;
+    std::shared_ptr<const TrajectorySource> shared; // or
+    const TrajectoryPair *full{nullptr};               // the first path, until it is shared
+    int length{0};
+    int reversed{1};
+    bool mirrored{false};
+    int step{0};
+    TrajectorySample last;            // profile at the end of the last step
+    TrajectorySample start;           // profile where feedback started
+    SensorSnapshot startTicks;
+    double startTheta{0};
+    double lastLeftError{0};
+    double lastRightError{0};
+  };
+
+  // paths to blend into the running one, guarded by currentPathMutex; queueOpen
+  // is false once the running chain does not take any more paths, following is
+  // true while the follower runs one
+  std::deque<QueuedPath> pathQueue;
+  bool queueOpen{false};
+  bool following{false};
+
+  // blendSteps() scratch, feed forward motor speeds of a path's end or start;
+  // only used by the follower task
+  struct BlendWindow {
+    std::array<double, PATH_BLEND_MAX_STEPS> left;
+    std::array<double, PATH_BLEND_MAX_STEPS> right;
+    std::array<double, PATH_BLEND_MAX_STEPS> speed;
+  };
+  BlendWindow blendEnd;
+  BlendWindow blendStart;
+
+  // follower settings, read once at the start of every path
+  CrossplatformMutex followerMutex;
+  ProfileFollowerGains followerGains;
+  std::shared_ptr<okapi::Odometry> headingSource;
+
+  // background generator, generatorMutex guards the queue and the pending paths
+  CrossplatformMutex generatorMutex;
+  std::deque<PathJob> generatorJobs;
+  std::map<std::string, std::shared_ptr<std::atomic<PathHandle::status>>> pendingPaths;
+  std::atomic_bool generatorStop{false};
+  std::atomic_bool generatorDone{false};
+  CrossplatformThread *generatorTask{nullptr};
+
+  static void generatorTrampoline(void *context);
+  void generatorLoop();
+
+  /**
+   * Generates one queued path and stores it with the other paths.
+   *
+   * @return Whether the path was generated and stored.
+   */
+  bool generateJob(const PathJob &ijob);
+
+  /**
+   * Blocks until the path is no longer being generated in the background.
+   */
+  void waitForPendingPath(const std::string &ipathId);
+
+  /**
+   * Converts a newly stored path to the current trajectory storage. currentPathMutex must be
+   * locked.
+   */
+  void compactStoredPath(const std::string &ipathId);
+
+  /**
+   * Moves the segments of a full path into a SegmentTrajectory in sharedPaths, without copying,
+   * so queued paths and views can share them. A follower reading the segments continues from
+   * the shared trajectory. currentPathMutex must be locked.
+   *
+   * @return The trajectory of the path, nullptr if there is no such path.
+   */
+  std::shared_ptr<const TrajectorySource> sharePath(const std::string &ipathId);
+
+  /**
+   * Reads the chassis encoders, without allocating if the model is a SensorSnapshotSource.
+   */
+  void readSensors(SensorSnapshot &out) const;
+
+  /**
+   * Reads one step of a followed path, switching it to the shared trajectory if its segments
+   * were shared while it runs.
+   *
+   * @return false if the path was force removed while it runs.
+   */
+  bool pathSample(FollowedPath &ipath, int i, TrajectorySample &osample, double &odt);
+
+  /**
+   * Prepares a path to be followed from its first step.
+   */
+  void beginPath(FollowedPath &ipath);
+
+  /**
+   * Measures feedback errors from the robot's position now.
+   */
+  void startFeedback(FollowedPath &ipath, const std::shared_ptr<okapi::Odometry> &iodometry);
+
+  /**
+   * The wheel velocities of one step of a path in m/s, in the frame of the path.
+   */
+  void wheelVelocities(FollowedPath &ipath,
+                       const TrajectorySample &isample,
+                       double idt,
+                       const ProfileFollowerGains &igains,
+                       const std::shared_ptr<okapi::Odometry> &iodometry,
+                       bool ifeedback,
+                       double &oleft,
+                       double &oright);
+
+  /**
+   * Converts the wheel velocities of a path into model->left() / right() speeds.
+   */
+  void motorSpeeds(const FollowedPath &ipath,
+                   double ileftVel,
+                   double irightVel,
+                   double &oleft,
+                   double &oright) const;
+
+  /**
+   * Starts following the chain of the current target. Looks the path up again, setTarget() may
+   * have replaced the one okapi's loop found.
+   */
+  void startChain(FollowedPath &ocurrent);
+
+  /**
+   * Ends the chain, dropping the queued paths if it ends before it ran out of them.
+   */
+  void endChain();
+
+  /**
+   * Moves the first queued path into onext. currentPathMutex must be locked.
+   */
+  void takeQueuedPath(FollowedPath &onext);
+
+  /**
+   * Takes the next path to blend into the running one off the queue, with the trajectory
+   * queuePath() shared.
+   *
+   * @return false if the queue is empty or starts with a path set with setTarget().
+   */
+  bool dequeuePath(FollowedPath &onext);
+
+  /**
+   * Picks the path to follow after the running one: a path set with setTarget() since, else
+   * ionext if ihaveNext, else the next queued path. With none the queue is closed, in the same
+   * lock as looking at it, so no path queued meanwhile is dropped.
+   *
+   * @return false if the chain ends.
+   */
+  bool continueChain(FollowedPath &ionext, bool ihaveNext);
+
+  /**
+   * @return The number of steps the end of icurrent and the start of inext are followed together,
+   * at most PATH_BLEND_MAX_STEPS.
+   */
+  int blendSteps(FollowedPath &icurrent, FollowedPath &inext);
+
+  /**
+   * Follows a path and the paths queued after it, from their compact trajectories or views if
+   * they have one, with the follower gains.
+   */
+  void executeSinglePath(const TrajectoryPair &path,
+                         std::unique_ptr<okapi::AbstractRate> rate) override;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef ODOM_ARC_MATH_H_
+#define ODOM_ARC_MATH_H_
+
+// ------- odomArcMath.h -------------------------------------------------------
+//
+// Side effect free tracking wheel math shared by the project's odometry
+// classes. It is the same arc model okapi::TwoEncoderOdometry uses: the robot
+// is assumed to move on a circular arc between two samples.
+//
+// Poses are in okapi's StateMode::FRAME_TRANSFORMATION convention: x forward,
+// y to the right, theta clockwise positive.
+
+#include "okapi/api/chassis/controller/chassisScales.hpp"
+#include "okapi/api/odometry/odomState.hpp"
+#include "okapi/api/odometry/stateMode.hpp"
+
+/**
+ * Plain pose in meters / radians - trivially copyable, so it can be published
+ * through a SeqLock or stored in ring buffers.
+ */
+struct OdomPose {
+  double x{0};                        // meters
+  double y{0};                        // meters
+  double theta{0};                    // radians
+};
+
+class OdomArcMath {
+  public:
+  /**
+   * Integrates one pair of tracking wheel deltas.
+   *
+   * @param ipose The pose before the movement.
+   * @param ideltaLeft The left wheel travel in meters.
+   * @param ideltaRight The right wheel travel in meters.
+   * @param ideltaTheta The heading change in radians for the movement, normally
+   * (ideltaLeft - ideltaRight) / wheel track but may come from another sensor.
+   * @param itrack The wheel track in meters.
+   * @return The pose after the movement.
+   */
+  static OdomPose step(const OdomPose &ipose,
+                       double ideltaLeft,
+                       double ideltaRight,
+                       double ideltaTheta,
+                       double itrack);
+
+  /**
+   * Integrates one pair of tracking wheel tick deltas using the chassis scales.
+   *
+   * @param ipose The pose before the movement.
+   * @param ileftTicks The left wheel tick delta.
+   * @param irightTicks The right wheel tick delta.
+   * @param iscales The tracking wheel scales.
+   * @return The pose after the movement.
+   */
+  static OdomPose stepTicks(const OdomPose &ipose,
+                            double ileftTicks,
+                            double irightTicks,
+                            const okapi::ChassisScales &iscales);
+
+  /**
+   * Converts a pose to an okapi::OdomState in the given mode.
+   */
+  static okapi::OdomState toState(const OdomPose &ipose, const okapi::StateMode &imode);
+
+  /**
+   * Converts an okapi::OdomState in the given mode to a pose.
+   */
+  static OdomPose fromState(const okapi::OdomState &istate, const okapi::StateMode &imode);
+
+  private:
+  OdomArcMath();
+  ~OdomArcMath();
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef PATH_BLOB_H_
+#define PATH_BLOB_H_
+
+// ------- pathBlob.h ----------------------------------------------------------
+//
+// Read only access to precomputed motion profiles (see pathBlobFormat.h and
+// tools/pathGen). The blob is either linked into the program ("make paths"
+// writes src/generatedPaths.cpp) or a file on the USD card. Only the small
+// directory is read up front; the segments of a path are copied out when the
+// path is first used.
+
+#include "pathBlobFormat.h"
+
+#include "okapi/api/coreProsAPI.hpp"
+#include "okapi/api/util/logging.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// written by "make paths", weak so the program still links without it
+extern const unsigned char generatedPathBlob[] __attribute__((weak));
+extern const std::size_t generatedPathBlobSize __attribute__((weak));
+
+class PathBlob {
+  public:
+  /**
+   * A blob in memory, for example the one linked into the program.
+   *
+   * @param idata The blob, must stay valid for the lifetime of this object.
+   * @param isize The size of the blob in bytes.
+   * @param ilogger The logger this instance will log to.
+   */
+  PathBlob(const unsigned char *idata,
+           std::size_t isize,
+           const std::shared_ptr<okapi::Logger> &ilogger = okapi::Logger::getDefaultLogger());
+
+  /**
+   * A blob file, for example on the USD card. The file stays open until this object is destroyed.
+   *
+   * @param ifileName The file name, e.g. "/usd/paths.bin".
+   * @param ilogger The logger this instance will log to.
+   */
+  explicit PathBlob(const std::string &ifileName,
+                    const std::shared_ptr<okapi::Logger> &ilogger =
+                      okapi::Logger::getDefaultLogger());
+
+  PathBlob(const PathBlob &) = delete;
+  PathBlob &operator=(const PathBlob &) = delete;
+
+  ~PathBlob();
+
+  /**
+   * @return The blob generated by "make paths" and linked into the program, nullptr if there is
+   * none.
+   */
+  static std::shared_ptr<PathBlob> linked();
+
+  /**
+   * @return Whether the blob was opened and its directory is valid.
+   */
+  bool isValid() const;
+
+  /**
+   * @return The ids of all paths in the blob.
+   */
+  std::vector<std::string> getPathIds() const;
+
+  /**
+   * @return The wheel track the paths were generated for in meters.
+   */
+  double getWheelTrack() const;
+
+  /**
+   * @param ipathId The path id.
+   * @return The number of segments per side, -1 if the path is not in the blob.
+   */
+  int getLength(const std::string &ipathId) const;
+
+  /**
+   * Copies the segments of a path.
+   *
+   * @param ipathId The path id.
+   * @param ileft Receives getLength() left segments.
+   * @param iright Receives getLength() right segments.
+   * @return false if the path is not in the blob or could not be read.
+   */
+  bool read(const std::string &ipathId, Segment *ileft, Segment *iright) const;
+
+  protected:
+  std::shared_ptr<okapi::Logger> logger;
+  const unsigned char *data{nullptr};
+  std::size_t size{0};
+  FILE *file{nullptr};
+  mutable CrossplatformMutex fileMutex;
+  PathBlobHeader header{};
+  std::vector<PathBlobEntry> entries;
+
+  /**
+   * Reads and checks the header and directory.
+   */
+  bool readDirectory();
+
+  /**
+   * Copies bytes from the blob, from memory or the file.
+   */
+  bool readBytes(std::size_t ioffset, void *out, std::size_t icount) const;
+
+  const PathBlobEntry *findEntry(const std::string &ipathId) const;
+};
+
+#endif
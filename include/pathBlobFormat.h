@@ -0,0 +1,44 @@
+#ifndef PATH_BLOB_FORMAT_H_
+#define PATH_BLOB_FORMAT_H_
+
+// ------- pathBlobFormat.h ----------------------------------------------------
+//
+// Layout of the precomputed motion profile blob made by tools/pathGen. Shared
+// between the robot program (pathBlob.cpp) and the host tool, so it must not
+// include any PROS headers.
+//
+// Layout, all little endian:
+//   PathBlobHeader
+//   PathBlobEntry[pathCount]          directory, one entry per path
+//   per path: Segment left[length], Segment right[length]
+//
+// Segments are pathfinder's Segment as AsyncMotionProfileController keeps
+// them, already split into left and right by the tank modifier.
+
+#include "okapi/pathfinder/include/pathfinder/structs.h"
+
+#include <cstdint>
+
+#define PATH_BLOB_MAGIC 0x42485450    // 'PTHB' little endian
+#define PATH_BLOB_VERSION 1
+#define PATH_BLOB_ID_SIZE 24          // path ids including the terminating 0
+
+struct PathBlobHeader {
+  std::uint32_t magic;
+  std::uint16_t version;
+  std::uint16_t pathCount;
+  std::uint32_t segmentSize;          // sizeof(Segment) of the generator, checked on load
+  float wheelTrack;                   // m, used by the tank modifier
+};
+
+struct PathBlobEntry {
+  char id[PATH_BLOB_ID_SIZE];
+  std::uint32_t offset;               // from the start of the blob to the left segments
+  std::int32_t length;                // segments per side
+};
+
+static_assert(sizeof(PathBlobHeader) == 16, "PathBlobHeader layout changed");
+static_assert(sizeof(PathBlobEntry) == 32, "PathBlobEntry layout changed");
+static_assert(sizeof(Segment) == 64, "pathfinder Segment layout changed");
+
+#endif
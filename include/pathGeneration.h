@@ -0,0 +1,102 @@
+#ifndef PATH_GENERATION_H_
+#define PATH_GENERATION_H_
+
+// ------- pathGeneration.h ----------------------------------------------------
+//
+// Tank drive motion profile generation with pathfinder, the same steps and
+// settings AsyncMotionProfileController::generatePath() uses. Shared by the
+// background generator in MotionProfileController and by tools/pathGen on the
+// PC, so it must not include any PROS headers.
+//
+// PathGenerator::curvature replaces pathfinder_generate() with a time optimal
+// profile along the same splines: every point gets its own velocity limit
+// from the curvature, so the outer wheel stays under the maximum velocity and
+// the sideways acceleration under the maximum acceleration, and a forward /
+// backward pass fits the acceleration limit in between. Straights run at full
+// speed and only the curves slow down. It does not limit jerk.
+//
+// With isamples PATH_SAMPLES_QUADRATURE (the default) both generators measure
+// the splines with SplineArcLength instead of pathfinder's brute force
+// sampling; any other isamples samples like pathfinder does.
+
+extern "C" {
+#include "okapi/pathfinder/include/pathfinder.h"
+}
+
+#include <vector>
+
+#define PATH_GENERATION_DT 0.010      // s between two segments, the same as generatePath()
+#define PATH_CURVATURE_STEP 0.005     // m between two points of the curvature generator
+#define PATH_SAMPLES_QUADRATURE 0     // isamples: arc length by quadrature, see splineArcLength.h
+
+enum class PathGenerator {
+  pathfinder,                         // pathfinder_generate(), one limit for the whole path
+  curvature                           // per point limits from the curvature, see above
+};
+
+class PathGeneration {
+  public:
+  /**
+   * Generates the left and right wheel trajectories of a path.
+   *
+   * @param iwaypoints The waypoints, x / y in m and the exit angle in radians.
+   * @param imaxVel The maximum velocity in m/s.
+   * @param imaxAccel The maximum acceleration in m/s^2.
+   * @param imaxJerk The maximum jerk in m/s^3.
+   * @param itrack The wheel track in m.
+   * @param oleft Receives the left wheel segments.
+   * @param oright Receives the right wheel segments.
+   * @param isamples Spline samples for the arc length like pathfinder, fewer is faster and less
+   * exact, or PATH_SAMPLES_QUADRATURE.
+   * @param igenerator The velocity profile generator.
+   * @return The number of segments per side, -1 if the path is impossible.
+   */
+  static int tank(const std::vector<Waypoint> &iwaypoints,
+                  double imaxVel,
+                  double imaxAccel,
+                  double imaxJerk,
+                  double itrack,
+                  std::vector<Segment> &oleft,
+                  std::vector<Segment> &oright,
+                  int isamples = PATH_SAMPLES_QUADRATURE,
+                  PathGenerator igenerator = PathGenerator::pathfinder);
+
+  /**
+   * Generates the center trajectory of a path with the curvature generator.
+   *
+   * @param iwaypoints The waypoints, x / y in m and the exit angle in radians.
+   * @param imaxVel The maximum wheel velocity in m/s.
+   * @param imaxAccel The maximum acceleration in m/s^2, forward and sideways.
+   * @param itrack The wheel track in m.
+   * @param isamples Spline samples for the arc length, or PATH_SAMPLES_QUADRATURE.
+   * @param otrajectory Receives the segments, PATH_GENERATION_DT apart.
+   * @return The number of segments, -1 if the path is impossible.
+   */
+  static int curvatureLimited(const std::vector<Waypoint> &iwaypoints,
+                              double imaxVel,
+                              double imaxAccel,
+                              double itrack,
+                              int isamples,
+                              std::vector<Segment> &otrajectory);
+
+  /**
+   * Turns field waypoints into the waypoints of a path which starts at the robot. The pose and
+   * the field waypoints are in okapi's odometry frame (x forward, y right, angles clockwise), the
+   * path is in pathfinder's frame relative to the robot (x forward, y left, angles
+   * counterclockwise) and starts with the robot itself.
+   *
+   * @param ix The robot's x in m.
+   * @param iy The robot's y in m.
+   * @param itheta The robot's heading in radians.
+   * @param ifield The field waypoints, x / y in m and the heading in radians.
+   * @return The path waypoints.
+   */
+  static std::vector<Waypoint>
+  fromPose(double ix, double iy, double itheta, const std::vector<Waypoint> &ifield);
+
+  private:
+  PathGeneration();
+  ~PathGeneration();
+};
+
+#endif
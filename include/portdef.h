@@ -14,6 +14,9 @@
 
 // ----------- Radio and Controllers ---------------
 #define VEX_RADIO 21
+#define TELEMETRY_PORT 0          // telemetry to the RPI Zero W radio: 0 = /ser/sout over USB,
+                                  // 1 - 21 = smart port in generic serial mode (RS-485 to the
+                                  // Pi's UART), which keeps std::cout text out of the stream
 
 // ------------ Vision Sensors ---------------------
 #define VISION_PORT 14
@@ -0,0 +1,146 @@
+#ifndef POSE_HISTORY_H_
+#define POSE_HISTORY_H_
+
+// ------- poseHistory.h -------------------------------------------------------
+//
+// Fixed size history of timestamped odometry poses, so a vision detection or a
+// log entry can be matched with where the robot was when it happened rather
+// than where it is now.
+//
+// One writer (the odometry task) and any number of readers. Every slot is its
+// own SeqLock and remembers which write it holds, so a reader never waits for
+// the writer: if the writer overwrites a slot while a reader is searching, the
+// reader notices and starts the search again.
+//
+// Only ONE task may call push() at a time. Timestamps must not go backwards.
+
+#include "odomArcMath.h"
+#include "seqLock.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * One pose in the history.
+ */
+struct PoseHistoryEntry {
+  std::uint32_t index{0};             // which write this is, used to spot overwritten slots
+  std::uint32_t timestamp{0};         // ms
+  OdomPose pose;
+};
+
+template <std::size_t capacity> class PoseHistory {
+  static_assert(capacity >= 4 && (capacity & (capacity - 1)) == 0,
+                "PoseHistory capacity must be a power of two");
+
+  public:
+  /**
+   * Adds a pose, overwriting the oldest one when the history is full. Never blocks.
+   *
+   * @param itimestamp When the pose was measured in ms, not older than the last push.
+   * @param ipose The pose.
+   */
+  void push(std::uint32_t itimestamp, const OdomPose &ipose) {
+    const std::uint32_t index = count.load(std::memory_order_relaxed);
+    slots[index & (capacity - 1)].write(PoseHistoryEntry{index, itimestamp, ipose});
+    count.store(index + 1, std::memory_order_release);
+  }
+
+  /**
+   * Finds the pose at a point in time, linearly interpolated between the two
+   * samples either side of it. Never blocks. O(log capacity).
+   *
+   * Times newer than the last sample return the last sample. Times older than
+   * the history return the oldest sample kept.
+   *
+   * @param itimestamp The time in ms.
+   * @param out The pose at that time.
+   * @return false if the history is empty or itimestamp is older than the history.
+   */
+  bool getPoseAt(std::uint32_t itimestamp, OdomPose &out) const {
+    while (true) {
+      const std::uint32_t written = count.load(std::memory_order_acquire);
+      if (written == 0) {
+        return false;
+      }
+
+      // keep one slot clear of the oldest, the writer may be replacing it right now
+      std::uint32_t lo = written > capacity ? written - capacity + 1 : 0;
+      std::uint32_t hi = written - 1;
+
+      PoseHistoryEntry newest, oldest;
+      if (!readSlot(hi, newest) || !readSlot(lo, oldest)) {
+        continue;
+      }
+      if (itimestamp >= newest.timestamp) {
+        out = newest.pose;
+        return true;
+      }
+      if (itimestamp < oldest.timestamp) {
+        out = oldest.pose;
+        return false;
+      }
+
+      // oldest.timestamp <= itimestamp < newest.timestamp
+      bool overwritten = false;
+      while (hi - lo > 1) {
+        const std::uint32_t mid = lo + (hi - lo) / 2;
+        PoseHistoryEntry entry;
+        if (!readSlot(mid, entry)) {
+          overwritten = true;
+          break;
+        }
+        if (entry.timestamp <= itimestamp) {
+          lo = mid;
+          oldest = entry;
+        } else {
+          hi = mid;
+          newest = entry;
+        }
+      }
+      if (overwritten) {
+        continue;
+      }
+
+      out = interpolate(oldest, newest, itimestamp);
+      return true;
+    }
+  }
+
+  /**
+   * @return The number of poses currently kept.
+   */
+  std::size_t size() const {
+    const std::uint32_t written = count.load(std::memory_order_acquire);
+    return written > capacity ? capacity : written;
+  }
+
+  protected:
+  SeqLock<PoseHistoryEntry> slots[capacity];
+  std::atomic<std::uint32_t> count{0};
+
+  /**
+   * Reads the slot holding write number iindex.
+   *
+   * @return false if the slot was overwritten by a newer write.
+   */
+  bool readSlot(std::uint32_t iindex, PoseHistoryEntry &out) const {
+    out = slots[iindex & (capacity - 1)].read();
+    return out.index == iindex;
+  }
+
+  static OdomPose
+  interpolate(const PoseHistoryEntry &ia, const PoseHistoryEntry &ib, std::uint32_t itimestamp) {
+    if (ib.timestamp == ia.timestamp) {
+      return ib.pose;
+    }
+    // theta is not wrapped by the odometry, so it can be interpolated directly
+    const double t = static_cast<double>(itimestamp - ia.timestamp) / (ib.timestamp - ia.timestamp);
+    return OdomPose{ia.pose.x + (ib.pose.x - ia.pose.x) * t,
+                    ia.pose.y + (ib.pose.y - ia.pose.y) * t,
+                    ia.pose.theta + (ib.pose.theta - ia.pose.theta) * t};
+  }
+};
+
+#endif
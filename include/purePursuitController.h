@@ -0,0 +1,146 @@
+#ifndef PURE_PURSUIT_CONTROLLER_H_
+#define PURE_PURSUIT_CONTROLLER_H_
+
+// ------- purePursuitController.h ---------------------------------------------
+//
+// Adaptive pure pursuit path follower for an OdomChassisController.
+//
+// driveToPoint() turns on the spot, then drives, and stops at every waypoint.
+// The follower instead steers continuously along a prepared path (see
+// pursuitPath.h): every cycle it picks the point one lookahead distance ahead
+// on the path, drives the arc that reaches it and sets the wheel speeds from
+// the arc curvature. The lookahead grows with the speed, so the robot cuts
+// corners less at low speed and does not weave at high speed.
+//
+// Uses the chassis' odometry for the pose and drives the side motors of its
+// model (skid steer, X drive or H drive) with velocity control, in rpm; the
+// chassis controller must not be given another target while following. A
+// path ends when its end is reached, when it times out, or when stop() is
+// called from another task.
+
+#include "pursuitPath.h"
+
+#include "okapi/api/chassis/controller/odomChassisController.hpp"
+#include "okapi/api/device/motor/abstractMotor.hpp"
+#include "okapi/api/units/QLength.hpp"
+#include "okapi/api/units/QTime.hpp"
+#include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/timeUtil.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#define PURE_PURSUIT_PERIOD (10 * okapi::millisecond) // control loop period
+#define PURE_PURSUIT_TIMEOUT (15 * okapi::second)     // default time limit of a path
+
+class PurePursuitController {
+  public:
+  /**
+   * A pure pursuit follower which drives the chassis along prepared paths.
+   *
+   * @param itimeUtil The TimeUtil.
+   * @param ichassis The chassis to drive, its odometry is used for the pose.
+   * @param ilookaheadMin The lookahead distance when standing still.
+   * @param ilookaheadMax The largest lookahead distance.
+   * @param ilookaheadGain How much the lookahead grows with the speed, lookahead = min + gain * v.
+   * @param isettleDistance The robot is done when it is this close to the end of the path.
+   * @param ilogger The logger this instance will log to.
+   */
+  PurePursuitController(const okapi::TimeUtil &itimeUtil,
+                        const std::shared_ptr<okapi::OdomChassisController> &ichassis,
+                        const okapi::QLength &ilookaheadMin = 0.25 * okapi::meter,
+                        const okapi::QLength &ilookaheadMax = 0.6 * okapi::meter,
+                        const okapi::QTime &ilookaheadGain = 0.3 * okapi::second,
+                        const okapi::QLength &isettleDistance = 0.03 * okapi::meter,
+                        const std::shared_ptr<okapi::Logger> &ilogger =
+                          okapi::Logger::getDefaultLogger());
+
+  /**
+   * Prepares a path through the waypoints and drives along it. Blocks until the end is reached,
+   * the time is up or stop() is called. The path speed is capped at the chassis' maximum
+   * velocity.
+   *
+   * @param iwaypoints The waypoints, normally starting at the robot's current position.
+   * @param ilimits The path speed limits.
+   * @param imode The StateMode the waypoints are given in.
+   * @param itimeout The longest the robot may take to the end.
+   * @return Whether the end of the path was reached.
+   */
+  bool followPath(const std::vector<okapi::Point> &iwaypoints,
+                  const PursuitPathLimits &ilimits,
+                  const okapi::StateMode &imode = okapi::StateMode::FRAME_TRANSFORMATION,
+                  const okapi::QTime &itimeout = PURE_PURSUIT_TIMEOUT);
+
+  /**
+   * Drives along an already prepared path. Blocks until the end is reached, the time is up or
+   * stop() is called.
+   *
+   * @param ipath The path, see PursuitPath::generate().
+   * @param itimeout The longest the robot may take to the end.
+   * @return Whether the end of the path was reached.
+   */
+  bool followPath(const std::vector<PursuitPoint> &ipath,
+                  const okapi::QTime &itimeout = PURE_PURSUIT_TIMEOUT);
+
+  /**
+   * Ends the path being followed on another task and stops the chassis. Does nothing if no path
+   * is being followed.
+   */
+  void stop();
+
+  /**
+   * @return The fastest the chassis can drive at its current maximum velocity, in m/s.
+   */
+  double getMaxSpeed() const;
+
+  protected:
+  std::shared_ptr<okapi::Logger> logger;
+  std::unique_ptr<okapi::AbstractTimer> timer;
+  std::unique_ptr<okapi::AbstractRate> rate;
+  std::shared_ptr<okapi::OdomChassisController> chassis;
+  const double lookaheadMin;
+  const double lookaheadMax;
+  const double lookaheadGain;
+  const double settleDistance;
+  std::vector<std::shared_ptr<okapi::AbstractMotor>> leftMotors;
+  std::vector<std::shared_ptr<okapi::AbstractMotor>> rightMotors;
+  std::atomic_bool following{false};
+  std::atomic_bool stopRequested{false};
+
+  // follow state, only valid during followPath()
+  std::size_t closestIndex{0};
+  double lookaheadIndex{0};           // fractional: segment index + position along it
+  double lookaheadX{0};
+  double lookaheadY{0};
+
+  /**
+   * Moves closestIndex to the path point nearest to the robot, only searching forwards.
+   */
+  void updateClosest(const std::vector<PursuitPoint> &ipath, double ix, double iy);
+
+  /**
+   * Moves the lookahead point to where the lookahead circle around the robot crosses the path,
+   * only searching forwards. Keeps the previous point if the circle does not cross the path.
+   */
+  void updateLookahead(const std::vector<PursuitPoint> &ipath,
+                       double ix,
+                       double iy,
+                       double ilookahead);
+
+  /**
+   * Sets the velocity of the side motors, both scaled down if one is faster than the chassis'
+   * maximum velocity, so the ratio that steers is kept.
+   *
+   * @param ileftRpm The left motor rpm.
+   * @param irightRpm The right motor rpm.
+   */
+  void moveSides(double ileftRpm, double irightRpm);
+
+  /**
+   * @return The motor rpm for a wheel speed of one m/s.
+   */
+  double rpmPerMeterPerSecond() const;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef PURSUIT_PATH_H_
+#define PURSUIT_PATH_H_
+
+// ------- pursuitPath.h -------------------------------------------------------
+//
+// Path preparation for the pure pursuit follower (purePursuitController.h).
+// A polyline of waypoints is filled in with evenly spaced points, smoothed
+// into a curve, and every point gets the distance along the path, the path
+// curvature and the speed the robot should have there: slower in tight
+// curves and ramping down to a stop at the end.
+//
+// Does no I/O and uses no PROS calls, so paths can be prepared on a PC too.
+
+#include "okapi/api/odometry/point.hpp"
+#include "okapi/api/odometry/stateMode.hpp"
+
+#include <vector>
+
+/**
+ * One point of a prepared path, in meters / seconds and FRAME_TRANSFORMATION
+ * coordinates (x forward, y right).
+ */
+struct PursuitPoint {
+  double x{0};
+  double y{0};
+  double distance{0};                 // m along the path from the first point
+  double curvature{0};                // 1/m, always positive
+  double velocity{0};                 // m/s target speed at this point
+};
+
+/**
+ * Limits used when preparing a path.
+ */
+struct PursuitPathLimits {
+  double maxVelocity{1.0};            // m/s
+  double maxAcceleration{1.5};        // m/s^2
+  double turnConstant{2.0};           // curve speed is limited to turnConstant / curvature
+  double spacing{0.05};               // m between two path points
+  double smoothing{0.8};              // 0 = keep straight segments, towards 1 = rounder corners
+};
+
+class PursuitPath {
+  public:
+  /**
+   * Prepares a path through the waypoints.
+   *
+   * @param iwaypoints The waypoints to go through, starting with the first one.
+   * @param ilimits The speed limits and point spacing.
+   * @param imode The StateMode the waypoints are given in.
+   * @return The prepared path, empty if there were fewer than two waypoints.
+   */
+  static std::vector<PursuitPoint>
+  generate(const std::vector<okapi::Point> &iwaypoints,
+           const PursuitPathLimits &ilimits,
+           const okapi::StateMode &imode = okapi::StateMode::FRAME_TRANSFORMATION);
+
+  /**
+   * Fills in distance, curvature and velocity for points which only have x and y set.
+   *
+   * @param ipoints The path points, updated in place.
+   * @param ilimits The speed limits.
+   */
+  static void computeProfile(std::vector<PursuitPoint> &ipoints, const PursuitPathLimits &ilimits);
+
+  private:
+  PursuitPath();
+  ~PursuitPath();
+
+  static void injectPoints(std::vector<PursuitPoint> &ipoints,
+                           const std::vector<okapi::Point> &iwaypoints,
+                           double ispacing,
+                           const okapi::StateMode &imode);
+
+  static void smooth(std::vector<PursuitPoint> &ipoints, double ismoothing);
+};
+
+#endif
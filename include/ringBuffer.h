@@ -0,0 +1,93 @@
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+// ------- ringBuffer.h --------------------------------------------------------
+//
+// Fixed capacity single producer / single consumer ring buffer. All storage is
+// allocated up front (inside the object) so pushing and popping never touches
+// the heap and never blocks - the producer (for example the drive task) and the
+// consumer (for example a low priority writer task) only share two atomic
+// indices.
+//
+// Only ONE task may push and only ONE task may pop at any time.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+template <typename T, std::size_t capacity> class RingBuffer {
+  static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0,
+                "RingBuffer capacity must be a power of two");
+
+  public:
+  /**
+   * Adds an item to the buffer. Never blocks.
+   *
+   * @param item The item to copy into the buffer.
+   * @return true if the item was stored, false if the buffer was full.
+   */
+  bool push(const T &item) {
+    const std::size_t currentHead = head.load(std::memory_order_relaxed);
+    if (currentHead - tail.load(std::memory_order_acquire) >= capacity) {
+      return false;
+    }
+    data[currentHead & (capacity - 1)] = item;
+    head.store(currentHead + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the oldest item from the buffer. Never blocks.
+   *
+   * @param item Where to copy the removed item.
+   * @return true if an item was removed, false if the buffer was empty.
+   */
+  bool pop(T &item) {
+    const std::size_t currentTail = tail.load(std::memory_order_relaxed);
+    if (currentTail == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = data[currentTail & (capacity - 1)];
+    tail.store(currentTail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes up to imax of the oldest items in one go, which lets the consumer
+   * write them out as one large block.
+   *
+   * @param out Destination array, must hold at least imax items.
+   * @param imax The maximum number of items to remove.
+   * @return The number of items removed.
+   */
+  std::size_t popBlock(T *out, std::size_t imax) {
+    const std::size_t currentTail = tail.load(std::memory_order_relaxed);
+    std::size_t count = head.load(std::memory_order_acquire) - currentTail;
+    if (count > imax) {
+      count = imax;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+      out[i] = data[(currentTail + i) & (capacity - 1)];
+    }
+    tail.store(currentTail + count, std::memory_order_release);
+    return count;
+  }
+
+  /**
+   * @return The number of items waiting to be popped.
+   */
+  std::size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  protected:
+  std::array<T, capacity> data{};
+  std::atomic<std::size_t> head{0}; // next slot to write, only changed by the producer
+  std::atomic<std::size_t> tail{0}; // next slot to read, only changed by the consumer
+};
+
+#endif
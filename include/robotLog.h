@@ -0,0 +1,111 @@
+#ifndef ROBOT_LOG_H_
+#define ROBOT_LOG_H_
+
+// ------- robotLog.h ----------------------------------------------------------
+//
+// Compile-time log levels and structured (deferred format) logging for the
+// project code.
+//
+// ROBOT_LOG_LEVEL is set from the Makefile (LOG_LEVEL=...) and uses the
+// okapi::Logger::LogLevel numbers: 4 debug, 3 info, 2 warn, 1 error, 0 off.
+// Log statements more verbose than ROBOT_LOG_LEVEL compile to nothing - their
+// arguments are not even evaluated.
+//
+// Structured logging:
+//   ROBOT_LOG_DEBUG("odom dt {} ticks {} {}", dtMs, left, right);
+// only copies the format pointer and the arguments into the calling task's
+// async log queue (see asyncLogSink.h); the writer task builds the text. The
+// format and any const char * arguments MUST be string literals.
+//
+// It also turns okapi's LOG_DEBUG/LOG_INFO/... macros into no-ops for disabled
+// levels in the project code (main.h includes this header). OkapiLib's own
+// classes are prebuilt in firmware/okapilib.a and keep their runtime level.
+
+#include "asyncLogSink.h"
+#include "okapi/api/util/logging.hpp"
+
+#include <type_traits>
+
+#ifndef ROBOT_LOG_LEVEL
+#define ROBOT_LOG_LEVEL 3             // info, warnings and errors
+#endif
+
+#define ROBOT_LOG_LEVEL_DEBUG 4
+#define ROBOT_LOG_LEVEL_INFO 3
+#define ROBOT_LOG_LEVEL_WARN 2
+#define ROBOT_LOG_LEVEL_ERROR 1
+
+template <typename T> AsyncLogArg robotLogArg(T ivalue) {
+  AsyncLogArg arg;
+  if constexpr (std::is_floating_point_v<T>) {
+    arg.type = AsyncLogArg::real;
+    arg.d = static_cast<double>(ivalue);
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    arg.type = AsyncLogArg::integer;
+    arg.i = static_cast<long long>(ivalue);
+  } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+    arg.type = AsyncLogArg::unsignedInteger;
+    arg.u = static_cast<unsigned long long>(ivalue);
+  } else {
+    static_assert(std::is_convertible_v<T, const char *>,
+                  "structured log arguments must be numbers or string literals");
+    arg.type = AsyncLogArg::literal;
+    arg.s = ivalue;
+  }
+  return arg;
+}
+
+/**
+ * Queues a structured log record. Use the ROBOT_LOG_* macros instead of calling
+ * this directly so disabled levels are compiled out.
+ *
+ * @param ilevel The okapi::Logger::LogLevel value of the record.
+ * @param iformat String literal, each "{}" is replaced with the next argument.
+ * @param iargs Numbers or string literals.
+ */
+template <typename... Args>
+inline void robotLogWrite(std::uint8_t ilevel, const char *iformat, Args... iargs) {
+  static_assert(sizeof...(Args) <= ASYNC_LOG_MAX_ARGS, "too many structured log arguments");
+  AsyncLogRecord record;
+  record.level = ilevel;
+  record.argc = static_cast<std::uint8_t>(sizeof...(Args));
+  record.format = iformat;
+  std::uint8_t i = 0;
+  ((record.args[i++] = robotLogArg(iargs)), ...);
+  (void)i;
+  asyncLogSinkPush(record);
+}
+
+#if ROBOT_LOG_LEVEL >= ROBOT_LOG_LEVEL_DEBUG
+#define ROBOT_LOG_DEBUG(...) robotLogWrite(ROBOT_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define ROBOT_LOG_DEBUG(...) ((void)0)
+#undef LOG_DEBUG
+#define LOG_DEBUG(msg) ((void)0)
+#endif
+
+#if ROBOT_LOG_LEVEL >= ROBOT_LOG_LEVEL_INFO
+#define ROBOT_LOG_INFO(...) robotLogWrite(ROBOT_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define ROBOT_LOG_INFO(...) ((void)0)
+#undef LOG_INFO
+#define LOG_INFO(msg) ((void)0)
+#endif
+
+#if ROBOT_LOG_LEVEL >= ROBOT_LOG_LEVEL_WARN
+#define ROBOT_LOG_WARN(...) robotLogWrite(ROBOT_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define ROBOT_LOG_WARN(...) ((void)0)
+#undef LOG_WARN
+#define LOG_WARN(msg) ((void)0)
+#endif
+
+#if ROBOT_LOG_LEVEL >= ROBOT_LOG_LEVEL_ERROR
+#define ROBOT_LOG_ERROR(...) robotLogWrite(ROBOT_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define ROBOT_LOG_ERROR(...) ((void)0)
+#undef LOG_ERROR
+#define LOG_ERROR(msg) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef RUNNING_AVERAGE_FILTER_H_
+#define RUNNING_AVERAGE_FILTER_H_
+
+// ------- runningAverageFilter.h ----------------------------------------------
+//
+// Drop-in replacement for okapi::AverageFilter<n>. okapi adds up all n samples
+// on every reading; this keeps a running sum instead, one add and one subtract
+// per reading whatever n is. Rounding errors of the running sum would add up
+// forever, so the sum is added up from the samples again every
+// RUNNING_AVERAGE_RESUM_WRAPS times round the window, on average one more
+// addition per RUNNING_AVERAGE_RESUM_WRAPS readings. The output matches
+// okapi's to rounding, within a few ulp of the largest sample.
+//
+// Like okapi's filter the window starts full of zeros.
+
+#include "okapi/api/filter/filter.hpp"
+
+#include <array>
+#include <cstddef>
+
+#define RUNNING_AVERAGE_RESUM_WRAPS 16 // windows between two exact sums
+
+template <std::size_t n> class RunningAverageFilter : public okapi::Filter {
+  static_assert(n > 0, "RunningAverageFilter needs at least one sample");
+
+  public:
+  /**
+   * Averaging filter.
+   */
+  RunningAverageFilter() = default;
+
+  /**
+   * Filters a value, like a sensor reading.
+   *
+   * @param ireading new measurement
+   * @return filtered result
+   */
+  double filter(const double ireading) override {
+    sum += ireading - data[index];
+    data[index++] = ireading;
+
+    if (index >= n) {
+      index = 0;
+      if (++wraps >= RUNNING_AVERAGE_RESUM_WRAPS) {
+        wraps = 0;
+        sum = 0;
+        for (std::size_t i = 0; i < n; i++) {
+          sum += data[i];
+        }
+      }
+    }
+
+    output = sum / static_cast<double>(n);
+    return output;
+  }
+
+  /**
+   * Returns the previous output from filter.
+   *
+   * @return the previous output from filter
+   */
+  double getOutput() const override {
+    return output;
+  }
+
+  protected:
+  std::array<double, n> data{};
+  std::size_t index{0};
+  std::size_t wraps{0};
+  double sum{0};
+  double output{0};
+};
+
+#endif
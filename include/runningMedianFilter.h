@@ -0,0 +1,177 @@
+#ifndef RUNNING_MEDIAN_FILTER_H_
+#define RUNNING_MEDIAN_FILTER_H_
+
+// ------- runningMedianFilter.h -----------------------------------------------
+//
+// Drop-in replacement for okapi::MedianFilter<n>. okapi copies the window and
+// runs a quickselect on every reading, O(n); this keeps the window in two
+// heaps around the median (the double heap "mediator" of a sliding median),
+// a max heap of the samples below it and a min heap of those above. A new
+// reading replaces the oldest sample where that sample is in the heaps and
+// sifts up or down from there, O(log n), with fixed size arrays and no
+// allocation.
+//
+// The result is bit for bit okapi's: for an even n the lower of the two middle
+// samples, and the window starts full of zeros.
+//
+// Heap positions are -belowCount .. aboveCount with the median at 0. The
+// children of position i are 2i and 2i + 1 above the median and 2i and
+// 2i - 1 below it, the parent is i / 2 on both sides.
+
+#include "okapi/api/filter/filter.hpp"
+
+#include <array>
+#include <cstddef>
+
+template <std::size_t n> class RunningMedianFilter : public okapi::Filter {
+  static_assert(n > 0, "RunningMedianFilter needs at least one sample");
+
+  public:
+  RunningMedianFilter() {
+    // every sample is 0, so any arrangement is a valid heap: alternate the
+    // samples above and below the median
+    for (int k = 0; k < count; k++) {
+      position[k] = (k & 1) ? (k + 1) / 2 : -(k / 2);
+      heapAt(position[k]) = k;
+    }
+  }
+
+  /**
+   * Filters a value, like a sensor reading.
+   *
+   * @param ireading new measurement
+   * @return filtered result
+   */
+  double filter(const double ireading) override {
+    const int p = position[index];
+    const double old = data[index];
+    data[index++] = ireading;
+    if (index >= count) {
+      index = 0;
+    }
+
+    if (p > 0) {
+      // above the median: a larger sample can only sink in the min heap, a
+      // smaller one can only rise, possibly into the median
+      if (old < ireading) {
+        minSortDown(p * 2);
+      } else if (minSortUp(p)) {
+        maxSortDown(-1);
+      }
+    } else if (belowCount > 0 && p < 0) {
+      if (ireading < old) {
+        maxSortDown(p * 2);
+      } else if (maxSortUp(p)) {
+        minSortDown(1);
+      }
+    } else {
+      if (belowCount > 0) {
+        maxSortDown(-1);
+      }
+      if (aboveCount > 0) {
+        minSortDown(1);
+      }
+    }
+
+    output = data[heapAt(0)];
+    return output;
+  }
+
+  /**
+   * Returns the previous output from filter.
+   *
+   * @return the previous output from filter
+   */
+  double getOutput() const override {
+    return output;
+  }
+
+  protected:
+  static constexpr int count = static_cast<int>(n);
+  static constexpr int belowCount = (count - 1) / 2; // max heap
+  static constexpr int aboveCount = count / 2;       // min heap
+
+  std::array<double, n> data{};       // the window, oldest sample at index
+  std::array<int, n> position{};      // heap position of every sample
+  std::array<int, n> heap{};          // sample of every heap position, offset by belowCount
+  int index{0};
+  double output{0};
+
+  int &heapAt(const int i) {
+    return heap[i + belowCount];
+  }
+
+  /**
+   * @return Whether the sample at heap position i is less than the one at j.
+   */
+  bool less(const int i, const int j) {
+    return data[heapAt(i)] < data[heapAt(j)];
+  }
+
+  /**
+   * Swaps heap positions i and j if the sample at i is less than the one at j.
+   *
+   * @return Whether they were swapped.
+   */
+  bool exchangeIfLess(const int i, const int j) {
+    if (!less(i, j)) {
+      return false;
+    }
+    const int sample = heapAt(i);
+    heapAt(i) = heapAt(j);
+    heapAt(j) = sample;
+    position[heapAt(i)] = i;
+    position[heapAt(j)] = j;
+    return true;
+  }
+
+  /**
+   * Sifts down the min heap from position i, which is compared with its parent first.
+   */
+  void minSortDown(int i) {
+    for (; i <= aboveCount; i *= 2) {
+      if (i > 1 && i < aboveCount && less(i + 1, i)) {
+        i++;
+      }
+      if (!exchangeIfLess(i, i / 2)) {
+        break;
+      }
+    }
+  }
+
+  /**
+   * Sifts down the max heap from position i, which is compared with its parent first.
+   */
+  void maxSortDown(int i) {
+    for (; i >= -belowCount; i *= 2) {
+      if (i < -1 && i > -belowCount && less(i, i - 1)) {
+        i--;
+      }
+      if (!exchangeIfLess(i / 2, i)) {
+        break;
+      }
+    }
+  }
+
+  /**
+   * @return Whether the sample moved up to the median.
+   */
+  bool minSortUp(int i) {
+    while (i > 0 && exchangeIfLess(i, i / 2)) {
+      i /= 2;
+    }
+    return i == 0;
+  }
+
+  /**
+   * @return Whether the sample moved up to the median.
+   */
+  bool maxSortUp(int i) {
+    while (i < 0 && exchangeIfLess(i / 2, i)) {
+      i /= 2;
+    }
+    return i == 0;
+  }
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef SENSOR_SNAPSHOT_H_
+#define SENSOR_SNAPSHOT_H_
+
+// ------- sensorSnapshot.h ----------------------------------------------------
+//
+// Allocation free way of reading a chassis model's sensors.
+// okapi::ReadOnlyChassisModel::getSensorVals() returns a new std::valarray, so
+// every encoder read in the odometry loop is a heap allocation. Models which
+// also implement SensorSnapshotSource fill a fixed size SensorSnapshot owned by
+// the caller instead. The odometry classes use it when the model supports it
+// and fall back to the valarray version otherwise.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#define SENSOR_SNAPSHOT_CAPACITY 4    // largest sensor count of any chassis model
+
+/**
+ * Fixed capacity copy of a chassis model's sensor readings, in the same order
+ * getSensorVals() returns them.
+ */
+struct SensorSnapshot {
+  std::array<std::int32_t, SENSOR_SNAPSHOT_CAPACITY> vals{};
+  std::size_t count{0};
+
+  std::int32_t operator[](std::size_t i) const {
+    return vals[i];
+  }
+};
+
+class SensorSnapshotSource {
+  public:
+  virtual ~SensorSnapshotSource() = default;
+
+  /**
+   * Read the sensors without allocating.
+   *
+   * @param out Filled with the sensor readings, same format as getSensorVals().
+   */
+  virtual void getSensorVals(SensorSnapshot &out) const = 0;
+};
+
+#endif
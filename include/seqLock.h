@@ -0,0 +1,91 @@
+#ifndef SEQ_LOCK_H_
+#define SEQ_LOCK_H_
+
+// ------- seqLock.h -----------------------------------------------------------
+//
+// Sequence lock for publishing a small value from one writer task to any
+// number of reader tasks. Readers never block the writer: they copy the value
+// and retry if the writer changed it while they were copying. Used to publish
+// the odometry pose so getState() can never stall the integrator.
+//
+// T must be trivially copyable. Only ONE task may call write() at a time.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template <typename T> class SeqLock {
+  static_assert(std::is_trivially_copyable_v<T>, "SeqLock value must be trivially copyable");
+
+  public:
+  SeqLock() = default;
+
+  explicit SeqLock(const T &ivalue) {
+    store(ivalue);
+  }
+
+  /**
+   * Publishes a new value. Never blocks.
+   *
+   * @param ivalue The new value.
+   */
+  void write(const T &ivalue) {
+    const std::uint32_t start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed); // odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    store(ivalue);
+    sequence.store(start + 2, std::memory_order_release);
+  }
+
+  /**
+   * @return A consistent copy of the last published value.
+   */
+  T read() const {
+    T out;
+    std::uint32_t before, after;
+    do {
+      before = sequence.load(std::memory_order_acquire);
+      load(out);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    return out;
+  }
+
+  /**
+   * @return The number of values written so far, can be used to see if a new
+   * value was published since the last read.
+   */
+  std::uint32_t version() const {
+    return sequence.load(std::memory_order_acquire) / 2;
+  }
+
+  protected:
+  // the value is kept as relaxed atomic words so concurrent reads and writes are
+  // well defined; torn copies are caught by the sequence check
+  static constexpr std::size_t words =
+    (sizeof(T) + sizeof(std::uint32_t) - 1) / sizeof(std::uint32_t);
+
+  std::atomic<std::uint32_t> sequence{0};
+  std::atomic<std::uint32_t> data[words]{};
+
+  void store(const T &ivalue) {
+    std::uint32_t raw[words]{};
+    std::memcpy(raw, &ivalue, sizeof(T));
+    for (std::size_t i = 0; i < words; i++) {
+      data[i].store(raw[i], std::memory_order_relaxed);
+    }
+  }
+
+  void load(T &out) const {
+    std::uint32_t raw[words];
+    for (std::size_t i = 0; i < words; i++) {
+      raw[i] = data[i].load(std::memory_order_relaxed);
+    }
+    std::memcpy(&out, raw, sizeof(T));
+  }
+};
+
+#endif
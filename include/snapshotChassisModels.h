@@ -0,0 +1,76 @@
+#ifndef SNAPSHOT_CHASSIS_MODELS_H_
+#define SNAPSHOT_CHASSIS_MODELS_H_
+
+// ------- snapshotChassisModels.h ---------------------------------------------
+//
+// okapi's chassis models with the allocation free SensorSnapshotSource read
+// added. They are drop in replacements - same constructors, same behaviour -
+// for when the project's odometry is given a motor based model instead of the
+// tracking wheel model.
+
+#include "sensorSnapshot.h"
+
+#include "okapi/api/chassis/model/hDriveModel.hpp"
+#include "okapi/api/chassis/model/skidSteerModel.hpp"
+#include "okapi/api/chassis/model/threeEncoderSkidSteerModel.hpp"
+#include "okapi/api/chassis/model/threeEncoderXDriveModel.hpp"
+#include "okapi/api/chassis/model/xDriveModel.hpp"
+
+class SnapshotSkidSteerModel : public okapi::SkidSteerModel, public SensorSnapshotSource {
+  public:
+  using okapi::SkidSteerModel::SkidSteerModel;
+  using okapi::SkidSteerModel::getSensorVals;
+
+  /**
+   * @param out Filled with {left, right}.
+   */
+  void getSensorVals(SensorSnapshot &out) const override;
+};
+
+class SnapshotThreeEncoderSkidSteerModel : public okapi::ThreeEncoderSkidSteerModel,
+                                           public SensorSnapshotSource {
+  public:
+  using okapi::ThreeEncoderSkidSteerModel::ThreeEncoderSkidSteerModel;
+  using okapi::ThreeEncoderSkidSteerModel::getSensorVals;
+
+  /**
+   * @param out Filled with {left, right, middle}.
+   */
+  void getSensorVals(SensorSnapshot &out) const override;
+};
+
+class SnapshotXDriveModel : public okapi::XDriveModel, public SensorSnapshotSource {
+  public:
+  using okapi::XDriveModel::XDriveModel;
+  using okapi::XDriveModel::getSensorVals;
+
+  /**
+   * @param out Filled with {left, right}.
+   */
+  void getSensorVals(SensorSnapshot &out) const override;
+};
+
+class SnapshotThreeEncoderXDriveModel : public okapi::ThreeEncoderXDriveModel,
+                                        public SensorSnapshotSource {
+  public:
+  using okapi::ThreeEncoderXDriveModel::ThreeEncoderXDriveModel;
+  using okapi::ThreeEncoderXDriveModel::getSensorVals;
+
+  /**
+   * @param out Filled with {left, right, middle}.
+   */
+  void getSensorVals(SensorSnapshot &out) const override;
+};
+
+class SnapshotHDriveModel : public okapi::HDriveModel, public SensorSnapshotSource {
+  public:
+  using okapi::HDriveModel::HDriveModel;
+  using okapi::HDriveModel::getSensorVals;
+
+  /**
+   * @param out Filled with {left, right, middle}.
+   */
+  void getSensorVals(SensorSnapshot &out) const override;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SPLINE_ARC_LENGTH_H_
+#define SPLINE_ARC_LENGTH_H_
+
+// ------- splineArcLength.h ---------------------------------------------------
+//
+// Arc length of a pathfinder spline without brute force sampling.
+// pf_spline_distance() and pf_spline_progress_for_distance() add up
+// sample_count trapezoids per call, and pathfinder_generate() calls the second
+// one for every 10ms segment, so generating a path with 100000 samples costs
+// millions of square roots. SplineArcLength integrates the same arc length
+// with 5 point Gauss-Legendre quadrature into a small table once per spline,
+// and finds the progress for a distance with a binary search in the table and
+// a few Newton steps. Does not use PROS, so it also builds on a PC.
+
+extern "C" {
+#include "okapi/pathfinder/include/pathfinder/structs.h"
+}
+
+#include <array>
+
+#define ARC_LENGTH_INTERVALS 32       // table entries per spline
+#define ARC_LENGTH_NEWTON_STEPS 3     // refinement steps of progressForDistance()
+
+class SplineArcLength {
+  public:
+  /**
+   * Integrates the arc length of a spline.
+   *
+   * @param ispline The spline, as fitted by pf_fit_hermite_cubic() or _quintic().
+   */
+  explicit SplineArcLength(const Spline &ispline);
+
+  /**
+   * @return The arc length of the whole spline in m, what pf_spline_distance() returns.
+   */
+  double getLength() const;
+
+  /**
+   * Finds where along the spline an arc length is reached, like
+   * pf_spline_progress_for_distance().
+   *
+   * @param idistance The arc length from the start of the spline in m.
+   * @return The progress 0 .. 1 for pf_spline_coords() and pf_spline_angle().
+   */
+  double progressForDistance(double idistance) const;
+
+  protected:
+  Spline spline;
+  std::array<double, ARC_LENGTH_INTERVALS + 1> table{}; // arc length at progress i / INTERVALS
+
+  /**
+   * @return d(arc length) / d(progress) at a progress.
+   */
+  double integrand(double iprogress) const;
+
+  /**
+   * @return The arc length between two progress values.
+   */
+  double integrate(double ifrom, double ito) const;
+};
+
+#endif
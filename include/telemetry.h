@@ -0,0 +1,56 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+// ------- telemetry.h ---------------------------------------------------------
+//
+// Binary telemetry stream to the Raspberry Pi Zero W radio. A dedicated task
+// sends odometry, drive motor state and controller error frames (see
+// telemetryProtocol.h) at a configurable rate.
+//
+// With TELEMETRY_PORT (portdef.h) 0 the frames go over /ser/sout, the USB
+// link to the Pi; initialize() must have disabled COBS and the stream
+// prefixes for them to arrive intact, and the decoder skips the std::cout and
+// okapi log text in between. Any other TELEMETRY_PORT is a smart port in
+// generic serial mode, wired to the Pi's UART through an RS-485 transceiver,
+// which the frames have to themselves.
+
+#include <cstdint>
+#include <memory>
+
+namespace okapi {
+class OdomChassisController;
+}
+
+#define TELEMETRY_BAUDRATE 115200     // generic serial baud rate of a smart TELEMETRY_PORT
+#define TELEMETRY_MAX_CONTROLLERS 8   // controller ids 0 .. 7 for telemetryReportError()
+
+// controller ids the project's controllers report their errors with
+#define TELEMETRY_ID_PROFILE_LEFT 0   // MotionProfileController left wheel position error, m
+#define TELEMETRY_ID_PROFILE_RIGHT 1  // MotionProfileController right wheel position error, m
+#define TELEMETRY_ID_PROFILE_HEADING 2 // MotionProfileController heading error, radians
+#define TELEMETRY_ID_PURSUIT 3        // PurePursuitController distance from the path, m
+
+/**
+ * Starts the telemetry task. Does nothing if it is already running.
+ *
+ * @param ichassis The chassis whose odometry state is sent.
+ * @param iperiodMs Time between two rounds of frames in ms.
+ */
+void telemetryStart(const std::shared_ptr<okapi::OdomChassisController> &ichassis,
+                    std::uint32_t iperiodMs);
+
+/**
+ * Stops the telemetry task and waits for it to finish its current round.
+ */
+void telemetryStop();
+
+/**
+ * Reports the latest error of a controller. Safe to call from any task, it only
+ * stores the value; the telemetry task sends it with the next round.
+ *
+ * @param icontrollerId Id chosen by the caller, 0 .. TELEMETRY_MAX_CONTROLLERS - 1.
+ * @param ierror The controller error.
+ */
+void telemetryReportError(std::uint8_t icontrollerId, float ierror);
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef TELEMETRY_PROTOCOL_H_
+#define TELEMETRY_PROTOCOL_H_
+
+// ------- telemetryProtocol.h -------------------------------------------------
+//
+// Binary telemetry frames sent over /ser/sout or a smart port serial link to
+// the Raspberry Pi Zero W radio.
+// Shared by the robot code (telemetry.cpp) and the Linux decoder library in
+// tools/telemetryLink - only depends on the C++ standard library.
+//
+// Frame layout (all values little endian):
+//
+//   +------+------+---------+-----+-----+-------------+-------+
+//   | 0xA5 | 0x5A | channel | seq | len | payload ... | crc16 |
+//   +------+------+---------+-----+-----+-------------+-------+
+//
+// seq counts every frame sent (wraps at 255) so the receiver can detect lost
+// frames. crc16 is CRC-16/CCITT-FALSE over channel, seq, len and payload.
+// The decoder skips any bytes that are not part of a valid frame, so it
+// resyncs after log text on /ser/sout, line noise or a receiver started
+// mid-frame.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define TELEMETRY_SYNC_0 0xA5
+#define TELEMETRY_SYNC_1 0x5A
+#define TELEMETRY_HEADER_SIZE 5       // sync x2, channel, seq, len
+#define TELEMETRY_CRC_SIZE 2
+#define TELEMETRY_MAX_PAYLOAD 64
+#define TELEMETRY_MAX_FRAME (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE)
+
+#define TELEMETRY_MOTOR_COUNT 4       // drive base motors - LF, LB, RF, RB
+
+enum TelemetryChannel : std::uint8_t {
+  TELEMETRY_CHANNEL_ODOMETRY = 1,
+  TELEMETRY_CHANNEL_MOTOR_STATE = 2,
+  TELEMETRY_CHANNEL_CONTROLLER_ERROR = 3
+};
+
+struct TelemetryOdometry {
+  std::uint32_t timestamp;            // ms since system uptime
+  float x;                            // meters
+  float y;                            // meters
+  float theta;                        // degrees
+};
+
+struct TelemetryMotor {
+  std::int16_t velocity;              // RPM
+  std::int16_t current;               // mA
+  std::uint8_t temperature;           // degrees C
+  std::uint8_t flags;                 // reserved, 0
+};
+
+struct TelemetryMotorState {
+  std::uint32_t timestamp;
+  TelemetryMotor motors[TELEMETRY_MOTOR_COUNT];
+};
+
+struct TelemetryControllerError {
+  std::uint32_t timestamp;
+  std::uint8_t controllerId;          // see telemetryReportError()
+  std::uint8_t reserved[3];
+  float error;                        // controller error in the controller's units
+};
+
+static_assert(sizeof(TelemetryOdometry) == 16, "TelemetryOdometry layout changed");
+static_assert(sizeof(TelemetryMotorState) == 28, "TelemetryMotorState layout changed");
+static_assert(sizeof(TelemetryControllerError) == 12, "TelemetryControllerError layout changed");
+
+/**
+ * CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF).
+ */
+inline std::uint16_t telemetryCrc16(const std::uint8_t *data, std::size_t length,
+                                    std::uint16_t crc = 0xFFFF) {
+  for (std::size_t i = 0; i < length; i++) {
+    crc ^= static_cast<std::uint16_t>(data[i]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? static_cast<std::uint16_t>((crc << 1) ^ 0x1021)
+                           : static_cast<std::uint16_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * Builds one frame.
+ *
+ * @param out Destination, at least TELEMETRY_MAX_FRAME bytes.
+ * @param ichannel The channel of the payload.
+ * @param iseq The frame sequence number.
+ * @param ipayload The payload bytes.
+ * @param ilength The payload length, at most TELEMETRY_MAX_PAYLOAD.
+ * @return The number of bytes written to out.
+ */
+inline std::size_t telemetryEncodeFrame(std::uint8_t *out, std::uint8_t ichannel,
+                                        std::uint8_t iseq, const void *ipayload,
+                                        std::size_t ilength) {
+  out[0] = TELEMETRY_SYNC_0;
+  out[1] = TELEMETRY_SYNC_1;
+  out[2] = ichannel;
+  out[3] = iseq;
+  out[4] = static_cast<std::uint8_t>(ilength);
+  std::memcpy(out + TELEMETRY_HEADER_SIZE, ipayload, ilength);
+
+  const std::uint16_t crc = telemetryCrc16(out + 2, 3 + ilength);
+  out[TELEMETRY_HEADER_SIZE + ilength] = static_cast<std::uint8_t>(crc & 0xFF);
+  out[TELEMETRY_HEADER_SIZE + ilength + 1] = static_cast<std::uint8_t>(crc >> 8);
+
+  return TELEMETRY_HEADER_SIZE + ilength + TELEMETRY_CRC_SIZE;
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef TIMESTAMPED_VEL_MATH_H_
+#define TIMESTAMPED_VEL_MATH_H_
+
+// ------- timestampedVelMath.h ------------------------------------------------
+//
+// okapi::VelMath which divides by the time between two encoder readings as the
+// motor stamped them (AbstractMotor::getRawPosition()) instead of the time
+// between two calls of step(). A V5 motor sends a new position every 10ms; the
+// task calling step() wakes a few ms early or late, so okapi's VelMath divides
+// a 10ms movement by 8 or 13ms (or a 0ms movement by 10ms when it reads the
+// same packet twice) and the scheduling jitter becomes velocity noise, which
+// then needs a heavier filter and more lag to hide. Here a reading whose
+// timestamp has not changed is skipped, and the velocity is the movement
+// between two device samples over their device time difference.
+//
+// step() differentiates the position from the same motor reading as the
+// timestamp, converted to the motor's encoder units, so the position it is
+// handed (read a moment earlier, possibly from an older packet) is only used
+// without a motor, or when the reading fails; then it is okapi's VelMath. It plugs into IterativeVelPIDController like okapi's:
+//
+//   auto velMath = std::make_unique<TimestampedVelMath>(okapi::imev5GreenTPR,
+//     std::make_unique<okapi::PassthroughFilter>(), 0_ms,
+//     okapi::TimeUtilFactory::createDefault().getTimer(), motor);
+
+#include "okapi/api/device/motor/abstractMotor.hpp"
+#include "okapi/api/filter/velMath.hpp"
+
+#include <cstdint>
+#include <memory>
+
+class TimestampedVelMath : public okapi::VelMath {
+  public:
+  /**
+   * Velocity math helper. Calculates filtered velocity. Throws a `std::invalid_argument` exception
+   * if `iticksPerRev` is zero.
+   *
+   * @param iticksPerRev The number of ticks per revolution (or whatever units you are using).
+   * @param ifilter The filter used for filtering the calculated velocity.
+   * @param isampleTime The minimum time between velocity measurements, in device time.
+   * @param iloopDtTimer The timer used when there is no device timestamp.
+   * @param imotor The motor whose reading step() gets, for its timestamps. nullptr to only use
+   * stepAt() with timestamps from elsewhere.
+   * @param ilogger The logger this instance will log to.
+   */
+  TimestampedVelMath(double iticksPerRev,
+                     std::unique_ptr<okapi::Filter> ifilter,
+                     okapi::QTime isampleTime,
+                     std::unique_ptr<okapi::AbstractTimer> iloopDtTimer,
+                     std::shared_ptr<okapi::AbstractMotor> imotor = nullptr,
+                     std::shared_ptr<okapi::Logger> ilogger = okapi::Logger::getDefaultLogger());
+
+  /**
+   * Calculates the current velocity and acceleration from a new motor reading and its timestamp,
+   * in the motor's encoder units. Returns the (filtered) velocity.
+   *
+   * @param inewPos The new position measurement, only used when the motor can't be read.
+   * @return The new velocity estimate.
+   */
+  okapi::QAngularSpeed step(double inewPos) override;
+
+  /**
+   * Calculates the current velocity and acceleration. A reading with the same timestamp as the
+   * previous one is the same device sample read again and leaves the velocity unchanged.
+   *
+   * @param inewPos The new position measurement.
+   * @param itimestamp When the device took the measurement, in ms.
+   * @return The new velocity estimate.
+   */
+  okapi::QAngularSpeed stepAt(double inewPos, std::uint32_t itimestamp);
+
+  /**
+   * @return How many readings were skipped because the device had not sent a new sample.
+   */
+  std::uint32_t getRepeatedSamples() const;
+
+  protected:
+  std::shared_ptr<okapi::AbstractMotor> motor;
+  std::uint32_t lastTimestamp{0};
+  bool haveTimestamp{false};
+  double rawScale{1};                 // encoder units per raw count, read with the first sample
+  std::uint32_t repeatedSamples{0};
+
+  /**
+   * @return The motor's encoder units per raw count, NAN if its settings can't be read.
+   */
+  double readRawScale() const;
+};
+
+#endif
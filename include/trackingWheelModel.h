@@ -0,0 +1,55 @@
+#ifndef TRACKING_WHEEL_MODEL_H_
+#define TRACKING_WHEEL_MODEL_H_
+
+// ------- trackingWheelModel.h ------------------------------------------------
+//
+// Read only chassis model made of just the tracking wheel encoders. Lets the
+// project's own Odometry classes read the ADI tracking wheels without owning
+// the drive motors (those stay with the ChassisController).
+
+#include "sensorSnapshot.h"
+
+#include "okapi/api/chassis/model/readOnlyChassisModel.hpp"
+#include "okapi/api/device/rotarysensor/continuousRotarySensor.hpp"
+
+#include <memory>
+
+class TrackingWheelModel : public okapi::ReadOnlyChassisModel, public SensorSnapshotSource {
+  public:
+  /**
+   * A model which reads two (left, right) or three (left, right, middle) tracking wheels.
+   *
+   * @param ileftSensor The left tracking wheel encoder.
+   * @param irightSensor The right tracking wheel encoder.
+   * @param imiddleSensor The middle tracking wheel encoder, optional.
+   */
+  TrackingWheelModel(std::shared_ptr<okapi::ContinuousRotarySensor> ileftSensor,
+                     std::shared_ptr<okapi::ContinuousRotarySensor> irightSensor,
+                     std::shared_ptr<okapi::ContinuousRotarySensor> imiddleSensor = nullptr);
+
+  /**
+   * Read the sensors.
+   *
+   * @return sensor readings in the format {left, right} or {left, right, middle}
+   */
+  std::valarray<std::int32_t> getSensorVals() const override;
+
+  /**
+   * Read the sensors without allocating.
+   *
+   * @param out Filled with {left, right} or {left, right, middle}.
+   */
+  void getSensorVals(SensorSnapshot &out) const override;
+
+  /**
+   * Reset the sensors to their zero point.
+   */
+  void resetSensors();
+
+  protected:
+  std::shared_ptr<okapi::ContinuousRotarySensor> leftSensor;
+  std::shared_ptr<okapi::ContinuousRotarySensor> rightSensor;
+  std::shared_ptr<okapi::ContinuousRotarySensor> middleSensor;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef TRAJECTORY_VIEW_H_
+#define TRAJECTORY_VIEW_H_
+
+// ------- trajectoryView.h ----------------------------------------------------
+//
+// Transformed views of stored trajectories, so field side and direction
+// variants of an autonomous do not need their own generated paths.
+//
+// A TrajectoryView is a list of pieces, each a step range of a shared
+// TrajectorySource with a transform: which way the steps are read, a 2x2
+// matrix on the left / right values, position and heading offsets. Every
+// transform or concatenation only changes that list, a few dozen bytes per
+// piece; the steps are transformed when get() reads them, and the sources
+// stay shared, whichever view or controller still uses them.
+//
+//   auto red = profile->getView("score");
+//   profile->storeView("scoreBlue", red.mirrored());
+//   profile->storeView("scoreAndBack", red.concat(red.reversed()));
+//
+// Does not use PROS, so it also builds on a PC.
+
+#include "compactTrajectory.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * Full pathfinder Segments as a TrajectorySource, taken over from a stored path without copying.
+ */
+class SegmentTrajectory final : public TrajectorySource {
+  public:
+  using SegmentPtr = std::unique_ptr<Segment, void (*)(void *)>;
+
+  /**
+   * @param ileft The left wheel segments, or the only trajectory.
+   * @param iright The right wheel segments, empty for a single trajectory.
+   * @param ilength The number of segments per side.
+   */
+  SegmentTrajectory(SegmentPtr ileft, SegmentPtr iright, int ilength);
+
+  int size() const override;
+
+  double getDt() const override;
+
+  bool isPair() const override;
+
+  TrajectorySample get(int i) const override;
+
+  std::size_t memoryUsage() const override;
+
+  protected:
+  SegmentPtr left;
+  SegmentPtr right;
+  int length;
+};
+
+class TrajectoryView final : public TrajectorySource {
+  public:
+  /**
+   * An empty view.
+   */
+  TrajectoryView() = default;
+
+  /**
+   * A view of a whole trajectory as it is.
+   *
+   * @param isource The trajectory, shared with the view.
+   */
+  explicit TrajectoryView(std::shared_ptr<const TrajectorySource> isource);
+
+  int size() const override;
+
+  double getDt() const override;
+
+  bool isPair() const override;
+
+  TrajectorySample get(int i) const override;
+
+  /**
+   * @return The memory of the piece list in bytes, the shared sources are not counted.
+   */
+  std::size_t memoryUsage() const override;
+
+  /**
+   * @return The path with left and right swapped, it turns the other way. A single trajectory
+   * is unchanged.
+   */
+  TrajectoryView mirrored() const;
+
+  /**
+   * @return The path driven in reverse gear, what setTarget(id, true) does. It turns the other
+   * way.
+   */
+  TrajectoryView backwards() const;
+
+  /**
+   * @return The path retraced from its end back to its start, in reverse gear.
+   */
+  TrajectoryView reversed() const;
+
+  /**
+   * Scales the distance along the path, with the same timing and heading changes. Above 1 the
+   * path can exceed the limits it was generated with.
+   *
+   * @param ifactor The distance factor.
+   * @return The scaled path.
+   */
+  TrajectoryView scaled(double ifactor) const;
+
+  /**
+   * Appends another path, which starts where and with the heading this one ends. Both must have
+   * the same dt and both be pairs or single trajectories.
+   *
+   * @param inext The path to drive afterwards.
+   * @return Both paths back to back.
+   */
+  TrajectoryView concat(const TrajectoryView &inext) const;
+
+  protected:
+  struct Piece {
+    std::shared_ptr<const TrajectorySource> source;
+    int first{0};                     // step of the view the piece starts at
+    int length{0};
+    bool timeReversed{false};         // read from the end of the source
+    double velocitySign{1};           // -1 when timeReversed an odd number of times
+    double matrix[2][2]{{1, 0}, {0, 1}}; // on left / right position, velocity, acceleration
+    double offset[2]{0, 0};           // added to the left / right position
+    double headingSign{1};
+    double headingOffset{0};
+  };
+
+  std::vector<Piece> pieces;
+  int length{0};
+  double dt{0};
+  bool pair{true};
+
+  /**
+   * Applies a transform to every piece: left / right values become imatrix * (left, right), the
+   * heading iheadingSign * heading + iheadingOffset.
+   */
+  void transform(const double imatrix[2][2], double iheadingSign, double iheadingOffset);
+
+  /**
+   * @return The piece a step of the view is in.
+   */
+  const Piece &pieceAt(int i) const;
+};
+
+#endif
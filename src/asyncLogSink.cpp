@@ -0,0 +1,362 @@
+// ------- asyncLogSink.cpp ----------------------------------------------------
+//
+// Asynchronous okapi::Logger backend, see asyncLogSink.h
+//
+// The FILE handle handed to okapi::Logger is a stdio "cookie" stream. stdio
+// calls asyncLogWrite() for every completed line; the line is copied into the
+// calling task's single producer queue. The writer task is the only consumer
+// of all queues and the only code that touches the real device.
+
+#include "asyncLogSink.h"
+#include "ringBuffer.h"
+
+#include "okapi/api/coreProsAPI.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#ifdef THREADS_STD
+#include <chrono>
+#include <thread>
+#endif
+
+namespace {
+using WriteResult = std::invoke_result_t<cookie_write_function_t *, void *, const char *, size_t>;
+
+struct TaskQueue {
+  std::atomic<std::uintptr_t> owner{0};  // id of the task allowed to push, 0 == free
+  char ownerName[ASYNC_LOG_NAME_SIZE]{}; // set by the owner before its first push
+  RingBuffer<AsyncLogEntry, ASYNC_LOG_QUEUE_SIZE> ring;
+#ifdef THREADS_STD
+  std::atomic<bool> ownerExited{false};  // set by the owner thread when it ends
+#endif
+};
+
+TaskQueue taskQueues[ASYNC_LOG_MAX_TASKS];
+
+// used by tasks which started logging after every queue was taken, only one
+// of them may push at a time so it is guarded by a try-lock flag
+TaskQueue sharedQueue;
+std::atomic_flag sharedQueueBusy = ATOMIC_FLAG_INIT;
+
+FILE *targetFile = nullptr;
+std::atomic<bool> sinkOpen{false};
+std::atomic<bool> writerStop{false};
+std::atomic<std::uint32_t> droppedLines{0};
+
+#ifdef THREADS_STD
+std::thread writerThread;
+#else
+std::atomic<bool> writerDone{false};
+#endif
+
+#ifdef THREADS_STD
+// std::thread has no task_get_state(): a thread marks the queue it owns when it ends
+struct ThreadExit {
+  std::uintptr_t id{0};
+  TaskQueue *queue{nullptr};
+
+  ~ThreadExit() {
+    if (queue != nullptr && queue->owner.load(std::memory_order_acquire) == id) {
+      queue->ownerExited.store(true, std::memory_order_release);
+    }
+  }
+};
+
+thread_local ThreadExit threadExit;
+#endif
+
+std::uintptr_t currentTaskId() {
+#ifdef THREADS_STD
+  // unlike std::thread::id hashes these are never reused by a later thread
+  static std::atomic<std::uintptr_t> nextId{1};
+  thread_local const std::uintptr_t id = nextId.fetch_add(1);
+  return id;
+#else
+  return reinterpret_cast<std::uintptr_t>(pros::c::task_get_current());
+#endif
+}
+
+// Whether the task which claimed a queue still exists. PROS deletes and
+// recreates the competition tasks (opcontrol, autonomous, disabled) on every
+// mode change, their queues must go back to the pool.
+bool ownerAlive(const TaskQueue &iqueue, const std::uintptr_t iid) {
+#ifdef THREADS_STD
+  (void)iid;
+  return !iqueue.ownerExited.load(std::memory_order_acquire);
+#else
+  (void)iqueue;
+  const auto state = pros::c::task_get_state(reinterpret_cast<pros::task_t>(iid));
+  return state != pros::E_TASK_STATE_DELETED && state != pros::E_TASK_STATE_INVALID;
+#endif
+}
+
+void claim(TaskQueue &queue) {
+  const std::string name = CrossplatformThread::getName();
+  std::strncpy(queue.ownerName, name.c_str(), sizeof(queue.ownerName) - 1);
+#ifdef THREADS_STD
+  queue.ownerExited.store(false, std::memory_order_release);
+  threadExit.id = currentTaskId();
+  threadExit.queue = &queue;
+#endif
+}
+
+// Find the queue owned by the calling task, claiming a free one on first use
+TaskQueue *findTaskQueue() {
+  const std::uintptr_t id = currentTaskId();
+
+  for (auto &queue : taskQueues) {
+    if (queue.owner.load(std::memory_order_acquire) == id) {
+      return &queue;
+    }
+  }
+
+  for (auto &queue : taskQueues) {
+    std::uintptr_t expected = 0;
+    if (queue.owner.compare_exchange_strong(expected, id, std::memory_order_acq_rel)) {
+      claim(queue);
+      return &queue;
+    }
+  }
+
+  // every queue is taken, take over one whose task is gone once the writer has
+  // emptied it, so the queue still has a single producer
+  for (auto &queue : taskQueues) {
+    std::uintptr_t previous = queue.owner.load(std::memory_order_acquire);
+    if (queue.ring.size() == 0 && !ownerAlive(queue, previous) &&
+        queue.owner.compare_exchange_strong(previous, id, std::memory_order_acq_rel)) {
+      claim(queue);
+      return &queue;
+    }
+  }
+
+  return nullptr;
+}
+
+bool pushChunks(TaskQueue &queue, const char *buf, size_t size) {
+  AsyncLogEntry entry;
+  while (size > 0) {
+    const size_t length = size < ASYNC_LOG_LINE_SIZE ? size : ASYNC_LOG_LINE_SIZE;
+    entry.length = static_cast<std::uint16_t>(length);
+    std::memcpy(entry.text, buf, length);
+    if (!queue.ring.push(entry)) {
+      return false;
+    }
+    buf += length;
+    size -= length;
+  }
+  return true;
+}
+
+// Queue an entry using the calling task's queue, or the shared one if every queue is taken
+bool pushEntry(const char *buf, size_t size, const AsyncLogRecord *record) {
+  bool queued = false;
+
+  auto push = [&](TaskQueue &queue) {
+    if (record != nullptr) {
+      AsyncLogEntry entry;
+      entry.length = 0;
+      entry.record = *record;
+      return queue.ring.push(entry);
+    }
+    return pushChunks(queue, buf, size);
+  };
+
+  TaskQueue *queue = findTaskQueue();
+  if (queue != nullptr) {
+    queued = push(*queue);
+  } else if (!sharedQueueBusy.test_and_set(std::memory_order_acquire)) {
+    queued = push(sharedQueue);
+    sharedQueueBusy.clear(std::memory_order_release);
+  }
+
+  if (!queued) {
+    droppedLines++;
+  }
+  return queued;
+}
+
+WriteResult asyncLogWrite(void *, const char *buf, size_t size) {
+  pushEntry(buf, size, nullptr);
+
+  // always report success, a dropped line must not put the stream in an error state
+  return static_cast<WriteResult>(size);
+}
+
+// Render a structured record in the same layout okapi::Logger uses for its lines,
+// "<ms> (<task name>) <LEVEL>: <message>"
+void writeRecord(const AsyncLogRecord &record, const char *itaskName) {
+  static const char *const levelNames[] = {"OFF", "ERROR", "WARN", "INFO", "DEBUG"};
+  char line[256];
+  std::size_t used = 0;
+
+  auto append = [&](int written) {
+    if (written > 0) {
+      used += static_cast<std::size_t>(written);
+      if (used >= sizeof(line)) {
+        used = sizeof(line) - 1;
+      }
+    }
+  };
+
+  append(snprintf(line, sizeof(line), "%ld (%s) %s: ", static_cast<long>(record.timestamp),
+                  itaskName, levelNames[record.level <= 4 ? record.level : 0]));
+
+  std::uint8_t arg = 0;
+  for (const char *c = record.format; *c != '\0' && used < sizeof(line) - 1; c++) {
+    if (c[0] == '{' && c[1] == '}' && arg < record.argc) {
+      const AsyncLogArg &value = record.args[arg++];
+      char *out = line + used;
+      const std::size_t left = sizeof(line) - used;
+      switch (value.type) {
+      case AsyncLogArg::integer:
+        append(snprintf(out, left, "%lld", value.i));
+        break;
+      case AsyncLogArg::unsignedInteger:
+        append(snprintf(out, left, "%llu", value.u));
+        break;
+      case AsyncLogArg::real:
+        append(snprintf(out, left, "%g", value.d));
+        break;
+      case AsyncLogArg::literal:
+        append(snprintf(out, left, "%s", value.s));
+        break;
+      }
+      c++;
+    } else {
+      line[used++] = *c;
+    }
+  }
+  line[used++] = '\n';
+
+  fwrite(line, 1, used, targetFile);
+}
+
+// Write everything currently queued to the target, returns true if anything was written
+bool drainQueues() {
+  AsyncLogEntry block[8];
+  bool wrote = false;
+
+  auto drain = [&](TaskQueue &queue, const char *itaskName) {
+    std::size_t count;
+    while ((count = queue.ring.popBlock(block, 8)) > 0) {
+      for (std::size_t i = 0; i < count; i++) {
+        if (block[i].length == 0) {
+          writeRecord(block[i].record, itaskName);
+        } else {
+          fwrite(block[i].text, 1, block[i].length, targetFile);
+        }
+      }
+      wrote = true;
+    }
+  };
+
+  for (auto &queue : taskQueues) {
+    drain(queue, queue.ownerName);
+  }
+  // tasks beyond ASYNC_LOG_MAX_TASKS take turns on the shared queue, which does not know who pushed
+  drain(sharedQueue, "shared");
+
+  return wrote;
+}
+
+void writerTask(void *) {
+  while (!writerStop.load()) {
+    if (drainQueues()) {
+      fflush(targetFile);
+    }
+#ifdef THREADS_STD
+    std::this_thread::sleep_for(std::chrono::milliseconds(ASYNC_LOG_WRITER_MS));
+#else
+    pros::delay(ASYNC_LOG_WRITER_MS);
+#endif
+  }
+
+  drainQueues();
+  fflush(targetFile);
+#ifndef THREADS_STD
+  writerDone = true;
+#endif
+}
+
+int asyncLogClose(void *) {
+  writerStop = true;
+#ifdef THREADS_STD
+  writerThread.join();
+#else
+  while (!writerDone.load()) {
+    pros::delay(1);
+  }
+#endif
+
+  fclose(targetFile);
+  targetFile = nullptr;
+
+  for (auto &queue : taskQueues) {
+    queue.owner = 0;
+  }
+  sinkOpen = false;
+  return 0;
+}
+} // namespace
+
+FILE *asyncLogSinkOpen(const char *itarget) {
+  bool expected = false;
+  if (!sinkOpen.compare_exchange_strong(expected, true)) {
+    return nullptr;
+  }
+
+  targetFile = fopen(itarget, "w");
+  if (targetFile == nullptr) {
+    sinkOpen = false;
+    return nullptr;
+  }
+
+  cookie_io_functions_t functions;
+  std::memset(&functions, 0, sizeof(functions));
+  functions.write = asyncLogWrite;
+  functions.close = asyncLogClose;
+
+  FILE *sink = fopencookie(nullptr, "w", functions);
+  if (sink == nullptr) {
+    fclose(targetFile);
+    targetFile = nullptr;
+    sinkOpen = false;
+    return nullptr;
+  }
+  // hand every complete line to asyncLogWrite() right away
+  setvbuf(sink, nullptr, _IOLBF, ASYNC_LOG_LINE_SIZE);
+
+  writerStop = false;
+  droppedLines = 0;
+#ifdef THREADS_STD
+  writerThread = std::thread(writerTask, nullptr);
+#else
+  writerDone = false;
+  pros::c::task_create(writerTask, nullptr, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT,
+                       "Async Log Writer");
+#endif
+
+  return sink;
+}
+
+bool asyncLogSinkPush(AsyncLogRecord &irecord) {
+  if (!sinkOpen.load()) {
+    return false;
+  }
+#ifdef THREADS_STD
+  irecord.timestamp = static_cast<std::uint32_t>(
+    std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count());
+#else
+  irecord.timestamp = pros::c::millis();
+#endif
+  return pushEntry(nullptr, 0, &irecord);
+}
+
+std::uint32_t asyncLogSinkDropped() {
+  return droppedLines.load();
+}
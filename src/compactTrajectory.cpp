@@ -0,0 +1,118 @@
+// ------- compactTrajectory.cpp -----------------------------------------------
+//
+// Compact trajectory storage, see compactTrajectory.h
+
+#include "compactTrajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define COMPACT_FIXED_MAX 32767       // largest magnitude of a fixed16 value
+
+// step layout: left position, velocity, acceleration, right position,
+// velocity, acceleration, heading; a single trajectory only has the first three
+
+CompactTrajectory::CompactTrajectory(const Segment *ileft,
+                                     const Segment *iright,
+                                     const int ilength,
+                                     const TrajectoryStorage istorage)
+  : storage(istorage == TrajectoryStorage::fixed16 ? TrajectoryStorage::fixed16
+                                                   : TrajectoryStorage::float32),
+    length(std::max(ilength, 0)),
+    width(iright == nullptr ? singleWidth : pairWidth),
+    dt(length > 0 ? ileft[0].dt : 0) {
+  std::vector<double> values(static_cast<std::size_t>(length) * width);
+  for (int i = 0; i < length; i++) {
+    double *step = &values[static_cast<std::size_t>(i) * width];
+    step[0] = ileft[i].position;
+    step[1] = ileft[i].velocity;
+    step[2] = ileft[i].acceleration;
+    if (iright != nullptr) {
+      step[3] = iright[i].position;
+      step[4] = iright[i].velocity;
+      step[5] = iright[i].acceleration;
+      step[6] = ileft[i].heading;
+    }
+  }
+
+  if (storage == TrajectoryStorage::float32) {
+    floats.assign(values.begin(), values.end());
+    return;
+  }
+
+  // scale every value to the largest magnitude it has anywhere in the path
+  double largest[pairWidth]{};
+  for (std::size_t i = 0; i < values.size(); i++) {
+    largest[i % width] = std::max(largest[i % width], std::abs(values[i]));
+  }
+  for (int c = 0; c < width; c++) {
+    scale[c] = largest[c] > 0 ? largest[c] / COMPACT_FIXED_MAX : 1;
+  }
+
+  fixed.resize(values.size());
+  for (std::size_t i = 0; i < values.size(); i++) {
+    fixed[i] = static_cast<std::int16_t>(std::lround(values[i] / scale[i % width]));
+  }
+}
+
+int CompactTrajectory::size() const {
+  return length;
+}
+
+double CompactTrajectory::getDt() const {
+  return dt;
+}
+
+bool CompactTrajectory::isPair() const {
+  return width == pairWidth;
+}
+
+TrajectoryStorage CompactTrajectory::getStorage() const {
+  return storage;
+}
+
+TrajectorySample CompactTrajectory::get(const int i) const {
+  double values[pairWidth]{};
+  const std::size_t first = static_cast<std::size_t>(i) * width;
+  if (storage == TrajectoryStorage::fixed16) {
+    for (int c = 0; c < width; c++) {
+      values[c] = fixed[first + c] * scale[c];
+    }
+  } else {
+    for (int c = 0; c < width; c++) {
+      values[c] = floats[first + c];
+    }
+  }
+
+  return TrajectorySample{values[0], values[1], values[2], values[3],
+                          values[4], values[5], values[6]};
+}
+
+std::size_t CompactTrajectory::memoryUsage() const {
+  return floats.capacity() * sizeof(float) + fixed.capacity() * sizeof(std::int16_t);
+}
+
+void TrajectorySource::toSegments(Segment *oleft, Segment *oright) const {
+  const int length = size();
+  const double dt = getDt();
+  for (int i = 0; i < length; i++) {
+    const TrajectorySample sample = get(i);
+
+    std::memset(&oleft[i], 0, sizeof(Segment));
+    oleft[i].dt = dt;
+    oleft[i].heading = sample.heading;
+    oleft[i].position = sample.leftPosition;
+    oleft[i].velocity = sample.leftVelocity;
+    oleft[i].acceleration = sample.leftAcceleration;
+
+    if (oright != nullptr) {
+      std::memset(&oright[i], 0, sizeof(Segment));
+      oright[i].dt = dt;
+      oright[i].heading = sample.heading;
+      oright[i].position = sample.rightPosition;
+      oright[i].velocity = sample.rightVelocity;
+      oright[i].acceleration = sample.rightAcceleration;
+    }
+  }
+}
@@ -0,0 +1,131 @@
+// ------- dataLogWriter.cpp ---------------------------------------------------
+//
+// Background writer of the binary robot data log, see dataLogWriter.h
+
+#include "dataLogWriter.h"
+#include "ringBuffer.h"
+
+#include <atomic>
+
+#ifdef THREADS_STD
+#include <chrono>
+#include <thread>
+#else
+#include "api.h"
+#endif
+
+namespace {
+RingBuffer<DataLogRecord, DATA_LOG_RING_SIZE> dataLogRing;
+DataLogRecord dataLogBlock[DATA_LOG_BLOCK_SIZE];  // only used by the writer task
+FILE *dataLogFile = nullptr;
+std::atomic<bool> dataLogRunning{false};
+std::atomic<bool> dataLogClosing{false};
+std::atomic<std::uint32_t> dataLogDropped{0};
+
+#ifdef THREADS_STD
+std::thread dataLogThread;
+#else
+std::atomic<bool> dataLogDone{false};
+#endif
+
+std::uint32_t nowMs() {
+#ifdef THREADS_STD
+  return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      std::chrono::steady_clock::now().time_since_epoch())
+                                      .count());
+#else
+  return pros::c::millis();
+#endif
+}
+
+// Write everything currently in the ring buffer to the card in block sized chunks
+void dataLogFlushRing() {
+  std::size_t count;
+  while ((count = dataLogRing.popBlock(dataLogBlock, DATA_LOG_BLOCK_SIZE)) > 0) {
+    fwrite(dataLogBlock, sizeof(DataLogRecord), count, dataLogFile);
+  }
+}
+
+// Background writer task -- runs at minimum priority so it only uses time the
+// control loops leave over
+void dataLogWriterTask(void *) {
+  std::uint32_t lastFlush = nowMs();
+  while (!dataLogClosing.load()) {
+    // only touch the card when a full block is waiting, small writes are slow,
+    // but never hold records longer than DATA_LOG_FLUSH_MS: a trace which is
+    // never closed loses at most that much when the brain is switched off
+    const std::size_t waiting = dataLogRing.size();
+    const std::uint32_t now = nowMs();
+    if (waiting >= DATA_LOG_BLOCK_SIZE || (waiting > 0 && now - lastFlush >= DATA_LOG_FLUSH_MS)) {
+      dataLogFlushRing();
+      // push the block to the card, traces must survive the brain being switched off
+      fflush(dataLogFile);
+      lastFlush = now;
+    } else if (waiting == 0) {
+      lastFlush = now;
+    }
+#ifdef THREADS_STD
+    std::this_thread::sleep_for(std::chrono::milliseconds(DATA_LOG_DRAIN_MS));
+#else
+    pros::delay(DATA_LOG_DRAIN_MS);
+#endif
+  }
+
+  dataLogFlushRing();
+  fflush(dataLogFile);
+#ifndef THREADS_STD
+  dataLogDone = true;
+#endif
+}
+} // namespace
+
+bool dataLogWriterStart(FILE *ifile) {
+  bool expected = false;
+  if (!dataLogRunning.compare_exchange_strong(expected, true)) {
+    return false;
+  }
+
+  dataLogFile = ifile;
+  dataLogClosing = false;
+  dataLogDropped = 0;
+#ifdef THREADS_STD
+  dataLogThread = std::thread(dataLogWriterTask, nullptr);
+#else
+  dataLogDone = false;
+  pros::c::task_create(dataLogWriterTask, nullptr, TASK_PRIORITY_MIN + 1,
+                       TASK_STACK_DEPTH_DEFAULT, "Data Logger Writer");
+#endif
+  return true;
+}
+
+bool dataLogWriterPush(const DataLogRecord &irecord) {
+  if (!dataLogRunning.load()) {
+    return false;
+  }
+  if (!dataLogRing.push(irecord)) {
+    dataLogDropped++;
+    return false;
+  }
+  return true;
+}
+
+void dataLogWriterStop() {
+  if (!dataLogRunning.load()) {
+    return;
+  }
+
+  dataLogClosing = true;
+#ifdef THREADS_STD
+  dataLogThread.join();
+#else
+  while (!dataLogDone.load()) {
+    pros::delay(10);
+  }
+#endif
+  dataLogFile = nullptr;
+  dataLogRunning = false;
+}
+
+std::uint32_t dataLogWriterDropped() {
+  return dataLogDropped.load();
+}
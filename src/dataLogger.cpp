@@ -0,0 +1,110 @@
+// ------- dataLogger.cpp ------------------------------------------------------
+//
+// Binary robot data logger for the USD card.
+//
+// robotDataLogger() is called from the drive code and only copies a fixed size
+// DataLogRecord into a preallocated ring buffer - no string formatting and no
+// file access happens on the calling task, so a slow SD card can no longer
+// stall the drive sequence. A low priority background task drains the ring
+// buffer and writes the records to /usd in large blocks (dataLogWriter.h).
+//
+// Use tools/dataLogDecode.cpp on a PC to convert the file into CSV.
+
+#include "main.h"
+#include "globals.h"
+#include "dataLoggerFormat.h"
+#include "dataLogWriter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#define DATA_LOG_FILE "/usd/robotData.bin"
+
+bool usdLogEnable = false;      // used to control writing to stream if USD card is available
+
+static FILE *dataLogFile = nullptr;
+
+// Record one data point -- timestamp, odometer state, tracking wheel ticks and
+// drive motor currents. Safe to call from the drive loop; it never blocks. If
+// the writer falls behind and the buffer is full the record is dropped and
+// counted instead of stalling the caller.
+// Only one task may call robotDataLogger() at a time.
+
+void robotDataLogger(const okapi::OdomState &state, std::uint16_t marker) {
+  if (!usdLogEnable) {
+    return;
+  }
+
+  DataLogRecord record;
+  record.timestamp = pros::c::millis();
+  record.marker = marker;
+  record.flags = 0;
+  record.x = static_cast<float>(state.x.convert(okapi::meter));
+  record.y = static_cast<float>(state.y.convert(okapi::meter));
+  record.theta = static_cast<float>(state.theta.convert(okapi::degree));
+  record.encoderLeft = encoderLeft.get_value();
+  record.encoderRight = encoderRight.get_value();
+  record.motorCurrent[0] = left_wheel_front.get_current_draw();
+  record.motorCurrent[1] = left_wheel_back.get_current_draw();
+  record.motorCurrent[2] = right_wheel_front.get_current_draw();
+  record.motorCurrent[3] = right_wheel_back.get_current_draw();
+
+  dataLogWriterPush(record);
+}
+
+// Create an ability to log robot data to the USD file system - useful for debugging autonomous
+// routines by recording robot positions with in the expected versus true odometer frame
+// It requires a FAT32 formatted SD card inserted, function will detect if card is present
+// Function returns a boolean -- true -- USD file writing is setup and available,
+//                               false -- No USD card present or other error opening file
+
+bool usdLoggerOpen(std::uint32_t runId, const char *programVersion, const char *versionDate) {
+  // We are going to open a log file, but first we need to know if we have USD card installed
+  if (!pros::usd::is_installed()) {
+    std::cout << "USD File system failed to open - either no card, wrong format or other error \n";
+    return(false);
+  }
+
+  dataLogFile = fopen(DATA_LOG_FILE, "wb");
+  if (dataLogFile == nullptr) {
+    std::cout << "USD File system failed to open " << DATA_LOG_FILE << "\n";
+    return(false);
+  }
+  std::cout << "USD file system is ready for writing \n";
+
+  // The V5 has no date/time functions or clock, so we can only use msec since start of execution
+  // to track our timing.
+  DataLogHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = DATA_LOG_MAGIC;
+  header.version = DATA_LOG_VERSION;
+  header.recordSize = sizeof(DataLogRecord);
+  header.runId = runId;
+  header.openedAt = pros::c::millis();
+  std::strncpy(header.programVersion, programVersion, sizeof(header.programVersion) - 1);
+  std::strncpy(header.versionDate, versionDate, sizeof(header.versionDate) - 1);
+  fwrite(&header, sizeof(header), 1, dataLogFile);
+
+  dataLogWriterStart(dataLogFile);
+  usdLogEnable = true;
+
+  return(true);
+}
+
+// function to close the logger file to USD card - should be called before exiting program
+// Waits for the writer task to put all buffered records on the card.
+void usdLoggerClose() {
+  if (!usdLogEnable) {
+    return;
+  }
+  usdLogEnable = false;
+
+  dataLogWriterStop();
+  fclose(dataLogFile);
+  dataLogFile = nullptr;
+
+  if (dataLogWriterDropped() > 0) {
+    std::cout << "USD logger dropped " << dataLogWriterDropped() << " records - writer too slow \n";
+  }
+}
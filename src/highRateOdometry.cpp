@@ -0,0 +1,202 @@
+// ------- highRateOdometry.cpp ------------------------------------------------
+//
+// Fixed rate tracking wheel odometry, see highRateOdometry.h
+
+#include "highRateOdometry.h"
+#include "robotLog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#ifndef THREADS_STD
+// what pros::micros() returns from PROS 3.5 on, kernel 3.3.1 does not have it yet
+extern "C" std::uint64_t vexSystemHighResTimeGet(void);
+#endif
+
+HighRateOdometry::HighRateOdometry(const okapi::TimeUtil &itimeUtil,
+                                   const std::shared_ptr<okapi::ReadOnlyChassisModel> &imodel,
+                                   const okapi::ChassisScales &ichassisScales,
+                                   const okapi::QFrequency &isampleRate,
+                                   const double imaximumSpeed,
+                                   const std::shared_ptr<okapi::Logger> &ilogger)
+  : logger(ilogger),
+    timer(itimeUtil.getTimer()),
+    rate(itimeUtil.getRate()),
+    model(imodel),
+    chassisScales(ichassisScales),
+    sampleRate(isampleRate),
+    maximumSpeed(imaximumSpeed),
+    snapshotSource(dynamic_cast<const SensorSnapshotSource *>(imodel.get())) {
+  if (snapshotSource == nullptr) {
+    LOG_WARN_S("HighRateOdometry: Chassis model has no SensorSnapshotSource, every sample will "
+               "allocate.");
+  }
+}
+
+HighRateOdometry::~HighRateOdometry() {
+  dtorCalled.store(true, std::memory_order_release);
+  delete task.load();
+}
+
+void HighRateOdometry::setScales(const okapi::ChassisScales &ichassisScales) {
+  std::scoped_lock lock(writerMutex);
+  chassisScales = ichassisScales;
+}
+
+void HighRateOdometry::step() {
+  // the sampling task does the work, the chassis controller's calls are not needed
+  if (task.load(std::memory_order_acquire) == nullptr) {
+    sample();
+  }
+}
+
+void HighRateOdometry::readSensors() {
+  if (snapshotSource != nullptr) {
+    snapshotSource->getSensorVals(ticks);
+    return;
+  }
+
+  const std::valarray<std::int32_t> vals = model->getSensorVals();
+  ticks.count = std::min(vals.size(), ticks.vals.size());
+  for (std::size_t i = 0; i < ticks.count; i++) {
+    ticks.vals[i] = vals[i];
+  }
+}
+
+std::uint64_t HighRateOdometry::readMicros() const {
+#ifdef THREADS_STD
+  return static_cast<std::uint64_t>(timer->millis().convert(okapi::millisecond) * 1000);
+#else
+  return vexSystemHighResTimeGet();
+#endif
+}
+
+void HighRateOdometry::sample() {
+  std::scoped_lock lock(writerMutex);
+
+  readSensors();
+  const std::uint64_t micros = readMicros();
+  const auto now = static_cast<std::uint32_t>(timer->millis().convert(okapi::millisecond));
+
+  if (!haveLastSample) {
+    lastTicks = ticks;
+    lastTime = now;
+    lastMicros = micros;
+    haveLastSample = true;
+    return;
+  }
+
+  // two samples at the same time: let the ticks add up into the next sample
+  if (micros == lastMicros) {
+    return;
+  }
+  const double dt = (micros - lastMicros) / 1e6;
+
+  const double leftDiff = ticks[0] - lastTicks[0];
+  const double rightDiff = ticks[1] - lastTicks[1];
+  lastTicks = ticks;
+  lastTime = now;
+  lastMicros = micros;
+
+  // scale the glitch limit with the real time since the last sample, a late
+  // sample legitimately carries more ticks
+  const double limit = maximumSpeed * dt;
+  if (std::abs(leftDiff) > limit || std::abs(rightDiff) > limit) {
+    LOG_WARN("HighRateOdometry: Tick diff too large: " + std::to_string(leftDiff) + ", " +
+             std::to_string(rightDiff) + " in " + std::to_string(dt * 1000) + " ms");
+    return;
+  }
+
+  ROBOT_LOG_DEBUG("HighRateOdometry: dt {} ms ticks {} {}", dt * 1000, leftDiff, rightDiff);
+
+  const OdomPose next = odomMathStep(pose, leftDiff, rightDiff, dt);
+
+  OdomSample out;
+  out.pose = next;
+  out.linearVelocity = (leftDiff + rightDiff) / 2 / chassisScales.straight / dt;
+  out.angularVelocity = (next.theta - pose.theta) / dt;
+  out.timestamp = now;
+  pose = next;
+
+  published.write(out);
+  history.push(now, next);
+}
+
+OdomPose HighRateOdometry::odomMathStep(const OdomPose &ipose,
+                                        const double ileftDiff,
+                                        const double irightDiff,
+                                        double) {
+  return OdomArcMath::stepTicks(ipose, ileftDiff, irightDiff, chassisScales);
+}
+
+void HighRateOdometry::onStateSet(const OdomPose &) {
+}
+
+okapi::OdomState HighRateOdometry::getState(const okapi::StateMode &imode) const {
+  return OdomArcMath::toState(published.read().pose, imode);
+}
+
+okapi::OdomState HighRateOdometry::getStateAt(const okapi::QTime &itime,
+                                              const okapi::StateMode &imode) const {
+  OdomPose past;
+  if (!history.getPoseAt(static_cast<std::uint32_t>(itime.convert(okapi::millisecond)), past) &&
+      history.size() == 0) {
+    // nothing sampled yet
+    past = published.read().pose;
+  }
+  return OdomArcMath::toState(past, imode);
+}
+
+OdomSample HighRateOdometry::getSample() const {
+  return published.read();
+}
+
+void HighRateOdometry::setState(const okapi::OdomState &istate, const okapi::StateMode &imode) {
+  LOG_INFO("HighRateOdometry: Set state to: " + istate.str());
+
+  std::scoped_lock lock(writerMutex);
+  pose = OdomArcMath::fromState(istate, imode);
+  onStateSet(pose);
+
+  OdomSample out = published.read();
+  out.pose = pose;
+  published.write(out);
+}
+
+std::shared_ptr<okapi::ReadOnlyChassisModel> HighRateOdometry::getModel() {
+  return model;
+}
+
+okapi::ChassisScales HighRateOdometry::getScales() {
+  std::scoped_lock lock(writerMutex);
+  return chassisScales;
+}
+
+void HighRateOdometry::startThread() {
+  if (task.load(std::memory_order_acquire) == nullptr) {
+    task.store(new CrossplatformThread(trampoline, this, "HighRateOdometry"),
+               std::memory_order_release);
+  }
+}
+
+CrossplatformThread *HighRateOdometry::getThread() const {
+  return task.load(std::memory_order_acquire);
+}
+
+void HighRateOdometry::trampoline(void *context) {
+  if (context) {
+    static_cast<HighRateOdometry *>(context)->loop();
+  }
+}
+
+void HighRateOdometry::loop() {
+  LOG_INFO_S("Started HighRateOdometry task.");
+
+  while (!dtorCalled.load(std::memory_order_acquire)) {
+    sample();
+    rate->delay(sampleRate);
+  }
+
+  LOG_INFO_S("Stopped HighRateOdometry task.");
+}
@@ -0,0 +1,152 @@
+// ------- holonomicMotionProfileController.cpp --------------------------------
+//
+// Holonomic motion profile following, see holonomicMotionProfileController.h
+
+#include "holonomicMotionProfileController.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+HolonomicMotionProfileController::HolonomicMotionProfileController(
+  const okapi::TimeUtil &itimeUtil,
+  const okapi::PathfinderLimits &ilimits,
+  const std::shared_ptr<okapi::XDriveModel> &imodel,
+  const okapi::ChassisScales &iscales,
+  const okapi::AbstractMotor::GearsetRatioPair &ipair,
+  const std::shared_ptr<okapi::Logger> &ilogger)
+  : MotionProfileController(itimeUtil, ilimits, imodel, iscales, ipair, ilogger),
+    drive(HolonomicDrive::xDrive),
+    motors{imodel->getTopLeftMotor(), imodel->getTopRightMotor(), imodel->getBottomRightMotor(),
+           imodel->getBottomLeftMotor()} {
+}
+
+HolonomicMotionProfileController::HolonomicMotionProfileController(
+  const okapi::TimeUtil &itimeUtil,
+  const okapi::PathfinderLimits &ilimits,
+  const std::shared_ptr<okapi::HDriveModel> &imodel,
+  const okapi::ChassisScales &iscales,
+  const okapi::AbstractMotor::GearsetRatioPair &ipair,
+  const std::shared_ptr<okapi::Logger> &ilogger)
+  : MotionProfileController(itimeUtil, ilimits, imodel, iscales, ipair, ilogger),
+    drive(HolonomicDrive::hDrive),
+    motors{imodel->getLeftSideMotor(), imodel->getRightSideMotor(), imodel->getMiddleMotor()} {
+}
+
+HolonomicDrive HolonomicMotionProfileController::getDrive() const {
+  return drive;
+}
+
+void HolonomicMotionProfileController::moveWheels(const double *ivelocities) {
+  const int wheels = HolonomicTrajectory::wheelCount(drive);
+  double wheelRpm[HOLONOMIC_MAX_WHEELS];
+  double fastest = 0;
+  for (int w = 0; w < wheels; w++) {
+    wheelRpm[w] = convertLinearToRotational(ivelocities[w] * okapi::mps).convert(okapi::rpm);
+    fastest = std::max(fastest, std::abs(wheelRpm[w]));
+  }
+
+  const double maxVelocity = model->getMaxVelocity();
+  const double scale = fastest > maxVelocity ? maxVelocity / fastest : 1;
+  for (int w = 0; w < wheels; w++) {
+    motors[w]->moveVelocity(static_cast<std::int16_t>(std::lround(wheelRpm[w] * scale)));
+  }
+}
+
+void HolonomicMotionProfileController::executeSinglePath(
+  const TrajectoryPair &,
+  std::unique_ptr<okapi::AbstractRate> rate) {
+  ProfileFollowerGains gains;
+  std::shared_ptr<okapi::Odometry> odometry;
+  {
+    std::scoped_lock lock(followerMutex);
+    gains = followerGains;
+    odometry = headingSource;
+  }
+
+  if (gains.kP != 0 || gains.kD != 0) {
+    LOG_WARN_S("HolonomicMotionProfileController: kP and kD are ignored, there is no wheel "
+               "position feedback.");
+  }
+
+  FollowedPath current;
+  startChain(current);
+
+  if (!current.shared && current.full == nullptr) {
+    LOG_ERROR("HolonomicMotionProfileController: Path " + current.id + " has no trajectory.");
+  } else {
+    const double track = scales.wheelTrack.convert(okapi::meter);
+    const bool holdHeading = odometry && gains.kHeading != 0;
+
+    // the heading the robot keeps for the whole chain of paths
+    const double startTheta = holdHeading ? odometry->getState().theta.convert(okapi::radian) : 0;
+
+    bool chained = true;
+    while (chained && !isDisabled()) {
+      // the step before, the step and the step after, for the turn rate of the path
+      TrajectorySample before, sample, after;
+      double dt = PATH_GENERATION_DT;
+      bool removed = current.length > 0 && !pathSample(current, 0, sample, dt);
+      const double startHeading = sample.heading;
+      before = sample;
+
+      for (int i = 0; i < current.length && !removed && !isDisabled(); i++) {
+        const int next = std::min(i + 1, current.length - 1);
+        if (!pathSample(current, next, after, dt)) {
+          removed = true;
+          break;
+        }
+
+        double velocities[HOLONOMIC_MAX_WHEELS], accelerations[HOLONOMIC_MAX_WHEELS];
+        HolonomicTrajectory::wheelStep(drive, sample, before, after, next - std::max(i - 1, 0),
+                                       startHeading, dt, track, current.reversed < 0,
+                                       current.mirrored, velocities, accelerations);
+
+        double turn[HOLONOMIC_MAX_WHEELS]{};
+        if (holdHeading) {
+          // okapi's theta is clockwise, turning back is counterclockwise
+          const double theta = odometry->getState().theta.convert(okapi::radian);
+          HolonomicTrajectory::wheelSpeeds(
+            drive, 0, 0, gains.kHeading * std::remainder(theta - startTheta, 2 * okapi::pi),
+            track, turn);
+        }
+
+        for (int w = 0; w < HolonomicTrajectory::wheelCount(drive); w++) {
+          velocities[w] = gains.kV * velocities[w] + gains.kA * accelerations[w] + turn[w];
+        }
+        moveWheels(velocities);
+
+        before = sample;
+        sample = after;
+        rate->delayUntil(dt * okapi::second);
+      }
+
+      if (removed) {
+        LOG_WARN("HolonomicMotionProfileController: Path " + current.id +
+                 " was removed while running.");
+        break;
+      }
+
+      // queued paths follow without stopping, from the same heading
+      chained = !isDisabled() && continueChain(current, false);
+      if (chained) {
+        {
+          std::scoped_lock lock(currentPathMutex);
+          currentPath = current.id;
+        }
+        direction.store(current.reversed, std::memory_order_release);
+        mirrored.store(current.mirrored, std::memory_order_release);
+
+        LOG_INFO("HolonomicMotionProfileController: Continuing with path " + current.id);
+      }
+    }
+  }
+
+  // okapi stops the chassis with driveVector(), which leaves an H drive's middle wheel running
+  for (const auto &motor : motors) {
+    motor->moveVelocity(0);
+  }
+
+  endChain();
+}
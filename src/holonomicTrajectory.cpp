@@ -0,0 +1,112 @@
+// ------- holonomicTrajectory.cpp ---------------------------------------------
+//
+// Holonomic wheel trajectories, see holonomicTrajectory.h
+
+#include "holonomicTrajectory.h"
+
+#include <algorithm>
+#include <cmath>
+
+HolonomicTrajectory::HolonomicTrajectory(const HolonomicDrive idrive,
+                                         const std::vector<TrajectorySample> &ipath,
+                                         const double idt,
+                                         const double itrack,
+                                         const bool ibackwards,
+                                         const bool imirrored)
+  : drive(idrive),
+    wheels(wheelCount(idrive)),
+    length(static_cast<int>(ipath.size())),
+    dt(idt) {
+  velocities.resize(static_cast<std::size_t>(length) * wheels);
+  accelerations.resize(static_cast<std::size_t>(length) * wheels);
+
+  for (int i = 0; i < length; i++) {
+    const int before = std::max(i - 1, 0);
+    const int after = std::min(i + 1, length - 1);
+    double velocity[HOLONOMIC_MAX_WHEELS], acceleration[HOLONOMIC_MAX_WHEELS];
+    wheelStep(drive, ipath[i], ipath[before], ipath[after], after - before, ipath[0].heading, dt,
+              itrack, ibackwards, imirrored, velocity, acceleration);
+    std::copy(velocity, velocity + wheels, &velocities[static_cast<std::size_t>(i) * wheels]);
+    std::copy(acceleration, acceleration + wheels,
+              &accelerations[static_cast<std::size_t>(i) * wheels]);
+  }
+}
+
+void HolonomicTrajectory::wheelStep(const HolonomicDrive idrive,
+                                    const TrajectorySample &isample,
+                                    const TrajectorySample &ibefore,
+                                    const TrajectorySample &iafter,
+                                    const int isteps,
+                                    const double istartHeading,
+                                    const double idt,
+                                    const double itrack,
+                                    const bool ibackwards,
+                                    const bool imirrored,
+                                    double *ovelocities,
+                                    double *oaccelerations) {
+  const double forwardSign = ibackwards ? -1 : 1;
+  const double leftSign = forwardSign * (imirrored ? -1 : 1);
+  const double v = (isample.leftVelocity + isample.rightVelocity) / 2;
+  const double a = (isample.leftAcceleration + isample.rightAcceleration) / 2;
+
+  // direction of travel relative to where the robot faces, which is the start
+  // of the path, and how fast it turns
+  const double angle = isample.heading - istartHeading;
+  const double turnRate =
+    isteps > 0 ? std::remainder(iafter.heading - ibefore.heading, 2 * M_PI) / (isteps * idt) : 0;
+
+  const double cosAngle = std::cos(angle);
+  const double sinAngle = std::sin(angle);
+
+  wheelSpeeds(idrive, forwardSign * v * cosAngle, leftSign * v * sinAngle, 0, itrack, ovelocities);
+
+  // d/dt of the velocity vector, the path turning changes its direction too
+  wheelSpeeds(idrive, forwardSign * (a * cosAngle - v * sinAngle * turnRate),
+              leftSign * (a * sinAngle + v * cosAngle * turnRate), 0, itrack, oaccelerations);
+}
+
+int HolonomicTrajectory::size() const {
+  return length;
+}
+
+double HolonomicTrajectory::getDt() const {
+  return dt;
+}
+
+int HolonomicTrajectory::getWheelCount() const {
+  return wheels;
+}
+
+double HolonomicTrajectory::velocity(const int istep, const int iwheel) const {
+  return velocities[static_cast<std::size_t>(istep) * wheels + iwheel];
+}
+
+double HolonomicTrajectory::acceleration(const int istep, const int iwheel) const {
+  return accelerations[static_cast<std::size_t>(istep) * wheels + iwheel];
+}
+
+int HolonomicTrajectory::wheelCount(const HolonomicDrive idrive) {
+  return idrive == HolonomicDrive::xDrive ? 4 : 3;
+}
+
+void HolonomicTrajectory::wheelSpeeds(const HolonomicDrive idrive,
+                                      const double iforward,
+                                      const double ileft,
+                                      const double iturn,
+                                      const double itrack,
+                                      double *owheels) {
+  if (idrive == HolonomicDrive::xDrive) {
+    // every wheel rolls diagonally, on a circle of radius track / sqrt(2)
+    const double diagonal = M_SQRT1_2;
+    const double turn = iturn * itrack * M_SQRT1_2;
+    owheels[0] = (iforward - ileft) * diagonal - turn; // top left
+    owheels[1] = (iforward + ileft) * diagonal + turn; // top right
+    owheels[2] = (iforward - ileft) * diagonal + turn; // bottom right
+    owheels[3] = (iforward + ileft) * diagonal - turn; // bottom left
+  } else {
+    const double turn = iturn * itrack / 2;
+    owheels[0] = iforward - turn;     // left
+    owheels[1] = iforward + turn;     // right
+    owheels[2] = -ileft;              // middle
+  }
+}
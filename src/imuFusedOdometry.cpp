@@ -0,0 +1,73 @@
+// ------- imuFusedOdometry.cpp ------------------------------------------------
+//
+// Complementary filter of tracking wheel and IMU heading, see imuFusedOdometry.h
+
+#include "imuFusedOdometry.h"
+#include "robotLog.h"
+
+#include <cmath>
+
+ImuFusedOdometry::ImuFusedOdometry(const okapi::TimeUtil &itimeUtil,
+                                   const std::shared_ptr<okapi::ReadOnlyChassisModel> &imodel,
+                                   const std::shared_ptr<okapi::ContinuousRotarySensor> &iimu,
+                                   const okapi::ChassisScales &ichassisScales,
+                                   const double iimuWeight,
+                                   const okapi::QFrequency &isampleRate,
+                                   const std::shared_ptr<okapi::Logger> &ilogger)
+  : HighRateOdometry(itimeUtil, imodel, ichassisScales, isampleRate, 100000, ilogger),
+    imu(iimu),
+    imuWeight(std::fmin(std::fmax(iimuWeight, 0.0), 1.0)) {
+}
+
+double ImuFusedOdometry::sampleGain(const double iimuWeight, const double idt) {
+  // remove iimuWeight of the error per second, independent of the sample rate
+  return 1 - std::pow(1 - iimuWeight, idt);
+}
+
+double ImuFusedOdometry::readImu() const {
+  const double heading = imu->get();
+  if (!std::isfinite(heading) || heading == okapi::OKAPI_PROS_ERR) {
+    return NAN;
+  }
+  return heading * okapi::degreeToRadian;
+}
+
+OdomPose ImuFusedOdometry::odomMathStep(const OdomPose &ipose,
+                                        const double ileftDiff,
+                                        const double irightDiff,
+                                        const double idt) {
+  const double deltaLeft = ileftDiff / chassisScales.straight;
+  const double deltaRight = irightDiff / chassisScales.straight;
+  const double track = chassisScales.wheelTrack.convert(okapi::meter);
+  const double encoderDeltaTheta = (deltaLeft - deltaRight) / track;
+
+  double deltaTheta = encoderDeltaTheta;
+
+  const double imuHeading = readImu();
+  if (!std::isnan(imuHeading)) {
+    if (!haveImuOffset) {
+      imuOffset = ipose.theta - imuHeading;
+      haveImuOffset = true;
+    }
+
+    // pull the encoder prediction towards the IMU heading, the error is wrapped
+    // so the correction always goes the short way round
+    const double predicted = ipose.theta + encoderDeltaTheta;
+    const double error = std::remainder(imuHeading + imuOffset - predicted, 2 * okapi::pi);
+    deltaTheta += sampleGain(imuWeight, idt) * error;
+
+    ROBOT_LOG_DEBUG("ImuFusedOdometry: encoder dtheta {} imu error {}", encoderDeltaTheta, error);
+  }
+
+  return OdomArcMath::step(ipose, deltaLeft, deltaRight, deltaTheta, track);
+}
+
+void ImuFusedOdometry::onStateSet(const OdomPose &ipose) {
+  const double imuHeading = readImu();
+  if (!std::isnan(imuHeading)) {
+    imuOffset = ipose.theta - imuHeading;
+    haveImuOffset = true;
+  } else {
+    haveImuOffset = false;
+  }
+}
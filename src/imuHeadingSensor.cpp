@@ -0,0 +1,31 @@
+// ------- imuHeadingSensor.cpp ------------------------------------------------
+//
+// pros::Imu heading as an okapi sensor, see imuHeadingSensor.h
+
+#include "imuHeadingSensor.h"
+
+#include <cmath>
+
+ImuHeadingSensor::ImuHeadingSensor(pros::Imu &iimu) : imu(iimu) {
+}
+
+double ImuHeadingSensor::get() const {
+  const double rotation = imu.get_rotation();
+  if (!std::isfinite(rotation)) {
+    return rotation;
+  }
+  return rotation - offset;
+}
+
+std::int32_t ImuHeadingSensor::reset() {
+  const double rotation = imu.get_rotation();
+  if (!std::isfinite(rotation)) {
+    return PROS_ERR;
+  }
+  offset = rotation;
+  return 1;
+}
+
+double ImuHeadingSensor::controllerGet() {
+  return get();
+}
@@ -0,0 +1,296 @@
+// ------- kalmanOdometry.cpp --------------------------------------------------
+//
+// Kalman filter fusion of tracking wheels, motor encoders and IMU, see
+// kalmanOdometry.h
+
+#include "kalmanOdometry.h"
+#include "robotLog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#define KALMAN_X 0                    // state indices
+#define KALMAN_Y 1
+#define KALMAN_THETA 2
+#define KALMAN_V 3
+#define KALMAN_OMEGA 4
+
+KalmanOdometry::KalmanOdometry(const okapi::TimeUtil &itimeUtil,
+                               const std::shared_ptr<okapi::ReadOnlyChassisModel> &imodel,
+                               const okapi::ChassisScales &ichassisScales,
+                               const std::shared_ptr<okapi::ReadOnlyChassisModel> &imotorModel,
+                               const okapi::ChassisScales &imotorScales,
+                               const std::shared_ptr<okapi::ContinuousRotarySensor> &iimu,
+                               const KalmanOdometryNoise &inoise,
+                               const okapi::QFrequency &isampleRate,
+                               const std::shared_ptr<okapi::Logger> &ilogger)
+  : HighRateOdometry(itimeUtil, imodel, ichassisScales, isampleRate, 100000, ilogger),
+    motorModel(imotorModel),
+    motorScales(imotorScales),
+    imu(iimu),
+    noise(inoise),
+    motorSnapshotSource(dynamic_cast<const SensorSnapshotSource *>(imotorModel.get())),
+    filter(Filter::State(), initialCovariance()) {
+  if (motorModel && motorSnapshotSource == nullptr) {
+    LOG_WARN_S("KalmanOdometry: Motor model has no SensorSnapshotSource, every sample will "
+               "allocate.");
+  }
+}
+
+KalmanOdometry::Filter::Covariance KalmanOdometry::initialCovariance() {
+  // the pose is what setState() says, the robot is standing still
+  return Filter::Covariance::diagonal({1e-6, 1e-6, 1e-6, 1e-4, 1e-4});
+}
+
+std::array<double, 4> KalmanOdometry::getVelocityEstimate() const {
+  return velocityEstimate.read();
+}
+
+double KalmanOdometry::readImu() const {
+  if (!imu) {
+    return NAN;
+  }
+  const double heading = imu->get();
+  if (!std::isfinite(heading) || heading == okapi::OKAPI_PROS_ERR) {
+    return NAN;
+  }
+  return heading * okapi::degreeToRadian;
+}
+
+bool KalmanOdometry::readMotors() {
+  if (motorSnapshotSource != nullptr) {
+    motorSnapshotSource->getSensorVals(motorTicks);
+  } else {
+    const std::valarray<std::int32_t> vals = motorModel->getSensorVals();
+    motorTicks.count = std::min(vals.size(), motorTicks.vals.size());
+    for (std::size_t i = 0; i < motorTicks.count; i++) {
+      motorTicks.vals[i] = vals[i];
+    }
+  }
+  return motorTicks.count >= 2;
+}
+
+OdomPose KalmanOdometry::odomMathStep(const OdomPose &,
+                                      const double ileftDiff,
+                                      const double irightDiff,
+                                      const double idt) {
+  // velocities are a random walk over the sample
+  const double accel = noise.acceleration * idt;
+  const double angularAccel = noise.angularAcceleration * idt;
+  filter.diffuse(
+    Filter::Covariance::diagonal({0, 0, 0, accel * accel, angularAccel * angularAccel}));
+
+  const bool wheelsUsed = updateTrackingWheels(ileftDiff, irightDiff, idt);
+  if (motorModel) {
+    updateMotors();
+  }
+
+  // the tick counts are exact where the velocities are smoothed, so the pose
+  // follows the tracking wheels unless their sample was rejected
+  if (wheelsUsed) {
+    moveByWheels(ileftDiff / chassisScales.straight, irightDiff / chassisScales.straight);
+  } else {
+    moveByVelocity(idt);
+  }
+  updateImu();
+
+  const auto &x = filter.getState();
+  const auto &p = filter.getCovariance();
+  velocityEstimate.write(
+    {x[KALMAN_V], x[KALMAN_OMEGA], p(KALMAN_V, KALMAN_V), p(KALMAN_OMEGA, KALMAN_OMEGA)});
+
+  ROBOT_LOG_DEBUG("KalmanOdometry: v {} omega {} var theta {}", x[KALMAN_V], x[KALMAN_OMEGA],
+                  p(KALMAN_THETA, KALMAN_THETA));
+
+  return OdomPose{x[KALMAN_X], x[KALMAN_Y], x[KALMAN_THETA]};
+}
+
+template <std::size_t m>
+bool KalmanOdometry::update(const FixedVector<m> &iinnovation,
+                            const FixedMatrix<m, KALMAN_ODOM_STATES> &ijacobian,
+                            const FixedMatrix<m, m> &inoise,
+                            int &irejects) {
+  const double gate = irejects >= KALMAN_ODOM_MAX_REJECTS
+                        ? std::numeric_limits<double>::infinity()
+                        : KALMAN_ODOM_GATE;
+  if (filter.update(iinnovation, ijacobian, inoise, gate)) {
+    irejects = 0;
+    return true;
+  }
+
+  irejects++;
+  ROBOT_LOG_DEBUG("KalmanOdometry: rejected sample, distance {}", filter.getLastDistance());
+  return false;
+}
+
+bool KalmanOdometry::updateTrackingWheels(const double ileftDiff,
+                                          const double irightDiff,
+                                          const double idt) {
+  const auto &x = filter.getState();
+  const double deltaLeft = ileftDiff / chassisScales.straight;
+  const double deltaRight = irightDiff / chassisScales.straight;
+  const double track = chassisScales.wheelTrack.convert(okapi::meter);
+
+  FixedVector<2> innovation;
+  innovation[0] = (deltaLeft + deltaRight) / 2 / idt - x[KALMAN_V];
+  innovation[1] = (deltaLeft - deltaRight) / track / idt - x[KALMAN_OMEGA];
+
+  FixedMatrix<2, KALMAN_ODOM_STATES> h;
+  h(0, KALMAN_V) = 1;
+  h(1, KALMAN_OMEGA) = 1;
+
+  // independent wheel noise: the mean and the difference of the wheels are uncorrelated
+  const double wheelVariance = noise.trackingWheel * noise.trackingWheel / (idt * idt);
+  const auto r =
+    FixedMatrix<2, 2>::diagonal({wheelVariance / 2, 2 * wheelVariance / (track * track)});
+
+  return update(innovation, h, r, rejects[0]);
+}
+
+void KalmanOdometry::updateMotors() {
+  if (!readMotors()) {
+    return;
+  }
+
+  // lastMicros is the time of the sample being integrated, see HighRateOdometry::sample()
+  if (!haveLastMotorTicks) {
+    lastMotorTicks = motorTicks;
+    lastMotorMicros = lastMicros;
+    haveLastMotorTicks = true;
+    return;
+  }
+  if (lastMicros == lastMotorMicros) {
+    return;
+  }
+
+  const double deltaLeft = (motorTicks[0] - lastMotorTicks[0]) / motorScales.straight;
+  const double deltaRight = (motorTicks[1] - lastMotorTicks[1]) / motorScales.straight;
+  const double dt = (lastMicros - lastMotorMicros) / 1e6;
+  lastMotorTicks = motorTicks;
+  lastMotorMicros = lastMicros;
+
+  // forward speed only: skid steer wheels scrub sideways in a turn, so the
+  // turn rate of the drive wheels depends on the floor more than on the track
+  FixedVector<1> innovation;
+  innovation[0] = (deltaLeft + deltaRight) / 2 / dt - filter.getState()[KALMAN_V];
+
+  FixedMatrix<1, KALMAN_ODOM_STATES> h;
+  h(0, KALMAN_V) = 1;
+
+  FixedMatrix<1, 1> r;
+  r(0, 0) = noise.motorWheel * noise.motorWheel / (dt * dt) / 2;
+
+  update(innovation, h, r, rejects[1]);
+}
+
+void KalmanOdometry::moveByWheels(const double ideltaLeft, const double ideltaRight) {
+  const auto &x = filter.getState();
+  const double track = chassisScales.wheelTrack.convert(okapi::meter);
+  const double distance = (ideltaLeft + ideltaRight) / 2;
+  const double deltaTheta = (ideltaLeft - ideltaRight) / track;
+
+  const OdomPose next = OdomArcMath::step(OdomPose{x[KALMAN_X], x[KALMAN_Y], x[KALMAN_THETA]},
+                                         ideltaLeft, ideltaRight, deltaTheta, track);
+
+  Filter::State predicted = x;
+  predicted[KALMAN_X] = next.x;
+  predicted[KALMAN_Y] = next.y;
+  predicted[KALMAN_THETA] = next.theta;
+
+  // Jacobians of the chord approximation of the arc, along the average heading,
+  // by the previous state and by the two wheel travels
+  const double averageTheta = x[KALMAN_THETA] + deltaTheta / 2;
+  const double cosTheta = std::cos(averageTheta);
+  const double sinTheta = std::sin(averageTheta);
+  auto f = Filter::Covariance::identity();
+  f(KALMAN_X, KALMAN_THETA) = -distance * sinTheta;
+  f(KALMAN_Y, KALMAN_THETA) = distance * cosTheta;
+
+  FixedMatrix<KALMAN_ODOM_STATES, 2> g;
+  g(KALMAN_X, 0) = cosTheta / 2 - distance * sinTheta / (2 * track);
+  g(KALMAN_X, 1) = cosTheta / 2 + distance * sinTheta / (2 * track);
+  g(KALMAN_Y, 0) = sinTheta / 2 + distance * cosTheta / (2 * track);
+  g(KALMAN_Y, 1) = sinTheta / 2 - distance * cosTheta / (2 * track);
+  g(KALMAN_THETA, 0) = 1 / track;
+  g(KALMAN_THETA, 1) = -1 / track;
+
+  const double wheelVariance = noise.trackingWheel * noise.trackingWheel;
+  const auto wheelNoise = FixedMatrix<2, 2>::diagonal({wheelVariance, wheelVariance});
+
+  filter.predict(predicted, f, g * wheelNoise * g.transpose());
+}
+
+void KalmanOdometry::moveByVelocity(const double idt) {
+  const auto &x = filter.getState();
+  const double track = chassisScales.wheelTrack.convert(okapi::meter);
+  const double distance = x[KALMAN_V] * idt;
+  const double deltaTheta = x[KALMAN_OMEGA] * idt;
+
+  const OdomPose next = OdomArcMath::step(OdomPose{x[KALMAN_X], x[KALMAN_Y], x[KALMAN_THETA]},
+                                         distance + deltaTheta * track / 2,
+                                         distance - deltaTheta * track / 2, deltaTheta, track);
+
+  Filter::State predicted = x;
+  predicted[KALMAN_X] = next.x;
+  predicted[KALMAN_Y] = next.y;
+  predicted[KALMAN_THETA] = next.theta;
+
+  // Jacobian of the chord approximation of the arc, along the average heading
+  const double averageTheta = x[KALMAN_THETA] + deltaTheta / 2;
+  const double cosTheta = std::cos(averageTheta);
+  const double sinTheta = std::sin(averageTheta);
+  auto f = Filter::Covariance::identity();
+  f(KALMAN_X, KALMAN_THETA) = -distance * sinTheta;
+  f(KALMAN_X, KALMAN_V) = idt * cosTheta;
+  f(KALMAN_X, KALMAN_OMEGA) = -distance * sinTheta * idt / 2;
+  f(KALMAN_Y, KALMAN_THETA) = distance * cosTheta;
+  f(KALMAN_Y, KALMAN_V) = idt * sinTheta;
+  f(KALMAN_Y, KALMAN_OMEGA) = distance * cosTheta * idt / 2;
+  f(KALMAN_THETA, KALMAN_OMEGA) = idt;
+
+  filter.predict(predicted, f, Filter::Covariance());
+}
+
+void KalmanOdometry::updateImu() {
+  const double imuHeading = readImu();
+  if (std::isnan(imuHeading)) {
+    return;
+  }
+
+  const auto &x = filter.getState();
+  if (!haveImuOffset) {
+    imuOffset = x[KALMAN_THETA] - imuHeading;
+    haveImuOffset = true;
+    return;
+  }
+
+  // wrapped so the correction always goes the short way round
+  FixedVector<1> innovation;
+  innovation[0] = std::remainder(imuHeading + imuOffset - x[KALMAN_THETA], 2 * okapi::pi);
+
+  FixedMatrix<1, KALMAN_ODOM_STATES> h;
+  h(0, KALMAN_THETA) = 1;
+
+  FixedMatrix<1, 1> r;
+  r(0, 0) = noise.imuHeading * noise.imuHeading;
+
+  update(innovation, h, r, rejects[2]);
+}
+
+void KalmanOdometry::onStateSet(const OdomPose &ipose) {
+  Filter::State x = filter.getState();
+  x[KALMAN_X] = ipose.x;
+  x[KALMAN_Y] = ipose.y;
+  x[KALMAN_THETA] = ipose.theta;
+  filter.reset(x, initialCovariance());
+  rejects.fill(0);
+
+  const double imuHeading = readImu();
+  if (!std::isnan(imuHeading)) {
+    imuOffset = ipose.theta - imuHeading;
+    haveImuOffset = true;
+  } else {
+    haveImuOffset = false;
+  }
+}
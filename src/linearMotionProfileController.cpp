@@ -0,0 +1,155 @@
+// ------- linearMotionProfileController.cpp -----------------------------------
+//
+// Linear motion profile controller with compact paths and views, see
+// linearMotionProfileController.h
+
+#include "linearMotionProfileController.h"
+
+#include <cstdlib>
+#include <mutex>
+
+void LinearMotionProfileController::generatePath(std::initializer_list<okapi::QLength> iwaypoints,
+                                                 const std::string &ipathId) {
+  okapi::AsyncLinearMotionProfileController::generatePath(iwaypoints, ipathId);
+
+  std::scoped_lock lock(currentPathMutex);
+  auto path = paths.find(ipathId);
+  if (path == paths.end() || path->second.segment == nullptr) {
+    return;
+  }
+
+  // a full path replaces any compact one or view with the same id
+  sharedPaths.erase(ipathId);
+
+  const TrajectoryStorage current = storage.load(std::memory_order_acquire);
+  if (current == TrajectoryStorage::full ||
+      (isRunning.load(std::memory_order_acquire) && currentPath == ipathId)) {
+    return;
+  }
+
+  const int length = path->second.length;
+  sharedPaths.emplace(ipathId, std::make_shared<const CompactTrajectory>(
+                                  path->second.segment.get(), nullptr, length, current));
+  path->second = TrajectoryPair{SegmentPtr(nullptr, free), length};
+}
+
+bool LinearMotionProfileController::removePath(const std::string &ipathId) {
+  if (!okapi::AsyncLinearMotionProfileController::removePath(ipathId)) {
+    return false;
+  }
+
+  std::scoped_lock lock(currentPathMutex);
+  sharedPaths.erase(ipathId);
+  return true;
+}
+
+void LinearMotionProfileController::setTrajectoryStorage(const TrajectoryStorage istorage) {
+  storage.store(istorage, std::memory_order_release);
+}
+
+TrajectoryStorage LinearMotionProfileController::getTrajectoryStorage() const {
+  return storage.load(std::memory_order_acquire);
+}
+
+std::size_t LinearMotionProfileController::getPathMemory(const std::string &ipathId) {
+  std::scoped_lock lock(currentPathMutex);
+  auto path = paths.find(ipathId);
+  if (path == paths.end()) {
+    return 0;
+  }
+
+  if (path->second.segment != nullptr) {
+    return sizeof(Segment) * static_cast<std::size_t>(path->second.length);
+  }
+
+  auto shared = sharedPaths.find(ipathId);
+  return shared == sharedPaths.end() ? 0 : shared->second->memoryUsage();
+}
+
+TrajectoryView LinearMotionProfileController::getView(const std::string &ipathId) {
+  std::scoped_lock lock(currentPathMutex);
+  if (paths.find(ipathId) == paths.end()) {
+    LOG_WARN("LinearMotionProfileController: There is no path " + ipathId + " to view.");
+    return TrajectoryView();
+  }
+
+  // the view shares the trajectory the path is followed from
+  auto shared = sharePath(ipathId);
+  return shared ? TrajectoryView(shared) : TrajectoryView();
+}
+
+std::shared_ptr<const TrajectorySource>
+LinearMotionProfileController::sharePath(const std::string &ipathId) {
+  auto path = paths.find(ipathId);
+  if (path == paths.end()) {
+    return nullptr;
+  }
+
+  if (path->second.segment == nullptr) {
+    auto shared = sharedPaths.find(ipathId);
+    return shared == sharedPaths.end() ? nullptr : shared->second;
+  }
+
+  const int length = path->second.length;
+  auto segments = std::make_shared<const SegmentTrajectory>(
+    std::move(path->second.segment), SegmentPtr(nullptr, free), length);
+  path->second = TrajectoryPair{SegmentPtr(nullptr, free), length};
+  sharedPaths[ipathId] = segments;
+  return segments;
+}
+
+bool LinearMotionProfileController::storeView(const std::string &ipathId,
+                                              const TrajectoryView &iview) {
+  if (iview.size() == 0 || iview.isPair()) {
+    LOG_ERROR("LinearMotionProfileController: View " + ipathId +
+              " is empty or not a linear path.");
+    return false;
+  }
+
+  std::scoped_lock lock(currentPathMutex);
+  if (isRunning.load(std::memory_order_acquire) && currentPath == ipathId) {
+    LOG_WARN("LinearMotionProfileController: Path " + ipathId +
+             " is running and was not replaced.");
+    return false;
+  }
+
+  const int length = iview.size();
+  paths.erase(ipathId);
+  paths.emplace(ipathId, TrajectoryPair{SegmentPtr(nullptr, free), length});
+  sharedPaths[ipathId] = std::make_shared<const TrajectoryView>(iview);
+  return true;
+}
+
+void LinearMotionProfileController::executeSinglePath(const TrajectoryPair &,
+                                                      std::unique_ptr<okapi::AbstractRate> rate) {
+  // the pair okapi hands in is not used: a full path is followed from a
+  // SegmentTrajectory too, so getView() can share its segments while it runs
+  // and removing it frees nothing under the follower; the shared_ptr keeps the
+  // trajectory alive
+  std::shared_ptr<const TrajectorySource> shared;
+  {
+    std::scoped_lock lock(currentPathMutex);
+    shared = sharePath(currentPath);
+  }
+
+  if (!shared) {
+    LOG_ERROR("LinearMotionProfileController: Path " + currentPath + " has no trajectory.");
+    return;
+  }
+
+  const int reversed = direction.load(std::memory_order_acquire);
+  const double gearset = okapi::toUnderlyingType(pair.internalGearset);
+  const okapi::QTime dt = shared->getDt() * okapi::second;
+
+  for (int i = 0; i < shared->size() && !isDisabled(); i++) {
+    const TrajectorySample sample = shared->get(i);
+    currentProfilePosition = sample.leftPosition;
+
+    const double speed =
+      convertLinearToRotational(sample.leftVelocity * okapi::mps).convert(okapi::rpm) / gearset *
+      reversed;
+    output->controllerSet(speed);
+
+    rate->delayUntil(dt);
+  }
+}
@@ -2,6 +2,17 @@
 #include "portdef.h"
 #include "globals.h"
 #include "autonomous.h"
+#include "asyncLogSink.h"
+#include "dataLoggerFormat.h"
+#include "telemetry.h"
+#include "trackingWheelModel.h"
+#include "highRateOdometry.h"
+#include "imuHeadingSensor.h"
+#include "imuFusedOdometry.h"
+#include "kalmanOdometry.h"
+#include "odomArcMath.h"
+#include "snapshotChassisModels.h"
+#include "purePursuitController.h"
 
 #include <iostream>
 #include <fstream>
@@ -11,6 +22,9 @@
 #define PROGRAM_VERSION "0.4 Alpha"
 #define VERSION_DATE "07-02-2021"
 
+#define ODOM_SAMPLE_RATE 200_Hz // tracking wheel sample rate of the odometry task
+#define IMU_HEADING_WEIGHT 0.9  // share of the heading error corrected by the IMU per second
+
 // ---------------- for serial port config -----------------------------------
 #include <iostream>
 #include <fstream>
@@ -25,6 +39,8 @@
 
 int portID = STDOUT_STREAM_ID;			// what serial port are we going to set
 																		// options for?
+
+#define TELEMETRY_PERIOD_MS 20      // binary telemetry to the RPI radio every 20ms (50Hz)
 // ----------- END serial port config section --------------------------------
 
 // We are writing okapi lib based code make sure that the following in main.h is uncommented:
@@ -50,11 +66,22 @@ void initialize() {
 	pros::c::serctl(SERCTL_DISABLE_COBS, &portID);	// disable byte stuffing COBS
   // --------------------- END serial config ----------------------------------
 
+	if(ODOM_USE_IMU || ODOM_USE_KALMAN) {
+		// The IMU must not move while it calibrates (about 2 seconds)
+		std::cout << "Calibrating IMU \n";
+		imu_sensor.reset();
+		while(imu_sensor.is_calibrating()) {
+			pros::delay(10);
+		}
+	}
+
 	std::cout << "Setting OKAPI log level \n";
+	// Log lines are queued and written to the terminal by a background task so
+	// the odometry and chassis tasks never wait on the serial port
 	okapi::Logger::setDefaultLogger(
 			std::make_shared<okapi::Logger>(
 					okapi::TimeUtilFactory::createDefault().getTimer(), // It needs a Timer
-					"/ser/sout", // Output to the PROS terminal
+					asyncLogSinkOpen("/ser/sout"), // Output to the PROS terminal
 					okapi::Logger::LogLevel::info // Show info, errors and warnings -- warn, debug, info
 			)
 	);
@@ -117,24 +144,36 @@ void opcontrol() {
 	// Lets facilitate logging to the USD file system for a record of our movements
 	// if we are opeining a FILE logger we must also ensure that we coloe it in the end
 	// using the call to usdLoggerClose()
-	if(usdLoggerOpen()) {
-		usdLogEnable = true;					// Set a local flag indicating we cna log to the filesystem
+	// Program run and version are stored in the log file header
+	if(usdLoggerOpen(RUN_VARIABLE, PROGRAM_VERSION, VERSION_DATE)) {
 		std::cout << "USD logger setup succeeded and enabled\n";
 	}
-	if(usdLogEnable) {
-		myUsdFile << "Program Run: " << RUN_VARIABLE << " Program Version: " << PROGRAM_VERSION;
-		myUsdFile << " Version Date: " << VERSION_DATE << " \n";
-	}
 
 
   // Now lets drive....
 	if(encoderTest) {
     // temporary test mode, intended for pushing chassis and seeing if tracking wheel encoders
 		// when robot is pushed forward are giving both postivie number increments.
+		// The tick stream is also recorded to the USD log (marker MARK_TRACE) so pushes
+		// can be replayed through the odometry math on a PC later. The pose of each record
+		// is integrated from the same ticks with the tracking wheel arc model (same scales
+		// as the odometry below), so a replay can be checked against it.
+		okapi::ChassisScales traceScales({0.06985_m, 0.2450_m}, okapi::quadEncoderTPR);
+		OdomPose tracePose;
+		std::int32_t lastLeft = encoderLeft.get_value();
+		std::int32_t lastRight = encoderRight.get_value();
 		while (true) {
+			const std::int32_t left = encoderLeft.get_value();
+			const std::int32_t right = encoderRight.get_value();
+			tracePose = OdomArcMath::stepTicks(tracePose, left - lastLeft, right - lastRight, traceScales);
+			lastLeft = left;
+			lastRight = right;
+			currentState = OdomArcMath::toState(tracePose, okapi::StateMode::FRAME_TRANSFORMATION);
+
 			// for debugging purppose get encoder counts as well and show on console
-			std::cout << pros::c::millis() << "\t Encoder LEFT value: " << encoderLeft.get_value() << " -- ";
-		  std::cout << "RIGHT value: " << encoderRight.get_value() << "\n";
+			std::cout << pros::c::millis() << "\t Encoder LEFT value: " << left << " -- ";
+		  std::cout << "RIGHT value: " << right << "\n";
+			robotDataLogger(currentState, MARK_TRACE);
 
       pros::delay(20);
 		}
@@ -143,6 +182,39 @@ void opcontrol() {
 
 		std::cout << "Setting up odometer in Okapi Lib \n";
 
+		// The tracking wheels are sampled by our own odometry task at ODOM_SAMPLE_RATE, independent
+		// of the chassis controller. Same ports and scales as the withOdometry() call below.
+		// METRIC: 0.06985m diameter -- 0.2450m wheel base
+		std::shared_ptr<TrackingWheelModel> odomModel = std::make_shared<TrackingWheelModel>(
+			std::make_shared<okapi::ADIEncoder>('C', 'D'), std::make_shared<okapi::ADIEncoder>('A', 'B'));
+		okapi::ChassisScales odomScales({0.06985_m, 0.2450_m}, okapi::quadEncoderTPR);
+
+		std::shared_ptr<HighRateOdometry> odometry;
+		if(ODOM_USE_KALMAN) {
+			// tracking wheels, drive motor encoders and IMU fused in a Kalman filter. This model only
+			// reads the drive motor encoders, the chassis controller below still drives the motors.
+			std::shared_ptr<okapi::MotorGroup> leftDrive = std::make_shared<okapi::MotorGroup>(
+				std::initializer_list<okapi::Motor>{LEFT_MOTOR_FRONT, LEFT_MOTOR_BACK});
+			std::shared_ptr<okapi::MotorGroup> rightDrive = std::make_shared<okapi::MotorGroup>(
+				std::initializer_list<okapi::Motor>{RIGHT_MOTOR_FRONT, RIGHT_MOTOR_BACK});
+			std::shared_ptr<SnapshotSkidSteerModel> driveModel = std::make_shared<SnapshotSkidSteerModel>(
+				leftDrive, rightDrive, leftDrive->getEncoder(), rightDrive->getEncoder(), 200, 12000);
+			// same dimensions as withDimensions() below
+			okapi::ChassisScales driveScales({0.1016_m, 0.3750_m}, okapi::imev5GreenTPR);
+
+			odometry = std::make_shared<KalmanOdometry>(okapi::TimeUtilFactory::createDefault(),
+				odomModel, odomScales, driveModel, driveScales, std::make_shared<ImuHeadingSensor>(imu_sensor),
+				KalmanOdometryNoise(), ODOM_SAMPLE_RATE);
+		} else if(ODOM_USE_IMU) {
+			// heading from the tracking wheels corrected by the IMU (calibrated in initialize())
+			odometry = std::make_shared<ImuFusedOdometry>(okapi::TimeUtilFactory::createDefault(),
+				odomModel, std::make_shared<ImuHeadingSensor>(imu_sensor), odomScales, IMU_HEADING_WEIGHT,
+				ODOM_SAMPLE_RATE);
+		} else {
+			odometry = std::make_shared<HighRateOdometry>(okapi::TimeUtilFactory::createDefault(),
+				odomModel, odomScales, ODOM_SAMPLE_RATE);
+		}
+
 		std::shared_ptr<okapi::OdomChassisController> chassis =
 			okapi::ChassisControllerBuilder()
 				.withMotors({LEFT_MOTOR_FRONT, LEFT_MOTOR_BACK}, {RIGHT_MOTOR_FRONT, RIGHT_MOTOR_BACK}) // left motor is 1, right motor is 2 (reversed)
@@ -155,17 +227,21 @@ void opcontrol() {
 				// specify the tracking wheels diameter (2.75 in), track (9.75 in), and TPR (360)
 				// METRIC: 0.06985m diameter -- 0.2450m wheel base
 				//.withOdometry({{2.75_in, 9.75_in}, okapi::quadEncoderTPR}, okapi::StateMode::FRAME_TRANSFORMATION)
-				.withOdometry({{0.06985_m, 0.2450_m}, okapi::quadEncoderTPR}, okapi::StateMode::FRAME_TRANSFORMATION)
+				//.withOdometry({{0.06985_m, 0.2450_m}, okapi::quadEncoderTPR}, okapi::StateMode::FRAME_TRANSFORMATION)
+				.withOdometry(odometry, okapi::StateMode::FRAME_TRANSFORMATION)
 				.buildOdometry();
 
+		odometry->startThread();
+
+		// stream odometry and motor state to the RPI radio while we drive
+		telemetryStart(chassis, TELEMETRY_PERIOD_MS);
+
 		// Set the chassis maximum velocity to 100 RPM (range is 0 - 600RPM)
 		std::cout << "Set the maximum velocity to: 100RPM \n";
-		if(usdLogEnable) { myUsdFile << pros::c::millis() << "\t Set the maximum velocity to: 100RPM \n"; }
     chassis->setMaxVelocity(100);
 
 		// set the state to zero
 		std::cout << "Setting starting position of 0,0,0 \n";
-		if(usdLogEnable) { myUsdFile << pros::c::millis() << "\t Setting starting position of 0,0,0 \n"; }
 
 		chassis->setState({0_m, 0_m, 0_deg});
 		// for debugging purppose get encoder counts as well and show on console
@@ -175,11 +251,7 @@ void opcontrol() {
 		currentState = chassis->getState();
 		std::cout << "Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << " ";
 		std::cout << std::to_string(currentState.y.convert(okapi::meter)) << " " << std::to_string(currentState.theta.convert(okapi::degree)) << "\n";
-		if(usdLogEnable) { myUsdFile << pros::c::millis() << "\t Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << "m ";
-			myUsdFile << std::to_string(currentState.y.convert(okapi::meter)) << "m " << std::to_string(currentState.theta.convert(okapi::degree)) << "Deg. \n";
-			myUsdFile << pros::c::millis() << "\t Encoder LEFT value: " << encoderLeft.get_value() << " -- ";
-			myUsdFile << "RIGHT value: " << encoderRight.get_value() << "\n";
-		}
+		robotDataLogger(currentState, MARK_START);
 
     // drive to a point 1m in front of robot
 		std:: cout << "Drive 1m straight forward \n";
@@ -192,11 +264,7 @@ void opcontrol() {
 		currentState = chassis->getState();
 		std::cout << "Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << " ";
 		std::cout << std::to_string(currentState.y.convert(okapi::meter)) << " " << std::to_string(currentState.theta.convert(okapi::degree)) << "\n";
-		if(usdLogEnable) { myUsdFile << pros::c::millis() << "\t Drive 1m straight forward \n";
-			myUsdFile << pros::c::millis() << "\t Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << "m ";myUsdFile << std::to_string(currentState.y.convert(okapi::meter)) << "m " << std::to_string(currentState.theta.convert(okapi::degree)) << "Deg. \n";
-			myUsdFile << pros::c::millis() << "\t Encoder LEFT value: " << encoderLeft.get_value() << " -- ";
-			myUsdFile << "RIGHT value: " << encoderRight.get_value() << "\n";
-		}
+		robotDataLogger(currentState, MARK_DRIVE_FORWARD);
 
 		// For testing purpose we are resetting Odometer frame to 0,0,0 to see if we get a nice 45degree turn
 		// at the end of the 1m forward move action
@@ -211,16 +279,21 @@ void opcontrol() {
 		currentState = chassis->getState();
 		std::cout << "Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << " ";
 		std::cout << std::to_string(currentState.y.convert(okapi::meter)) << " " << std::to_string(currentState.theta.convert(okapi::degree)) << "\n";
-		if(usdLogEnable) { myUsdFile << pros::c::millis() << "\t Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << "m ";
-			myUsdFile << std::to_string(currentState.y.convert(okapi::meter)) << "m " << std::to_string(currentState.theta.convert(okapi::degree)) << "Deg. \n";
-			myUsdFile << pros::c::millis() << "\t Encoder LEFT value: " << encoderLeft.get_value() << " -- ";
-			myUsdFile << "RIGHT value: " << encoderRight.get_value() << "\n";
+		robotDataLogger(currentState, MARK_RESET);
+
+		if(USE_PURE_PURSUIT) {
+			// curve to 1m, 1m without stopping to turn first
+			std::cout << "Following pure pursuit path to 1m, 1m \n";
+			PurePursuitController follower(okapi::TimeUtilFactory::createDefault(), chassis);
+			PursuitPathLimits limits;
+			limits.maxVelocity = follower.getMaxSpeed();
+			follower.followPath({{0_m, 0_m}, {0.5_m, 0_m}, {1_m, 0.5_m}, {1_m, 1_m}}, limits);
+		} else {
+			// turn 45 degrees and drive approximately 1.4m
+			std::cout << "Setting 45degree pivot 1m, 1m \n";
+			chassis->driveToPoint({1_m, 1_m});
 		}
 
-		// turn 45 degrees and drive approximately 1.4m
-		std::cout << "Setting 45degree pivot 1m, 1m \n";
-		chassis->driveToPoint({1_m, 1_m});
-
 		currentState = chassis->getState();
 		// for debugging purppose get encoder counts as well and show on console
 		std::cout << "Encoder LEFT value: " << encoderLeft.get_value() << " -- ";
@@ -228,11 +301,7 @@ void opcontrol() {
 
 		std::cout << "Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << " ";
 		std::cout << std::to_string(currentState.y.convert(okapi::meter)) << " " << std::to_string(currentState.theta.convert(okapi::degree)) << "\n";
-		if(usdLogEnable) { myUsdFile << pros::c::millis() << "\t 45degree turn 1m,1m,0 \n";
-			myUsdFile << pros::c::millis() << "\t Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << "m ";myUsdFile << std::to_string(currentState.y.convert(okapi::meter)) << "m " << std::to_string(currentState.theta.convert(okapi::degree)) << "Deg. \n";
-			myUsdFile << pros::c::millis() << "\t Encoder LEFT value: " << encoderLeft.get_value() << " -- ";
-			myUsdFile << "RIGHT value: " << encoderRight.get_value() << "\n";
-		}
+		robotDataLogger(currentState, MARK_PIVOT);
 
 		// Face a 90 degree angle -- turning in place.
 		std::cout << "Turning to 90degree heading \n";
@@ -245,11 +314,10 @@ void opcontrol() {
 		currentState = chassis->getState();
 		std::cout << "Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << " ";
 		std::cout << std::to_string(currentState.y.convert(okapi::meter)) << " " << std::to_string(currentState.theta.convert(okapi::degree)) << "\n";
-		if(usdLogEnable) { myUsdFile << pros::c::millis() << "\t Turning to 90degree heading \n";
-			myUsdFile << pros::c::millis() << "\t Get state: " << std::to_string(currentState.x.convert(okapi::meter)) << "m ";myUsdFile << std::to_string(currentState.y.convert(okapi::meter)) << "m " << std::to_string(currentState.theta.convert(okapi::degree)) << "Deg. \n";
-			myUsdFile << pros::c::millis() << "\t Encoder LEFT value: " << encoderLeft.get_value() << " -- ";
-			myUsdFile << "RIGHT value: " << encoderRight.get_value() << "\n";
-		}	}
+		robotDataLogger(currentState, MARK_TURN);
+
+		telemetryStop();
+	}
 
 	// Make sure that if we used USD file logging, we close it before the program ends
   if (usdLogEnable) {
@@ -0,0 +1,1010 @@
+// ------- motionProfileController.cpp -----------------------------------------
+//
+// Project motion profile controller, see motionProfileController.h
+
+#include "motionProfileController.h"
+#include "pathGeneration.h"
+#include "telemetry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <valarray>
+
+#ifdef THREADS_STD
+#include <chrono>
+#include <thread>
+#endif
+
+#define PATH_GENERATOR_IDLE_MS 10     // how often the idle generator task looks for work
+#define PATH_WAIT_POLL_MS 5           // how often a task waiting for a path checks it
+
+static void pathTaskDelay(const std::uint32_t ims) {
+#ifdef THREADS_STD
+  std::this_thread::sleep_for(std::chrono::milliseconds(ims));
+#else
+  pros::delay(ims);
+#endif
+}
+
+PathHandle::PathHandle(std::shared_ptr<std::atomic<status>> istate) : state(std::move(istate)) {
+}
+
+PathHandle::status PathHandle::getStatus() const {
+  return state ? state->load(std::memory_order_acquire) : status::failed;
+}
+
+bool PathHandle::isReady() const {
+  return getStatus() == status::ready;
+}
+
+bool PathHandle::waitUntilReady() const {
+  while (getStatus() == status::pending) {
+    pathTaskDelay(PATH_WAIT_POLL_MS);
+  }
+  return isReady();
+}
+
+MotionProfileController::~MotionProfileController() {
+  generatorStop.store(true, std::memory_order_release);
+  if (generatorTask != nullptr) {
+    while (!generatorDone.load(std::memory_order_acquire)) {
+      pathTaskDelay(PATH_WAIT_POLL_MS);
+    }
+    delete generatorTask;
+  }
+}
+
+void MotionProfileController::setPathBlob(const std::shared_ptr<PathBlob> &iblob) {
+  blob = iblob;
+
+  if (blob && std::abs(blob->getWheelTrack() - scales.wheelTrack.convert(okapi::meter)) > 0.001) {
+    LOG_WARN("MotionProfileController: Blob paths were generated for a wheel track of " +
+             std::to_string(blob->getWheelTrack()) + " m, the chassis has " +
+             std::to_string(scales.wheelTrack.convert(okapi::meter)) + " m");
+  }
+}
+
+bool MotionProfileController::loadBlobPath(const std::string &ipathId) {
+  {
+    std::scoped_lock lock(currentPathMutex);
+    if (paths.find(ipathId) != paths.end()) {
+      return true;
+    }
+  }
+
+  if (!blob) {
+    return false;
+  }
+
+  const int length = blob->getLength(ipathId);
+  if (length <= 0) {
+    return false;
+  }
+
+  SegmentPtr left(static_cast<Segment *>(malloc(sizeof(Segment) * length)), free);
+  SegmentPtr right(static_cast<Segment *>(malloc(sizeof(Segment) * length)), free);
+  if (left == nullptr || right == nullptr) {
+    LOG_ERROR("MotionProfileController: Could not allocate path " + ipathId);
+    return false;
+  }
+
+  if (!blob->read(ipathId, left.get(), right.get())) {
+    return false;
+  }
+
+  LOG_INFO("MotionProfileController: Loaded path " + ipathId + " from the blob, " +
+           std::to_string(length) + " segments");
+
+  std::scoped_lock lock(currentPathMutex);
+  if (paths.emplace(ipathId, TrajectoryPair{std::move(left), std::move(right), length}).second) {
+    compactStoredPath(ipathId);
+  }
+  return true;
+}
+
+void MotionProfileController::generatePath(std::initializer_list<okapi::PathfinderPoint> iwaypoints,
+                                           const std::string &ipathId) {
+  generatePath(iwaypoints, ipathId, limits);
+}
+
+void MotionProfileController::generatePath(std::initializer_list<okapi::PathfinderPoint> iwaypoints,
+                                           const std::string &ipathId,
+                                           const okapi::PathfinderLimits &ilimits) {
+  if (iwaypoints.size() == 0) {
+    return;
+  }
+
+  // PathGeneration instead of okapi's generatePath(), for the quadrature arc
+  // length and the selectable generator
+  PathJob job{ipathId, {}, ilimits, nullptr, generator.load(std::memory_order_acquire)};
+  for (const auto &point : iwaypoints) {
+    job.waypoints.push_back(Waypoint{point.x.convert(okapi::meter), point.y.convert(okapi::meter),
+                                     point.theta.convert(okapi::radian)});
+  }
+
+  // like okapi's generatePath(), an impossible path throws
+  if (!generateJob(job)) {
+    throw std::runtime_error("MotionProfileController: Could not generate path " + ipathId);
+  }
+}
+
+bool MotionProfileController::removePath(const std::string &ipathId) {
+  if (!okapi::AsyncMotionProfileController::removePath(ipathId)) {
+    return false;
+  }
+
+  std::scoped_lock lock(currentPathMutex);
+  sharedPaths.erase(ipathId);
+  return true;
+}
+
+void MotionProfileController::forceRemovePath(const std::string &ipathId) {
+  okapi::AsyncMotionProfileController::forceRemovePath(ipathId);
+
+  std::scoped_lock lock(currentPathMutex);
+  sharedPaths.erase(ipathId);
+}
+
+void MotionProfileController::storePath(const std::string &idirectory,
+                                        const std::string &ipathId) {
+  std::shared_ptr<const TrajectorySource> stored;
+  {
+    std::scoped_lock lock(currentPathMutex);
+    auto path = paths.find(ipathId);
+    auto found = sharedPaths.find(ipathId);
+    if (path != paths.end() && path->second.left == nullptr && found != sharedPaths.end()) {
+      stored = found->second;
+    }
+  }
+
+  if (!stored) {
+    okapi::AsyncMotionProfileController::storePath(idirectory, ipathId);
+    return;
+  }
+
+  std::vector<Segment> left(stored->size()), right(stored->size());
+  stored->toSegments(left.data(), right.data());
+
+  const std::string leftFilePath = makeFilePath(idirectory, ipathId + ".left.csv");
+  const std::string rightFilePath = makeFilePath(idirectory, ipathId + ".right.csv");
+  FILE *leftPathFile = fopen(leftFilePath.c_str(), "w");
+  FILE *rightPathFile = fopen(rightFilePath.c_str(), "w");
+
+  if (leftPathFile == nullptr || rightPathFile == nullptr) {
+    LOG_WARN("MotionProfileController: Couldn't open " +
+             (leftPathFile == nullptr ? leftFilePath : rightFilePath) + " for writing");
+  } else {
+    pathfinder_serialize_csv(leftPathFile, left.data(), stored->size());
+    pathfinder_serialize_csv(rightPathFile, right.data(), stored->size());
+  }
+
+  if (leftPathFile != nullptr) {
+    fclose(leftPathFile);
+  }
+  if (rightPathFile != nullptr) {
+    fclose(rightPathFile);
+  }
+}
+
+void MotionProfileController::loadPath(const std::string &idirectory,
+                                       const std::string &ipathId) {
+  okapi::AsyncMotionProfileController::loadPath(idirectory, ipathId);
+
+  std::scoped_lock lock(currentPathMutex);
+  compactStoredPath(ipathId);
+}
+
+void MotionProfileController::setTrajectoryStorage(const TrajectoryStorage istorage) {
+  storage.store(istorage, std::memory_order_release);
+}
+
+TrajectoryStorage MotionProfileController::getTrajectoryStorage() const {
+  return storage.load(std::memory_order_acquire);
+}
+
+std::size_t MotionProfileController::getPathMemory(const std::string &ipathId) {
+  std::scoped_lock lock(currentPathMutex);
+  auto path = paths.find(ipathId);
+  if (path == paths.end()) {
+    return 0;
+  }
+
+  if (path->second.left != nullptr) {
+    return 2 * sizeof(Segment) * static_cast<std::size_t>(path->second.length);
+  }
+
+  auto shared = sharedPaths.find(ipathId);
+  return shared == sharedPaths.end() ? 0 : shared->second->memoryUsage();
+}
+
+TrajectoryView MotionProfileController::getView(const std::string &ipathId) {
+  waitForPendingPath(ipathId);
+  loadBlobPath(ipathId);
+
+  std::scoped_lock lock(currentPathMutex);
+  if (paths.find(ipathId) == paths.end()) {
+    LOG_WARN("MotionProfileController: There is no path " + ipathId + " to view.");
+    return TrajectoryView();
+  }
+
+  // the view takes the segments over and the path is followed from there, a
+  // running one from its next step on
+  auto shared = sharePath(ipathId);
+  return shared ? TrajectoryView(shared) : TrajectoryView();
+}
+
+bool MotionProfileController::storeView(const std::string &ipathId, const TrajectoryView &iview) {
+  if (iview.size() == 0 || !iview.isPair()) {
+    LOG_ERROR("MotionProfileController: View " + ipathId + " is empty or not a tank path.");
+    return false;
+  }
+
+  std::scoped_lock lock(currentPathMutex);
+  if (isRunning.load(std::memory_order_acquire) && currentPath == ipathId) {
+    LOG_WARN("MotionProfileController: Path " + ipathId + " is running and was not replaced.");
+    return false;
+  }
+
+  const int length = iview.size();
+  paths.erase(ipathId);
+  paths.emplace(ipathId,
+                TrajectoryPair{SegmentPtr(nullptr, free), SegmentPtr(nullptr, free), length});
+  sharedPaths[ipathId] = std::make_shared<const TrajectoryView>(iview);
+  return true;
+}
+
+void MotionProfileController::compactStoredPath(const std::string &ipathId) {
+  auto path = paths.find(ipathId);
+  if (path == paths.end() || path->second.left == nullptr) {
+    return;
+  }
+
+  // a full path replaces any compact one or view with the same id
+  sharedPaths.erase(ipathId);
+
+  const TrajectoryStorage current = storage.load(std::memory_order_acquire);
+  if (current == TrajectoryStorage::full ||
+      (isRunning.load(std::memory_order_acquire) && currentPath == ipathId)) {
+    return;
+  }
+
+  const int length = path->second.length;
+  sharedPaths.emplace(ipathId,
+                       std::make_shared<const CompactTrajectory>(
+                         path->second.left.get(), path->second.right.get(), length, current));
+  path->second = TrajectoryPair{SegmentPtr(nullptr, free), SegmentPtr(nullptr, free), length};
+}
+
+bool MotionProfileController::generatePathFrom(const okapi::OdomState &ifrom,
+                                               const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                                               const std::string &ipathId) {
+  return generatePathFrom(ifrom, iwaypoints, ipathId, limits);
+}
+
+bool MotionProfileController::generatePathFrom(const okapi::OdomState &ifrom,
+                                               const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                                               const std::string &ipathId,
+                                               const okapi::PathfinderLimits &ilimits) {
+  if (iwaypoints.empty()) {
+    return false;
+  }
+
+  std::vector<Waypoint> field;
+  field.reserve(iwaypoints.size());
+  for (const auto &point : iwaypoints) {
+    field.push_back(Waypoint{point.x.convert(okapi::meter), point.y.convert(okapi::meter),
+                             point.theta.convert(okapi::radian)});
+  }
+
+  auto timer = timeUtil.getTimer();
+  const okapi::QTime start = timer->millis();
+
+  PathJob job{ipathId,
+              PathGeneration::fromPose(ifrom.x.convert(okapi::meter),
+                                       ifrom.y.convert(okapi::meter),
+                                       ifrom.theta.convert(okapi::radian), field),
+              ilimits, nullptr, generator.load(std::memory_order_acquire)};
+  const bool ok = generateJob(job);
+  const double elapsed = (timer->millis() - start).convert(okapi::millisecond);
+
+  LOG_INFO("MotionProfileController: Planned path " + ipathId + " from the robot's pose, " +
+           std::to_string(iwaypoints.size()) + " waypoints in " + std::to_string(elapsed) + " ms");
+  return ok;
+}
+
+void MotionProfileController::moveToField(const okapi::OdomState &ifrom,
+                                          const std::vector<okapi::PathfinderPoint> &iwaypoints) {
+  moveToField(ifrom, iwaypoints, limits);
+}
+
+void MotionProfileController::moveToField(const okapi::OdomState &ifrom,
+                                          const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                                          const okapi::PathfinderLimits &ilimits) {
+  if (!generatePathFrom(ifrom, iwaypoints, FIELD_MOVE_PATH_ID, ilimits)) {
+    return;
+  }
+
+  setTarget(FIELD_MOVE_PATH_ID);
+  waitUntilSettled();
+  removePath(FIELD_MOVE_PATH_ID);
+}
+
+void MotionProfileController::moveTo(std::initializer_list<okapi::PathfinderPoint> iwaypoints,
+                                     const bool ibackwards,
+                                     const bool imirrored) {
+  moveTo(iwaypoints, limits, ibackwards, imirrored);
+}
+
+void MotionProfileController::moveTo(std::initializer_list<okapi::PathfinderPoint> iwaypoints,
+                                     const okapi::PathfinderLimits &ilimits,
+                                     const bool ibackwards,
+                                     const bool imirrored) {
+  generatePath(iwaypoints, MOVE_TO_PATH_ID, ilimits);
+  setTarget(MOVE_TO_PATH_ID, ibackwards, imirrored);
+  waitUntilSettled();
+  forceRemovePath(MOVE_TO_PATH_ID);
+}
+
+void MotionProfileController::setPathGenerator(const PathGenerator igenerator) {
+  generator.store(igenerator, std::memory_order_release);
+}
+
+PathGenerator MotionProfileController::getPathGenerator() const {
+  return generator.load(std::memory_order_acquire);
+}
+
+void MotionProfileController::setFollowerGains(const ProfileFollowerGains &igains) {
+  std::scoped_lock lock(followerMutex);
+  followerGains = igains;
+}
+
+ProfileFollowerGains MotionProfileController::getFollowerGains() {
+  std::scoped_lock lock(followerMutex);
+  return followerGains;
+}
+
+void MotionProfileController::setHeadingSource(const std::shared_ptr<okapi::Odometry> &iodometry) {
+  std::scoped_lock lock(followerMutex);
+  headingSource = iodometry;
+}
+
+std::shared_ptr<const TrajectorySource>
+MotionProfileController::sharePath(const std::string &ipathId) {
+  auto path = paths.find(ipathId);
+  if (path == paths.end()) {
+    return nullptr;
+  }
+
+  if (path->second.left == nullptr) {
+    auto shared = sharedPaths.find(ipathId);
+    return shared == sharedPaths.end() ? nullptr : shared->second;
+  }
+
+  const int length = path->second.length;
+  auto segments = std::make_shared<const SegmentTrajectory>(
+    std::move(path->second.left), std::move(path->second.right), length);
+  path->second = TrajectoryPair{SegmentPtr(nullptr, free), SegmentPtr(nullptr, free), length};
+  sharedPaths[ipathId] = segments;
+  return segments;
+}
+
+void MotionProfileController::readSensors(SensorSnapshot &out) const {
+  const auto *snapshotSource = dynamic_cast<const SensorSnapshotSource *>(model.get());
+  if (snapshotSource != nullptr) {
+    snapshotSource->getSensorVals(out);
+    return;
+  }
+
+  const std::valarray<std::int32_t> vals = model->getSensorVals();
+  out.count = std::min(vals.size(), out.vals.size());
+  for (std::size_t i = 0; i < out.count; i++) {
+    out.vals[i] = vals[i];
+  }
+}
+
+bool MotionProfileController::pathSample(FollowedPath &ipath,
+                                         const int i,
+                                         TrajectorySample &osample,
+                                         double &odt) {
+  if (ipath.shared) {
+    odt = ipath.shared->getDt();
+    osample = ipath.shared->get(i);
+    return true;
+  }
+
+  // a full path can be force removed while it runs, which frees its segments:
+  // check it is still there like okapi's follower does before every step
+  std::scoped_lock lock(currentPathMutex);
+  auto found = paths.find(ipath.id);
+  if (found == paths.end() || &found->second != ipath.full) {
+    return false;
+  }
+
+  if (found->second.left == nullptr) {
+    // sharePath() took the segments over, they are read from there from now on
+    auto shared = sharedPaths.find(ipath.id);
+    if (shared == sharedPaths.end()) {
+      return false;
+    }
+    ipath.shared = shared->second;
+    ipath.full = nullptr;
+    odt = ipath.shared->getDt();
+    osample = ipath.shared->get(i);
+    return true;
+  }
+
+  const Segment &left = ipath.full->left.get()[i];
+  const Segment &right = ipath.full->right.get()[i];
+  odt = left.dt;
+  osample = TrajectorySample{left.position,  left.velocity,  left.acceleration, right.position,
+                             right.velocity, right.acceleration, left.heading};
+  return true;
+}
+
+void MotionProfileController::beginPath(FollowedPath &ipath) {
+  ipath.step = 0;
+  ipath.lastLeftError = ipath.lastRightError = 0;
+
+  // where the profile starts, the robot is there by definition
+  double dt;
+  TrajectorySample first;
+  if (ipath.length > 0) {
+    pathSample(ipath, 0, first, dt);
+  }
+  ipath.last = TrajectorySample{0, 0, 0, 0, 0, 0, first.heading};
+  ipath.start = ipath.last;
+}
+
+void MotionProfileController::startFeedback(FollowedPath &ipath,
+                                            const std::shared_ptr<okapi::Odometry> &iodometry) {
+  readSensors(ipath.startTicks);
+  ipath.startTheta = iodometry ? iodometry->getState().theta.convert(okapi::radian) : 0;
+  ipath.start = ipath.last;
+  ipath.lastLeftError = ipath.lastRightError = 0;
+}
+
+void MotionProfileController::wheelVelocities(FollowedPath &ipath,
+                                              const TrajectorySample &isample,
+                                              const double idt,
+                                              const ProfileFollowerGains &igains,
+                                              const std::shared_ptr<okapi::Odometry> &iodometry,
+                                              const bool ifeedback,
+                                              double &oleft,
+                                              double &oright) {
+  oleft = igains.kV * isample.leftVelocity + igains.kA * isample.leftAcceleration;
+  oright = igains.kV * isample.rightVelocity + igains.kA * isample.rightAcceleration;
+  if (!ifeedback) {
+    return;
+  }
+
+  // feedback works in the frame of the path: wheel sides as the path names
+  // them, distances positive along the path and pathfinder's counterclockwise
+  // heading, so mirrored and backwards paths need no special cases
+  const std::size_t leftSensor = ipath.mirrored ? 1 : 0;
+  const std::size_t rightSensor = ipath.mirrored ? 0 : 1;
+  const double track = scales.wheelTrack.convert(okapi::meter);
+
+  SensorSnapshot ticks;
+  readSensors(ticks);
+  const double leftTravel =
+    ipath.reversed * (ticks[leftSensor] - ipath.startTicks[leftSensor]) / scales.straight;
+  const double rightTravel =
+    ipath.reversed * (ticks[rightSensor] - ipath.startTicks[rightSensor]) / scales.straight;
+
+  double turned;
+  if (iodometry) {
+    // okapi's theta is clockwise
+    const double theta = iodometry->getState().theta.convert(okapi::radian);
+    turned = -(theta - ipath.startTheta) * ipath.reversed * (ipath.mirrored ? -1 : 1);
+  } else {
+    turned = (rightTravel - leftTravel) / track;
+  }
+
+  // compare with how far the profile got until the end of the last step
+  const double leftError = ipath.last.leftPosition - ipath.start.leftPosition - leftTravel;
+  const double rightError = ipath.last.rightPosition - ipath.start.rightPosition - rightTravel;
+  const double headingError =
+    std::remainder(ipath.last.heading - ipath.start.heading - turned, 2 * okapi::pi);
+  const double turn = igains.kHeading * headingError * track / 2;
+
+  oleft += igains.kP * leftError + igains.kD * (leftError - ipath.lastLeftError) / idt - turn;
+  oright += igains.kP * rightError + igains.kD * (rightError - ipath.lastRightError) / idt + turn;
+
+  ipath.lastLeftError = leftError;
+  ipath.lastRightError = rightError;
+
+  telemetryReportError(TELEMETRY_ID_PROFILE_LEFT, static_cast<float>(leftError));
+  telemetryReportError(TELEMETRY_ID_PROFILE_RIGHT, static_cast<float>(rightError));
+  telemetryReportError(TELEMETRY_ID_PROFILE_HEADING, static_cast<float>(headingError));
+}
+
+void MotionProfileController::motorSpeeds(const FollowedPath &ipath,
+                                          const double ileftVel,
+                                          const double irightVel,
+                                          double &oleft,
+                                          double &oright) const {
+  const double gearset = okapi::toUnderlyingType(pair.internalGearset);
+  const double leftSpeed =
+    convertLinearToRotational(ileftVel * okapi::mps).convert(okapi::rpm) / gearset * ipath.reversed;
+  const double rightSpeed = convertLinearToRotational(irightVel * okapi::mps).convert(okapi::rpm) /
+                            gearset * ipath.reversed;
+
+  oleft = ipath.mirrored ? rightSpeed : leftSpeed;
+  oright = ipath.mirrored ? leftSpeed : rightSpeed;
+}
+
+void MotionProfileController::takeQueuedPath(FollowedPath &onext) {
+  // queuePath() shared the trajectory, it stays alive if the path is removed
+  QueuedPath &queued = pathQueue.front();
+  onext = FollowedPath{};
+  onext.id = std::move(queued.id);
+  onext.shared = std::move(queued.trajectory);
+  onext.length = onext.shared->size();
+  onext.reversed = queued.backwards ? -1 : 1;
+  onext.mirrored = queued.mirrored;
+  pathQueue.pop_front();
+}
+
+bool MotionProfileController::dequeuePath(FollowedPath &onext) {
+  {
+    // a path set with setTarget() starts from where the running one ends, it
+    // is not blended
+    std::scoped_lock lock(currentPathMutex);
+    if (pathQueue.empty() || pathQueue.front().target) {
+      return false;
+    }
+    takeQueuedPath(onext);
+  }
+
+  beginPath(onext);
+  return true;
+}
+
+bool MotionProfileController::continueChain(FollowedPath &ionext, const bool ihaveNext) {
+  {
+    std::scoped_lock lock(currentPathMutex);
+    const bool target = !pathQueue.empty() && pathQueue.front().target;
+    if (ihaveNext && !target) {
+      return true;
+    }
+
+    if (pathQueue.empty()) {
+      // closed while the queue is locked, so a later queuePath() starts a new
+      // chain instead of queueing behind this one
+      queueOpen = false;
+      following = false;
+      return false;
+    }
+
+    // a setTarget() after ionext was taken replaces it
+    takeQueuedPath(ionext);
+  }
+
+  beginPath(ionext);
+  return true;
+}
+
+int MotionProfileController::blendSteps(FollowedPath &icurrent, FollowedPath &inext) {
+  // the part of icurrent which slows down to its end and of inext which speeds
+  // up from its start, as feed forward motor speeds
+  const int remaining = icurrent.length - icurrent.step;
+  const int longest = std::min({remaining, inext.length, PATH_BLEND_MAX_STEPS});
+  if (longest <= 0) {
+    return 0;
+  }
+
+  auto &endLeft = blendEnd.left;
+  auto &endRight = blendEnd.right;
+  auto &endSpeed = blendEnd.speed;
+  auto &startLeft = blendStart.left;
+  auto &startRight = blendStart.right;
+  auto &startSpeed = blendStart.speed;
+  double peak = 0;
+  for (int j = 0; j < longest; j++) {
+    double dt, left, right;
+    TrajectorySample end, start;
+    if (!pathSample(icurrent, icurrent.length - longest + j, end, dt) ||
+        !pathSample(inext, j, start, dt)) {
+      return 0;
+    }
+
+    motorSpeeds(icurrent, end.leftVelocity, end.rightVelocity, endLeft[j], endRight[j]);
+    endSpeed[j] = std::abs(end.leftVelocity + end.rightVelocity);
+
+    motorSpeeds(inext, start.leftVelocity, start.rightVelocity, startLeft[j], startRight[j]);
+    startSpeed[j] = std::abs(start.leftVelocity + start.rightVelocity);
+
+    left = std::max(std::abs(endLeft[j]), std::abs(startLeft[j]));
+    right = std::max(std::abs(endRight[j]), std::abs(startRight[j]));
+    peak = std::max({peak, left, right});
+  }
+
+  int slowing = 0;
+  while (slowing + 1 < longest &&
+         endSpeed[longest - 2 - slowing] >= endSpeed[longest - 1 - slowing]) {
+    slowing++;
+  }
+  int speeding = 0;
+  while (speeding + 1 < longest && startSpeed[speeding + 1] >= startSpeed[speeding]) {
+    speeding++;
+  }
+
+  for (int overlap = std::min(slowing, speeding); overlap > 0; overlap--) {
+    bool fits = true;
+    for (int j = 0; j < overlap && fits; j++) {
+      const int end = longest - overlap + j;
+      fits = std::abs(endLeft[end] + startLeft[j]) <= peak + 1e-9 &&
+             std::abs(endRight[end] + startRight[j]) <= peak + 1e-9;
+    }
+    if (fits) {
+      return overlap;
+    }
+  }
+  return 0;
+}
+
+void MotionProfileController::startChain(FollowedPath &ocurrent) {
+  // okapi's loop looked the path up before a setTarget() may have replaced it,
+  // the path is taken from the target set now
+  std::scoped_lock lock(currentPathMutex);
+  following = true;
+  ocurrent = FollowedPath{};
+  ocurrent.id = currentPath;
+  ocurrent.reversed = direction.load(std::memory_order_acquire);
+  ocurrent.mirrored = mirrored.load(std::memory_order_acquire);
+
+  auto found = paths.find(currentPath);
+  if (found == paths.end()) {
+    return;
+  }
+
+  if (found->second.left == nullptr) {
+    // the shared_ptr keeps the trajectory alive if the path is removed while it runs
+    auto shared = sharedPaths.find(currentPath);
+    if (shared != sharedPaths.end()) {
+      ocurrent.shared = shared->second;
+      ocurrent.length = ocurrent.shared->size();
+    }
+  } else {
+    ocurrent.full = &found->second;
+    ocurrent.length = found->second.length;
+  }
+}
+
+void MotionProfileController::endChain() {
+  // a chain which was disabled or lost its path drops what is queued after
+  // it; one which ran out of paths closed the queue already, whatever is in
+  // it now belongs to the next chain
+  std::scoped_lock lock(currentPathMutex);
+  if (following) {
+    following = false;
+    queueOpen = false;
+    pathQueue.clear();
+  }
+}
+
+void MotionProfileController::executeSinglePath(const TrajectoryPair &,
+                                                std::unique_ptr<okapi::AbstractRate> rate) {
+  ProfileFollowerGains gains;
+  std::shared_ptr<okapi::Odometry> odometry;
+  {
+    std::scoped_lock lock(followerMutex);
+    gains = followerGains;
+    odometry = headingSource;
+  }
+
+  const bool openLoop = gains.kV == 1 && gains.kA == 0 && gains.kP == 0 && gains.kD == 0 &&
+                        gains.kHeading == 0;
+
+  FollowedPath current;
+  startChain(current);
+
+  if (!current.shared && current.full == nullptr) {
+    LOG_ERROR("MotionProfileController: Path " + current.id + " has no trajectory.");
+  } else {
+    beginPath(current);
+    if (!openLoop) {
+      startFeedback(current, odometry);
+    }
+
+    FollowedPath next;
+    bool haveNext = false;
+    int overlap = 0;
+
+    while (!isDisabled()) {
+      if (!haveNext && dequeuePath(next)) {
+        haveNext = true;
+        overlap = blendSteps(current, next);
+      }
+
+      if (current.step >= current.length) {
+        if (!continueChain(next, haveNext)) {
+          break;
+        }
+
+        current = std::move(next);
+        haveNext = false;
+        {
+          std::scoped_lock lock(currentPathMutex);
+          currentPath = current.id;
+        }
+        direction.store(current.reversed, std::memory_order_release);
+        mirrored.store(current.mirrored, std::memory_order_release);
+        if (!openLoop) {
+          startFeedback(current, odometry);
+        }
+
+        LOG_INFO("MotionProfileController: Continuing with path " + current.id);
+        continue;
+      }
+
+      double dt, leftVel, rightVel, leftSpeed, rightSpeed;
+      TrajectorySample sample;
+      if (!pathSample(current, current.step, sample, dt)) {
+        LOG_WARN("MotionProfileController: Path " + current.id + " was removed while running.");
+        break;
+      }
+
+      // while blending the paths are followed feed forward only, the next path
+      // closes the loop again from where the robot is when the last one ends
+      const bool blending = haveNext && current.length - current.step <= overlap;
+      wheelVelocities(current, sample, dt, gains, odometry, !openLoop && !blending, leftVel,
+                      rightVel);
+      motorSpeeds(current, leftVel, rightVel, leftSpeed, rightSpeed);
+
+      if (blending && next.step < next.length) {
+        double nextDt, nextLeft, nextRight;
+        TrajectorySample nextSample;
+        pathSample(next, next.step, nextSample, nextDt);
+        wheelVelocities(next, nextSample, nextDt, gains, odometry, false, leftVel, rightVel);
+        motorSpeeds(next, leftVel, rightVel, nextLeft, nextRight);
+        leftSpeed += nextLeft;
+        rightSpeed += nextRight;
+        next.last = nextSample;
+        next.step++;
+      }
+
+      model->left(leftSpeed);
+      model->right(rightSpeed);
+
+      current.last = sample;
+      current.step++;
+      rate->delayUntil(dt * okapi::second);
+    }
+  }
+
+  endChain();
+}
+
+PathHandle
+MotionProfileController::generatePathAsync(const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                                           const std::string &ipathId) {
+  return generatePathAsync(iwaypoints, ipathId, limits);
+}
+
+PathHandle
+MotionProfileController::generatePathAsync(const std::vector<okapi::PathfinderPoint> &iwaypoints,
+                                           const std::string &ipathId,
+                                           const okapi::PathfinderLimits &ilimits) {
+  auto state = std::make_shared<std::atomic<PathHandle::status>>(PathHandle::status::pending);
+
+  if (iwaypoints.empty()) {
+    // same as generatePath(), no waypoints means no path
+    state->store(PathHandle::status::failed);
+    return PathHandle(state);
+  }
+
+  PathJob job{ipathId, {}, ilimits, state, generator.load(std::memory_order_acquire)};
+  job.waypoints.reserve(iwaypoints.size());
+  for (const auto &point : iwaypoints) {
+    job.waypoints.push_back(Waypoint{point.x.convert(okapi::meter),
+                                     point.y.convert(okapi::meter),
+                                     point.theta.convert(okapi::radian)});
+  }
+
+  {
+    std::scoped_lock lock(generatorMutex);
+    generatorJobs.push_back(std::move(job));
+    pendingPaths[ipathId] = state;
+
+    if (generatorTask == nullptr) {
+      generatorTask = new CrossplatformThread(generatorTrampoline, this, "MotionProfileGenerator");
+#ifndef THREADS_STD
+      // only use time the control loops leave over
+      pros::c::task_set_priority(generatorTask->thread, TASK_PRIORITY_MIN + 1);
+#endif
+    }
+  }
+
+  LOG_INFO("MotionProfileController: Queued path " + ipathId + " for generation");
+  return PathHandle(state);
+}
+
+void MotionProfileController::generatorTrampoline(void *context) {
+  if (context) {
+    static_cast<MotionProfileController *>(context)->generatorLoop();
+  }
+}
+
+void MotionProfileController::generatorLoop() {
+  LOG_INFO_S("Started MotionProfileController generator task.");
+
+  while (!generatorStop.load(std::memory_order_acquire)) {
+    PathJob job;
+    bool haveJob = false;
+    {
+      std::scoped_lock lock(generatorMutex);
+      if (!generatorJobs.empty()) {
+        job = std::move(generatorJobs.front());
+        generatorJobs.pop_front();
+        haveJob = true;
+      }
+    }
+
+    if (!haveJob) {
+      pathTaskDelay(PATH_GENERATOR_IDLE_MS);
+      continue;
+    }
+
+    const bool ok = generateJob(job);
+
+    {
+      std::scoped_lock lock(generatorMutex);
+      auto pending = pendingPaths.find(job.id);
+      if (pending != pendingPaths.end() && pending->second == job.state) {
+        pendingPaths.erase(pending);
+      }
+    }
+    job.state->store(ok ? PathHandle::status::ready : PathHandle::status::failed,
+                     std::memory_order_release);
+  }
+
+  // fail whatever is left so nobody waits forever
+  std::scoped_lock lock(generatorMutex);
+  for (auto &job : generatorJobs) {
+    job.state->store(PathHandle::status::failed, std::memory_order_release);
+  }
+  generatorJobs.clear();
+  pendingPaths.clear();
+
+  LOG_INFO_S("Stopped MotionProfileController generator task.");
+  generatorDone.store(true, std::memory_order_release);
+}
+
+bool MotionProfileController::generateJob(const PathJob &ijob) {
+  LOG_INFO("MotionProfileController: Generating path " + ijob.id);
+
+  std::vector<Segment> left, right;
+  const int length = PathGeneration::tank(ijob.waypoints, ijob.limits.maxVel,
+                                          ijob.limits.maxAccel, ijob.limits.maxJerk,
+                                          scales.wheelTrack.convert(okapi::meter), left, right,
+                                          PATH_SAMPLES_QUADRATURE, ijob.generator);
+  if (length <= 0) {
+    LOG_ERROR("MotionProfileController: Path " + ijob.id +
+              " is impossible with these waypoints and limits.");
+    return false;
+  }
+
+  SegmentPtr leftPath(static_cast<Segment *>(malloc(sizeof(Segment) * length)), free);
+  SegmentPtr rightPath(static_cast<Segment *>(malloc(sizeof(Segment) * length)), free);
+  if (leftPath == nullptr || rightPath == nullptr) {
+    LOG_ERROR("MotionProfileController: Could not allocate path " + ijob.id);
+    return false;
+  }
+  std::memcpy(leftPath.get(), left.data(), sizeof(Segment) * length);
+  std::memcpy(rightPath.get(), right.data(), sizeof(Segment) * length);
+
+  std::scoped_lock lock(currentPathMutex);
+  if (isRunning.load(std::memory_order_acquire) && currentPath == ijob.id) {
+    LOG_WARN("MotionProfileController: Path " + ijob.id + " is running and was not replaced.");
+    return false;
+  }
+  paths.erase(ijob.id);
+  paths.emplace(ijob.id, TrajectoryPair{std::move(leftPath), std::move(rightPath), length});
+  compactStoredPath(ijob.id);
+
+  LOG_INFO("MotionProfileController: Generated path " + ijob.id + ", " + std::to_string(length) +
+           " segments");
+  return true;
+}
+
+void MotionProfileController::setTarget(std::string ipathId) {
+  setTarget(std::move(ipathId), false, false);
+}
+
+void MotionProfileController::setTarget(std::string ipathId,
+                                        const bool ibackwards,
+                                        const bool imirrored) {
+  waitForPendingPath(ipathId);
+  loadBlobPath(ipathId);
+
+  while (true) {
+    {
+      std::scoped_lock lock(currentPathMutex);
+      pathQueue.clear();
+
+      if (following) {
+        // okapi's loop would drop a target set while a path runs, the
+        // follower takes it over where the running path ends instead
+        auto trajectory = sharePath(ipathId);
+        if (!trajectory) {
+          LOG_WARN("MotionProfileController: There is no path " + ipathId + " to follow.");
+          return;
+        }
+
+        LOG_INFO("MotionProfileController: Following path " + ipathId + " after the running one");
+        pathQueue.push_back(
+          QueuedPath{std::move(ipathId), ibackwards, imirrored, std::move(trajectory), true});
+        return;
+      }
+
+      if (queueOpen || !isRunning.load(std::memory_order_acquire)) {
+        // a new chain, the follower closes the queue again when it ends
+        queueOpen = true;
+        break;
+      }
+    }
+
+    // a chain just ended and okapi's loop has yet to clear isRunning, which
+    // would drop this target too
+    pathTaskDelay(PATH_WAIT_POLL_MS);
+  }
+
+  okapi::AsyncMotionProfileController::setTarget(std::move(ipathId), ibackwards, imirrored);
+}
+
+void MotionProfileController::queuePath(std::string ipathId,
+                                        const bool ibackwards,
+                                        const bool imirrored) {
+  waitForPendingPath(ipathId);
+  loadBlobPath(ipathId);
+
+  {
+    std::scoped_lock lock(currentPathMutex);
+    if (queueOpen) {
+      auto trajectory = sharePath(ipathId);
+      if (!trajectory) {
+        LOG_WARN("MotionProfileController: There is no path " + ipathId + " to queue.");
+        return;
+      }
+
+      LOG_INFO("MotionProfileController: Queued path " + ipathId);
+      pathQueue.push_back(
+        QueuedPath{std::move(ipathId), ibackwards, imirrored, std::move(trajectory), false});
+      return;
+    }
+  }
+
+  // nothing is running, the path starts the chain
+  setTarget(std::move(ipathId), ibackwards, imirrored);
+}
+
+void MotionProfileController::clearQueue() {
+  std::scoped_lock lock(currentPathMutex);
+  pathQueue.clear();
+}
+
+std::size_t MotionProfileController::getQueueSize() {
+  std::scoped_lock lock(currentPathMutex);
+  return pathQueue.size();
+}
+
+void MotionProfileController::waitForPendingPath(const std::string &ipathId) {
+  std::shared_ptr<std::atomic<PathHandle::status>> state;
+  {
+    std::scoped_lock lock(generatorMutex);
+    auto pending = pendingPaths.find(ipathId);
+    if (pending == pendingPaths.end()) {
+      return;
+    }
+    state = pending->second;
+  }
+
+  LOG_INFO("MotionProfileController: Waiting for path " + ipathId + " to be generated");
+  PathHandle(state).waitUntilReady();
+}
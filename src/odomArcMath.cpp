@@ -0,0 +1,63 @@
+// ------- odomArcMath.cpp -----------------------------------------------------
+//
+// Tracking wheel arc math, see odomArcMath.h
+
+#include "odomArcMath.h"
+
+#include <cmath>
+
+OdomPose OdomArcMath::step(const OdomPose &ipose,
+                           const double ideltaLeft,
+                           const double ideltaRight,
+                           const double ideltaTheta,
+                           const double itrack) {
+  // offset along the robot's heading, measured from the chord of the arc
+  double localOffset;
+  if (ideltaTheta != 0) {
+    localOffset = 2 * std::sin(ideltaTheta / 2) * (ideltaRight / ideltaTheta + itrack / 2);
+  } else {
+    localOffset = (ideltaLeft + ideltaRight) / 2;
+  }
+
+  // the chord points along the average heading of the arc
+  const double averageTheta = ipose.theta + ideltaTheta / 2;
+
+  double dX = std::cos(averageTheta) * localOffset;
+  double dY = std::sin(averageTheta) * localOffset;
+  if (std::isnan(dX)) {
+    dX = 0;
+  }
+  if (std::isnan(dY)) {
+    dY = 0;
+  }
+
+  return OdomPose{ipose.x + dX, ipose.y + dY, ipose.theta + ideltaTheta};
+}
+
+OdomPose OdomArcMath::stepTicks(const OdomPose &ipose,
+                                const double ileftTicks,
+                                const double irightTicks,
+                                const okapi::ChassisScales &iscales) {
+  const double deltaLeft = ileftTicks / iscales.straight;
+  const double deltaRight = irightTicks / iscales.straight;
+  const double track = iscales.wheelTrack.convert(okapi::meter);
+  return step(ipose, deltaLeft, deltaRight, (deltaLeft - deltaRight) / track, track);
+}
+
+okapi::OdomState OdomArcMath::toState(const OdomPose &ipose, const okapi::StateMode &imode) {
+  if (imode == okapi::StateMode::FRAME_TRANSFORMATION) {
+    return okapi::OdomState{ipose.x * okapi::meter, ipose.y * okapi::meter,
+                            ipose.theta * okapi::radian};
+  }
+  return okapi::OdomState{ipose.y * okapi::meter, ipose.x * okapi::meter,
+                          ipose.theta * okapi::radian};
+}
+
+OdomPose OdomArcMath::fromState(const okapi::OdomState &istate, const okapi::StateMode &imode) {
+  if (imode == okapi::StateMode::FRAME_TRANSFORMATION) {
+    return OdomPose{istate.x.convert(okapi::meter), istate.y.convert(okapi::meter),
+                    istate.theta.convert(okapi::radian)};
+  }
+  return OdomPose{istate.y.convert(okapi::meter), istate.x.convert(okapi::meter),
+                  istate.theta.convert(okapi::radian)};
+}
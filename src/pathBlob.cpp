@@ -0,0 +1,147 @@
+// ------- pathBlob.cpp --------------------------------------------------------
+//
+// Precomputed motion profile blob reader, see pathBlob.h
+
+#include "pathBlob.h"
+
+#include <cstring>
+#include <mutex>
+
+PathBlob::PathBlob(const unsigned char *idata,
+                   const std::size_t isize,
+                   const std::shared_ptr<okapi::Logger> &ilogger)
+  : logger(ilogger), data(idata), size(isize) {
+  if (!readDirectory()) {
+    entries.clear();
+  }
+}
+
+PathBlob::PathBlob(const std::string &ifileName, const std::shared_ptr<okapi::Logger> &ilogger)
+  : logger(ilogger) {
+  file = fopen(ifileName.c_str(), "rb");
+  if (file == nullptr) {
+    LOG_ERROR("PathBlob: Could not open " + ifileName);
+    return;
+  }
+
+  fseek(file, 0, SEEK_END);
+  size = static_cast<std::size_t>(ftell(file));
+
+  if (!readDirectory()) {
+    entries.clear();
+  }
+}
+
+PathBlob::~PathBlob() {
+  if (file != nullptr) {
+    fclose(file);
+  }
+}
+
+std::shared_ptr<PathBlob> PathBlob::linked() {
+  if (generatedPathBlob == nullptr || &generatedPathBlobSize == nullptr) {
+    return nullptr;
+  }
+  return std::make_shared<PathBlob>(generatedPathBlob, generatedPathBlobSize);
+}
+
+bool PathBlob::readDirectory() {
+  if (!readBytes(0, &header, sizeof(header))) {
+    LOG_ERROR_S("PathBlob: Blob too short for the header.");
+    return false;
+  }
+
+  if (header.magic != PATH_BLOB_MAGIC || header.version != PATH_BLOB_VERSION) {
+    LOG_ERROR_S("PathBlob: Not a path blob or wrong version, regenerate it with pathGen.");
+    return false;
+  }
+
+  if (header.segmentSize != sizeof(Segment)) {
+    LOG_ERROR("PathBlob: Segment size " + std::to_string(header.segmentSize) +
+              " does not match this program's " + std::to_string(sizeof(Segment)));
+    return false;
+  }
+
+  entries.resize(header.pathCount);
+  if (!readBytes(sizeof(header), entries.data(), entries.size() * sizeof(PathBlobEntry))) {
+    LOG_ERROR_S("PathBlob: Blob too short for the directory.");
+    return false;
+  }
+
+  for (auto &entry : entries) {
+    entry.id[PATH_BLOB_ID_SIZE - 1] = '\0';
+    const std::size_t end = entry.offset + 2 * sizeof(Segment) * static_cast<std::size_t>(entry.length);
+    if (entry.length <= 0 || end > size) {
+      LOG_ERROR("PathBlob: Path " + std::string(entry.id) + " is outside the blob.");
+      return false;
+    }
+  }
+
+  LOG_INFO("PathBlob: " + std::to_string(entries.size()) + " paths available.");
+  return true;
+}
+
+bool PathBlob::readBytes(const std::size_t ioffset, void *out, const std::size_t icount) const {
+  if (ioffset + icount > size) {
+    return false;
+  }
+
+  if (data != nullptr) {
+    std::memcpy(out, data + ioffset, icount);
+    return true;
+  }
+
+  if (file == nullptr) {
+    return false;
+  }
+
+  std::scoped_lock lock(fileMutex);
+  return fseek(file, static_cast<long>(ioffset), SEEK_SET) == 0 &&
+         fread(out, 1, icount, file) == icount;
+}
+
+const PathBlobEntry *PathBlob::findEntry(const std::string &ipathId) const {
+  for (const auto &entry : entries) {
+    if (ipathId == entry.id) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+bool PathBlob::isValid() const {
+  return !entries.empty();
+}
+
+std::vector<std::string> PathBlob::getPathIds() const {
+  std::vector<std::string> ids;
+  ids.reserve(entries.size());
+  for (const auto &entry : entries) {
+    ids.emplace_back(entry.id);
+  }
+  return ids;
+}
+
+double PathBlob::getWheelTrack() const {
+  return header.wheelTrack;
+}
+
+int PathBlob::getLength(const std::string &ipathId) const {
+  const PathBlobEntry *entry = findEntry(ipathId);
+  return entry != nullptr ? entry->length : -1;
+}
+
+bool PathBlob::read(const std::string &ipathId, Segment *ileft, Segment *iright) const {
+  const PathBlobEntry *entry = findEntry(ipathId);
+  if (entry == nullptr) {
+    return false;
+  }
+
+  const std::size_t sideSize = sizeof(Segment) * static_cast<std::size_t>(entry->length);
+  if (!readBytes(entry->offset, ileft, sideSize) ||
+      !readBytes(entry->offset + sideSize, iright, sideSize)) {
+    LOG_ERROR("PathBlob: Could not read path " + ipathId);
+    return false;
+  }
+  return true;
+}
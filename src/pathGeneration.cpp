@@ -0,0 +1,301 @@
+// ------- pathGeneration.cpp --------------------------------------------------
+//
+// Tank drive motion profile generation, see pathGeneration.h
+
+#include "pathGeneration.h"
+#include "splineArcLength.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+struct CurvaturePoint {
+  double x, y, heading;
+  double distance;                    // m from the start of the path
+  double velocity;                    // m/s, first the limit, then the profile
+};
+
+double angleDifference(const double ito, const double ifrom) {
+  return std::remainder(ito - ifrom, 2 * PI);
+}
+
+/**
+ * pathfinder_prepare() and pathfinder_generate() with the arc length from
+ * SplineArcLength instead of sampling, otherwise the same steps.
+ */
+int pathfinderQuadrature(const std::vector<Waypoint> &iwaypoints,
+                         const double imaxVel,
+                         const double imaxAccel,
+                         const double imaxJerk,
+                         std::vector<Segment> &otrajectory) {
+  std::vector<Spline> splines(iwaypoints.size() - 1);
+  std::vector<SplineArcLength> lengths;
+  lengths.reserve(splines.size());
+  double totalLength = 0;
+  for (std::size_t i = 0; i < splines.size(); i++) {
+    pf_fit_hermite_cubic(iwaypoints[i], iwaypoints[i + 1], &splines[i]);
+    lengths.emplace_back(splines[i]);
+    totalLength += lengths.back().getLength();
+  }
+
+  TrajectoryConfig config{PATH_GENERATION_DT, imaxVel,  imaxAccel,
+                          imaxJerk,           0,        iwaypoints[0].angle,
+                          totalLength,        0,        iwaypoints[0].angle,
+                          PATHFINDER_SAMPLES_HIGH};
+  const TrajectoryInfo info = pf_trajectory_prepare(config);
+  if (info.length <= 0) {
+    return -1;
+  }
+
+  otrajectory.resize(info.length);
+  if (pf_trajectory_create(info, config, otrajectory.data()) < 0) {
+    return -1;
+  }
+
+  // place every segment on the spline its position falls on
+  std::size_t spline = 0;
+  double splineStart = 0;
+  for (auto &segment : otrajectory) {
+    while (spline + 1 < splines.size() &&
+           segment.position - splineStart > lengths[spline].getLength()) {
+      splineStart += lengths[spline].getLength();
+      spline++;
+    }
+
+    const double progress = lengths[spline].progressForDistance(segment.position - splineStart);
+    const Coord coords = pf_spline_coords(splines[spline], progress);
+    segment.heading = pf_spline_angle(splines[spline], progress);
+    segment.x = coords.x;
+    segment.y = coords.y;
+  }
+  return info.length;
+}
+} // namespace
+
+int PathGeneration::tank(const std::vector<Waypoint> &iwaypoints,
+                         const double imaxVel,
+                         const double imaxAccel,
+                         const double imaxJerk,
+                         const double itrack,
+                         std::vector<Segment> &oleft,
+                         std::vector<Segment> &oright,
+                         const int isamples,
+                         const PathGenerator igenerator) {
+  if (iwaypoints.size() < 2) {
+    return -1;
+  }
+
+  std::vector<Segment> trajectory;
+  int length;
+
+  if (igenerator == PathGenerator::curvature) {
+    length = curvatureLimited(iwaypoints, imaxVel, imaxAccel, itrack, isamples, trajectory);
+    if (length <= 0) {
+      return -1;
+    }
+  } else if (isamples == PATH_SAMPLES_QUADRATURE) {
+    length = pathfinderQuadrature(iwaypoints, imaxVel, imaxAccel, imaxJerk, trajectory);
+    if (length <= 0) {
+      return -1;
+    }
+  } else {
+    // pathfinder_prepare does not change the waypoints, it just is not const correct
+    std::vector<Waypoint> points = iwaypoints;
+    TrajectoryCandidate candidate;
+    pathfinder_prepare(points.data(), static_cast<int>(points.size()), FIT_HERMITE_CUBIC,
+                       isamples, PATH_GENERATION_DT, imaxVel, imaxAccel, imaxJerk, &candidate);
+
+    length = candidate.length;
+    if (length <= 0) {
+      free(candidate.laptr);
+      free(candidate.saptr);
+      return -1;
+    }
+
+    trajectory.resize(length);
+    pathfinder_generate(&candidate, trajectory.data());
+  }
+
+  oleft.resize(length);
+  oright.resize(length);
+  pathfinder_modify_tank(trajectory.data(), length, oleft.data(), oright.data(), itrack);
+  return length;
+}
+
+
+int PathGeneration::curvatureLimited(const std::vector<Waypoint> &iwaypoints,
+                                     const double imaxVel,
+                                     const double imaxAccel,
+                                     const double itrack,
+                                     const int isamples,
+                                     std::vector<Segment> &otrajectory) {
+  if (iwaypoints.size() < 2 || imaxVel <= 0 || imaxAccel <= 0 || isamples < 0) {
+    return -1;
+  }
+
+  // points every PATH_CURVATURE_STEP along the splines
+  std::vector<CurvaturePoint> points;
+  double distance = 0;                // along the path up to the end of the last spline / chord
+  double nextPoint = 0;               // where the next point goes
+
+  for (std::size_t i = 0; i + 1 < iwaypoints.size(); i++) {
+    Spline spline;
+    pf_fit_hermite_cubic(iwaypoints[i], iwaypoints[i + 1], &spline);
+
+    Coord last = pf_spline_coords(spline, 0);
+    if (points.empty()) {
+      points.push_back(CurvaturePoint{last.x, last.y, pf_spline_angle(spline, 0), 0, 0});
+      nextPoint = PATH_CURVATURE_STEP;
+    }
+
+    if (isamples == PATH_SAMPLES_QUADRATURE) {
+      const SplineArcLength arcLength(spline);
+      while (nextPoint <= distance + arcLength.getLength()) {
+        const double progress = arcLength.progressForDistance(nextPoint - distance);
+        const Coord coord = pf_spline_coords(spline, progress);
+        points.push_back(
+          CurvaturePoint{coord.x, coord.y, pf_spline_angle(spline, progress), nextPoint, 0});
+        nextPoint += PATH_CURVATURE_STEP;
+      }
+      distance += arcLength.getLength();
+      last = pf_spline_coords(spline, 1);
+    } else {
+      // isamples chords per spline, the way pathfinder measures the arc length
+      for (int k = 1; k <= isamples; k++) {
+        const double percentage = static_cast<double>(k) / isamples;
+        const Coord coord = pf_spline_coords(spline, percentage);
+        const double chord = std::hypot(coord.x - last.x, coord.y - last.y);
+
+        while (chord > 0 && distance + chord >= nextPoint) {
+          const double f = (nextPoint - distance) / chord;
+          const double at = (k - 1 + f) / isamples;
+          points.push_back(CurvaturePoint{last.x + f * (coord.x - last.x),
+                                          last.y + f * (coord.y - last.y),
+                                          pf_spline_angle(spline, at), nextPoint, 0});
+          nextPoint += PATH_CURVATURE_STEP;
+        }
+
+        distance += chord;
+        last = coord;
+      }
+    }
+
+    if (i + 2 == iwaypoints.size() && distance - points.back().distance > 1e-6) {
+      points.push_back(CurvaturePoint{last.x, last.y, pf_spline_angle(spline, 1), distance, 0});
+    }
+  }
+
+  if (points.size() < 2) {
+    return -1;
+  }
+
+  // a path no longer than PATH_CURVATURE_STEP has only its two ends, which both
+  // stand still and would take forever to connect: add the middle, where the
+  // profile stops accelerating and starts braking
+  if (points.size() == 2) {
+    const CurvaturePoint &from = points[0];
+    const CurvaturePoint &to = points[1];
+    const CurvaturePoint middle{(from.x + to.x) / 2, (from.y + to.y) / 2,
+                                from.heading + angleDifference(to.heading, from.heading) / 2,
+                                (from.distance + to.distance) / 2, 0};
+    points.insert(points.begin() + 1, middle);
+  }
+
+  const std::size_t count = points.size();
+
+  // velocity limit of every point: the outer wheel runs at v * (1 + k * track / 2)
+  // and the sideways acceleration is v^2 * k
+  for (std::size_t i = 0; i < count; i++) {
+    const std::size_t before = i > 0 ? i - 1 : i;
+    const std::size_t after = i + 1 < count ? i + 1 : i;
+    const double curvature =
+      std::abs(angleDifference(points[after].heading, points[before].heading) /
+               (points[after].distance - points[before].distance));
+
+    double limit = imaxVel / (1 + curvature * itrack / 2);
+    if (curvature > 0) {
+      limit = std::min(limit, std::sqrt(imaxAccel / curvature));
+    }
+    points[i].velocity = limit;
+  }
+
+  // forward pass accelerates from a stop, backward pass brakes to a stop
+  points.front().velocity = 0;
+  for (std::size_t i = 1; i < count; i++) {
+    const double ds = points[i].distance - points[i - 1].distance;
+    points[i].velocity = std::min(
+      points[i].velocity, std::sqrt(points[i - 1].velocity * points[i - 1].velocity + 2 * imaxAccel * ds));
+  }
+  points.back().velocity = 0;
+  for (std::size_t i = count - 1; i > 0; i--) {
+    const double ds = points[i].distance - points[i - 1].distance;
+    points[i - 1].velocity = std::min(
+      points[i - 1].velocity, std::sqrt(points[i].velocity * points[i].velocity + 2 * imaxAccel * ds));
+  }
+
+  // time at every point, with constant acceleration between two points
+  std::vector<double> times(count, 0);
+  for (std::size_t i = 1; i < count; i++) {
+    const double ds = points[i].distance - points[i - 1].distance;
+    times[i] = times[i - 1] + 2 * ds / (points[i - 1].velocity + points[i].velocity);
+  }
+
+  // sample the profile every PATH_GENERATION_DT, like pathfinder_generate()
+  const double total = times.back();
+  const int length = static_cast<int>(std::ceil(total / PATH_GENERATION_DT)) + 1;
+  otrajectory.assign(length, Segment{});
+
+  std::size_t i = 0;
+  double lastAcceleration = 0;
+  for (int k = 0; k < length; k++) {
+    const double t = std::min(k * PATH_GENERATION_DT, total);
+    while (i + 2 < count && times[i + 1] <= t) {
+      i++;
+    }
+
+    const CurvaturePoint &from = points[i];
+    const CurvaturePoint &to = points[i + 1];
+    const double ds = to.distance - from.distance;
+    const double acceleration = (to.velocity * to.velocity - from.velocity * from.velocity) / (2 * ds);
+    const double tau = t - times[i];
+    const double travelled = std::min(from.velocity * tau + acceleration * tau * tau / 2, ds);
+    const double f = travelled / ds;
+
+    Segment &segment = otrajectory[k];
+    segment.dt = PATH_GENERATION_DT;
+    segment.x = from.x + f * (to.x - from.x);
+    segment.y = from.y + f * (to.y - from.y);
+    segment.position = from.distance + travelled;
+    segment.velocity = std::max(from.velocity + acceleration * tau, 0.0);
+    segment.acceleration = acceleration;
+    segment.jerk = k > 0 ? (acceleration - lastAcceleration) / PATH_GENERATION_DT : 0;
+    segment.heading = from.heading + f * angleDifference(to.heading, from.heading);
+    lastAcceleration = acceleration;
+  }
+
+  return length;
+}
+
+std::vector<Waypoint> PathGeneration::fromPose(const double ix,
+                                               const double iy,
+                                               const double itheta,
+                                               const std::vector<Waypoint> &ifield) {
+  const double cosTheta = std::cos(itheta);
+  const double sinTheta = std::sin(itheta);
+
+  std::vector<Waypoint> points;
+  points.reserve(ifield.size() + 1);
+  points.push_back(Waypoint{0, 0, 0});
+
+  for (const auto &point : ifield) {
+    // rotate into the robot frame, then flip y and the angle to pathfinder's
+    const double dx = point.x - ix;
+    const double dy = point.y - iy;
+    const double forward = dx * cosTheta + dy * sinTheta;
+    const double right = -dx * sinTheta + dy * cosTheta;
+    points.push_back(
+      Waypoint{forward, -right, -std::remainder(point.angle - itheta, 2 * PI)});
+  }
+  return points;
+}
@@ -0,0 +1,261 @@
+// ------- purePursuitController.cpp -------------------------------------------
+//
+// Adaptive pure pursuit path follower, see purePursuitController.h
+
+#include "purePursuitController.h"
+#include "odomArcMath.h"
+#include "robotLog.h"
+#include "telemetry.h"
+
+#include "okapi/api/chassis/model/hDriveModel.hpp"
+#include "okapi/api/chassis/model/skidSteerModel.hpp"
+#include "okapi/api/chassis/model/xDriveModel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#define PURE_PURSUIT_MIN_SPEED 0.05   // m/s, crawl speed so the end of the path is reached
+
+PurePursuitController::PurePursuitController(
+  const okapi::TimeUtil &itimeUtil,
+  const std::shared_ptr<okapi::OdomChassisController> &ichassis,
+  const okapi::QLength &ilookaheadMin,
+  const okapi::QLength &ilookaheadMax,
+  const okapi::QTime &ilookaheadGain,
+  const okapi::QLength &isettleDistance,
+  const std::shared_ptr<okapi::Logger> &ilogger)
+  : logger(ilogger),
+    timer(itimeUtil.getTimer()),
+    rate(itimeUtil.getRate()),
+    chassis(ichassis),
+    lookaheadMin(ilookaheadMin.convert(okapi::meter)),
+    lookaheadMax(std::max(ilookaheadMax.convert(okapi::meter), lookaheadMin)),
+    lookaheadGain(ilookaheadGain.convert(okapi::second)),
+    settleDistance(isettleDistance.convert(okapi::meter)) {
+  const auto model = chassis->getModel();
+  if (const auto skidSteer = std::dynamic_pointer_cast<okapi::SkidSteerModel>(model)) {
+    leftMotors = {skidSteer->getLeftSideMotor()};
+    rightMotors = {skidSteer->getRightSideMotor()};
+  } else if (const auto xDrive = std::dynamic_pointer_cast<okapi::XDriveModel>(model)) {
+    leftMotors = {xDrive->getTopLeftMotor(), xDrive->getBottomLeftMotor()};
+    rightMotors = {xDrive->getTopRightMotor(), xDrive->getBottomRightMotor()};
+  } else if (const auto hDrive = std::dynamic_pointer_cast<okapi::HDriveModel>(model)) {
+    leftMotors = {hDrive->getLeftSideMotor()};
+    rightMotors = {hDrive->getRightSideMotor()};
+  } else {
+    LOG_ERROR_S("PurePursuitController: The chassis model has no left and right side motors.");
+  }
+}
+
+double PurePursuitController::rpmPerMeterPerSecond() const {
+  // wheel rpm for 1 m/s, times the motor : wheel ratio
+  const double wheelCircumference =
+    chassis->getChassisScales().wheelDiameter.convert(okapi::meter) * okapi::pi;
+  return 60 / wheelCircumference * chassis->getGearsetRatioPair().ratio;
+}
+
+double PurePursuitController::getMaxSpeed() const {
+  return chassis->getMaxVelocity() / rpmPerMeterPerSecond();
+}
+
+bool PurePursuitController::followPath(const std::vector<okapi::Point> &iwaypoints,
+                                       const PursuitPathLimits &ilimits,
+                                       const okapi::StateMode &imode,
+                                       const okapi::QTime &itimeout) {
+  PursuitPathLimits limits = ilimits;
+  const double maxSpeed = getMaxSpeed();
+  if (limits.maxVelocity > maxSpeed) {
+    LOG_INFO("PurePursuitController: Path speed capped to chassis max of " +
+             std::to_string(maxSpeed) + " m/s");
+    limits.maxVelocity = maxSpeed;
+  }
+
+  return followPath(PursuitPath::generate(iwaypoints, limits, imode), itimeout);
+}
+
+void PurePursuitController::stop() {
+  if (following.load(std::memory_order_acquire)) {
+    stopRequested.store(true, std::memory_order_release);
+  }
+}
+
+void PurePursuitController::moveSides(const double ileftRpm, const double irightRpm) {
+  // keep the ratio between the sides if one of them is saturated, that is what steers
+  const double maxVelocity = chassis->getMaxVelocity();
+  const double largest = std::max(std::abs(ileftRpm), std::abs(irightRpm));
+  const double scale = largest > maxVelocity ? maxVelocity / largest : 1;
+
+  for (const auto &motor : leftMotors) {
+    motor->moveVelocity(static_cast<std::int16_t>(std::lround(ileftRpm * scale)));
+  }
+  for (const auto &motor : rightMotors) {
+    motor->moveVelocity(static_cast<std::int16_t>(std::lround(irightRpm * scale)));
+  }
+}
+
+bool PurePursuitController::followPath(const std::vector<PursuitPoint> &ipath,
+                                       const okapi::QTime &itimeout) {
+  if (ipath.size() < 2) {
+    LOG_WARN_S("PurePursuitController: Path needs at least two points.");
+    return false;
+  }
+
+  if (leftMotors.empty()) {
+    LOG_ERROR_S("PurePursuitController: Can't follow a path without side motors.");
+    return false;
+  }
+
+  LOG_INFO("PurePursuitController: Following path of " + std::to_string(ipath.size()) +
+           " points, " + std::to_string(ipath.back().distance) + " m");
+
+  auto odometry = chassis->getOdometry();
+  const double track = chassis->getChassisScales().wheelTrack.convert(okapi::meter);
+  const double speedToRpm = rpmPerMeterPerSecond();
+  const double maxAcceleration = [&]() {
+    // steepest speed change the path asks for, used to limit the ramp up
+    double steepest = 0;
+    for (std::size_t i = 1; i < ipath.size(); i++) {
+      const double gap = ipath[i].distance - ipath[i - 1].distance;
+      if (gap > 0) {
+        steepest = std::max(steepest,
+                            std::abs(ipath[i].velocity * ipath[i].velocity -
+                                     ipath[i - 1].velocity * ipath[i - 1].velocity) /
+                              (2 * gap));
+      }
+    }
+    return steepest > 0 ? steepest : 1.0;
+  }();
+
+  closestIndex = 0;
+  lookaheadIndex = 0;
+  lookaheadX = ipath[0].x;
+  lookaheadY = ipath[0].y;
+
+  const double period = PURE_PURSUIT_PERIOD.convert(okapi::second);
+  const PursuitPoint &end = ipath.back();
+  double velocity = 0;
+  bool reached = false;
+
+  stopRequested.store(false, std::memory_order_release);
+  following.store(true, std::memory_order_release);
+  timer->placeMark();
+
+  while (!stopRequested.load(std::memory_order_acquire)) {
+    if (timer->getDtFromMark() > itimeout) {
+      LOG_WARN("PurePursuitController: Path timed out after " +
+               std::to_string(itimeout.convert(okapi::second)) + " s");
+      break;
+    }
+
+    const OdomPose pose = OdomArcMath::fromState(
+      odometry->getState(okapi::StateMode::FRAME_TRANSFORMATION),
+      okapi::StateMode::FRAME_TRANSFORMATION);
+
+    updateClosest(ipath, pose.x, pose.y);
+    telemetryReportError(TELEMETRY_ID_PURSUIT,
+                         static_cast<float>(std::hypot(ipath[closestIndex].x - pose.x,
+                                                       ipath[closestIndex].y - pose.y)));
+
+    // done once the robot is at the end, or has driven past it
+    const double toEndX = end.x - pose.x;
+    const double toEndY = end.y - pose.y;
+    const double endAhead = toEndX * std::cos(pose.theta) + toEndY * std::sin(pose.theta);
+    if (closestIndex + 1 >= ipath.size() &&
+        (std::hypot(toEndX, toEndY) < settleDistance || endAhead < 0)) {
+      reached = true;
+      break;
+    }
+
+    const double lookahead =
+      std::min(lookaheadMin + lookaheadGain * std::abs(velocity), lookaheadMax);
+    updateLookahead(ipath, pose.x, pose.y, lookahead);
+
+    // curvature of the arc from the robot through the lookahead point, positive to the right
+    const double dX = lookaheadX - pose.x;
+    const double dY = lookaheadY - pose.y;
+    const double side = -dX * std::sin(pose.theta) + dY * std::cos(pose.theta);
+    const double distanceSquared = dX * dX + dY * dY;
+    const double curvature = distanceSquared > 0 ? 2 * side / distanceSquared : 0;
+
+    // the path already slows down early enough, only the ramp up has to be limited
+    const double maxChange = maxAcceleration * period;
+    velocity = std::min(std::max(ipath[closestIndex].velocity, PURE_PURSUIT_MIN_SPEED),
+                        velocity + maxChange);
+
+    ROBOT_LOG_DEBUG("PurePursuitController: closest {} v {} curvature {}", closestIndex,
+                    velocity, curvature);
+
+    moveSides(velocity * (2 + curvature * track) / 2 * speedToRpm,
+              velocity * (2 - curvature * track) / 2 * speedToRpm);
+    rate->delayUntil(PURE_PURSUIT_PERIOD);
+  }
+
+  moveSides(0, 0);
+  following.store(false, std::memory_order_release);
+
+  if (reached) {
+    LOG_INFO_S("PurePursuitController: Path done.");
+  } else {
+    LOG_WARN_S("PurePursuitController: Path ended before its end was reached.");
+  }
+  return reached;
+}
+
+void PurePursuitController::updateClosest(const std::vector<PursuitPoint> &ipath,
+                                          const double ix,
+                                          const double iy) {
+  // never search past the lookahead point, a path which comes back near itself must not
+  // make the robot skip the loop
+  const std::size_t last =
+    std::min(static_cast<std::size_t>(lookaheadIndex) + 1, ipath.size() - 1);
+  double best = std::hypot(ipath[closestIndex].x - ix, ipath[closestIndex].y - iy);
+  for (std::size_t i = closestIndex + 1; i <= last; i++) {
+    const double distance = std::hypot(ipath[i].x - ix, ipath[i].y - iy);
+    if (distance < best) {
+      best = distance;
+      closestIndex = i;
+    }
+  }
+}
+
+void PurePursuitController::updateLookahead(const std::vector<PursuitPoint> &ipath,
+                                            const double ix,
+                                            const double iy,
+                                            const double ilookahead) {
+  const auto firstSegment = static_cast<std::size_t>(lookaheadIndex);
+
+  for (std::size_t i = firstSegment; i + 1 < ipath.size(); i++) {
+    // intersect the lookahead circle with the segment start + t * (end - start)
+    const double segmentX = ipath[i + 1].x - ipath[i].x;
+    const double segmentY = ipath[i + 1].y - ipath[i].y;
+    const double fromRobotX = ipath[i].x - ix;
+    const double fromRobotY = ipath[i].y - iy;
+
+    const double a = segmentX * segmentX + segmentY * segmentY;
+    const double b = 2 * (fromRobotX * segmentX + fromRobotY * segmentY);
+    const double c = fromRobotX * fromRobotX + fromRobotY * fromRobotY - ilookahead * ilookahead;
+    const double discriminant = b * b - 4 * a * c;
+    if (a == 0 || discriminant < 0) {
+      continue;
+    }
+
+    // the far intersection is the one further along the path
+    const double root = std::sqrt(discriminant);
+    for (const double t : {(-b + root) / (2 * a), (-b - root) / (2 * a)}) {
+      if (t >= 0 && t <= 1 && i + t > lookaheadIndex) {
+        lookaheadIndex = i + t;
+        lookaheadX = ipath[i].x + t * segmentX;
+        lookaheadY = ipath[i].y + t * segmentY;
+        return;
+      }
+    }
+  }
+
+  // close to the end the circle no longer crosses the path, aim at the end itself
+  if (std::hypot(ipath.back().x - ix, ipath.back().y - iy) < ilookahead) {
+    lookaheadIndex = static_cast<double>(ipath.size() - 1);
+    lookaheadX = ipath.back().x;
+    lookaheadY = ipath.back().y;
+  }
+}
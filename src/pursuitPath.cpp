@@ -0,0 +1,127 @@
+// ------- pursuitPath.cpp -----------------------------------------------------
+//
+// Pure pursuit path preparation, see pursuitPath.h
+
+#include "pursuitPath.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define PURSUIT_SMOOTH_TOLERANCE 0.0001   // m, smoothing stops when no point moves more
+#define PURSUIT_SMOOTH_MAX_PASSES 200
+
+std::vector<PursuitPoint> PursuitPath::generate(const std::vector<okapi::Point> &iwaypoints,
+                                                const PursuitPathLimits &ilimits,
+                                                const okapi::StateMode &imode) {
+  std::vector<PursuitPoint> points;
+  if (iwaypoints.size() < 2) {
+    return points;
+  }
+
+  injectPoints(points, iwaypoints, ilimits.spacing, imode);
+  smooth(points, ilimits.smoothing);
+  computeProfile(points, ilimits);
+  return points;
+}
+
+void PursuitPath::injectPoints(std::vector<PursuitPoint> &ipoints,
+                               const std::vector<okapi::Point> &iwaypoints,
+                               const double ispacing,
+                               const okapi::StateMode &imode) {
+  for (std::size_t i = 0; i + 1 < iwaypoints.size(); i++) {
+    const okapi::Point start = iwaypoints[i].inFT(imode);
+    const okapi::Point end = iwaypoints[i + 1].inFT(imode);
+    const double startX = start.x.convert(okapi::meter);
+    const double startY = start.y.convert(okapi::meter);
+    const double dX = end.x.convert(okapi::meter) - startX;
+    const double dY = end.y.convert(okapi::meter) - startY;
+
+    const auto count =
+      std::max(1, static_cast<int>(std::ceil(std::hypot(dX, dY) / std::max(ispacing, 0.001))));
+    for (int j = 0; j < count; j++) {
+      PursuitPoint point;
+      point.x = startX + dX * j / count;
+      point.y = startY + dY * j / count;
+      ipoints.push_back(point);
+    }
+  }
+
+  const okapi::Point last = iwaypoints.back().inFT(imode);
+  PursuitPoint point;
+  point.x = last.x.convert(okapi::meter);
+  point.y = last.y.convert(okapi::meter);
+  ipoints.push_back(point);
+}
+
+void PursuitPath::smooth(std::vector<PursuitPoint> &ipoints, const double ismoothing) {
+  if (ismoothing <= 0 || ipoints.size() < 3) {
+    return;
+  }
+
+  // gradient descent between staying on the original points and being the
+  // average of the neighbours, the end points never move
+  const double weightSmooth = std::min(ismoothing, 0.99);
+  const double weightData = 1 - weightSmooth;
+  const std::vector<PursuitPoint> original = ipoints;
+
+  for (int pass = 0; pass < PURSUIT_SMOOTH_MAX_PASSES; pass++) {
+    double change = 0;
+    for (std::size_t i = 1; i + 1 < ipoints.size(); i++) {
+      const double oldX = ipoints[i].x;
+      const double oldY = ipoints[i].y;
+      ipoints[i].x += weightData * (original[i].x - oldX) +
+                      weightSmooth * (ipoints[i - 1].x + ipoints[i + 1].x - 2 * oldX);
+      ipoints[i].y += weightData * (original[i].y - oldY) +
+                      weightSmooth * (ipoints[i - 1].y + ipoints[i + 1].y - 2 * oldY);
+      change = std::max(change, std::hypot(ipoints[i].x - oldX, ipoints[i].y - oldY));
+    }
+    if (change < PURSUIT_SMOOTH_TOLERANCE) {
+      break;
+    }
+  }
+}
+
+void PursuitPath::computeProfile(std::vector<PursuitPoint> &ipoints,
+                                 const PursuitPathLimits &ilimits) {
+  if (ipoints.empty()) {
+    return;
+  }
+
+  ipoints[0].distance = 0;
+  for (std::size_t i = 1; i < ipoints.size(); i++) {
+    ipoints[i].distance = ipoints[i - 1].distance +
+                          std::hypot(ipoints[i].x - ipoints[i - 1].x, ipoints[i].y - ipoints[i - 1].y);
+  }
+
+  // curvature of the circle through each point and its two neighbours
+  ipoints.front().curvature = 0;
+  ipoints.back().curvature = 0;
+  for (std::size_t i = 1; i + 1 < ipoints.size(); i++) {
+    const PursuitPoint &a = ipoints[i - 1];
+    const PursuitPoint &b = ipoints[i];
+    const PursuitPoint &c = ipoints[i + 1];
+    const double ab = std::hypot(b.x - a.x, b.y - a.y);
+    const double bc = std::hypot(c.x - b.x, c.y - b.y);
+    const double ca = std::hypot(a.x - c.x, a.y - c.y);
+    const double twiceArea = std::abs((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x));
+    const double product = ab * bc * ca;
+    ipoints[i].curvature = product > 0 ? 2 * twiceArea / product : 0;
+  }
+
+  for (auto &point : ipoints) {
+    point.velocity = ilimits.maxVelocity;
+    if (point.curvature > 0) {
+      point.velocity = std::min(point.velocity, ilimits.turnConstant / point.curvature);
+    }
+  }
+
+  // ramp down to a stop at the end, and early enough for every slow curve
+  ipoints.back().velocity = 0;
+  for (std::size_t i = ipoints.size() - 1; i > 0; i--) {
+    const double gap = ipoints[i].distance - ipoints[i - 1].distance;
+    ipoints[i - 1].velocity =
+      std::min(ipoints[i - 1].velocity,
+               std::sqrt(ipoints[i].velocity * ipoints[i].velocity +
+                         2 * ilimits.maxAcceleration * gap));
+  }
+}
@@ -0,0 +1,39 @@
+// ------- snapshotChassisModels.cpp -------------------------------------------
+//
+// Allocation free sensor reads for okapi's chassis models, see
+// snapshotChassisModels.h
+
+#include "snapshotChassisModels.h"
+
+void SnapshotSkidSteerModel::getSensorVals(SensorSnapshot &out) const {
+  out.vals[0] = static_cast<std::int32_t>(leftSensor->get());
+  out.vals[1] = static_cast<std::int32_t>(rightSensor->get());
+  out.count = 2;
+}
+
+void SnapshotThreeEncoderSkidSteerModel::getSensorVals(SensorSnapshot &out) const {
+  out.vals[0] = static_cast<std::int32_t>(leftSensor->get());
+  out.vals[1] = static_cast<std::int32_t>(rightSensor->get());
+  out.vals[2] = static_cast<std::int32_t>(middleSensor->get());
+  out.count = 3;
+}
+
+void SnapshotXDriveModel::getSensorVals(SensorSnapshot &out) const {
+  out.vals[0] = static_cast<std::int32_t>(leftSensor->get());
+  out.vals[1] = static_cast<std::int32_t>(rightSensor->get());
+  out.count = 2;
+}
+
+void SnapshotThreeEncoderXDriveModel::getSensorVals(SensorSnapshot &out) const {
+  out.vals[0] = static_cast<std::int32_t>(leftSensor->get());
+  out.vals[1] = static_cast<std::int32_t>(rightSensor->get());
+  out.vals[2] = static_cast<std::int32_t>(middleSensor->get());
+  out.count = 3;
+}
+
+void SnapshotHDriveModel::getSensorVals(SensorSnapshot &out) const {
+  out.vals[0] = static_cast<std::int32_t>(leftSensor->get());
+  out.vals[1] = static_cast<std::int32_t>(rightSensor->get());
+  out.vals[2] = static_cast<std::int32_t>(middleSensor->get());
+  out.count = 3;
+}
@@ -0,0 +1,69 @@
+// ------- splineArcLength.cpp -------------------------------------------------
+//
+// Spline arc length by Gauss-Legendre quadrature, see splineArcLength.h
+
+#include "splineArcLength.h"
+
+#include <algorithm>
+#include <cmath>
+
+// 5 point Gauss-Legendre nodes and weights on [-1, 1]
+static const double gaussNodes[5] = {0.0, -0.5384693101056831, 0.5384693101056831,
+                                     -0.9061798459386640, 0.9061798459386640};
+static const double gaussWeights[5] = {0.5688888888888889, 0.4786286704993665,
+                                       0.4786286704993665, 0.2369268850561891,
+                                       0.2369268850561891};
+
+SplineArcLength::SplineArcLength(const Spline &ispline) : spline(ispline) {
+  table[0] = 0;
+  for (int i = 0; i < ARC_LENGTH_INTERVALS; i++) {
+    table[i + 1] = table[i] + integrate(static_cast<double>(i) / ARC_LENGTH_INTERVALS,
+                                        static_cast<double>(i + 1) / ARC_LENGTH_INTERVALS);
+  }
+}
+
+double SplineArcLength::getLength() const {
+  return table[ARC_LENGTH_INTERVALS];
+}
+
+double SplineArcLength::integrand(const double iprogress) const {
+  // the spline is y(x) in its own frame with x = progress * knot_distance
+  const double x = iprogress * spline.knot_distance;
+  const double dydx = (((5 * spline.a * x + 4 * spline.b) * x + 3 * spline.c) * x + 2 * spline.d) * x +
+                      spline.e;
+  return spline.knot_distance * std::sqrt(1 + dydx * dydx);
+}
+
+double SplineArcLength::integrate(const double ifrom, const double ito) const {
+  const double half = (ito - ifrom) / 2;
+  const double middle = (ito + ifrom) / 2;
+
+  double sum = 0;
+  for (int i = 0; i < 5; i++) {
+    sum += gaussWeights[i] * integrand(middle + half * gaussNodes[i]);
+  }
+  return sum * half;
+}
+
+double SplineArcLength::progressForDistance(const double idistance) const {
+  if (idistance <= 0) {
+    return 0;
+  }
+  if (idistance >= getLength()) {
+    return 1;
+  }
+
+  // the interval the distance is in, then Newton steps from its linear estimate
+  const auto upper = std::upper_bound(table.begin(), table.end(), idistance);
+  const int i = static_cast<int>(upper - table.begin()) - 1;
+  const double start = static_cast<double>(i) / ARC_LENGTH_INTERVALS;
+  const double end = static_cast<double>(i + 1) / ARC_LENGTH_INTERVALS;
+  const double remaining = idistance - table[i];
+
+  double progress = start + (end - start) * remaining / (table[i + 1] - table[i]);
+  for (int step = 0; step < ARC_LENGTH_NEWTON_STEPS; step++) {
+    const double error = integrate(start, progress) - remaining;
+    progress = std::clamp(progress - error / integrand(progress), start, end);
+  }
+  return progress;
+}
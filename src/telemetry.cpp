@@ -0,0 +1,131 @@
+// ------- telemetry.cpp -------------------------------------------------------
+//
+// Binary telemetry stream to the Raspberry Pi Zero W radio, see telemetry.h
+// and telemetryProtocol.h. The Pi side decoder lives in tools/telemetryLink.
+
+#include "main.h"
+#include "globals.h"
+#include "portdef.h"
+#include "telemetry.h"
+#include "telemetryProtocol.h"
+
+#include <atomic>
+#include <cstdio>
+
+static std::shared_ptr<okapi::OdomChassisController> telemetryChassis;
+static std::uint32_t telemetryPeriod = 20;
+static std::uint8_t telemetrySeq = 0;
+static std::atomic<bool> telemetryRunning{false};
+static std::atomic<bool> telemetryDone{true};
+static std::uint32_t telemetryDropped = 0;   // frames the smart port buffer had no room for
+
+static std::atomic<float> controllerErrors[TELEMETRY_MAX_CONTROLLERS];
+static std::atomic<bool> controllerErrorPending[TELEMETRY_MAX_CONTROLLERS];
+
+static void telemetrySend(std::uint8_t channel, const void *payload, std::size_t length) {
+  std::uint8_t frame[TELEMETRY_MAX_FRAME];
+  const std::size_t size = telemetryEncodeFrame(frame, channel, telemetrySeq++, payload, length);
+#if TELEMETRY_PORT == 0
+  // one write per frame so the frame is not split up by other output
+  fwrite(frame, 1, size, stdout);
+#else
+  // only whole frames go out, the receiver sees a dropped one as a gap in seq
+  if (pros::c::serial_get_write_free(TELEMETRY_PORT) < static_cast<std::int32_t>(size)) {
+    telemetryDropped++;
+    return;
+  }
+  pros::c::serial_write(TELEMETRY_PORT, frame, static_cast<std::int32_t>(size));
+#endif
+}
+
+static void telemetryFillMotor(TelemetryMotor &out, pros::Motor &motor) {
+  out.velocity = static_cast<std::int16_t>(motor.get_actual_velocity());
+  out.current = static_cast<std::int16_t>(motor.get_current_draw());
+  out.temperature = static_cast<std::uint8_t>(motor.get_temperature());
+  out.flags = 0;
+}
+
+static void telemetryTask(void *) {
+  std::uint32_t now = pros::c::millis();
+
+  while (telemetryRunning.load()) {
+    const std::uint32_t timestamp = pros::c::millis();
+
+    const okapi::OdomState state = telemetryChassis->getState();
+    TelemetryOdometry odometry;
+    odometry.timestamp = timestamp;
+    odometry.x = static_cast<float>(state.x.convert(okapi::meter));
+    odometry.y = static_cast<float>(state.y.convert(okapi::meter));
+    odometry.theta = static_cast<float>(state.theta.convert(okapi::degree));
+    telemetrySend(TELEMETRY_CHANNEL_ODOMETRY, &odometry, sizeof(odometry));
+
+    TelemetryMotorState motorState;
+    motorState.timestamp = timestamp;
+    telemetryFillMotor(motorState.motors[0], left_wheel_front);
+    telemetryFillMotor(motorState.motors[1], left_wheel_back);
+    telemetryFillMotor(motorState.motors[2], right_wheel_front);
+    telemetryFillMotor(motorState.motors[3], right_wheel_back);
+    telemetrySend(TELEMETRY_CHANNEL_MOTOR_STATE, &motorState, sizeof(motorState));
+
+    // only send controller errors which changed since the last round
+    for (std::uint8_t id = 0; id < TELEMETRY_MAX_CONTROLLERS; id++) {
+      if (controllerErrorPending[id].exchange(false)) {
+        TelemetryControllerError error{};
+        error.timestamp = timestamp;
+        error.controllerId = id;
+        error.error = controllerErrors[id].load();
+        telemetrySend(TELEMETRY_CHANNEL_CONTROLLER_ERROR, &error, sizeof(error));
+      }
+    }
+
+#if TELEMETRY_PORT == 0
+    fflush(stdout);
+#endif
+    pros::c::task_delay_until(&now, telemetryPeriod);
+  }
+
+  telemetryDone = true;
+}
+
+void telemetryStart(const std::shared_ptr<okapi::OdomChassisController> &ichassis,
+                    std::uint32_t iperiodMs) {
+  if (telemetryRunning.load() || !telemetryDone.load()) {
+    return;
+  }
+
+#if TELEMETRY_PORT != 0
+  if (pros::c::serial_enable(TELEMETRY_PORT) == PROS_ERR ||
+      pros::c::serial_set_baudrate(TELEMETRY_PORT, TELEMETRY_BAUDRATE) == PROS_ERR) {
+    std::cout << "Telemetry port " << TELEMETRY_PORT << " could not be set up for serial \n";
+    return;
+  }
+#endif
+
+  telemetryChassis = ichassis;
+  telemetryPeriod = iperiodMs;
+  telemetryDropped = 0;
+  telemetryDone = false;
+  telemetryRunning = true;
+  pros::c::task_create(telemetryTask, nullptr, TASK_PRIORITY_DEFAULT - 1, TASK_STACK_DEPTH_DEFAULT,
+                       "Telemetry");
+}
+
+void telemetryStop() {
+  telemetryRunning = false;
+  while (!telemetryDone.load()) {
+    pros::delay(1);
+  }
+  telemetryChassis.reset();
+
+  if (telemetryDropped > 0) {
+    std::cout << "Telemetry dropped " << telemetryDropped << " frames - serial link too slow \n";
+  }
+}
+
+void telemetryReportError(std::uint8_t icontrollerId, float ierror) {
+  if (icontrollerId >= TELEMETRY_MAX_CONTROLLERS) {
+    return;
+  }
+  controllerErrors[icontrollerId] = ierror;
+  controllerErrorPending[icontrollerId] = true;
+}
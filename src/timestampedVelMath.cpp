@@ -0,0 +1,92 @@
+// ------- timestampedVelMath.cpp ----------------------------------------------
+//
+// Velocity from device timestamped encoder readings, see timestampedVelMath.h
+
+#include "timestampedVelMath.h"
+
+#include "okapi/api/util/mathUtil.hpp"
+
+#include <cmath>
+
+TimestampedVelMath::TimestampedVelMath(const double iticksPerRev,
+                                       std::unique_ptr<okapi::Filter> ifilter,
+                                       const okapi::QTime isampleTime,
+                                       std::unique_ptr<okapi::AbstractTimer> iloopDtTimer,
+                                       std::shared_ptr<okapi::AbstractMotor> imotor,
+                                       std::shared_ptr<okapi::Logger> ilogger)
+  : okapi::VelMath(iticksPerRev,
+                   std::move(ifilter),
+                   isampleTime,
+                   std::move(iloopDtTimer),
+                   std::move(ilogger)),
+    motor(std::move(imotor)) {
+}
+
+okapi::QAngularSpeed TimestampedVelMath::step(const double inewPos) {
+  if (motor) {
+    if (!haveTimestamp) {
+      rawScale = readRawScale();
+    }
+    std::uint32_t timestamp = 0;
+    const std::int32_t raw = motor->getRawPosition(&timestamp);
+    if (raw != okapi::OKAPI_PROS_ERR && !std::isnan(rawScale)) {
+      return stepAt(raw * rawScale, timestamp);
+    }
+  }
+  // the raw counts are not tared like inewPos, start over when they come back
+  haveTimestamp = false;
+  return okapi::VelMath::step(inewPos);
+}
+
+okapi::QAngularSpeed TimestampedVelMath::stepAt(const double inewPos,
+                                                const std::uint32_t itimestamp) {
+  if (!haveTimestamp) {
+    lastPos = inewPos;
+    lastTimestamp = itimestamp;
+    haveTimestamp = true;
+    return vel;
+  }
+
+  // the same device sample read again (or an older one), nothing new to differentiate
+  const auto dtMs = static_cast<std::int32_t>(itimestamp - lastTimestamp);
+  if (dtMs <= 0) {
+    repeatedSamples++;
+    return vel;
+  }
+
+  const okapi::QTime dt = dtMs * okapi::millisecond;
+  if (dt < sampleTime) {
+    return vel;
+  }
+
+  vel = filter->filter((inewPos - lastPos) * (60000.0 / dtMs) / ticksPerRev) * okapi::rpm;
+  accel = (vel - lastVel) / dt;
+
+  lastVel = vel;
+  lastPos = inewPos;
+  lastTimestamp = itimestamp;
+
+  return vel;
+}
+
+double TimestampedVelMath::readRawScale() const {
+  const auto gearing = motor->getGearing();
+  if (gearing == okapi::AbstractMotor::gearset::invalid) {
+    return NAN;
+  }
+  const double countsPerRev = okapi::gearsetToTPR(gearing);
+  switch (motor->getEncoderUnits()) {
+  case okapi::AbstractMotor::encoderUnits::counts:
+    return 1;
+  case okapi::AbstractMotor::encoderUnits::degrees:
+    return 360.0 / countsPerRev;
+  case okapi::AbstractMotor::encoderUnits::rotations:
+    return 1.0 / countsPerRev;
+  default:
+    return NAN;
+  }
+}
+
+std::uint32_t TimestampedVelMath::getRepeatedSamples() const {
+  return repeatedSamples;
+}
@@ -0,0 +1,41 @@
+// ------- trackingWheelModel.cpp ----------------------------------------------
+//
+// Read only model of the tracking wheels, see trackingWheelModel.h
+
+#include "trackingWheelModel.h"
+
+TrackingWheelModel::TrackingWheelModel(std::shared_ptr<okapi::ContinuousRotarySensor> ileftSensor,
+                                       std::shared_ptr<okapi::ContinuousRotarySensor> irightSensor,
+                                       std::shared_ptr<okapi::ContinuousRotarySensor> imiddleSensor)
+  : leftSensor(std::move(ileftSensor)),
+    rightSensor(std::move(irightSensor)),
+    middleSensor(std::move(imiddleSensor)) {
+}
+
+std::valarray<std::int32_t> TrackingWheelModel::getSensorVals() const {
+  if (middleSensor) {
+    return std::valarray<std::int32_t>{static_cast<std::int32_t>(leftSensor->get()),
+                                       static_cast<std::int32_t>(rightSensor->get()),
+                                       static_cast<std::int32_t>(middleSensor->get())};
+  }
+  return std::valarray<std::int32_t>{static_cast<std::int32_t>(leftSensor->get()),
+                                     static_cast<std::int32_t>(rightSensor->get())};
+}
+
+void TrackingWheelModel::getSensorVals(SensorSnapshot &out) const {
+  out.vals[0] = static_cast<std::int32_t>(leftSensor->get());
+  out.vals[1] = static_cast<std::int32_t>(rightSensor->get());
+  out.count = 2;
+  if (middleSensor) {
+    out.vals[2] = static_cast<std::int32_t>(middleSensor->get());
+    out.count = 3;
+  }
+}
+
+void TrackingWheelModel::resetSensors() {
+  leftSensor->reset();
+  rightSensor->reset();
+  if (middleSensor) {
+    middleSensor->reset();
+  }
+}
@@ -0,0 +1,204 @@
+// ------- trajectoryView.cpp --------------------------------------------------
+//
+// Trajectory views, see trajectoryView.h
+
+#include "trajectoryView.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+SegmentTrajectory::SegmentTrajectory(SegmentPtr ileft, SegmentPtr iright, const int ilength)
+  : left(std::move(ileft)), right(std::move(iright)), length(ilength) {
+}
+
+int SegmentTrajectory::size() const {
+  return length;
+}
+
+double SegmentTrajectory::getDt() const {
+  return length > 0 ? left.get()[0].dt : 0;
+}
+
+bool SegmentTrajectory::isPair() const {
+  return right != nullptr;
+}
+
+TrajectorySample SegmentTrajectory::get(const int i) const {
+  const Segment &l = left.get()[i];
+  if (right == nullptr) {
+    return TrajectorySample{l.position, l.velocity, l.acceleration};
+  }
+
+  const Segment &r = right.get()[i];
+  return TrajectorySample{l.position, l.velocity,     l.acceleration, r.position,
+                          r.velocity, r.acceleration, l.heading};
+}
+
+std::size_t SegmentTrajectory::memoryUsage() const {
+  return sizeof(Segment) * static_cast<std::size_t>(length) * (right == nullptr ? 1 : 2);
+}
+
+TrajectoryView::TrajectoryView(std::shared_ptr<const TrajectorySource> isource) {
+  if (!isource || isource->size() <= 0) {
+    return;
+  }
+
+  length = isource->size();
+  dt = isource->getDt();
+  pair = isource->isPair();
+
+  Piece piece;
+  piece.source = std::move(isource);
+  piece.length = length;
+  pieces.push_back(std::move(piece));
+}
+
+int TrajectoryView::size() const {
+  return length;
+}
+
+double TrajectoryView::getDt() const {
+  return dt;
+}
+
+bool TrajectoryView::isPair() const {
+  return pair;
+}
+
+TrajectorySample TrajectoryView::get(const int i) const {
+  const Piece &piece = pieceAt(i);
+  const int step = i - piece.first;
+  const TrajectorySample in = piece.source->get(piece.timeReversed ? piece.length - 1 - step : step);
+
+  const double(&m)[2][2] = piece.matrix;
+  const double sign = piece.velocitySign;
+
+  TrajectorySample out;
+  out.leftPosition = m[0][0] * in.leftPosition + m[0][1] * in.rightPosition + piece.offset[0];
+  out.rightPosition = m[1][0] * in.leftPosition + m[1][1] * in.rightPosition + piece.offset[1];
+  out.leftVelocity = sign * (m[0][0] * in.leftVelocity + m[0][1] * in.rightVelocity);
+  out.rightVelocity = sign * (m[1][0] * in.leftVelocity + m[1][1] * in.rightVelocity);
+  out.leftAcceleration = m[0][0] * in.leftAcceleration + m[0][1] * in.rightAcceleration;
+  out.rightAcceleration = m[1][0] * in.leftAcceleration + m[1][1] * in.rightAcceleration;
+  out.heading = pair ? piece.headingSign * in.heading + piece.headingOffset : 0;
+  return out;
+}
+
+std::size_t TrajectoryView::memoryUsage() const {
+  return pieces.capacity() * sizeof(Piece);
+}
+
+TrajectoryView TrajectoryView::mirrored() const {
+  TrajectoryView out(*this);
+  if (pair && length > 0) {
+    // the heading turns the other way around where the path starts
+    const double swap[2][2] = {{0, 1}, {1, 0}};
+    out.transform(swap, -1, 2 * get(0).heading);
+  }
+  return out;
+}
+
+TrajectoryView TrajectoryView::backwards() const {
+  TrajectoryView out(*this);
+  if (length > 0) {
+    const double negate[2][2] = {{-1, 0}, {0, -1}};
+    out.transform(negate, -1, pair ? 2 * get(0).heading : 0);
+  }
+  return out;
+}
+
+TrajectoryView TrajectoryView::reversed() const {
+  TrajectoryView out(*this);
+  if (length == 0) {
+    return out;
+  }
+
+  // step i of the result is step length - 1 - i, measured from the end:
+  // positions count down to where the path started, velocities change sign,
+  // accelerations do not
+  const TrajectorySample end = get(length - 1);
+  std::reverse(out.pieces.begin(), out.pieces.end());
+
+  int first = 0;
+  for (auto &piece : out.pieces) {
+    piece.first = first;
+    first += piece.length;
+    piece.timeReversed = !piece.timeReversed;
+    piece.velocitySign = -piece.velocitySign;
+    piece.offset[0] -= end.leftPosition;
+    piece.offset[1] -= end.rightPosition;
+  }
+  return out;
+}
+
+TrajectoryView TrajectoryView::scaled(const double ifactor) const {
+  TrajectoryView out(*this);
+
+  // a pair scales the center distance and keeps the difference between the
+  // wheels, which is what the heading changes come from
+  const double center = (ifactor + 1) / 2;
+  const double difference = (ifactor - 1) / 2;
+  const double pairScale[2][2] = {{center, difference}, {difference, center}};
+  const double singleScale[2][2] = {{ifactor, 0}, {0, ifactor}};
+  out.transform(pair ? pairScale : singleScale, 1, 0);
+  return out;
+}
+
+TrajectoryView TrajectoryView::concat(const TrajectoryView &inext) const {
+  if (inext.length == 0) {
+    return *this;
+  }
+  if (length == 0) {
+    return inext;
+  }
+  if (pair != inext.pair || std::abs(dt - inext.dt) > 1e-9) {
+    throw std::invalid_argument(
+      "TrajectoryView: Only paths with the same dt and the same sides can be concatenated.");
+  }
+
+  const TrajectorySample end = get(length - 1);
+  const TrajectorySample start = inext.get(0);
+
+  TrajectoryView out(*this);
+  for (Piece piece : inext.pieces) {
+    piece.first += length;
+    piece.offset[0] += end.leftPosition - start.leftPosition;
+    piece.offset[1] += end.rightPosition - start.rightPosition;
+    piece.headingOffset += end.heading - start.heading;
+    out.pieces.push_back(std::move(piece));
+  }
+  out.length += inext.length;
+  return out;
+}
+
+void TrajectoryView::transform(const double imatrix[2][2],
+                               const double iheadingSign,
+                               const double iheadingOffset) {
+  for (auto &piece : pieces) {
+    double matrix[2][2];
+    for (int r = 0; r < 2; r++) {
+      for (int c = 0; c < 2; c++) {
+        matrix[r][c] = imatrix[r][0] * piece.matrix[0][c] + imatrix[r][1] * piece.matrix[1][c];
+      }
+    }
+    std::copy(&matrix[0][0], &matrix[0][0] + 4, &piece.matrix[0][0]);
+
+    const double offset[2] = {imatrix[0][0] * piece.offset[0] + imatrix[0][1] * piece.offset[1],
+                              imatrix[1][0] * piece.offset[0] + imatrix[1][1] * piece.offset[1]};
+    piece.offset[0] = offset[0];
+    piece.offset[1] = offset[1];
+
+    piece.headingSign *= iheadingSign;
+    piece.headingOffset = iheadingSign * piece.headingOffset + iheadingOffset;
+  }
+}
+
+const TrajectoryView::Piece &TrajectoryView::pieceAt(const int i) const {
+  // the last piece which starts at or before i
+  auto after = std::upper_bound(pieces.begin(), pieces.end(), i,
+                                [](const int istep, const Piece &ipiece) {
+                                  return istep < ipiece.first;
+                                });
+  return *(after - 1);
+}
@@ -0,0 +1,375 @@
+// ------- asyncLogSinkTest.cpp ------------------------------------------------
+//
+// Host tests of the asynchronous okapi::Logger backend (asyncLogSink.h) with
+// several threads logging at once: every thread's lines arrive complete and in
+// order, structured records are rendered in okapi's "<ms> (<task>) LEVEL: "
+// layout, full queues drop and count lines instead of blocking, and the queues
+// of ended threads go back to the pool.
+//
+// The benchmark compares what okapi::Logger costs a logging task - its mutex
+// held around fprintf() - on the plain device and on the async sink, with the
+// device being a FIFO emptied at serial port speed.
+
+#include "hostTest.h"
+
+#include "asyncLogSink.h"
+#include "robotLog.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#define LOG_TEST_THREADS 4
+#define LOG_TEST_LINES 200            // lines per thread in the ordering test
+#define LOG_TEST_BURST (4 * ASYNC_LOG_QUEUE_SIZE) // lines written faster than the writer task runs
+#define LOG_BENCH_LINES 100           // lines per thread in the benchmark, one every period
+#define LOG_BENCH_PERIOD_MS 10
+#define LOG_BENCH_BYTES_PER_MS 11.52  // 115200 baud
+#define LOG_BENCH_PIPE_SIZE 4096      // bytes the device buffers
+
+namespace {
+/**
+ * @return A new empty file name in /tmp.
+ */
+std::string tempPath(const char *iname) {
+  std::string path = std::string("/tmp/") + iname + "XXXXXX";
+  const int fd = mkstemp(&path[0]);
+  if (fd >= 0) {
+    close(fd);
+  }
+  return path;
+}
+
+std::vector<std::string> readLines(const std::string &ipath) {
+  std::vector<std::string> lines;
+  std::ifstream in(ipath);
+  std::string line;
+  while (std::getline(in, line)) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+/**
+ * Checks that the lines "task <t> line <n>" of every thread are in order.
+ *
+ * @return The number of such lines found per thread.
+ */
+std::vector<int> checkTaskLines(const std::vector<std::string> &ilines, int ithreads) {
+  std::vector<int> found(ithreads, 0);
+  std::vector<int> last(ithreads, -1);
+  bool ordered = true;
+  for (const auto &line : ilines) {
+    int task, number;
+    if (std::sscanf(line.c_str(), "task %d line %d", &task, &number) == 2 && task >= 0 &&
+        task < ithreads) {
+      ordered = ordered && number > last[task];
+      last[task] = number;
+      found[task]++;
+    }
+  }
+  HOST_CHECK(ordered);
+  return found;
+}
+
+/**
+ * @return Whether a line starts with "<ms> (<itask>) <ilevel>: " and ends with imessage.
+ */
+bool okapiLayout(const std::string &iline, const std::string &itask, const char *ilevel,
+                 const std::string &imessage) {
+  long timestamp;
+  int used = 0;
+  if (std::sscanf(iline.c_str(), "%ld %n", &timestamp, &used) != 1 || used == 0) {
+    return false;
+  }
+  return iline.compare(used, std::string::npos,
+                       "(" + itask + ") " + ilevel + ": " + imessage) == 0;
+}
+
+/**
+ * A serial port stand-in: a FIFO a thread empties at LOG_BENCH_BYTES_PER_MS.
+ */
+class SlowDevice {
+  public:
+  const std::string path;
+
+  SlowDevice() : path(tempPath("asyncLogBench")) {
+    unlink(path.c_str());
+    mkfifo(path.c_str(), 0600);
+    reader = std::thread([this] {
+      const int fd = open(path.c_str(), O_RDONLY);
+      fcntl(fd, F_SETPIPE_SZ, LOG_BENCH_PIPE_SIZE);
+      char buffer[64];
+      ssize_t count;
+      while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+        bytes += static_cast<std::size_t>(count);
+        std::this_thread::sleep_for(
+          std::chrono::microseconds(static_cast<long>(count * 1000 / LOG_BENCH_BYTES_PER_MS)));
+      }
+      close(fd);
+    });
+  }
+
+  /**
+   * Waits for the writer to close the FIFO.
+   *
+   * @return The bytes read.
+   */
+  std::size_t finish() {
+    reader.join();
+    unlink(path.c_str());
+    return bytes;
+  }
+
+  private:
+  std::thread reader;
+  std::size_t bytes{0};
+};
+
+struct BenchResult {
+  double meanMicros{0};               // time a logging thread spent per line
+  double maxMicros{0};
+  double lateMs{0};                   // worst delay of a thread's 10 ms loop
+};
+
+/**
+ * LOG_TEST_THREADS threads log a line every LOG_BENCH_PERIOD_MS under one mutex, like
+ * okapi::Logger does.
+ */
+BenchResult benchLogging(FILE *ifile) {
+  std::mutex loggerMutex;
+  std::atomic<std::uint64_t> totalNanos{0}, maxNanos{0}, maxLate{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < LOG_TEST_THREADS; t++) {
+    threads.emplace_back([&, t] {
+      std::uint64_t next = hostNanos();
+      for (int n = 0; n < LOG_BENCH_LINES; n++) {
+        const std::uint64_t start = hostNanos();
+        {
+          std::scoped_lock lock(loggerMutex);
+          std::fprintf(ifile, "%ld (Odometry %d) INFO: task %d line %d x 0.1234 y 1.2345\n",
+                       static_cast<long>(start / 1000000), t, t, n);
+        }
+        const std::uint64_t end = hostNanos();
+        totalNanos += end - start;
+        std::uint64_t seen = maxNanos.load();
+        while (end - start > seen && !maxNanos.compare_exchange_weak(seen, end - start)) {
+        }
+        const std::uint64_t late = end > next ? end - next : 0;
+        seen = maxLate.load();
+        while (late > seen && !maxLate.compare_exchange_weak(seen, late)) {
+        }
+
+        next += LOG_BENCH_PERIOD_MS * 1000000ull;
+        if (next > end) {
+          std::this_thread::sleep_for(std::chrono::nanoseconds(next - end));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  BenchResult result;
+  result.meanMicros = totalNanos / 1e3 / (LOG_TEST_THREADS * LOG_BENCH_LINES);
+  result.maxMicros = maxNanos / 1e3;
+  result.lateMs = maxLate / 1e6;
+  return result;
+}
+} // namespace
+
+HOST_TEST(asyncLogSinkKeepsTaskOrder) {
+  const std::string path = tempPath("asyncLogTest");
+  FILE *sink = asyncLogSinkOpen(path.c_str());
+  HOST_CHECK(sink != nullptr);
+  if (sink == nullptr) {
+    return;
+  }
+  HOST_CHECK(asyncLogSinkOpen(path.c_str()) == nullptr);   // one sink at a time
+
+  // paced so no queue runs full: every line must arrive
+  std::vector<std::string> names(LOG_TEST_THREADS);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < LOG_TEST_THREADS; t++) {
+    threads.emplace_back([&, t] {
+      names[t] = CrossplatformThread::getName();
+      for (int n = 0; n < LOG_TEST_LINES; n++) {
+        std::fprintf(sink, "task %d line %d\n", t, n);
+        if (n % 10 == 0) {
+          robotLogWrite(ROBOT_LOG_LEVEL_INFO, "task {} record {} at {} m", t, n, 0.5);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  robotLogWrite(ROBOT_LOG_LEVEL_WARN, "{} {}", "literal", -3);
+  const std::uint32_t dropped = asyncLogSinkDropped();
+  std::fclose(sink);
+
+  const auto lines = readLines(path);
+  std::remove(path.c_str());
+  const auto found = checkTaskLines(lines, LOG_TEST_THREADS);
+  hostReport("%d threads: %zu lines written, %u dropped", LOG_TEST_THREADS, lines.size(),
+             dropped);
+  HOST_CHECK(dropped == 0);
+  for (int t = 0; t < LOG_TEST_THREADS; t++) {
+    HOST_CHECK(found[t] == LOG_TEST_LINES);
+  }
+
+  // records are rendered by the writer with the name of the task which queued them
+  int records = 0;
+  bool layout = true;
+  for (const auto &line : lines) {
+    int task, number;
+    if (std::sscanf(line.c_str(), "%*d (%*[^)]) INFO: task %d record %d", &task, &number) == 2) {
+      records++;
+      layout = layout && task >= 0 && task < LOG_TEST_THREADS &&
+               okapiLayout(line, names[task], "INFO",
+                           "task " + std::to_string(task) + " record " + std::to_string(number) +
+                             " at 0.5 m");
+    }
+  }
+  HOST_CHECK(layout);
+  HOST_CHECK(records == LOG_TEST_THREADS * LOG_TEST_LINES / 10);
+  HOST_CHECK(!lines.empty() &&
+             okapiLayout(lines.back(), CrossplatformThread::getName(), "WARN", "literal -3"));
+}
+
+HOST_TEST(asyncLogSinkDropsWhenFull) {
+  const std::string path = tempPath("asyncLogTest");
+  FILE *sink = asyncLogSinkOpen(path.c_str());
+  HOST_CHECK(sink != nullptr);
+  if (sink == nullptr) {
+    return;
+  }
+
+  // a burst far larger than a queue between two runs of the writer task
+  std::vector<std::thread> threads;
+  for (int t = 0; t < LOG_TEST_THREADS; t++) {
+    threads.emplace_back([sink, t] {
+      for (int n = 0; n < LOG_TEST_BURST; n++) {
+        std::fprintf(sink, "task %d line %d\n", t, n);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const std::uint32_t dropped = asyncLogSinkDropped();
+  std::fclose(sink);
+
+  const auto lines = readLines(path);
+  std::remove(path.c_str());
+  const auto found = checkTaskLines(lines, LOG_TEST_THREADS);
+  int total = 0;
+  for (const int count : found) {
+    total += count;
+  }
+  hostReport("%d lines in bursts: %d written, %u dropped", LOG_TEST_THREADS * LOG_TEST_BURST,
+             total, dropped);
+  // what was not written was counted, the lines which made it are still in order
+  HOST_CHECK(dropped > 0);
+  HOST_CHECK(total + static_cast<int>(dropped) == LOG_TEST_THREADS * LOG_TEST_BURST);
+}
+
+HOST_TEST(asyncLogSinkReusesQueuesOfEndedTasks) {
+  const std::string path = tempPath("asyncLogTest");
+  FILE *sink = asyncLogSinkOpen(path.c_str());
+  HOST_CHECK(sink != nullptr);
+  if (sink == nullptr) {
+    return;
+  }
+
+  auto logName = [](const char *iwhen) {
+    robotLogWrite(ROBOT_LOG_LEVEL_INFO, "{}", iwhen);
+  };
+
+  // while ASYNC_LOG_MAX_TASKS threads own the queues another one has to use the shared queue
+  std::atomic<bool> release{false};
+  std::atomic<int> started{0};
+  std::vector<std::thread> owners;
+  for (int t = 0; t < ASYNC_LOG_MAX_TASKS; t++) {
+    owners.emplace_back([&] {
+      logName("owner");
+      started++;
+      while (!release.load()) {
+        std::this_thread::yield();
+      }
+    });
+  }
+  while (started.load() < ASYNC_LOG_MAX_TASKS) {
+    std::this_thread::yield();
+  }
+  std::string lateName;
+  std::thread([&] {
+    lateName = CrossplatformThread::getName();
+    logName("while owned");
+  }).join();
+
+  // once they ended and the writer emptied their queues a new thread takes one over
+  release = true;
+  for (auto &thread : owners) {
+    thread.join();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5 * ASYNC_LOG_WRITER_MS));
+  std::string takeoverName;
+  std::thread([&] {
+    takeoverName = CrossplatformThread::getName();
+    logName("after the owners ended");
+  }).join();
+  std::fclose(sink);
+
+  const auto lines = readLines(path);
+  std::remove(path.c_str());
+  int owned = 0;
+  bool shared = false, takenOver = false;
+  for (const auto &line : lines) {
+    owned += line.find(") INFO: owner") != std::string::npos;
+    shared = shared || okapiLayout(line, "shared", "INFO", "while owned");
+    takenOver = takenOver || okapiLayout(line, takeoverName, "INFO", "after the owners ended");
+  }
+  HOST_CHECK(owned == ASYNC_LOG_MAX_TASKS);
+  HOST_CHECK(shared);
+  HOST_CHECK(takenOver);
+  HOST_CHECK(asyncLogSinkDropped() == 0);
+}
+
+HOST_BENCH(asyncLogSinkVsLockedFprintf) {
+  hostReport("%d threads log a line every %d ms under the logger mutex, device drains %.1f "
+             "bytes/ms (115200 baud) with a %d byte buffer",
+             LOG_TEST_THREADS, LOG_BENCH_PERIOD_MS, LOG_BENCH_BYTES_PER_MS, LOG_BENCH_PIPE_SIZE);
+  hostReport("%-16s %12s %12s %14s %8s %8s", "", "mean us/line", "max us/line", "worst late ms",
+             "bytes", "dropped");
+
+  {
+    SlowDevice device;
+    FILE *file = std::fopen(device.path.c_str(), "w");
+    setvbuf(file, nullptr, _IOLBF, BUFSIZ);
+    const BenchResult result = benchLogging(file);
+    std::fclose(file);
+    hostReport("%-16s %12.1f %12.0f %14.1f %8zu %8s", "mutex + fprintf", result.meanMicros,
+               result.maxMicros, result.lateMs, device.finish(), "-");
+  }
+
+  {
+    SlowDevice device;
+    FILE *sink = asyncLogSinkOpen(device.path.c_str());
+    const BenchResult result = benchLogging(sink);
+    const std::uint32_t dropped = asyncLogSinkDropped();
+    std::fclose(sink);
+    hostReport("%-16s %12.1f %12.0f %14.1f %8zu %8u", "async sink", result.meanMicros,
+               result.maxMicros, result.lateMs, device.finish(), dropped);
+  }
+}
@@ -0,0 +1,229 @@
+// ------- dataLogTest.cpp -----------------------------------------------------
+//
+// Host test of the binary data log writer (dataLogWriter.h) behind
+// robotDataLogger(), and a benchmark of what logging costs a 10 ms control loop
+// when the SD card is slow: the text the drive code used to write with
+// std::to_string() and operator<< to a std::ofstream, against a DataLogRecord
+// handed to the writer. robotDataLogger() itself reads the PROS sensors, so
+// the benchmark fills in the record the same way with stand-in values.
+
+#include "hostTest.h"
+
+#include "dataLogWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#define DATA_TEST_RECORDS 1000        // fits the ring buffer
+#define DATA_TEST_BURST 3000          // does not
+#define DATA_BENCH_LOOPS 300          // 10 ms loop iterations per run
+#define DATA_BENCH_PERIOD_MS 10
+#define DATA_BENCH_CHUNK 512          // bytes the card takes per write
+#define DATA_BENCH_CHUNK_MS 5         // time per chunk, about 100 kB/s
+#define DATA_BENCH_STALL_EVERY 16     // chunks between two stalls (8 kB)
+#define DATA_BENCH_STALL_MS 200       // a slow erase block
+#define DATA_BENCH_PIPE_SIZE 4096     // bytes the card buffers
+
+namespace {
+std::string tempPath(const char *iname) {
+  std::string path = std::string("/tmp/") + iname + "XXXXXX";
+  const int fd = mkstemp(&path[0]);
+  if (fd >= 0) {
+    close(fd);
+  }
+  return path;
+}
+
+DataLogRecord testRecord(std::uint32_t itimestamp, int ii) {
+  DataLogRecord record;
+  record.timestamp = itimestamp;
+  record.marker = 0;
+  record.flags = 0;
+  record.x = 0.001f * ii;
+  record.y = -0.002f * ii;
+  record.theta = 0.1f * ii;
+  record.encoderLeft = ii;
+  record.encoderRight = 2 * ii;
+  for (int m = 0; m < DATA_LOG_MOTOR_COUNT; m++) {
+    record.motorCurrent[m] = 1000 + m;
+  }
+  return record;
+}
+
+/**
+ * Writes records to a new file.
+ *
+ * @param icount The records pushed.
+ * @param ipaced Whether to let the writer catch up before the ring buffer is full.
+ * @param odropped The records dropped.
+ * @return The records read back from the file.
+ */
+std::vector<DataLogRecord> writeRecords(int icount, bool ipaced, std::uint32_t &odropped) {
+  const std::string path = tempPath("dataLogTest");
+  FILE *file = std::fopen(path.c_str(), "wb");
+  HOST_CHECK(dataLogWriterStart(file));
+  HOST_CHECK(!dataLogWriterStart(file));   // already running
+  for (int i = 0; i < icount; i++) {
+    dataLogWriterPush(testRecord(static_cast<std::uint32_t>(i), i));
+    if (ipaced && i % (DATA_LOG_RING_SIZE / 2) == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2 * DATA_LOG_DRAIN_MS));
+    }
+  }
+  dataLogWriterStop();
+  odropped = dataLogWriterDropped();
+  std::fclose(file);
+  HOST_CHECK(!dataLogWriterPush(testRecord(0, 0)));   // stopped
+
+  std::vector<DataLogRecord> records;
+  file = std::fopen(path.c_str(), "rb");
+  DataLogRecord record;
+  while (file != nullptr && std::fread(&record, sizeof(record), 1, file) == 1) {
+    records.push_back(record);
+  }
+  if (file != nullptr) {
+    std::fclose(file);
+  }
+  std::remove(path.c_str());
+  return records;
+}
+
+/**
+ * An SD card stand-in: a FIFO drained in chunks, with a long stall every few chunks.
+ */
+class SlowCard {
+  public:
+  const std::string path;
+
+  SlowCard() : path(tempPath("dataLogBench")) {
+    unlink(path.c_str());
+    mkfifo(path.c_str(), 0600);
+    reader = std::thread([this] {
+      const int fd = open(path.c_str(), O_RDONLY);
+      fcntl(fd, F_SETPIPE_SZ, DATA_BENCH_PIPE_SIZE);
+      char buffer[DATA_BENCH_CHUNK];
+      int chunks = 0;
+      while (read(fd, buffer, sizeof(buffer)) > 0) {
+        const bool stall = ++chunks % DATA_BENCH_STALL_EVERY == 0;
+        std::this_thread::sleep_for(
+          std::chrono::milliseconds(stall ? DATA_BENCH_STALL_MS : DATA_BENCH_CHUNK_MS));
+      }
+      close(fd);
+    });
+  }
+
+  void finish() {
+    reader.join();
+    unlink(path.c_str());
+  }
+
+  private:
+  std::thread reader;
+};
+
+/**
+ * Runs a 10 ms loop which calls ilog once per iteration.
+ *
+ * @return The iteration periods in ms.
+ */
+template <typename Log> std::vector<double> loopPeriods(Log &&ilog) {
+  std::vector<double> periods;
+  std::uint64_t next = hostNanos();
+  std::uint64_t last = 0;
+  for (int i = 0; i < DATA_BENCH_LOOPS; i++) {
+    const std::uint64_t start = hostNanos();
+    if (i > 0) {
+      periods.push_back((start - last) / 1e6);
+    }
+    last = start;
+    ilog(i);
+
+    // like pros::Task::delay_until(), a late iteration is not made up for
+    next = std::max<std::uint64_t>(next + DATA_BENCH_PERIOD_MS * 1000000ull, hostNanos());
+    std::this_thread::sleep_for(std::chrono::nanoseconds(next - hostNanos()));
+  }
+  return periods;
+}
+
+void reportPeriods(const char *iname, std::vector<double> periods) {
+  std::sort(periods.begin(), periods.end());
+  const double p99 = periods[periods.size() * 99 / 100];
+  hostReport("%-22s %8.2f %8.2f %8.2f %8.1f %10.1f", iname, periods.front(),
+             periods[periods.size() / 2], p99, periods.back(), periods.back() - periods.front());
+}
+} // namespace
+
+HOST_TEST(dataLogWriterKeepsRecords) {
+  std::uint32_t dropped;
+  const auto records = writeRecords(DATA_TEST_RECORDS, true, dropped);
+  HOST_CHECK(dropped == 0);
+  HOST_CHECK(records.size() == DATA_TEST_RECORDS);
+  bool intact = true;
+  for (std::size_t i = 0; i < records.size(); i++) {
+    const DataLogRecord expected = testRecord(static_cast<std::uint32_t>(i), static_cast<int>(i));
+    intact = intact && std::memcmp(&records[i], &expected, sizeof(expected)) == 0;
+  }
+  HOST_CHECK(intact);
+
+  // a burst the ring buffer can not hold drops the newest records, the rest stay in order
+  const auto burst = writeRecords(DATA_TEST_BURST, false, dropped);
+  hostReport("%d records in a burst: %zu written, %u dropped", DATA_TEST_BURST, burst.size(),
+             dropped);
+  HOST_CHECK(dropped > 0);
+  HOST_CHECK(burst.size() + dropped == DATA_TEST_BURST);
+  HOST_CHECK(burst.size() >= DATA_LOG_RING_SIZE);
+  bool ordered = true;
+  for (std::size_t i = 1; i < burst.size(); i++) {
+    ordered = ordered && burst[i].timestamp > burst[i - 1].timestamp;
+  }
+  HOST_CHECK(ordered);
+}
+
+HOST_BENCH(dataLogLoopJitter) {
+  hostReport("%d ms loop, %d iterations; card takes %d bytes per %d ms, stalls %d ms every %d "
+             "kB, %d byte buffer",
+             DATA_BENCH_PERIOD_MS, DATA_BENCH_LOOPS, DATA_BENCH_CHUNK, DATA_BENCH_CHUNK_MS,
+             DATA_BENCH_STALL_MS, DATA_BENCH_CHUNK * DATA_BENCH_STALL_EVERY / 1024,
+             DATA_BENCH_PIPE_SIZE);
+  hostReport("%-22s %8s %8s %8s %8s %10s", "period ms", "min", "median", "p99", "max",
+             "spread");
+
+  {
+    // what main.cpp logged per step before the binary logger
+    SlowCard card;
+    std::ofstream file(card.path, std::ios::trunc);
+    const auto periods = loopPeriods([&](int i) {
+      const DataLogRecord state = testRecord(0, i);
+      const auto millis = static_cast<std::uint32_t>(hostNanos() / 1000000);
+      file << millis << "\t Get state: " << std::to_string(state.x) << "m ";
+      file << std::to_string(state.y) << "m " << std::to_string(state.theta) << "Deg. \n";
+      file << millis << "\t Encoder LEFT value: " << state.encoderLeft << " -- ";
+      file << "RIGHT value: " << state.encoderRight << "\n";
+    });
+    file.close();
+    card.finish();
+    reportPeriods("to_string + operator<<", periods);
+  }
+
+  {
+    SlowCard card;
+    FILE *file = std::fopen(card.path.c_str(), "wb");
+    dataLogWriterStart(file);
+    const auto periods = loopPeriods([](int i) {
+      dataLogWriterPush(testRecord(static_cast<std::uint32_t>(hostNanos() / 1000000), i));
+    });
+    dataLogWriterStop();
+    const std::uint32_t dropped = dataLogWriterDropped();
+    std::fclose(file);
+    card.finish();
+    reportPeriods("DataLogRecord writer", periods);
+    hostReport("%u records dropped", dropped);
+  }
+}
@@ -0,0 +1,293 @@
+// ------- filterTest.cpp ------------------------------------------------------
+//
+// Host tests and benchmarks of the filters replacing okapi's: the running
+// average and median against okapi's AverageFilter and MedianFilter, which
+// are header templates and so run here as they do on the V5, and
+// FilterPipeline against ComposableFilter, whose stages are called through the
+// hostOkapi.cpp stand-ins like through okapilib, and the filter banks against
+// one filter object per channel.
+
+#include "hostTest.h"
+
+#include "filterBank.h"
+#include "filterPipeline.h"
+#include "inlineFilters.h"
+#include "okapi/api/filter/averageFilter.hpp"
+#include "okapi/api/filter/composableFilter.hpp"
+#include "okapi/api/filter/demaFilter.hpp"
+#include "okapi/api/filter/emaFilter.hpp"
+#include "okapi/api/filter/medianFilter.hpp"
+#include "runningAverageFilter.h"
+#include "runningMedianFilter.h"
+
+#include <cfloat>
+#include <random>
+
+#define FILTER_TEST_READINGS 20000    // readings per equivalence test
+#define FILTER_BENCH_READINGS 200000  // readings per benchmark
+#define FILTER_BANK_WINDOW 10         // AverageFilterBank samples
+
+namespace {
+/**
+ * Noisy readings of up to +-500 where every third one is a small integer, so
+ * the median window holds many equal samples.
+ */
+std::vector<double> testReadings(const int icount, const unsigned iseed) {
+  std::mt19937 generator(iseed);
+  std::uniform_real_distribution<double> noise(-500, 500);
+  std::uniform_int_distribution<int> ticks(-20, 20);
+  std::vector<double> readings(icount);
+  for (int i = 0; i < icount; i++) {
+    readings[i] = i % 3 == 0 ? ticks(generator) : noise(generator);
+  }
+  return readings;
+}
+
+/**
+ * @return The time per filter() call in ns.
+ */
+template <typename F> double filterNanos(F &ifilter, const std::vector<double> &ireadings) {
+  volatile double sink = 0;
+  const std::uint64_t start = hostNanos();
+  for (const double reading : ireadings) {
+    sink = ifilter.filter(reading);
+  }
+  (void)sink;
+  return static_cast<double>(hostNanos() - start) / ireadings.size();
+}
+
+template <typename F> double filterNanos(const std::vector<double> &ireadings) {
+  F filter;
+  return filterNanos(filter, ireadings);
+}
+
+using VelocityPipeline = FilterPipeline<RunningMedianFilter<5>, InlineEmaFilter, InlineDemaFilter>;
+
+VelocityPipeline velocityPipeline() {
+  return VelocityPipeline(RunningMedianFilter<5>(), InlineEmaFilter(0.3),
+                          InlineDemaFilter(0.2, 0.05));
+}
+
+/**
+ * @return The same stages as velocityPipeline(), composed by okapi.
+ */
+okapi::ComposableFilter velocityComposable() {
+  return okapi::ComposableFilter({std::make_shared<okapi::MedianFilter<5>>(),
+                                  std::make_shared<okapi::EmaFilter>(0.3),
+                                  std::make_shared<okapi::DemaFilter>(0.2, 0.05)});
+}
+
+
+template <std::size_t n> void checkRunningFilters() {
+  const std::vector<double> readings = testReadings(FILTER_TEST_READINGS, n);
+  okapi::AverageFilter<n> average;
+  RunningAverageFilter<n> runningAverage;
+  okapi::MedianFilter<n> median;
+  RunningMedianFilter<n> runningMedian;
+
+  double averageError = 0;
+  int medianMismatches = 0;
+  for (const double reading : readings) {
+    averageError =
+      std::max(averageError, std::abs(average.filter(reading) - runningAverage.filter(reading)));
+    medianMismatches += median.filter(reading) != runningMedian.filter(reading);
+  }
+  HOST_CHECK(runningMedian.getOutput() == median.getOutput());
+
+  hostReport("n = %3zu: average within %.1e, %d median mismatches", n, averageError,
+             medianMismatches);
+  // a few ulp of the largest sample, 500
+  HOST_CHECK(averageError < 64 * DBL_EPSILON * 500);
+  HOST_CHECK(medianMismatches == 0);
+}
+
+template <std::size_t n> void benchRunningFilters(const std::vector<double> &ireadings) {
+  hostReport("%5zu %15.1f %15.1f %15.1f %15.1f", n,
+             filterNanos<okapi::AverageFilter<n>>(ireadings),
+             filterNanos<RunningAverageFilter<n>>(ireadings),
+             filterNanos<okapi::MedianFilter<n>>(ireadings),
+             filterNanos<RunningMedianFilter<n>>(ireadings));
+}
+/**
+ * One filter object per channel, the way a bank's channels are filtered without it.
+ */
+struct ChannelFilters {
+  std::vector<std::unique_ptr<okapi::Filter>> filters;
+
+  void filter(const double *ireadings) {
+    for (std::size_t c = 0; c < filters.size(); c++) {
+      filters[c]->filter(ireadings[c]);
+    }
+  }
+
+  double getOutput(const std::size_t ichannel) const {
+    return filters[ichannel]->getOutput();
+  }
+};
+
+template <typename F, typename... Args>
+ChannelFilters channelFilters(const std::size_t ichannels, const Args... iargs) {
+  ChannelFilters channels;
+  for (std::size_t c = 0; c < ichannels; c++) {
+    channels.filters.push_back(std::make_unique<F>(iargs...));
+  }
+  return channels;
+}
+
+/**
+ * @return The time per filter() call of all channels in ns.
+ */
+template <typename F>
+double bankNanos(F &ifilter, const std::vector<double> &ireadings, const std::size_t ichannels) {
+  const std::size_t updates = ireadings.size() / ichannels;
+  volatile double sink = 0;
+  const std::uint64_t start = hostNanos();
+  for (std::size_t i = 0; i < updates; i++) {
+    ifilter.filter(&ireadings[i * ichannels]);
+    sink = ifilter.getOutput(ichannels - 1);
+  }
+  (void)sink;
+  return static_cast<double>(hostNanos() - start) / updates;
+}
+
+template <std::size_t channels> void checkFilterBanks() {
+  const std::vector<double> readings = testReadings(FILTER_TEST_READINGS * channels, channels);
+  EmaFilterBank<channels> emaBank(0.3);
+  DemaFilterBank<channels> demaBank(0.2, 0.05);
+  AverageFilterBank<FILTER_BANK_WINDOW, channels> averageBank;
+  ChannelFilters emas = channelFilters<okapi::EmaFilter>(channels, 0.3);
+  ChannelFilters demas = channelFilters<okapi::DemaFilter>(channels, 0.2, 0.05);
+  ChannelFilters averages = channelFilters<RunningAverageFilter<FILTER_BANK_WINDOW>>(channels);
+
+  int mismatches = 0;
+  for (int i = 0; i < FILTER_TEST_READINGS; i++) {
+    const double *reading = &readings[i * channels];
+    emaBank.filter(reading);
+    demaBank.filter(reading);
+    averageBank.filter(reading);
+    emas.filter(reading);
+    demas.filter(reading);
+    averages.filter(reading);
+    for (std::size_t c = 0; c < channels; c++) {
+      mismatches += emaBank.getOutput(c) != emas.getOutput(c);
+      mismatches += demaBank.getOutput(c) != demas.getOutput(c);
+      mismatches += averageBank.getOutput(c) != averages.getOutput(c);
+    }
+  }
+  hostReport("%2zu channels: %d mismatches", channels, mismatches);
+  HOST_CHECK(mismatches == 0);
+}
+
+template <std::size_t channels> void benchFilterBanks() {
+  const std::vector<double> readings = testReadings(FILTER_BENCH_READINGS, channels);
+  EmaFilterBank<channels> emaBank(0.3);
+  DemaFilterBank<channels> demaBank(0.2, 0.05);
+  AverageFilterBank<FILTER_BANK_WINDOW, channels> averageBank;
+  ChannelFilters emas = channelFilters<okapi::EmaFilter>(channels, 0.3);
+  ChannelFilters demas = channelFilters<okapi::DemaFilter>(channels, 0.2, 0.05);
+  ChannelFilters averages = channelFilters<RunningAverageFilter<FILTER_BANK_WINDOW>>(channels);
+  hostReport("%8zu %11.1f %6.1f %11.1f %6.1f %11.1f %6.1f", channels,
+             bankNanos(emas, readings, channels), bankNanos(emaBank, readings, channels),
+             bankNanos(demas, readings, channels), bankNanos(demaBank, readings, channels),
+             bankNanos(averages, readings, channels), bankNanos(averageBank, readings, channels));
+}
+} // namespace
+
+HOST_TEST(runningFiltersMatchOkapi) {
+  // okapi's MedianFilter<2> reads before its array, so from 3 on
+  checkRunningFilters<3>();
+  checkRunningFilters<4>();
+  checkRunningFilters<5>();
+  checkRunningFilters<10>();
+  checkRunningFilters<25>();
+  checkRunningFilters<51>();
+  checkRunningFilters<100>();
+  checkRunningFilters<101>();
+
+  // the windows start full of zeros like okapi's
+  RunningMedianFilter<5> median;
+  RunningAverageFilter<5> average;
+  HOST_CHECK(median.filter(10) == 0 && median.filter(10) == 0 && median.filter(10) == 10);
+  HOST_CHECK_NEAR(average.filter(10), 2, 1e-12);
+}
+
+HOST_BENCH(runningFiltersCost) {
+  const std::vector<double> readings = testReadings(FILTER_BENCH_READINGS, 1);
+  hostReport("ns per reading");
+  hostReport("    n   AverageFilter  RunningAverage    MedianFilter   RunningMedian");
+  benchRunningFilters<5>(readings);
+  benchRunningFilters<11>(readings);
+  benchRunningFilters<25>(readings);
+  benchRunningFilters<51>(readings);
+  benchRunningFilters<101>(readings);
+}
+
+HOST_TEST(filterPipelineMatchesComposableFilter) {
+  const std::vector<double> readings = testReadings(FILTER_TEST_READINGS, 2);
+  okapi::ComposableFilter composable = velocityComposable();
+  VelocityPipeline pipeline = velocityPipeline();
+  okapi::Filter &throughBase = pipeline;
+
+  int mismatches = 0;
+  for (const double reading : readings) {
+    mismatches += composable.filter(reading) != throughBase.filter(reading);
+  }
+  HOST_CHECK(mismatches == 0);
+  HOST_CHECK(pipeline.getOutput() == composable.getOutput());
+
+  // the stages are the pipeline's own
+  pipeline.getStage<1>().setGains(1);
+  pipeline.filter(7);
+  HOST_CHECK(pipeline.getStage<1>().getOutput() == pipeline.getStage<0>().getOutput());
+}
+
+HOST_BENCH(filterPipelineCost) {
+  const std::vector<double> readings = testReadings(FILTER_BENCH_READINGS, 1);
+
+  okapi::ComposableFilter composable = velocityComposable();
+  VelocityPipeline pipeline = velocityPipeline();
+  // as VelMath and the PID controllers hold their filter
+  std::unique_ptr<okapi::Filter> throughBase =
+    std::make_unique<VelocityPipeline>(velocityPipeline());
+  FilterPipeline<okapi::MedianFilter<5>, InlineEmaFilter, InlineDemaFilter> okapiMedian(
+    okapi::MedianFilter<5>(), InlineEmaFilter(0.3), InlineDemaFilter(0.2, 0.05));
+  hostReport("median of 5, EMA, DEMA, ns per reading");
+  hostReport("ComposableFilter %.1f, FilterPipeline %.1f (through unique_ptr<Filter> %.1f), "
+             "with okapi's MedianFilter %.1f",
+             filterNanos(composable, readings), filterNanos(pipeline, readings),
+             filterNanos(*throughBase, readings), filterNanos(okapiMedian, readings));
+
+  okapi::ComposableFilter emaDema(
+    {std::make_shared<okapi::EmaFilter>(0.3), std::make_shared<okapi::DemaFilter>(0.2, 0.05)});
+  FilterPipeline<InlineEmaFilter, InlineDemaFilter> inlineEmaDema(InlineEmaFilter(0.3),
+                                                                  InlineDemaFilter(0.2, 0.05));
+  hostReport("EMA, DEMA: ComposableFilter %.1f, FilterPipeline %.1f",
+             filterNanos(emaDema, readings), filterNanos(inlineEmaDema, readings));
+}
+
+HOST_TEST(filterBanksMatchSingleFilters) {
+  // odd counts leave padding in the last lane
+  checkFilterBanks<1>();
+  checkFilterBanks<3>();
+  checkFilterBanks<4>();
+  checkFilterBanks<5>();
+  checkFilterBanks<8>();
+  checkFilterBanks<16>();
+
+  EmaFilterBank<3> bank(0.3);
+  bank.setGains(1, 1);
+  const double readings[3] = {4, 5, 6};
+  bank.filter(readings);
+  double outputs[3];
+  bank.getOutputs(outputs);
+  HOST_CHECK(outputs[1] == 5);
+  HOST_CHECK_NEAR(outputs[2], 0.3 * 6, 1e-12);
+}
+
+HOST_BENCH(filterBankCost) {
+  hostReport("ns per update of all channels, one filter object per channel / bank");
+  hostReport("channels         EMA              DEMA      average of %d", FILTER_BANK_WINDOW);
+  benchFilterBanks<4>();
+  benchFilterBanks<8>();
+  benchFilterBanks<16>();
+}
@@ -0,0 +1,566 @@
+// ------- hostChassis.cpp -----------------------------------------------------
+//
+// Kinematic chassis simulation for the host tests, see hostChassis.h. Also
+// stands in for telemetryReportError() (telemetry.cpp needs PROS), keeping
+// the reported errors for the tests to check.
+
+#include "hostChassis.h"
+#include "hostTest.h"
+#include "telemetry.h"
+
+#include "okapi/api/odometry/odomMath.hpp"
+#include "okapi/api/util/mathUtil.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace okapi::literals;
+
+#define SIM_MOVE_PERIOD_MS 10         // control period of moveDistance() and turnAngle()
+#define SIM_MOVE_DONE 0.0005          // m of wheel travel left when a move counts as done
+#define SIM_POSITION_GAIN 2.0         // rpm per degree of error in position mode
+
+namespace {
+std::atomic<float> telemetryErrors[TELEMETRY_MAX_CONTROLLERS];
+std::atomic<float> telemetryMaxErrors[TELEMETRY_MAX_CONTROLLERS];
+
+/**
+ * A motor's integrated encoder.
+ */
+class SimEncoder : public okapi::ContinuousRotarySensor {
+  public:
+  explicit SimEncoder(std::shared_ptr<SimMotor> imotor) : motor(std::move(imotor)) {
+  }
+
+  double get() const override {
+    return motor->getPosition();
+  }
+
+  std::int32_t reset() override {
+    return motor->tarePosition();
+  }
+
+  double controllerGet() override {
+    return get();
+  }
+
+  protected:
+  std::shared_ptr<SimMotor> motor;
+};
+
+/**
+ * Odometry which reads the simulation's true pose.
+ */
+class SimOdometry : public okapi::Odometry {
+  public:
+  SimOdometry(std::shared_ptr<SimDrive> idrive, const okapi::ChassisScales &iscales)
+    : drive(std::move(idrive)), scales(iscales) {
+  }
+
+  void setScales(const okapi::ChassisScales &ichassisScales) override {
+    scales = ichassisScales;
+  }
+
+  void step() override {
+    drive->update();
+  }
+
+  okapi::OdomState getState(const okapi::StateMode &imode) const override {
+    return OdomArcMath::toState(drive->getPose(), imode);
+  }
+
+  void setState(const okapi::OdomState &istate, const okapi::StateMode &imode) override {
+    drive->setPose(OdomArcMath::fromState(istate, imode));
+  }
+
+  std::shared_ptr<okapi::ReadOnlyChassisModel> getModel() override {
+    return nullptr;
+  }
+
+  okapi::ChassisScales getScales() override {
+    return scales;
+  }
+
+  protected:
+  std::shared_ptr<SimDrive> drive;
+  okapi::ChassisScales scales;
+};
+
+double gearsetRpm(const okapi::AbstractMotor::gearset igearset) {
+  return static_cast<double>(okapi::toUnderlyingType(igearset));
+}
+
+okapi::ChassisScales simScales(const SimDriveConfig &iconfig) {
+  return okapi::ChassisScales({iconfig.wheelDiameter * okapi::meter, iconfig.track * okapi::meter},
+                              okapi::gearsetToTPR(iconfig.gearset));
+}
+} // namespace
+
+SimMotor::SimMotor(SimDrive &idrive) : drive(idrive), gearing(idrive.config.gearset) {
+}
+
+void SimMotor::advance(const double idt) {
+  double target = targetRpm;
+  if (positionMode) {
+    const double error = targetDegrees - degrees;
+    target = std::clamp(error * SIM_POSITION_GAIN, -std::abs(targetRpm), std::abs(targetRpm));
+  }
+  target = std::clamp(target, -gearsetRpm(gearing), gearsetRpm(gearing));
+  actualRpm += (target - actualRpm) * std::min(1.0, idt / drive.config.motorLag);
+  degrees += actualRpm * 6 * idt;
+}
+
+double SimMotor::getDegrees() const {
+  return degrees;
+}
+
+double SimMotor::toUnits(const double idegrees) const {
+  switch (units) {
+  case encoderUnits::rotations:
+    return idegrees / 360;
+  case encoderUnits::counts:
+    return idegrees / 360 * okapi::gearsetToTPR(gearing);
+  default:
+    return idegrees;
+  }
+}
+
+double SimMotor::fromUnits(const double iposition) const {
+  switch (units) {
+  case encoderUnits::rotations:
+    return iposition * 360;
+  case encoderUnits::counts:
+    return iposition * 360 / okapi::gearsetToTPR(gearing);
+  default:
+    return iposition;
+  }
+}
+
+std::int32_t SimMotor::moveAbsolute(const double iposition, const std::int32_t ivelocity) {
+  drive.update();
+  positionMode = true;
+  targetDegrees = fromUnits(iposition) + zeroDegrees;
+  targetRpm = ivelocity;
+  return 1;
+}
+
+std::int32_t SimMotor::moveRelative(const double iposition, const std::int32_t ivelocity) {
+  drive.update();
+  positionMode = true;
+  targetDegrees = degrees + fromUnits(iposition);
+  targetRpm = ivelocity;
+  return 1;
+}
+
+std::int32_t SimMotor::moveVelocity(const std::int16_t ivelocity) {
+  drive.update();
+  positionMode = false;
+  targetRpm = ivelocity;
+  return 1;
+}
+
+std::int32_t SimMotor::moveVoltage(const std::int16_t ivoltage) {
+  drive.update();
+  positionMode = false;
+  targetRpm = ivoltage / okapi::v5MotorMaxVoltage * gearsetRpm(gearing);
+  return 1;
+}
+
+std::int32_t SimMotor::modifyProfiledVelocity(const std::int32_t ivelocity) {
+  drive.update();
+  targetRpm = ivelocity;
+  return 1;
+}
+
+double SimMotor::getTargetPosition() {
+  return toUnits(targetDegrees - zeroDegrees);
+}
+
+double SimMotor::getPosition() {
+  drive.update();
+  return toUnits(degrees - zeroDegrees);
+}
+
+std::int32_t SimMotor::tarePosition() {
+  drive.update();
+  zeroDegrees = degrees;
+  return 1;
+}
+
+std::int32_t SimMotor::getTargetVelocity() {
+  return static_cast<std::int32_t>(std::lround(targetRpm));
+}
+
+double SimMotor::getActualVelocity() {
+  drive.update();
+  return actualRpm;
+}
+
+std::int32_t SimMotor::getCurrentDraw() {
+  return 0;
+}
+
+std::int32_t SimMotor::getDirection() {
+  return actualRpm < 0 ? -1 : 1;
+}
+
+double SimMotor::getEfficiency() {
+  return 100;
+}
+
+std::int32_t SimMotor::isOverCurrent() {
+  return 0;
+}
+
+std::int32_t SimMotor::isOverTemp() {
+  return 0;
+}
+
+std::int32_t SimMotor::isStopped() {
+  drive.update();
+  return std::abs(actualRpm) < SIM_STOPPED_RPM;
+}
+
+std::int32_t SimMotor::getZeroPositionFlag() {
+  return 0;
+}
+
+uint32_t SimMotor::getFaults() {
+  return 0;
+}
+
+uint32_t SimMotor::getFlags() {
+  return 0;
+}
+
+std::int32_t SimMotor::getRawPosition(std::uint32_t *timestamp) {
+  drive.update();
+  if (timestamp != nullptr) {
+    *timestamp = static_cast<std::uint32_t>(hostMicros / 1000);
+  }
+  return static_cast<std::int32_t>(std::lround(degrees / 360 * okapi::gearsetToTPR(gearing)));
+}
+
+double SimMotor::getPower() {
+  return 0;
+}
+
+double SimMotor::getTemperature() {
+  return 20;
+}
+
+double SimMotor::getTorque() {
+  return 0;
+}
+
+std::int32_t SimMotor::getVoltage() {
+  return static_cast<std::int32_t>(actualRpm / gearsetRpm(gearing) * okapi::v5MotorMaxVoltage);
+}
+
+std::int32_t SimMotor::setBrakeMode(const brakeMode imode) {
+  brake = imode;
+  return 1;
+}
+
+okapi::AbstractMotor::brakeMode SimMotor::getBrakeMode() {
+  return brake;
+}
+
+std::int32_t SimMotor::setCurrentLimit(std::int32_t) {
+  return 1;
+}
+
+std::int32_t SimMotor::getCurrentLimit() {
+  return 2500;
+}
+
+std::int32_t SimMotor::setEncoderUnits(const encoderUnits iunits) {
+  units = iunits;
+  return 1;
+}
+
+okapi::AbstractMotor::encoderUnits SimMotor::getEncoderUnits() {
+  return units;
+}
+
+std::int32_t SimMotor::setGearing(const gearset igearset) {
+  gearing = igearset;
+  return 1;
+}
+
+okapi::AbstractMotor::gearset SimMotor::getGearing() {
+  return gearing;
+}
+
+std::int32_t SimMotor::setReversed(bool) {
+  return 1;
+}
+
+std::int32_t SimMotor::setVoltageLimit(std::int32_t) {
+  return 1;
+}
+
+std::shared_ptr<okapi::ContinuousRotarySensor> SimMotor::getEncoder() {
+  return std::make_shared<SimEncoder>(shared_from_this());
+}
+
+void SimMotor::controllerSet(const double ivalue) {
+  moveVelocity(static_cast<std::int16_t>(ivalue * gearsetRpm(gearing)));
+}
+
+SimDrive::SimDrive(const SimDriveConfig &iconfig)
+  : config(iconfig),
+    leftMotor(std::make_shared<SimMotor>(*this)),
+    rightMotor(std::make_shared<SimMotor>(*this)),
+    micros(hostMicros) {
+}
+
+void SimDrive::update() {
+  const std::uint64_t step = SIM_PERIOD_MS * 1000;
+  const double circumference = config.wheelDiameter * okapi::pi;
+  while (micros + step <= hostMicros) {
+    micros += step;
+    leftMotor->advance(SIM_PERIOD_MS / 1000.0);
+    rightMotor->advance(SIM_PERIOD_MS / 1000.0);
+
+    const double left = (leftMotor->getDegrees() - leftDegrees) / 360 * circumference;
+    const double right = (rightMotor->getDegrees() - rightDegrees) / 360 * circumference;
+    leftDegrees = leftMotor->getDegrees();
+    rightDegrees = rightMotor->getDegrees();
+    pose = OdomArcMath::step(pose, left, right, (left - right) / config.track, config.track);
+    travel += std::abs(left + right) / 2;
+    if (tracing) {
+      trace.push_back(pose);
+    }
+  }
+}
+
+void SimDrive::settle() {
+  update();
+  while (!leftMotor->isStopped() || !rightMotor->isStopped()) {
+    hostMicros += SIM_PERIOD_MS * 1000;
+    update();
+  }
+}
+
+OdomPose SimDrive::getPose() {
+  update();
+  return pose;
+}
+
+void SimDrive::setPose(const OdomPose &ipose) {
+  update();
+  pose = ipose;
+}
+
+double SimDrive::getTravel() {
+  update();
+  return travel;
+}
+
+void SimDrive::startTrace() {
+  update();
+  trace.clear();
+  tracing = true;
+}
+
+const std::vector<OdomPose> &SimDrive::getTrace() {
+  update();
+  return trace;
+}
+
+double SimDrive::rpmPerMeterPerSecond() const {
+  return 60 / (config.wheelDiameter * okapi::pi);
+}
+
+double SimDrive::maxSpeed() const {
+  return gearsetRpm(config.gearset) / rpmPerMeterPerSecond();
+}
+
+SimChassisController::SimChassisController(const std::shared_ptr<SimDrive> &idrive,
+                                           const double imaxAcceleration)
+  : OdomChassisController(hostTimeUtil(),
+                          std::make_shared<SimOdometry>(idrive, simScales(idrive->config))),
+    drive(idrive),
+    skidSteer(std::make_shared<okapi::SkidSteerModel>(
+      idrive->leftMotor, idrive->rightMotor, idrive->leftMotor->getEncoder(),
+      idrive->rightMotor->getEncoder(), gearsetRpm(idrive->config.gearset),
+      okapi::v5MotorMaxVoltage)),
+    maxAcceleration(imaxAcceleration) {
+  // like ChassisControllerBuilder, the drive encoders count ticks
+  skidSteer->setEncoderUnits(okapi::AbstractMotor::encoderUnits::counts);
+}
+
+void SimChassisController::profiledMove(const double ileft, const double iright) {
+  const double total = std::max(std::abs(ileft), std::abs(iright));
+  if (total <= 0) {
+    return;
+  }
+
+  auto rate = timeUtil.getRate();
+  const double period = SIM_MOVE_PERIOD_MS / 1000.0;
+  const double maxSpeed = skidSteer->getMaxVelocity() / drive->rpmPerMeterPerSecond();
+  const double circumference = drive->config.wheelDiameter * okapi::pi;
+  const bool leftLeads = std::abs(ileft) >= std::abs(iright);
+  const auto &lead = leftLeads ? drive->leftMotor : drive->rightMotor;
+  const double start = lead->getDegrees();
+  double velocity = 0;
+
+  while (true) {
+    drive->update();
+    const double done = std::abs(lead->getDegrees() - start) / 360 * circumference;
+    const double remaining = total - done;
+    if (remaining < SIM_MOVE_DONE) {
+      break;
+    }
+    velocity = std::min({maxSpeed, velocity + maxAcceleration * period,
+                         std::sqrt(2 * maxAcceleration * remaining)});
+    const double rpm = velocity * drive->rpmPerMeterPerSecond();
+    drive->leftMotor->moveVelocity(static_cast<std::int16_t>(std::lround(rpm * ileft / total)));
+    drive->rightMotor->moveVelocity(static_cast<std::int16_t>(std::lround(rpm * iright / total)));
+    rate->delayUntil(SIM_MOVE_PERIOD_MS);
+  }
+  skidSteer->stop();
+  drive->settle();
+}
+
+void SimChassisController::moveDistance(const okapi::QLength itarget) {
+  const double distance = itarget.convert(okapi::meter);
+  profiledMove(distance, distance);
+}
+
+void SimChassisController::moveRaw(const double itarget) {
+  moveDistance(itarget / okapi::gearsetToTPR(drive->config.gearset) *
+               drive->config.wheelDiameter * okapi::pi * okapi::meter);
+}
+
+void SimChassisController::moveDistanceAsync(const okapi::QLength itarget) {
+  moveDistance(itarget);
+}
+
+void SimChassisController::moveRawAsync(const double itarget) {
+  moveRaw(itarget);
+}
+
+void SimChassisController::turnAngle(const okapi::QAngle idegTarget) {
+  const double wheel = idegTarget.convert(okapi::radian) * drive->config.track / 2 *
+                       (turnsMirrored ? -1 : 1);
+  profiledMove(wheel, -wheel);
+}
+
+void SimChassisController::turnRaw(const double idegTarget) {
+  const double wheel = idegTarget / okapi::gearsetToTPR(drive->config.gearset) *
+                       drive->config.wheelDiameter * okapi::pi * (turnsMirrored ? -1 : 1);
+  profiledMove(wheel, -wheel);
+}
+
+void SimChassisController::turnAngleAsync(const okapi::QAngle idegTarget) {
+  turnAngle(idegTarget);
+}
+
+void SimChassisController::turnRawAsync(const double idegTarget) {
+  turnRaw(idegTarget);
+}
+
+void SimChassisController::setTurnsMirrored(const bool ishouldMirror) {
+  turnsMirrored = ishouldMirror;
+}
+
+bool SimChassisController::isSettled() {
+  return drive->leftMotor->isStopped() && drive->rightMotor->isStopped();
+}
+
+void SimChassisController::waitUntilSettled() {
+  drive->settle();
+}
+
+void SimChassisController::stop() {
+  skidSteer->stop();
+}
+
+void SimChassisController::setMaxVelocity(const double imaxVelocity) {
+  skidSteer->setMaxVelocity(imaxVelocity);
+}
+
+double SimChassisController::getMaxVelocity() const {
+  return skidSteer->getMaxVelocity();
+}
+
+okapi::ChassisScales SimChassisController::getChassisScales() const {
+  return simScales(drive->config);
+}
+
+okapi::AbstractMotor::GearsetRatioPair SimChassisController::getGearsetRatioPair() const {
+  return drive->config.gearset * 1.0;
+}
+
+std::shared_ptr<okapi::ChassisModel> SimChassisController::getModel() {
+  return skidSteer;
+}
+
+okapi::ChassisModel &SimChassisController::model() {
+  return *skidSteer;
+}
+
+void SimChassisController::driveToPoint(const okapi::Point &ipoint,
+                                        const bool ibackwards,
+                                        const okapi::QLength &ioffset) {
+  auto [length, angle] = okapi::OdomMath::computeDistanceAndAngleToPoint(
+    ipoint.inFT(defaultStateMode), odom->getState(okapi::StateMode::FRAME_TRANSFORMATION));
+
+  if (ibackwards) {
+    length *= -1;
+    angle += 180_deg;
+  }
+  length -= ioffset;
+  angle = okapi::OdomMath::constrainAngle180(angle);
+
+  if (angle.abs() > turnThreshold) {
+    turnAngle(angle);
+  }
+  if (length.abs() > moveThreshold) {
+    moveDistance(length);
+  }
+}
+
+void SimChassisController::turnToPoint(const okapi::Point &ipoint) {
+  const auto angle = okapi::OdomMath::computeAngleToPoint(
+    ipoint.inFT(defaultStateMode), odom->getState(okapi::StateMode::FRAME_TRANSFORMATION));
+  if (angle.abs() > turnThreshold) {
+    turnAngle(angle);
+  }
+}
+
+void SimChassisController::turnToAngle(const okapi::QAngle &iangle) {
+  const auto angle = okapi::OdomMath::constrainAngle180(
+    iangle - odom->getState(okapi::StateMode::FRAME_TRANSFORMATION).theta);
+  if (angle.abs() > turnThreshold) {
+    turnAngle(angle);
+  }
+}
+
+void telemetryReportError(const std::uint8_t icontrollerId, const float ierror) {
+  if (icontrollerId >= TELEMETRY_MAX_CONTROLLERS) {
+    return;
+  }
+  telemetryErrors[icontrollerId] = ierror;
+  if (std::abs(ierror) > telemetryMaxErrors[icontrollerId]) {
+    telemetryMaxErrors[icontrollerId] = std::abs(ierror);
+  }
+}
+
+float hostTelemetryError(const std::uint8_t icontrollerId) {
+  return telemetryErrors[icontrollerId];
+}
+
+float hostTelemetryMaxError(const std::uint8_t icontrollerId) {
+  return telemetryMaxErrors[icontrollerId];
+}
+
+void hostTelemetryReset() {
+  for (int i = 0; i < TELEMETRY_MAX_CONTROLLERS; i++) {
+    telemetryErrors[i] = 0;
+    telemetryMaxErrors[i] = 0;
+  }
+}
@@ -0,0 +1,242 @@
+#ifndef HOST_CHASSIS_H_
+#define HOST_CHASSIS_H_
+
+// ------- hostChassis.h -------------------------------------------------------
+//
+// Kinematic simulation of a skid steer chassis for the host tests of the path
+// followers. SimMotor stands in for a V5 motor: it follows its velocity or
+// voltage target with a first order lag. SimDrive moves the robot by the left
+// and right wheel travel on the same arcs the odometry assumes (odomArcMath.h),
+// without slip, so the pose it reports is the true one.
+//
+// Nothing runs on its own: the simulation catches up to hostMicros whenever
+// the pose or a motor is read, so a follower sleeping through the rates of
+// hostTimeUtil() drives the robot in simulated time, on the test's thread.
+//
+// SimChassisController is the OdomChassisController around it. Its
+// moveDistance() and turnAngle() run a trapezoidal profile to a stop like the
+// motors' built in profile does for okapi's ChassisControllerIntegrated, and
+// driveToPoint() turns, then drives, like okapi's DefaultOdomChassisController.
+
+#include "odomArcMath.h"
+
+#include "okapi/api/chassis/controller/odomChassisController.hpp"
+#include "okapi/api/chassis/model/skidSteerModel.hpp"
+#include "okapi/api/device/motor/abstractMotor.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define SIM_PERIOD_MS 1               // simulation step
+#define SIM_STOPPED_RPM 1.0           // a motor this slow counts as stopped
+
+/**
+ * The simulated chassis.
+ */
+struct SimDriveConfig {
+  double wheelDiameter{0.1016};       // m, 4 inch wheels
+  double track{0.30};                 // m
+  okapi::AbstractMotor::gearset gearset{okapi::AbstractMotor::gearset::green};
+  double motorLag{0.04};              // s, time constant of a motor following its target
+};
+
+class SimDrive;
+
+class SimMotor : public okapi::AbstractMotor,
+                 public std::enable_shared_from_this<SimMotor> {
+  public:
+  /**
+   * A motor of idrive, only moved when idrive updates.
+   */
+  explicit SimMotor(SimDrive &idrive);
+
+  /**
+   * Moves the motor on by idt seconds.
+   */
+  void advance(double idt);
+
+  /**
+   * @return The position in degrees, whatever the encoder units.
+   */
+  double getDegrees() const;
+
+  std::int32_t moveAbsolute(double iposition, std::int32_t ivelocity) override;
+  std::int32_t moveRelative(double iposition, std::int32_t ivelocity) override;
+  std::int32_t moveVelocity(std::int16_t ivelocity) override;
+  std::int32_t moveVoltage(std::int16_t ivoltage) override;
+  std::int32_t modifyProfiledVelocity(std::int32_t ivelocity) override;
+  double getTargetPosition() override;
+  double getPosition() override;
+  std::int32_t tarePosition() override;
+  std::int32_t getTargetVelocity() override;
+  double getActualVelocity() override;
+  std::int32_t getCurrentDraw() override;
+  std::int32_t getDirection() override;
+  double getEfficiency() override;
+  std::int32_t isOverCurrent() override;
+  std::int32_t isOverTemp() override;
+  std::int32_t isStopped() override;
+  std::int32_t getZeroPositionFlag() override;
+  uint32_t getFaults() override;
+  uint32_t getFlags() override;
+  std::int32_t getRawPosition(std::uint32_t *timestamp) override;
+  double getPower() override;
+  double getTemperature() override;
+  double getTorque() override;
+  std::int32_t getVoltage() override;
+  std::int32_t setBrakeMode(brakeMode imode) override;
+  brakeMode getBrakeMode() override;
+  std::int32_t setCurrentLimit(std::int32_t ilimit) override;
+  std::int32_t getCurrentLimit() override;
+  std::int32_t setEncoderUnits(encoderUnits iunits) override;
+  encoderUnits getEncoderUnits() override;
+  std::int32_t setGearing(gearset igearset) override;
+  gearset getGearing() override;
+  std::int32_t setReversed(bool ireverse) override;
+  std::int32_t setVoltageLimit(std::int32_t ilimit) override;
+  std::shared_ptr<okapi::ContinuousRotarySensor> getEncoder() override;
+  void controllerSet(double ivalue) override;
+
+  protected:
+  SimDrive &drive;
+  gearset gearing;
+  encoderUnits units{encoderUnits::degrees};
+  brakeMode brake{brakeMode::coast};
+  bool positionMode{false};
+  double targetRpm{0};
+  double targetDegrees{0};            // position mode target
+  double actualRpm{0};
+  double degrees{0};
+  double zeroDegrees{0};
+
+  double toUnits(double idegrees) const;
+  double fromUnits(double iposition) const;
+};
+
+class SimDrive {
+  public:
+  const SimDriveConfig config;
+  const std::shared_ptr<SimMotor> leftMotor;
+  const std::shared_ptr<SimMotor> rightMotor;
+
+  explicit SimDrive(const SimDriveConfig &iconfig = SimDriveConfig{});
+
+  /**
+   * Moves the robot on to hostMicros.
+   */
+  void update();
+
+  /**
+   * Moves hostMicros on until every motor has stopped.
+   */
+  void settle();
+
+  /**
+   * @return The true pose at hostMicros.
+   */
+  OdomPose getPose();
+
+  void setPose(const OdomPose &ipose);
+
+  /**
+   * @return The distance the center of the robot has travelled, in m.
+   */
+  double getTravel();
+
+  /**
+   * Starts recording the true pose of every simulation step.
+   */
+  void startTrace();
+
+  /**
+   * @return The poses recorded since startTrace().
+   */
+  const std::vector<OdomPose> &getTrace();
+
+  /**
+   * @return The motor rpm for a wheel speed of one m/s.
+   */
+  double rpmPerMeterPerSecond() const;
+
+  /**
+   * @return The wheel speed of a motor at full speed, in m/s.
+   */
+  double maxSpeed() const;
+
+  protected:
+  std::uint64_t micros{0};
+  OdomPose pose;
+  double travel{0};
+  bool tracing{false};
+  std::vector<OdomPose> trace;
+  double leftDegrees{0};
+  double rightDegrees{0};
+};
+
+class SimChassisController : public okapi::OdomChassisController {
+  public:
+  /**
+   * An OdomChassisController driving idrive, with perfect odometry.
+   *
+   * @param idrive The simulation.
+   * @param imaxAcceleration The acceleration of moveDistance() and turnAngle(), in m/s^2 of
+   * the wheels.
+   */
+  explicit SimChassisController(const std::shared_ptr<SimDrive> &idrive,
+                                double imaxAcceleration = 1.5);
+
+  void moveDistance(okapi::QLength itarget) override;
+  void moveRaw(double itarget) override;
+  void moveDistanceAsync(okapi::QLength itarget) override;
+  void moveRawAsync(double itarget) override;
+  void turnAngle(okapi::QAngle idegTarget) override;
+  void turnRaw(double idegTarget) override;
+  void turnAngleAsync(okapi::QAngle idegTarget) override;
+  void turnRawAsync(double idegTarget) override;
+  void setTurnsMirrored(bool ishouldMirror) override;
+  bool isSettled() override;
+  void waitUntilSettled() override;
+  void stop() override;
+  void setMaxVelocity(double imaxVelocity) override;
+  double getMaxVelocity() const override;
+  okapi::ChassisScales getChassisScales() const override;
+  okapi::AbstractMotor::GearsetRatioPair getGearsetRatioPair() const override;
+  std::shared_ptr<okapi::ChassisModel> getModel() override;
+  okapi::ChassisModel &model() override;
+
+  void driveToPoint(const okapi::Point &ipoint,
+                    bool ibackwards = false,
+                    const okapi::QLength &ioffset = 0 * okapi::millimeter) override;
+  void turnToPoint(const okapi::Point &ipoint) override;
+  void turnToAngle(const okapi::QAngle &iangle) override;
+
+  protected:
+  std::shared_ptr<SimDrive> drive;
+  std::shared_ptr<okapi::SkidSteerModel> skidSteer;
+  const double maxAcceleration;
+  bool turnsMirrored{false};
+
+  /**
+   * Moves the left and right wheels by ileft and iright meters, both starting and stopping
+   * together, and waits until the robot stands still.
+   */
+  void profiledMove(double ileft, double iright);
+};
+
+/**
+ * @return The last error a controller reported with telemetryReportError(), 0 if none.
+ */
+float hostTelemetryError(std::uint8_t icontrollerId);
+
+/**
+ * @return The largest error a controller reported since hostTelemetryReset().
+ */
+float hostTelemetryMaxError(std::uint8_t icontrollerId);
+
+/**
+ * Forgets the reported errors.
+ */
+void hostTelemetryReset();
+
+#endif
@@ -0,0 +1,1689 @@
+// ------- hostOkapi.cpp -------------------------------------------------------
+//
+// Host stand-ins for the parts of okapilib the tested sources link against.
+// The include/okapi headers are the library's, but the library itself is only
+// shipped built for the V5, so the non-inline functions used are defined here,
+// following okapilib 4.2's behaviour: filters, odometry, the chassis models
+// and OdomChassisController's odometry half. The logger is always off.
+//
+// AsyncMotionProfileController stores paths with pathfinder's CSV functions
+// and AsyncLinearMotionProfileController generates them with pathfinder, so
+// both are only built with the Pathfinder C sources (HOST_TEST_PATHFINDER).
+
+#include "hostTest.h"
+
+#include "okapi/api/chassis/controller/chassisScales.hpp"
+#include "okapi/api/chassis/controller/odomChassisController.hpp"
+#include "okapi/api/chassis/model/hDriveModel.hpp"
+#include "okapi/api/chassis/model/skidSteerModel.hpp"
+#include "okapi/api/chassis/model/xDriveModel.hpp"
+#include "okapi/api/control/async/asyncLinearMotionProfileController.hpp"
+#include "okapi/api/control/async/asyncMotionProfileController.hpp"
+#include "okapi/api/device/motor/abstractMotor.hpp"
+#include "okapi/api/device/rotarysensor/rotarySensor.hpp"
+#include "okapi/api/filter/composableFilter.hpp"
+#include "okapi/api/filter/demaFilter.hpp"
+#include "okapi/api/filter/emaFilter.hpp"
+#include "okapi/api/filter/filter.hpp"
+#include "okapi/api/filter/velMath.hpp"
+#include "okapi/api/odometry/odomMath.hpp"
+#include "okapi/api/odometry/odomState.hpp"
+#include "okapi/api/odometry/threeEncoderOdometry.hpp"
+#include "okapi/api/odometry/twoEncoderOdometry.hpp"
+#include "okapi/api/util/logging.hpp"
+#include "okapi/api/util/mathUtil.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+std::uint64_t hostMicros = 0;
+
+namespace {
+class HostTimer : public okapi::AbstractTimer {
+  public:
+  HostTimer() : okapi::AbstractTimer(now()) {
+  }
+
+  okapi::QTime millis() const override {
+    return now();
+  }
+
+  static okapi::QTime now() {
+    return (hostMicros / 1000.0) * okapi::millisecond;
+  }
+};
+
+// sleeping moves the simulated clock instead
+class HostRate : public okapi::AbstractRate {
+  public:
+  void delay(const okapi::QFrequency ihz) override {
+    delayUntil(okapi::QTime(1.0 / ihz.convert(okapi::Hz)));
+  }
+
+  void delayUntil(const okapi::QTime itime) override {
+    hostMicros += static_cast<std::uint64_t>(itime.convert(okapi::millisecond) * 1000);
+  }
+
+  void delayUntil(const uint32_t ims) override {
+    hostMicros += static_cast<std::uint64_t>(ims) * 1000;
+  }
+};
+} // namespace
+
+okapi::TimeUtil hostTimeUtil() {
+  return okapi::TimeUtil(
+    okapi::Supplier<std::unique_ptr<okapi::AbstractTimer>>(
+      [] { return std::unique_ptr<okapi::AbstractTimer>(std::make_unique<HostTimer>()); }),
+    okapi::Supplier<std::unique_ptr<okapi::AbstractRate>>(
+      [] { return std::unique_ptr<okapi::AbstractRate>(std::make_unique<HostRate>()); }),
+    okapi::Supplier<std::unique_ptr<okapi::SettledUtil>>(
+      [] { return std::unique_ptr<okapi::SettledUtil>(); }));
+}
+
+namespace okapi {
+int DefaultLoggerInitializer::count = 0;
+std::shared_ptr<Logger> defaultLogger;
+
+Logger::Logger() noexcept : timer(nullptr), logLevel(LogLevel::off), logfile(nullptr) {
+}
+
+Logger::~Logger() {
+  close();
+}
+
+std::shared_ptr<Logger> Logger::getDefaultLogger() {
+  return defaultLogger;
+}
+
+void Logger::setDefaultLogger(std::shared_ptr<Logger> ilogger) {
+  defaultLogger = std::move(ilogger);
+}
+
+std::string OdomState::str() const {
+  return "OdomState(x=" + std::to_string(x.convert(meter)) +
+         "m, y=" + std::to_string(y.convert(meter)) +
+         "m, theta=" + std::to_string(theta.convert(degree)) + "deg)";
+}
+
+AbstractTimer::AbstractTimer(const QTime ifirstCalled)
+  : firstCalled(ifirstCalled), lastCalled(ifirstCalled), mark(ifirstCalled) {
+}
+
+AbstractTimer::~AbstractTimer() = default;
+
+QTime AbstractTimer::getDt() {
+  const QTime currTime = millis();
+  const QTime dt = currTime - lastCalled;
+  lastCalled = currTime;
+  return dt;
+}
+
+QTime AbstractTimer::readDt() const {
+  return millis() - lastCalled;
+}
+
+QTime AbstractTimer::getStartingTime() const {
+  return firstCalled;
+}
+
+QTime AbstractTimer::getDtFromStart() const {
+  return millis() - firstCalled;
+}
+
+void AbstractTimer::placeMark() {
+  mark = millis();
+}
+
+QTime AbstractTimer::clearMark() {
+  const QTime old = mark;
+  mark = 0_ms;
+  return old;
+}
+
+void AbstractTimer::placeHardMark() {
+  if (hardMark == 0_ms) {
+    hardMark = millis();
+  }
+}
+
+QTime AbstractTimer::clearHardMark() {
+  const QTime old = hardMark;
+  hardMark = 0_ms;
+  return old;
+}
+
+QTime AbstractTimer::getDtFromMark() const {
+  return mark != 0_ms ? millis() - mark : 0_ms;
+}
+
+QTime AbstractTimer::getDtFromHardMark() const {
+  return hardMark != 0_ms ? millis() - hardMark : 0_ms;
+}
+
+bool AbstractTimer::repeat(const QTime time) {
+  if (repeatMark == 0_ms) {
+    repeatMark = millis();
+    return false;
+  }
+
+  if (millis() - repeatMark >= time) {
+    repeatMark = 0_ms;
+    return true;
+  }
+
+  return false;
+}
+
+bool AbstractTimer::repeat(const QFrequency frequency) {
+  return repeat(QTime(1.0 / frequency.convert(Hz)));
+}
+
+AbstractRate::~AbstractRate() = default;
+
+Filter::~Filter() = default;
+
+EmaFilter::EmaFilter(const double ialpha) : alpha(ialpha) {
+}
+
+double EmaFilter::filter(const double ireading) {
+  output = alpha * ireading + (1.0 - alpha) * lastOutput;
+  lastOutput = output;
+  return output;
+}
+
+double EmaFilter::getOutput() const {
+  return output;
+}
+
+void EmaFilter::setGains(const double ialpha) {
+  alpha = ialpha;
+}
+
+DemaFilter::DemaFilter(const double ialpha, const double ibeta) : alpha(ialpha), beta(ibeta) {
+}
+
+double DemaFilter::filter(const double ireading) {
+  outputS = alpha * ireading + (1.0 - alpha) * (lastOutputS + lastOutputB);
+  outputB = beta * (outputS - lastOutputS) + (1.0 - beta) * lastOutputB;
+  lastOutputS = outputS;
+  lastOutputB = outputB;
+  return outputS + outputB;
+}
+
+double DemaFilter::getOutput() const {
+  return outputS + outputB;
+}
+
+void DemaFilter::setGains(const double ialpha, const double ibeta) {
+  alpha = ialpha;
+  beta = ibeta;
+}
+
+VelMath::VelMath(const double iticksPerRev,
+                 std::unique_ptr<Filter> ifilter,
+                 const QTime isampleTime,
+                 std::unique_ptr<AbstractTimer> iloopDtTimer,
+                 std::shared_ptr<Logger> ilogger)
+  : logger(std::move(ilogger)),
+    ticksPerRev(iticksPerRev),
+    sampleTime(isampleTime),
+    loopDtTimer(std::move(iloopDtTimer)),
+    filter(std::move(ifilter)) {
+  if (iticksPerRev == 0) {
+    throw std::invalid_argument("VelMath: The ticks per revolution cannot be zero!");
+  }
+}
+
+VelMath::~VelMath() = default;
+
+QAngularSpeed VelMath::step(const double inewPos) {
+  const QTime dt = loopDtTimer->readDt();
+
+  if (dt >= sampleTime) {
+    vel = filter->filter(((inewPos - lastPos) * (60_s / dt).convert(number)) / ticksPerRev) * rpm;
+    accel = (vel - lastVel) / dt;
+
+    lastVel = vel;
+    lastPos = inewPos;
+
+    loopDtTimer->getDt();
+  }
+
+  return vel;
+}
+
+void VelMath::setTicksPerRev(const double iTPR) {
+  ticksPerRev = iTPR;
+}
+
+QAngularSpeed VelMath::getVelocity() const {
+  return vel;
+}
+
+QAngularAcceleration VelMath::getAccel() const {
+  return accel;
+}
+
+ComposableFilter::ComposableFilter(const std::initializer_list<std::shared_ptr<Filter>> &ilist)
+  : filters(ilist) {
+}
+
+double ComposableFilter::filter(const double ireading) {
+  output = ireading;
+  for (auto &filter : filters) {
+    output = filter->filter(output);
+  }
+  return output;
+}
+
+double ComposableFilter::getOutput() const {
+  return output;
+}
+
+void ComposableFilter::addFilter(std::shared_ptr<Filter> ifilter) {
+  filters.push_back(std::move(ifilter));
+}
+
+RotarySensor::~RotarySensor() = default;
+
+TimeUtil::TimeUtil(const Supplier<std::unique_ptr<AbstractTimer>> &itimerSupplier,
+                   const Supplier<std::unique_ptr<AbstractRate>> &irateSupplier,
+                   const Supplier<std::unique_ptr<SettledUtil>> &isettledUtilSupplier)
+  : timerSupplier(itimerSupplier),
+    rateSupplier(irateSupplier),
+    settledUtilSupplier(isettledUtilSupplier) {
+}
+
+std::unique_ptr<AbstractTimer> TimeUtil::getTimer() const {
+  return timerSupplier.get();
+}
+
+std::unique_ptr<AbstractRate> TimeUtil::getRate() const {
+  return rateSupplier.get();
+}
+
+std::unique_ptr<SettledUtil> TimeUtil::getSettledUtil() const {
+  return settledUtilSupplier.get();
+}
+
+void ChassisScales::validateInputSize(const std::size_t inputSize,
+                                      const std::shared_ptr<Logger> &) {
+  if (inputSize < 2 || inputSize > 4) {
+    throw std::invalid_argument("At least two measurements must be given to ChassisScales. Got " +
+                                std::to_string(inputSize) + " measurements.");
+  }
+}
+
+ChassisScales::ChassisScales(const std::initializer_list<QLength> &idimensions,
+                             const double itpr,
+                             const std::shared_ptr<Logger> &ilogger) {
+  validateInputSize(idimensions.size(), ilogger);
+  const std::vector<QLength> vec(idimensions);
+
+  wheelDiameter = vec.at(0);
+  wheelTrack = vec.at(1);
+  middleWheelDistance = vec.size() >= 3 ? vec.at(2) : 0_m;
+  middleWheelDiameter = vec.size() == 4 ? vec.at(3) : wheelDiameter;
+  tpr = itpr;
+
+  straight = tpr / (wheelDiameter.convert(meter) * 1_pi);
+  turn = wheelTrack.convert(meter) / wheelDiameter.convert(meter);
+  middle = tpr / (middleWheelDiameter.convert(meter) * 1_pi);
+}
+
+ChassisScales::ChassisScales(const std::initializer_list<double> &iscales,
+                             const double itpr,
+                             const std::shared_ptr<Logger> &ilogger) {
+  validateInputSize(iscales.size(), ilogger);
+  const std::vector<double> vec(iscales);
+
+  straight = vec.at(0);
+  turn = vec.at(1);
+  middle = vec.size() == 4 ? vec.at(3) : straight;
+  tpr = itpr;
+
+  wheelDiameter = (tpr / (straight * 1_pi)) * meter;
+  wheelTrack = turn * wheelDiameter;
+  middleWheelDistance = vec.size() >= 3 ? vec.at(2) * meter : 0_m;
+  middleWheelDiameter = (tpr / (middle * 1_pi)) * meter;
+}
+
+TwoEncoderOdometry::TwoEncoderOdometry(const TimeUtil &itimeUtil,
+                                       const std::shared_ptr<ReadOnlyChassisModel> &imodel,
+                                       const ChassisScales &ichassisScales,
+                                       const std::shared_ptr<Logger> &ilogger)
+  : logger(ilogger),
+    rate(itimeUtil.getRate()),
+    timer(itimeUtil.getTimer()),
+    model(imodel),
+    chassisScales(ichassisScales) {
+}
+
+void TwoEncoderOdometry::setScales(const ChassisScales &ichassisScales) {
+  chassisScales = ichassisScales;
+}
+
+void TwoEncoderOdometry::step() {
+  const auto deltaT = timer->getDt();
+
+  if (deltaT.getValue() != 0) {
+    newTicks = model->getSensorVals();
+    tickDiff = newTicks - lastTicks;
+    lastTicks = newTicks;
+
+    const auto newState = odomMathStep(tickDiff, deltaT);
+
+    state.x += newState.x;
+    state.y += newState.y;
+    state.theta += newState.theta;
+  }
+}
+
+OdomState TwoEncoderOdometry::odomMathStep(const std::valarray<std::int32_t> &itickDiff,
+                                           const QTime &) {
+  if (itickDiff.size() < 2) {
+    return OdomState{};
+  }
+  for (auto &&elem : itickDiff) {
+    if (std::abs(elem) > maximumTickDiff) {
+      return OdomState{};
+    }
+  }
+
+  const double deltaL = itickDiff[0] / chassisScales.straight;
+  const double deltaR = itickDiff[1] / chassisScales.straight;
+
+  double deltaTheta = (deltaL - deltaR) / chassisScales.wheelTrack.convert(meter);
+  double localOffX, localOffY;
+
+  if (deltaL == deltaR) {
+    localOffX = 0;
+    localOffY = deltaR;
+  } else {
+    localOffX = 0;
+    localOffY = 2 * std::sin(deltaTheta / 2) *
+                (deltaR / deltaTheta + chassisScales.wheelTrack.convert(meter) / 2);
+  }
+
+  const double avgA = state.theta.convert(radian) + (deltaTheta / 2);
+
+  const double polarR = std::sqrt((localOffX * localOffX) + (localOffY * localOffY));
+  const double polarA = std::atan2(localOffY, localOffX) - avgA;
+
+  double dX = std::sin(polarA) * polarR;
+  double dY = std::cos(polarA) * polarR;
+
+  if (std::isnan(dX)) {
+    dX = 0;
+  }
+  if (std::isnan(dY)) {
+    dY = 0;
+  }
+  if (std::isnan(deltaTheta)) {
+    deltaTheta = 0;
+  }
+
+  return OdomState{dX * meter, dY * meter, deltaTheta * radian};
+}
+
+OdomState TwoEncoderOdometry::getState(const StateMode &imode) const {
+  if (imode == StateMode::FRAME_TRANSFORMATION) {
+    return state;
+  }
+  return OdomState{state.y, state.x, state.theta};
+}
+
+void TwoEncoderOdometry::setState(const OdomState &istate, const StateMode &imode) {
+  if (imode == StateMode::FRAME_TRANSFORMATION) {
+    state = istate;
+  } else {
+    state = OdomState{istate.y, istate.x, istate.theta};
+  }
+}
+
+std::shared_ptr<ReadOnlyChassisModel> TwoEncoderOdometry::getModel() {
+  return model;
+}
+
+ChassisScales TwoEncoderOdometry::getScales() {
+  return chassisScales;
+}
+
+ThreeEncoderOdometry::ThreeEncoderOdometry(const TimeUtil &itimeUtil,
+                                           const std::shared_ptr<ReadOnlyChassisModel> &imodel,
+                                           const ChassisScales &ichassisScales,
+                                           const std::shared_ptr<Logger> &ilogger)
+  : TwoEncoderOdometry(itimeUtil, imodel, ichassisScales, ilogger) {
+}
+
+OdomState ThreeEncoderOdometry::odomMathStep(const std::valarray<std::int32_t> &itickDiff,
+                                             const QTime &) {
+  if (itickDiff.size() < 3) {
+    return OdomState{};
+  }
+  for (auto &&elem : itickDiff) {
+    if (std::abs(elem) > maximumTickDiff) {
+      return OdomState{};
+    }
+  }
+
+  const double deltaL = itickDiff[0] / chassisScales.straight;
+  const double deltaR = itickDiff[1] / chassisScales.straight;
+  const double deltaM = itickDiff[2] / chassisScales.middle;
+
+  double deltaTheta = (deltaL - deltaR) / chassisScales.wheelTrack.convert(meter);
+  double localOffX, localOffY;
+
+  if (deltaL == deltaR) {
+    localOffX = deltaM;
+    localOffY = deltaR;
+  } else {
+    localOffX = 2 * std::sin(deltaTheta / 2) *
+                (deltaM / deltaTheta + chassisScales.middleWheelDistance.convert(meter));
+    localOffY = 2 * std::sin(deltaTheta / 2) *
+                (deltaR / deltaTheta + chassisScales.wheelTrack.convert(meter) / 2);
+  }
+
+  const double avgA = state.theta.convert(radian) + (deltaTheta / 2);
+
+  const double polarR = std::sqrt((localOffX * localOffX) + (localOffY * localOffY));
+  const double polarA = std::atan2(localOffY, localOffX) - avgA;
+
+  double dX = std::sin(polarA) * polarR;
+  double dY = std::cos(polarA) * polarR;
+
+  if (std::isnan(dX)) {
+    dX = 0;
+  }
+  if (std::isnan(dY)) {
+    dY = 0;
+  }
+  if (std::isnan(deltaTheta)) {
+    deltaTheta = 0;
+  }
+
+  return OdomState{dX * meter, dY * meter, deltaTheta * radian};
+}
+
+QLength OdomMath::computeDistanceToPoint(const Point &ipoint, const OdomState &istate) {
+  const auto [xDiff, yDiff] = computeDiffs(ipoint, istate);
+  return computeDistance(xDiff, yDiff) * meter;
+}
+
+QAngle OdomMath::computeAngleToPoint(const Point &ipoint, const OdomState &istate) {
+  const auto [xDiff, yDiff] = computeDiffs(ipoint, istate);
+  return constrainAngle180(computeAngle(xDiff, yDiff, istate.theta.convert(radian)) * radian);
+}
+
+std::pair<QLength, QAngle> OdomMath::computeDistanceAndAngleToPoint(const Point &ipoint,
+                                                                    const OdomState &istate) {
+  const auto [xDiff, yDiff] = computeDiffs(ipoint, istate);
+  return std::make_pair(
+    computeDistance(xDiff, yDiff) * meter,
+    constrainAngle180(computeAngle(xDiff, yDiff, istate.theta.convert(radian)) * radian));
+}
+
+std::pair<double, double> OdomMath::computeDiffs(const Point &ipoint, const OdomState &istate) {
+  const double xDiff = (ipoint.x - istate.x).convert(meter);
+  const double yDiff = (ipoint.y - istate.y).convert(meter);
+  return std::make_pair(xDiff, yDiff);
+}
+
+double OdomMath::computeDistance(const double xDiff, const double yDiff) {
+  return std::sqrt(std::pow(xDiff, 2) + std::pow(yDiff, 2));
+}
+
+double OdomMath::computeAngle(const double xDiff, const double yDiff, const double theta) {
+  return std::atan2(yDiff, xDiff) - theta;
+}
+
+QAngle OdomMath::constrainAngle360(const QAngle &angle) {
+  return angle - 360_deg * std::floor(angle.convert(degree) / 360.0);
+}
+
+QAngle OdomMath::constrainAngle180(const QAngle &angle) {
+  return angle - 360_deg * std::floor((angle.convert(degree) + 180.0) / 360.0);
+}
+
+AbstractMotor::~AbstractMotor() = default;
+
+double AbstractMotor::getPositionError() {
+  return getTargetPosition() - getPosition();
+}
+
+double AbstractMotor::getVelocityError() {
+  return getTargetVelocity() - getActualVelocity();
+}
+
+AbstractMotor::GearsetRatioPair operator*(const AbstractMotor::gearset gearset,
+                                          const double ratio) {
+  return AbstractMotor::GearsetRatioPair(gearset, ratio);
+}
+
+namespace {
+/**
+ * WPILib's arcade drive, shared by the chassis models: returns the left and right outputs.
+ */
+std::pair<double, double> arcadeOutputs(const double iforwardSpeed,
+                                        const double iyaw,
+                                        const double ithreshold) {
+  double forwardSpeed = std::clamp(iforwardSpeed, -1.0, 1.0);
+  if (std::abs(forwardSpeed) <= ithreshold) {
+    forwardSpeed = 0;
+  }
+  double yaw = std::clamp(iyaw, -1.0, 1.0);
+  if (std::abs(yaw) <= ithreshold) {
+    yaw = 0;
+  }
+
+  const double maxInput =
+    std::copysign(std::max(std::abs(forwardSpeed), std::abs(yaw)), forwardSpeed);
+  double leftOutput = 0;
+  double rightOutput = 0;
+
+  if (forwardSpeed >= 0) {
+    if (yaw >= 0) {
+      leftOutput = maxInput;
+      rightOutput = forwardSpeed - yaw;
+    } else {
+      leftOutput = forwardSpeed + yaw;
+      rightOutput = maxInput;
+    }
+  } else {
+    if (yaw >= 0) {
+      leftOutput = forwardSpeed + yaw;
+      rightOutput = maxInput;
+    } else {
+      leftOutput = maxInput;
+      rightOutput = forwardSpeed - yaw;
+    }
+  }
+  return {std::clamp(leftOutput, -1.0, 1.0), std::clamp(rightOutput, -1.0, 1.0)};
+}
+
+/**
+ * WPILib's curvature-free drive vector, normalized so neither side is over 1.
+ */
+std::pair<double, double> vectorOutputs(const double iforwardSpeed, const double iyaw) {
+  const double forwardSpeed = std::clamp(iforwardSpeed, -1.0, 1.0);
+  const double yaw = std::clamp(iyaw, -1.0, 1.0);
+
+  double leftOutput = forwardSpeed + yaw;
+  double rightOutput = forwardSpeed - yaw;
+  if (const double maxInputMag = std::max(std::abs(leftOutput), std::abs(rightOutput));
+      maxInputMag > 1) {
+    leftOutput /= maxInputMag;
+    rightOutput /= maxInputMag;
+  }
+  return {leftOutput, rightOutput};
+}
+
+double thresholded(const double ispeed, const double ithreshold) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  return std::abs(speed) < ithreshold ? 0 : speed;
+}
+} // namespace
+
+SkidSteerModel::SkidSteerModel(std::shared_ptr<AbstractMotor> ileftSideMotor,
+                               std::shared_ptr<AbstractMotor> irightSideMotor,
+                               std::shared_ptr<ContinuousRotarySensor> ileftEnc,
+                               std::shared_ptr<ContinuousRotarySensor> irightEnc,
+                               const double imaxVelocity,
+                               const double imaxVoltage)
+  : maxVelocity(imaxVelocity),
+    maxVoltage(imaxVoltage),
+    leftSideMotor(std::move(ileftSideMotor)),
+    rightSideMotor(std::move(irightSideMotor)),
+    leftSensor(std::move(ileftEnc)),
+    rightSensor(std::move(irightEnc)) {
+}
+
+void SkidSteerModel::forward(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  leftSideMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  rightSideMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+}
+
+void SkidSteerModel::driveVector(const double iforwardSpeed, const double iyaw) {
+  const auto [leftOutput, rightOutput] = vectorOutputs(iforwardSpeed, iyaw);
+  leftSideMotor->moveVelocity(static_cast<int16_t>(leftOutput * maxVelocity));
+  rightSideMotor->moveVelocity(static_cast<int16_t>(rightOutput * maxVelocity));
+}
+
+void SkidSteerModel::driveVectorVoltage(const double iforwardSpeed, const double iyaw) {
+  const auto [leftOutput, rightOutput] = vectorOutputs(iforwardSpeed, iyaw);
+  leftSideMotor->moveVoltage(static_cast<int16_t>(leftOutput * maxVoltage));
+  rightSideMotor->moveVoltage(static_cast<int16_t>(rightOutput * maxVoltage));
+}
+
+void SkidSteerModel::rotate(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  leftSideMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  rightSideMotor->moveVelocity(static_cast<int16_t>(-1 * speed * maxVelocity));
+}
+
+void SkidSteerModel::stop() {
+  leftSideMotor->moveVelocity(0);
+  rightSideMotor->moveVelocity(0);
+}
+
+void SkidSteerModel::tank(const double ileftSpeed,
+                          const double irightSpeed,
+                          const double ithreshold) {
+  leftSideMotor->moveVoltage(
+    static_cast<int16_t>(thresholded(ileftSpeed, ithreshold) * maxVoltage));
+  rightSideMotor->moveVoltage(
+    static_cast<int16_t>(thresholded(irightSpeed, ithreshold) * maxVoltage));
+}
+
+void SkidSteerModel::arcade(const double iforwardSpeed,
+                            const double iyaw,
+                            const double ithreshold) {
+  const auto [leftOutput, rightOutput] = arcadeOutputs(iforwardSpeed, iyaw, ithreshold);
+  leftSideMotor->moveVoltage(static_cast<int16_t>(leftOutput * maxVoltage));
+  rightSideMotor->moveVoltage(static_cast<int16_t>(rightOutput * maxVoltage));
+}
+
+void SkidSteerModel::left(const double ispeed) {
+  leftSideMotor->moveVelocity(static_cast<int16_t>(std::clamp(ispeed, -1.0, 1.0) * maxVelocity));
+}
+
+void SkidSteerModel::right(const double ispeed) {
+  rightSideMotor->moveVelocity(static_cast<int16_t>(std::clamp(ispeed, -1.0, 1.0) * maxVelocity));
+}
+
+std::valarray<std::int32_t> SkidSteerModel::getSensorVals() const {
+  return std::valarray<std::int32_t>{static_cast<std::int32_t>(leftSensor->get()),
+                                     static_cast<std::int32_t>(rightSensor->get())};
+}
+
+void SkidSteerModel::resetSensors() {
+  leftSensor->reset();
+  rightSensor->reset();
+}
+
+void SkidSteerModel::setBrakeMode(const AbstractMotor::brakeMode mode) {
+  leftSideMotor->setBrakeMode(mode);
+  rightSideMotor->setBrakeMode(mode);
+}
+
+void SkidSteerModel::setEncoderUnits(const AbstractMotor::encoderUnits units) {
+  leftSideMotor->setEncoderUnits(units);
+  rightSideMotor->setEncoderUnits(units);
+}
+
+void SkidSteerModel::setGearing(const AbstractMotor::gearset gearset) {
+  leftSideMotor->setGearing(gearset);
+  rightSideMotor->setGearing(gearset);
+}
+
+void SkidSteerModel::setMaxVelocity(const double imaxVelocity) {
+  maxVelocity = imaxVelocity < 0 ? 0 : imaxVelocity;
+}
+
+double SkidSteerModel::getMaxVelocity() const {
+  return maxVelocity;
+}
+
+void SkidSteerModel::setMaxVoltage(const double imaxVoltage) {
+  maxVoltage = std::clamp(imaxVoltage, 0.0, v5MotorMaxVoltage);
+}
+
+double SkidSteerModel::getMaxVoltage() const {
+  return maxVoltage;
+}
+
+std::shared_ptr<AbstractMotor> SkidSteerModel::getLeftSideMotor() const {
+  return leftSideMotor;
+}
+
+std::shared_ptr<AbstractMotor> SkidSteerModel::getRightSideMotor() const {
+  return rightSideMotor;
+}
+
+XDriveModel::XDriveModel(std::shared_ptr<AbstractMotor> itopLeftMotor,
+                         std::shared_ptr<AbstractMotor> itopRightMotor,
+                         std::shared_ptr<AbstractMotor> ibottomRightMotor,
+                         std::shared_ptr<AbstractMotor> ibottomLeftMotor,
+                         std::shared_ptr<ContinuousRotarySensor> ileftEnc,
+                         std::shared_ptr<ContinuousRotarySensor> irightEnc,
+                         const double imaxVelocity,
+                         const double imaxVoltage)
+  : maxVelocity(imaxVelocity),
+    maxVoltage(imaxVoltage),
+    topLeftMotor(std::move(itopLeftMotor)),
+    topRightMotor(std::move(itopRightMotor)),
+    bottomRightMotor(std::move(ibottomRightMotor)),
+    bottomLeftMotor(std::move(ibottomLeftMotor)),
+    leftSensor(std::move(ileftEnc)),
+    rightSensor(std::move(irightEnc)) {
+}
+
+void XDriveModel::forward(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  topLeftMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  topRightMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  bottomRightMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  bottomLeftMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+}
+
+void XDriveModel::driveVector(const double iforwardSpeed, const double iyaw) {
+  const auto [leftOutput, rightOutput] = vectorOutputs(iforwardSpeed, iyaw);
+  topLeftMotor->moveVelocity(static_cast<int16_t>(leftOutput * maxVelocity));
+  topRightMotor->moveVelocity(static_cast<int16_t>(rightOutput * maxVelocity));
+  bottomRightMotor->moveVelocity(static_cast<int16_t>(rightOutput * maxVelocity));
+  bottomLeftMotor->moveVelocity(static_cast<int16_t>(leftOutput * maxVelocity));
+}
+
+void XDriveModel::driveVectorVoltage(const double iforwardSpeed, const double iyaw) {
+  const auto [leftOutput, rightOutput] = vectorOutputs(iforwardSpeed, iyaw);
+  topLeftMotor->moveVoltage(static_cast<int16_t>(leftOutput * maxVoltage));
+  topRightMotor->moveVoltage(static_cast<int16_t>(rightOutput * maxVoltage));
+  bottomRightMotor->moveVoltage(static_cast<int16_t>(rightOutput * maxVoltage));
+  bottomLeftMotor->moveVoltage(static_cast<int16_t>(leftOutput * maxVoltage));
+}
+
+void XDriveModel::rotate(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  topLeftMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  topRightMotor->moveVelocity(static_cast<int16_t>(-1 * speed * maxVelocity));
+  bottomRightMotor->moveVelocity(static_cast<int16_t>(-1 * speed * maxVelocity));
+  bottomLeftMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+}
+
+void XDriveModel::strafe(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  topLeftMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  topRightMotor->moveVelocity(static_cast<int16_t>(-1 * speed * maxVelocity));
+  bottomRightMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  bottomLeftMotor->moveVelocity(static_cast<int16_t>(-1 * speed * maxVelocity));
+}
+
+void XDriveModel::strafeVector(const double istrafeSpeed, const double iyaw) {
+  const double strafeSpeed = std::clamp(istrafeSpeed, -1.0, 1.0);
+  const double yaw = std::clamp(iyaw, -1.0, 1.0);
+
+  double topLeft = strafeSpeed + yaw;
+  double topRight = -strafeSpeed - yaw;
+  double bottomRight = strafeSpeed - yaw;
+  double bottomLeft = -strafeSpeed + yaw;
+  if (const double maxInputMag = std::max({std::abs(topLeft), std::abs(topRight),
+                                           std::abs(bottomRight), std::abs(bottomLeft)});
+      maxInputMag > 1) {
+    topLeft /= maxInputMag;
+    topRight /= maxInputMag;
+    bottomRight /= maxInputMag;
+    bottomLeft /= maxInputMag;
+  }
+
+  topLeftMotor->moveVelocity(static_cast<int16_t>(topLeft * maxVelocity));
+  topRightMotor->moveVelocity(static_cast<int16_t>(topRight * maxVelocity));
+  bottomRightMotor->moveVelocity(static_cast<int16_t>(bottomRight * maxVelocity));
+  bottomLeftMotor->moveVelocity(static_cast<int16_t>(bottomLeft * maxVelocity));
+}
+
+void XDriveModel::stop() {
+  topLeftMotor->moveVelocity(0);
+  topRightMotor->moveVelocity(0);
+  bottomRightMotor->moveVelocity(0);
+  bottomLeftMotor->moveVelocity(0);
+}
+
+void XDriveModel::tank(const double ileftSpeed, const double irightSpeed, const double ithreshold) {
+  const double leftSpeed = thresholded(ileftSpeed, ithreshold);
+  const double rightSpeed = thresholded(irightSpeed, ithreshold);
+  topLeftMotor->moveVoltage(static_cast<int16_t>(leftSpeed * maxVoltage));
+  topRightMotor->moveVoltage(static_cast<int16_t>(rightSpeed * maxVoltage));
+  bottomRightMotor->moveVoltage(static_cast<int16_t>(rightSpeed * maxVoltage));
+  bottomLeftMotor->moveVoltage(static_cast<int16_t>(leftSpeed * maxVoltage));
+}
+
+void XDriveModel::arcade(const double iforwardSpeed, const double iyaw, const double ithreshold) {
+  const auto [leftOutput, rightOutput] = arcadeOutputs(iforwardSpeed, iyaw, ithreshold);
+  topLeftMotor->moveVoltage(static_cast<int16_t>(leftOutput * maxVoltage));
+  topRightMotor->moveVoltage(static_cast<int16_t>(rightOutput * maxVoltage));
+  bottomRightMotor->moveVoltage(static_cast<int16_t>(rightOutput * maxVoltage));
+  bottomLeftMotor->moveVoltage(static_cast<int16_t>(leftOutput * maxVoltage));
+}
+
+void XDriveModel::xArcade(const double irightSpeed,
+                          const double iforwardSpeed,
+                          const double iyaw,
+                          const double ithreshold) {
+  const double rightSpeed = thresholded(irightSpeed, ithreshold);
+  const double forwardSpeed = thresholded(iforwardSpeed, ithreshold);
+  const double yaw = thresholded(iyaw, ithreshold);
+
+  topLeftMotor->moveVoltage(
+    static_cast<int16_t>(std::clamp(forwardSpeed + rightSpeed + yaw, -1.0, 1.0) * maxVoltage));
+  topRightMotor->moveVoltage(
+    static_cast<int16_t>(std::clamp(forwardSpeed - rightSpeed - yaw, -1.0, 1.0) * maxVoltage));
+  bottomRightMotor->moveVoltage(
+    static_cast<int16_t>(std::clamp(forwardSpeed + rightSpeed - yaw, -1.0, 1.0) * maxVoltage));
+  bottomLeftMotor->moveVoltage(
+    static_cast<int16_t>(std::clamp(forwardSpeed - rightSpeed + yaw, -1.0, 1.0) * maxVoltage));
+}
+
+void XDriveModel::left(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  topLeftMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  bottomLeftMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+}
+
+void XDriveModel::right(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  topRightMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  bottomRightMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+}
+
+std::valarray<std::int32_t> XDriveModel::getSensorVals() const {
+  return std::valarray<std::int32_t>{static_cast<std::int32_t>(leftSensor->get()),
+                                     static_cast<std::int32_t>(rightSensor->get())};
+}
+
+void XDriveModel::resetSensors() {
+  leftSensor->reset();
+  rightSensor->reset();
+}
+
+void XDriveModel::setBrakeMode(const AbstractMotor::brakeMode mode) {
+  topLeftMotor->setBrakeMode(mode);
+  topRightMotor->setBrakeMode(mode);
+  bottomRightMotor->setBrakeMode(mode);
+  bottomLeftMotor->setBrakeMode(mode);
+}
+
+void XDriveModel::setEncoderUnits(const AbstractMotor::encoderUnits units) {
+  topLeftMotor->setEncoderUnits(units);
+  topRightMotor->setEncoderUnits(units);
+  bottomRightMotor->setEncoderUnits(units);
+  bottomLeftMotor->setEncoderUnits(units);
+}
+
+void XDriveModel::setGearing(const AbstractMotor::gearset gearset) {
+  topLeftMotor->setGearing(gearset);
+  topRightMotor->setGearing(gearset);
+  bottomRightMotor->setGearing(gearset);
+  bottomLeftMotor->setGearing(gearset);
+}
+
+void XDriveModel::setMaxVelocity(const double imaxVelocity) {
+  maxVelocity = imaxVelocity < 0 ? 0 : imaxVelocity;
+}
+
+double XDriveModel::getMaxVelocity() const {
+  return maxVelocity;
+}
+
+void XDriveModel::setMaxVoltage(const double imaxVoltage) {
+  maxVoltage = std::clamp(imaxVoltage, 0.0, v5MotorMaxVoltage);
+}
+
+double XDriveModel::getMaxVoltage() const {
+  return maxVoltage;
+}
+
+std::shared_ptr<AbstractMotor> XDriveModel::getTopLeftMotor() const {
+  return topLeftMotor;
+}
+
+std::shared_ptr<AbstractMotor> XDriveModel::getTopRightMotor() const {
+  return topRightMotor;
+}
+
+std::shared_ptr<AbstractMotor> XDriveModel::getBottomRightMotor() const {
+  return bottomRightMotor;
+}
+
+std::shared_ptr<AbstractMotor> XDriveModel::getBottomLeftMotor() const {
+  return bottomLeftMotor;
+}
+
+HDriveModel::HDriveModel(std::shared_ptr<AbstractMotor> ileftSideMotor,
+                         std::shared_ptr<AbstractMotor> irightSideMotor,
+                         std::shared_ptr<AbstractMotor> imiddleMotor,
+                         std::shared_ptr<ContinuousRotarySensor> ileftEnc,
+                         std::shared_ptr<ContinuousRotarySensor> irightEnc,
+                         std::shared_ptr<ContinuousRotarySensor> imiddleEnc,
+                         const double imaxVelocity,
+                         const double imaxVoltage)
+  : maxVelocity(imaxVelocity),
+    maxVoltage(imaxVoltage),
+    leftSideMotor(std::move(ileftSideMotor)),
+    rightSideMotor(std::move(irightSideMotor)),
+    middleMotor(std::move(imiddleMotor)),
+    leftSensor(std::move(ileftEnc)),
+    rightSensor(std::move(irightEnc)),
+    middleSensor(std::move(imiddleEnc)) {
+}
+
+void HDriveModel::forward(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  leftSideMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  rightSideMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  middleMotor->moveVelocity(0);
+}
+
+void HDriveModel::driveVector(const double iforwardSpeed, const double iyaw) {
+  const auto [leftOutput, rightOutput] = vectorOutputs(iforwardSpeed, iyaw);
+  leftSideMotor->moveVelocity(static_cast<int16_t>(leftOutput * maxVelocity));
+  rightSideMotor->moveVelocity(static_cast<int16_t>(rightOutput * maxVelocity));
+  middleMotor->moveVelocity(0);
+}
+
+void HDriveModel::driveVectorVoltage(const double iforwardSpeed, const double iyaw) {
+  const auto [leftOutput, rightOutput] = vectorOutputs(iforwardSpeed, iyaw);
+  leftSideMotor->moveVoltage(static_cast<int16_t>(leftOutput * maxVoltage));
+  rightSideMotor->moveVoltage(static_cast<int16_t>(rightOutput * maxVoltage));
+  middleMotor->moveVoltage(0);
+}
+
+void HDriveModel::rotate(const double ispeed) {
+  const double speed = std::clamp(ispeed, -1.0, 1.0);
+  leftSideMotor->moveVelocity(static_cast<int16_t>(speed * maxVelocity));
+  rightSideMotor->moveVelocity(static_cast<int16_t>(-1 * speed * maxVelocity));
+  middleMotor->moveVelocity(0);
+}
+
+void HDriveModel::stop() {
+  leftSideMotor->moveVelocity(0);
+  rightSideMotor->moveVelocity(0);
+  middleMotor->moveVelocity(0);
+}
+
+void HDriveModel::tank(const double ileftSpeed, const double irightSpeed, const double ithreshold) {
+  leftSideMotor->moveVoltage(
+    static_cast<int16_t>(thresholded(ileftSpeed, ithreshold) * maxVoltage));
+  rightSideMotor->moveVoltage(
+    static_cast<int16_t>(thresholded(irightSpeed, ithreshold) * maxVoltage));
+  middleMotor->moveVoltage(0);
+}
+
+void HDriveModel::arcade(const double iforwardSpeed, const double iyaw, const double ithreshold) {
+  const auto [leftOutput, rightOutput] = arcadeOutputs(iforwardSpeed, iyaw, ithreshold);
+  leftSideMotor->moveVoltage(static_cast<int16_t>(leftOutput * maxVoltage));
+  rightSideMotor->moveVoltage(static_cast<int16_t>(rightOutput * maxVoltage));
+  middleMotor->moveVoltage(0);
+}
+
+void HDriveModel::hArcade(const double irightSpeed,
+                          const double iforwardSpeed,
+                          const double iyaw,
+                          const double ithreshold) {
+  arcade(iforwardSpeed, iyaw, ithreshold);
+  const double rightSpeed = thresholded(irightSpeed, ithreshold);
+  middleMotor->moveVoltage(static_cast<int16_t>(rightSpeed * maxVoltage));
+}
+
+void HDriveModel::left(const double ispeed) {
+  leftSideMotor->moveVelocity(static_cast<int16_t>(std::clamp(ispeed, -1.0, 1.0) * maxVelocity));
+}
+
+void HDriveModel::right(const double ispeed) {
+  rightSideMotor->moveVelocity(static_cast<int16_t>(std::clamp(ispeed, -1.0, 1.0) * maxVelocity));
+}
+
+void HDriveModel::middle(const double ispeed) {
+  middleMotor->moveVelocity(static_cast<int16_t>(std::clamp(ispeed, -1.0, 1.0) * maxVelocity));
+}
+
+std::valarray<std::int32_t> HDriveModel::getSensorVals() const {
+  return std::valarray<std::int32_t>{static_cast<std::int32_t>(leftSensor->get()),
+                                     static_cast<std::int32_t>(rightSensor->get()),
+                                     static_cast<std::int32_t>(middleSensor->get())};
+}
+
+void HDriveModel::resetSensors() {
+  leftSensor->reset();
+  rightSensor->reset();
+  middleSensor->reset();
+}
+
+void HDriveModel::setBrakeMode(const AbstractMotor::brakeMode mode) {
+  leftSideMotor->setBrakeMode(mode);
+  rightSideMotor->setBrakeMode(mode);
+  middleMotor->setBrakeMode(mode);
+}
+
+void HDriveModel::setEncoderUnits(const AbstractMotor::encoderUnits units) {
+  leftSideMotor->setEncoderUnits(units);
+  rightSideMotor->setEncoderUnits(units);
+  middleMotor->setEncoderUnits(units);
+}
+
+void HDriveModel::setGearing(const AbstractMotor::gearset gearset) {
+  leftSideMotor->setGearing(gearset);
+  rightSideMotor->setGearing(gearset);
+  middleMotor->setGearing(gearset);
+}
+
+void HDriveModel::setMaxVelocity(const double imaxVelocity) {
+  maxVelocity = imaxVelocity < 0 ? 0 : imaxVelocity;
+}
+
+double HDriveModel::getMaxVelocity() const {
+  return maxVelocity;
+}
+
+void HDriveModel::setMaxVoltage(const double imaxVoltage) {
+  maxVoltage = std::clamp(imaxVoltage, 0.0, v5MotorMaxVoltage);
+}
+
+double HDriveModel::getMaxVoltage() const {
+  return maxVoltage;
+}
+
+std::shared_ptr<AbstractMotor> HDriveModel::getLeftSideMotor() const {
+  return leftSideMotor;
+}
+
+std::shared_ptr<AbstractMotor> HDriveModel::getRightSideMotor() const {
+  return rightSideMotor;
+}
+
+std::shared_ptr<AbstractMotor> HDriveModel::getMiddleMotor() const {
+  return middleMotor;
+}
+
+OdomChassisController::OdomChassisController(TimeUtil itimeUtil,
+                                             std::shared_ptr<Odometry> iodometry,
+                                             const StateMode &imode,
+                                             const QLength &imoveThreshold,
+                                             const QAngle &iturnThreshold,
+                                             std::shared_ptr<Logger> ilogger)
+  : logger(std::move(ilogger)),
+    timeUtil(std::move(itimeUtil)),
+    moveThreshold(imoveThreshold),
+    turnThreshold(iturnThreshold),
+    odom(std::move(iodometry)),
+    defaultStateMode(imode) {
+}
+
+OdomChassisController::~OdomChassisController() {
+  dtorCalled.store(true, std::memory_order_release);
+  delete odomTask;
+}
+
+void OdomChassisController::loop() {
+  auto rate = timeUtil.getRate();
+  odomTaskRunning = true;
+  while (!dtorCalled.load(std::memory_order_acquire)) {
+    odom->step();
+    rate->delayUntil(10_ms);
+  }
+  odomTaskRunning = false;
+}
+
+void OdomChassisController::trampoline(void *context) {
+  if (context) {
+    static_cast<OdomChassisController *>(context)->loop();
+  }
+}
+
+OdomState OdomChassisController::getState() const {
+  return odom->getState(defaultStateMode);
+}
+
+void OdomChassisController::setState(const OdomState &istate) {
+  odom->setState(istate, defaultStateMode);
+}
+
+void OdomChassisController::setDefaultStateMode(const StateMode &imode) {
+  defaultStateMode = imode;
+}
+
+void OdomChassisController::setMoveThreshold(const QLength &imoveThreshold) {
+  moveThreshold = imoveThreshold;
+}
+
+void OdomChassisController::setTurnThreshold(const QAngle &iturnTreshold) {
+  turnThreshold = iturnTreshold;
+}
+
+QLength OdomChassisController::getMoveThreshold() const {
+  return moveThreshold;
+}
+
+QAngle OdomChassisController::getTurnThreshold() const {
+  return turnThreshold;
+}
+
+void OdomChassisController::startOdomThread() {
+  if (!odomTask) {
+    odomTask = new CrossplatformThread(trampoline, this, "OdomChassisController");
+  }
+}
+
+CrossplatformThread *OdomChassisController::getOdomThread() const {
+  return odomTask;
+}
+
+std::shared_ptr<Odometry> OdomChassisController::getOdometry() {
+  return odom;
+}
+} // namespace okapi
+
+#ifdef HOST_TEST_PATHFINDER
+namespace okapi {
+AsyncMotionProfileController::AsyncMotionProfileController(
+  const TimeUtil &itimeUtil,
+  const PathfinderLimits &ilimits,
+  const std::shared_ptr<ChassisModel> &imodel,
+  const ChassisScales &iscales,
+  const AbstractMotor::GearsetRatioPair &ipair,
+  const std::shared_ptr<Logger> &ilogger)
+  : logger(ilogger),
+    limits(ilimits),
+    model(imodel),
+    scales(iscales),
+    pair(ipair),
+    timeUtil(itimeUtil) {
+  if (ipair.ratio == 0) {
+    throw std::invalid_argument("AsyncMotionProfileController: The gear ratio cannot be zero!");
+  }
+}
+
+AsyncMotionProfileController::~AsyncMotionProfileController() {
+  dtorCalled.store(true, std::memory_order_release);
+  delete task;
+}
+
+bool AsyncMotionProfileController::removePath(const std::string &ipathId) {
+  if (!isDisabled() && isRunning.load(std::memory_order_acquire) && getTarget() == ipathId) {
+    return false;
+  }
+
+  std::scoped_lock lock(currentPathMutex);
+  paths.erase(ipathId);
+  return true;
+}
+
+std::vector<std::string> AsyncMotionProfileController::getPaths() {
+  std::vector<std::string> names;
+  for (const auto &path : paths) {
+    names.push_back(path.first);
+  }
+  return names;
+}
+
+void AsyncMotionProfileController::setTarget(std::string ipathId) {
+  setTarget(std::move(ipathId), false, false);
+}
+
+void AsyncMotionProfileController::setTarget(std::string ipathId,
+                                             const bool ibackwards,
+                                             const bool imirrored) {
+  std::scoped_lock lock(currentPathMutex);
+  currentPath = ipathId;
+  direction.store(boolToSign(!ibackwards), std::memory_order_release);
+  mirrored.store(imirrored, std::memory_order_release);
+  isRunning.store(true, std::memory_order_release);
+}
+
+void AsyncMotionProfileController::controllerSet(std::string ivalue) {
+  setTarget(std::move(ivalue));
+}
+
+std::string AsyncMotionProfileController::getTarget() {
+  std::scoped_lock lock(currentPathMutex);
+  return currentPath;
+}
+
+std::string AsyncMotionProfileController::getProcessValue() const {
+  return currentPath;
+}
+
+void AsyncMotionProfileController::waitUntilSettled() {
+  auto rate = timeUtil.getRate();
+  while (!isSettled()) {
+    rate->delayUntil(10_ms);
+  }
+}
+
+PathfinderPoint AsyncMotionProfileController::getError() const {
+  return PathfinderPoint{0_m, 0_m, 0_deg};
+}
+
+bool AsyncMotionProfileController::isSettled() {
+  return isDisabled() || !isRunning.load(std::memory_order_acquire);
+}
+
+void AsyncMotionProfileController::reset() {
+  // interrupts executeSinglePath() by disabling the controller
+  flipDisable(true);
+  auto rate = timeUtil.getRate();
+  while (isRunning.load(std::memory_order_acquire)) {
+    rate->delayUntil(1_ms);
+  }
+  flipDisable(false);
+}
+
+void AsyncMotionProfileController::flipDisable() {
+  flipDisable(!disabled.load(std::memory_order_acquire));
+}
+
+void AsyncMotionProfileController::flipDisable(const bool iisDisabled) {
+  disabled.store(iisDisabled, std::memory_order_release);
+}
+
+bool AsyncMotionProfileController::isDisabled() const {
+  return disabled.load(std::memory_order_acquire);
+}
+
+void AsyncMotionProfileController::tarePosition() {
+}
+
+void AsyncMotionProfileController::setMaxVelocity(std::int32_t) {
+}
+
+void AsyncMotionProfileController::startThread() {
+  if (!task) {
+    task = new CrossplatformThread(trampoline, this, "AsyncMotionProfileController");
+  }
+}
+
+CrossplatformThread *AsyncMotionProfileController::getThread() const {
+  return task;
+}
+
+void AsyncMotionProfileController::trampoline(void *context) {
+  if (context) {
+    static_cast<AsyncMotionProfileController *>(context)->loop();
+  }
+}
+
+void AsyncMotionProfileController::loop() {
+  auto rate = timeUtil.getRate();
+  while (!dtorCalled.load(std::memory_order_acquire) && !task->notifyTake(0)) {
+    if (isRunning.load(std::memory_order_acquire) && !isDisabled()) {
+      auto path = paths.find(getTarget());
+      if (path != paths.end()) {
+        executeSinglePath(path->second, timeUtil.getRate());
+        model->stop();
+      }
+      isRunning.store(false, std::memory_order_release);
+    }
+    rate->delayUntil(10_ms);
+  }
+}
+
+void AsyncMotionProfileController::executeSinglePath(const TrajectoryPair &path,
+                                                     std::unique_ptr<AbstractRate> rate) {
+  const auto reversed = direction.load(std::memory_order_acquire);
+  const bool followMirrored = mirrored.load(std::memory_order_acquire);
+  const int pathLength = getPathLength(path);
+
+  for (int i = 0; i < pathLength && !isDisabled(); ++i) {
+    std::scoped_lock lock(currentPathMutex);
+
+    const auto segDT = path.left.get()[i].dt * second;
+    const auto leftRPM = convertLinearToRotational(path.left.get()[i].velocity * mps).convert(rpm);
+    const auto rightRPM =
+      convertLinearToRotational(path.right.get()[i].velocity * mps).convert(rpm);
+
+    const double rightSpeed = rightRPM / toUnderlyingType(pair.internalGearset) * reversed;
+    const double leftSpeed = leftRPM / toUnderlyingType(pair.internalGearset) * reversed;
+    if (followMirrored) {
+      model->left(rightSpeed);
+      model->right(leftSpeed);
+    } else {
+      model->left(leftSpeed);
+      model->right(rightSpeed);
+    }
+
+    rate->delayUntil(segDT);
+  }
+}
+
+QAngularSpeed AsyncMotionProfileController::convertLinearToRotational(const QSpeed linear) const {
+  return (linear * (360_deg / (scales.wheelDiameter * 1_pi))) * pair.ratio;
+}
+
+std::string AsyncMotionProfileController::makeFilePath(const std::string &directory,
+                                                       const std::string &filename) {
+  std::string path(directory);
+
+  // paths are on the SD card
+  if (path.find("/usd") != 0) {
+    if (path.find("usd") != 0) {
+      path = path.find('/') == 0 ? "/usd" + path : "/usd/" + path;
+    } else {
+      path = "/" + path;
+    }
+  }
+
+  if (path.find_last_of('/') != path.length() - 1) {
+    path.append("/");
+  }
+
+  std::string cleanFilename(filename);
+  cleanFilename.erase(std::remove(cleanFilename.begin(), cleanFilename.end(), '/'),
+                      cleanFilename.end());
+  return path + cleanFilename;
+}
+
+void AsyncMotionProfileController::storePath(const std::string &idirectory,
+                                             const std::string &ipathId) {
+  const std::string leftFilePath = makeFilePath(idirectory, ipathId + ".left.csv");
+  const std::string rightFilePath = makeFilePath(idirectory, ipathId + ".right.csv");
+  FILE *leftPathFile = fopen(leftFilePath.c_str(), "w");
+  FILE *rightPathFile = fopen(rightFilePath.c_str(), "w");
+
+  if (leftPathFile != nullptr && rightPathFile != nullptr) {
+    internalStorePath(leftPathFile, rightPathFile, ipathId);
+  }
+
+  if (leftPathFile != nullptr) {
+    fclose(leftPathFile);
+  }
+  if (rightPathFile != nullptr) {
+    fclose(rightPathFile);
+  }
+}
+
+void AsyncMotionProfileController::loadPath(const std::string &idirectory,
+                                            const std::string &ipathId) {
+  const std::string leftFilePath = makeFilePath(idirectory, ipathId + ".left.csv");
+  const std::string rightFilePath = makeFilePath(idirectory, ipathId + ".right.csv");
+  FILE *leftPathFile = fopen(leftFilePath.c_str(), "r");
+  FILE *rightPathFile = fopen(rightFilePath.c_str(), "r");
+
+  if (leftPathFile != nullptr && rightPathFile != nullptr) {
+    internalLoadPath(leftPathFile, rightPathFile, ipathId);
+  }
+
+  if (leftPathFile != nullptr) {
+    fclose(leftPathFile);
+  }
+  if (rightPathFile != nullptr) {
+    fclose(rightPathFile);
+  }
+}
+
+void AsyncMotionProfileController::internalStorePath(FILE *leftPathFile,
+                                                     FILE *rightPathFile,
+                                                     const std::string &ipathId) {
+  auto pathData = paths.find(ipathId);
+  if (pathData != paths.end()) {
+    const int len = pathData->second.length;
+    pathfinder_serialize_csv(leftPathFile, pathData->second.left.get(), len);
+    pathfinder_serialize_csv(rightPathFile, pathData->second.right.get(), len);
+  }
+}
+
+void AsyncMotionProfileController::internalLoadPath(FILE *leftPathFile,
+                                                    FILE *rightPathFile,
+                                                    const std::string &ipathId) {
+  // one segment per line after the header
+  int count = 0;
+  for (int c = getc(leftPathFile); c != EOF; c = getc(leftPathFile)) {
+    if (c == '\n') {
+      ++count;
+    }
+  }
+  --count;
+  rewind(leftPathFile);
+
+  SegmentPtr leftTrajectory(static_cast<Segment *>(malloc(sizeof(Segment) * count)), free);
+  SegmentPtr rightTrajectory(static_cast<Segment *>(malloc(sizeof(Segment) * count)), free);
+  pathfinder_deserialize_csv(leftPathFile, leftTrajectory.get());
+  pathfinder_deserialize_csv(rightPathFile, rightTrajectory.get());
+
+  forceRemovePath(ipathId);
+  paths.emplace(ipathId,
+                TrajectoryPair{std::move(leftTrajectory), std::move(rightTrajectory), count});
+}
+
+void AsyncMotionProfileController::forceRemovePath(const std::string &ipathId) {
+  if (!removePath(ipathId)) {
+    // a running path can only be removed from a disabled controller
+    flipDisable(true);
+    removePath(ipathId);
+  }
+}
+
+int AsyncMotionProfileController::getPathLength(const TrajectoryPair &path) {
+  return path.length;
+}
+
+AsyncLinearMotionProfileController::AsyncLinearMotionProfileController(
+  const TimeUtil &itimeUtil,
+  const PathfinderLimits &ilimits,
+  const std::shared_ptr<ControllerOutput<double>> &ioutput,
+  const QLength &idiameter,
+  const AbstractMotor::GearsetRatioPair &ipair,
+  const std::shared_ptr<Logger> &ilogger)
+  : logger(ilogger),
+    limits(ilimits),
+    output(ioutput),
+    diameter(idiameter),
+    pair(ipair),
+    timeUtil(itimeUtil) {
+  if (ipair.ratio == 0) {
+    throw std::invalid_argument(
+      "AsyncLinearMotionProfileController: The gear ratio cannot be zero!");
+  }
+}
+
+AsyncLinearMotionProfileController::~AsyncLinearMotionProfileController() {
+  dtorCalled.store(true, std::memory_order_release);
+  delete task;
+}
+
+void AsyncLinearMotionProfileController::generatePath(std::initializer_list<QLength> iwaypoints,
+                                                      const std::string &ipathId) {
+  generatePath(iwaypoints, ipathId, limits);
+}
+
+void AsyncLinearMotionProfileController::generatePath(std::initializer_list<QLength> iwaypoints,
+                                                      const std::string &ipathId,
+                                                      const PathfinderLimits &ilimits) {
+  if (iwaypoints.size() == 0) {
+    // no point in generating a path
+    return;
+  }
+
+  std::vector<Waypoint> points;
+  points.reserve(iwaypoints.size());
+  for (auto &point : iwaypoints) {
+    points.push_back(Waypoint{point.convert(meter), 0, 0});
+  }
+
+  TrajectoryCandidate candidate;
+  pathfinder_prepare(points.data(), static_cast<int>(points.size()), FIT_HERMITE_CUBIC,
+                     PATHFINDER_SAMPLES_FAST, 0.010, ilimits.maxVel, ilimits.maxAccel,
+                     ilimits.maxJerk, &candidate);
+
+  const int length = candidate.length;
+  if (length < 0) {
+    free(candidate.laptr);
+    free(candidate.saptr);
+    throw std::runtime_error(getPathErrorMessage(points, ipathId, length));
+  }
+
+  SegmentPtr trajectory(static_cast<Segment *>(malloc(length * sizeof(Segment))), free);
+  if (trajectory == nullptr) {
+    throw std::runtime_error(
+      "AsyncLinearMotionProfileController: Could not allocate trajectory for path " + ipathId);
+  }
+
+  // frees the candidate's splines
+  pathfinder_generate(&candidate, trajectory.get());
+
+  // free the old path before overwriting it
+  forceRemovePath(ipathId);
+  paths.emplace(ipathId, TrajectoryPair{std::move(trajectory), length});
+}
+
+bool AsyncLinearMotionProfileController::removePath(const std::string &ipathId) {
+  if (!isDisabled() && isRunning.load(std::memory_order_acquire) && getTarget() == ipathId) {
+    return false;
+  }
+
+  std::scoped_lock lock(currentPathMutex);
+  paths.erase(ipathId);
+  return true;
+}
+
+std::vector<std::string> AsyncLinearMotionProfileController::getPaths() {
+  std::vector<std::string> names;
+  for (const auto &path : paths) {
+    names.push_back(path.first);
+  }
+  return names;
+}
+
+void AsyncLinearMotionProfileController::setTarget(std::string ipathId) {
+  setTarget(std::move(ipathId), false);
+}
+
+void AsyncLinearMotionProfileController::setTarget(std::string ipathId, const bool ibackwards) {
+  std::scoped_lock lock(currentPathMutex);
+  currentPath = ipathId;
+  direction.store(boolToSign(!ibackwards), std::memory_order_release);
+  isRunning.store(true, std::memory_order_release);
+}
+
+void AsyncLinearMotionProfileController::controllerSet(std::string ivalue) {
+  setTarget(std::move(ivalue));
+}
+
+std::string AsyncLinearMotionProfileController::getTarget() {
+  std::scoped_lock lock(currentPathMutex);
+  return currentPath;
+}
+
+std::string AsyncLinearMotionProfileController::getTarget() const {
+  return currentPath;
+}
+
+std::string AsyncLinearMotionProfileController::getProcessValue() const {
+  return currentPath;
+}
+
+void AsyncLinearMotionProfileController::waitUntilSettled() {
+  auto rate = timeUtil.getRate();
+  while (!isSettled()) {
+    rate->delayUntil(10_ms);
+  }
+}
+
+double AsyncLinearMotionProfileController::getError() const {
+  return 0;
+}
+
+bool AsyncLinearMotionProfileController::isSettled() {
+  return isDisabled() || !isRunning.load(std::memory_order_acquire);
+}
+
+void AsyncLinearMotionProfileController::reset() {
+  // interrupts executeSinglePath() by disabling the controller
+  flipDisable(true);
+  auto rate = timeUtil.getRate();
+  while (isRunning.load(std::memory_order_acquire)) {
+    rate->delayUntil(1_ms);
+  }
+  flipDisable(false);
+}
+
+void AsyncLinearMotionProfileController::flipDisable() {
+  flipDisable(!disabled.load(std::memory_order_acquire));
+}
+
+void AsyncLinearMotionProfileController::flipDisable(const bool iisDisabled) {
+  disabled.store(iisDisabled, std::memory_order_release);
+}
+
+bool AsyncLinearMotionProfileController::isDisabled() const {
+  return disabled.load(std::memory_order_acquire);
+}
+
+void AsyncLinearMotionProfileController::tarePosition() {
+}
+
+void AsyncLinearMotionProfileController::setMaxVelocity(std::int32_t) {
+}
+
+void AsyncLinearMotionProfileController::startThread() {
+  if (!task) {
+    task = new CrossplatformThread(trampoline, this, "AsyncLinearMotionProfileController");
+  }
+}
+
+CrossplatformThread *AsyncLinearMotionProfileController::getThread() const {
+  return task;
+}
+
+void AsyncLinearMotionProfileController::trampoline(void *context) {
+  if (context) {
+    static_cast<AsyncLinearMotionProfileController *>(context)->loop();
+  }
+}
+
+void AsyncLinearMotionProfileController::loop() {
+  auto rate = timeUtil.getRate();
+  while (!dtorCalled.load(std::memory_order_acquire) && !task->notifyTake(0)) {
+    if (isRunning.load(std::memory_order_acquire) && !isDisabled()) {
+      auto path = paths.find(getTarget());
+      if (path != paths.end()) {
+        executeSinglePath(path->second, timeUtil.getRate());
+        output->controllerSet(0);
+      }
+      isRunning.store(false, std::memory_order_release);
+    }
+    rate->delayUntil(10_ms);
+  }
+}
+
+void AsyncLinearMotionProfileController::executeSinglePath(const TrajectoryPair &path,
+                                                           std::unique_ptr<AbstractRate> rate) {
+  const auto reversed = direction.load(std::memory_order_acquire);
+  const int pathLength = getPathLength(path);
+
+  for (int i = 0; i < pathLength && !isDisabled(); ++i) {
+    currentProfilePosition = path.segment.get()[i].position;
+
+    const auto segDT = path.segment.get()[i].dt * second;
+    const auto segRPM =
+      convertLinearToRotational(path.segment.get()[i].velocity * mps).convert(rpm);
+    output->controllerSet(segRPM / toUnderlyingType(pair.internalGearset) * reversed);
+
+    rate->delayUntil(segDT);
+  }
+}
+
+QAngularSpeed
+AsyncLinearMotionProfileController::convertLinearToRotational(const QSpeed linear) const {
+  return (linear * (360_deg / (diameter * 1_pi))) * pair.ratio;
+}
+
+std::string
+AsyncLinearMotionProfileController::getPathErrorMessage(const std::vector<Waypoint> &points,
+                                                        const std::string &ipathId,
+                                                        const int length) {
+  std::string pointsString = "{";
+  for (const auto &point : points) {
+    pointsString += "{" + std::to_string(point.x) + "}, ";
+  }
+  pointsString += "}";
+
+  return "AsyncLinearMotionProfileController: Path " + ipathId + " is impossible with " +
+         pointsString + ", pathfinder length " + std::to_string(length);
+}
+
+void AsyncLinearMotionProfileController::forceRemovePath(const std::string &ipathId) {
+  if (!removePath(ipathId)) {
+    // a running path can only be removed from a disabled controller
+    flipDisable(true);
+    removePath(ipathId);
+  }
+}
+
+int AsyncLinearMotionProfileController::getPathLength(const TrajectoryPair &path) {
+  std::scoped_lock lock(currentPathMutex);
+  return path.length;
+}
+} // namespace okapi
+#endif
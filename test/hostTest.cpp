@@ -0,0 +1,261 @@
+// ------- hostTest.cpp --------------------------------------------------------
+//
+// Runs the host tests registered with HOST_TEST() / HOST_BENCH(), see
+// hostTest.h. Exits with 1 if any check failed.
+//
+// Usage:
+//   hostTest [--bench] [--update] [name...]
+//     --bench   also run the benchmarks
+//     --update  write the golden files in test/golden instead of comparing
+//     name      only run the tests whose name contains one of these
+
+#include "hostTest.h"
+
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+
+namespace {
+struct HostTest {
+  const char *name;
+  HostTestFunction function;
+  bool bench;
+};
+
+struct HostSkip {
+  const char *name;
+  const char *reason;
+};
+
+// function local so registration from other files' static initializers finds it constructed
+std::vector<HostTest> &hostTests() {
+  static std::vector<HostTest> tests;
+  return tests;
+}
+
+std::vector<HostSkip> &hostSkips() {
+  static std::vector<HostSkip> skips;
+  return skips;
+}
+
+bool selected(const char *iname, const std::vector<const char *> &ifilters) {
+  bool match = ifilters.empty();
+  for (const char *filter : ifilters) {
+    match = match || std::strstr(iname, filter) != nullptr;
+  }
+  return match;
+}
+
+std::atomic<std::uint64_t> allocations{0};
+int failedChecks = 0;
+bool updateGolden = false;
+} // namespace
+
+// every allocation of the test binary goes through here, so hostAllocations() sees them
+void *operator new(std::size_t isize) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(isize == 0 ? 1 : isize)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t isize) {
+  return operator new(isize);
+}
+
+void *operator new(std::size_t isize, const std::nothrow_t &) noexcept {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(isize == 0 ? 1 : isize);
+}
+
+void *operator new[](std::size_t isize, const std::nothrow_t &) noexcept {
+  return operator new(isize, std::nothrow);
+}
+
+void operator delete(void *ip) noexcept {
+  std::free(ip);
+}
+
+void operator delete[](void *ip) noexcept {
+  std::free(ip);
+}
+
+void operator delete(void *ip, std::size_t) noexcept {
+  std::free(ip);
+}
+
+void operator delete[](void *ip, std::size_t) noexcept {
+  std::free(ip);
+}
+
+bool registerHostTest(const char *iname, const HostTestFunction ifunction, const bool ibench) {
+  hostTests().push_back(HostTest{iname, ifunction, ibench});
+  return true;
+}
+
+bool registerHostSkip(const char *iname, const char *ireason) {
+  hostSkips().push_back(HostSkip{iname, ireason});
+  return true;
+}
+
+void hostCheckFailed(const char *ifile, const int iline, const std::string &imessage) {
+  std::printf("    FAILED %s:%d: %s\n", ifile, iline, imessage.c_str());
+  failedChecks++;
+}
+
+void hostReport(const char *iformat, ...) {
+  std::va_list args;
+  va_start(args, iformat);
+  std::printf("    ");
+  std::vprintf(iformat, args);
+  std::printf("\n");
+  va_end(args);
+}
+
+std::uint64_t hostAllocations() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t hostNanos() {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now().time_since_epoch())
+                                      .count());
+}
+
+bool hostReadCsv(const std::string &ipath, std::vector<std::vector<double>> &orows) {
+  std::ifstream in(ipath);
+  if (!in) {
+    return false;
+  }
+
+  orows.clear();
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || !(std::isdigit(static_cast<unsigned char>(line[0])) || line[0] == '-')) {
+      continue;
+    }
+    std::vector<double> row;
+    std::istringstream fields(line);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+      row.push_back(std::strtod(field.c_str(), nullptr));
+    }
+    orows.push_back(std::move(row));
+  }
+  return true;
+}
+
+void hostGolden(const char *iname,
+                const char *iheader,
+                const std::vector<std::vector<double>> &irows,
+                const double itolerance) {
+  const std::string path = std::string(HOST_GOLDEN_DIR) + "/" + iname;
+
+  if (updateGolden) {
+    FILE *out = std::fopen(path.c_str(), "w");
+    if (out == nullptr) {
+      hostCheckFailed(__FILE__, __LINE__, "could not write " + path);
+      return;
+    }
+    std::fprintf(out, "%s\n", iheader);
+    for (const auto &row : irows) {
+      for (std::size_t i = 0; i < row.size(); i++) {
+        std::fprintf(out, i == 0 ? "%.9g" : ",%.9g", row[i]);
+      }
+      std::fprintf(out, "\n");
+    }
+    std::fclose(out);
+    hostReport("wrote %s", path.c_str());
+    return;
+  }
+
+  std::vector<std::vector<double>> golden;
+  if (!hostReadCsv(path, golden)) {
+    hostCheckFailed(__FILE__, __LINE__, "could not read " + path + ", run hostTest --update");
+    return;
+  }
+  if (golden.size() != irows.size()) {
+    hostCheckFailed(__FILE__, __LINE__,
+                    path + " has " + std::to_string(golden.size()) + " rows, expected " +
+                      std::to_string(irows.size()));
+    return;
+  }
+
+  double worst = 0;
+  std::size_t worstRow = 0;
+  for (std::size_t r = 0; r < irows.size(); r++) {
+    if (golden[r].size() != irows[r].size()) {
+      hostCheckFailed(__FILE__, __LINE__, path + " row " + std::to_string(r + 1) + " differs");
+      return;
+    }
+    for (std::size_t i = 0; i < irows[r].size(); i++) {
+      const double diff = std::abs(golden[r][i] - irows[r][i]);
+      if (!(diff <= worst)) {
+        worst = diff;
+        worstRow = r;
+      }
+    }
+  }
+  if (!(worst <= itolerance)) {
+    hostCheckFailed(__FILE__, __LINE__,
+                    path + " row " + std::to_string(worstRow + 1) + " is off by " +
+                      std::to_string(worst));
+  }
+}
+
+int main(int argc, char **argv) {
+  bool bench = false;
+  std::vector<const char *> filters;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--bench") == 0) {
+      bench = true;
+    } else if (std::strcmp(argv[i], "--update") == 0) {
+      updateGolden = true;
+    } else {
+      filters.push_back(argv[i]);
+    }
+  }
+
+  int run = 0;
+  int failed = 0;
+  for (const auto &test : hostTests()) {
+    if (test.bench && !bench) {
+      continue;
+    }
+    if (!selected(test.name, filters)) {
+      continue;
+    }
+
+    std::printf("%s\n", test.name);
+    std::fflush(stdout);
+    const int failedBefore = failedChecks;
+    test.function();
+    run++;
+    if (failedChecks != failedBefore) {
+      failed++;
+    }
+  }
+
+  int skipped = 0;
+  for (const auto &skip : hostSkips()) {
+    if (selected(skip.name, filters)) {
+      std::printf("%s skipped (%s)\n", skip.name, skip.reason);
+      skipped++;
+    }
+  }
+
+  if (skipped > 0) {
+    std::printf("%d of %d tests passed, %d test files skipped\n", run - failed, run, skipped);
+  } else {
+    std::printf("%d of %d tests passed\n", run - failed, run);
+  }
+  return failed == 0 ? 0 : 1;
+}
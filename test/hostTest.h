@@ -0,0 +1,138 @@
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+// ------- hostTest.h ----------------------------------------------------------
+//
+// Minimal regression test and benchmark harness for the PROS independent parts
+// of the project, built for the PC by "make test" (see the Makefile). No test
+// framework is needed: every test is a function registered with HOST_TEST()
+// and run by hostTest.cpp, which also counts heap allocations so a test can
+// check that a loop allocates nothing.
+//
+// The okapilib functions the tested sources call are stood in for by
+// hostOkapi.cpp. Its timers run on the simulated clock hostMicros, which only
+// moves when a test moves it.
+//
+// Results which are not pass/fail (pose error, time per call, allocations)
+// are printed with hostReport(). Tests comparing against a recorded result
+// read it from test/golden with hostGolden(); "bin/hostTest --update" writes
+// the current results there instead.
+
+#include "okapi/api/util/timeUtil.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define HOST_GOLDEN_DIR "test/golden"
+
+using HostTestFunction = void (*)();
+
+/**
+ * Registers a test, used by HOST_TEST() and HOST_BENCH().
+ *
+ * @param iname The test name.
+ * @param ifunction The test.
+ * @param ibench Whether it is a benchmark, only run with --bench.
+ * @return Always true.
+ */
+bool registerHostTest(const char *iname, HostTestFunction ifunction, bool ibench);
+
+/**
+ * Registers a test file left out of the build, used by HOST_SKIP().
+ *
+ * @param iname The name listed as skipped.
+ * @param ireason Why it was left out.
+ * @return Always true.
+ */
+bool registerHostSkip(const char *iname, const char *ireason);
+
+/**
+ * Records a failed check, used by the HOST_CHECK macros.
+ */
+void hostCheckFailed(const char *ifile, int iline, const std::string &imessage);
+
+#define HOST_TEST_REGISTER(name, bench)                                                          \
+  static void name();                                                                            \
+  static const bool name##Registered = registerHostTest(#name, name, bench);                     \
+  static void name()
+
+// a regression test, run by "make test"
+#define HOST_TEST(name) HOST_TEST_REGISTER(name, false)
+// a benchmark, run by "make bench" together with the tests
+#define HOST_BENCH(name) HOST_TEST_REGISTER(name, true)
+// the tests of a file its dependencies were missing for, listed as skipped so they are not
+// silently missing from the results
+#define HOST_SKIP(name, reason)                                                                  \
+  static const bool name##Skipped = registerHostSkip(#name, reason)
+
+#define HOST_CHECK(condition)                                                                    \
+  do {                                                                                           \
+    if (!(condition)) {                                                                          \
+      hostCheckFailed(__FILE__, __LINE__, #condition);                                           \
+    }                                                                                            \
+  } while (0)
+
+#define HOST_CHECK_NEAR(actual, expected, tolerance)                                             \
+  do {                                                                                           \
+    const double hostActual = (actual);                                                          \
+    const double hostExpected = (expected);                                                      \
+    if (!(std::abs(hostActual - hostExpected) <= (tolerance))) {                                 \
+      hostCheckFailed(__FILE__, __LINE__,                                                        \
+                      #actual " = " + std::to_string(hostActual) + ", expected " +               \
+                        std::to_string(hostExpected));                                           \
+    }                                                                                            \
+  } while (0)
+
+/**
+ * Prints one result line of the running test, printf style.
+ */
+void hostReport(const char *iformat, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @return The number of operator new calls so far.
+ */
+std::uint64_t hostAllocations();
+
+/**
+ * @return A monotonic wall clock in ns, for timing.
+ */
+std::uint64_t hostNanos();
+
+/**
+ * The simulated clock of the timers hostTimeUtil() hands out, in us. Starts at 0.
+ */
+extern std::uint64_t hostMicros;
+
+/**
+ * @return A TimeUtil whose timers read hostMicros and whose rates do not sleep.
+ */
+okapi::TimeUtil hostTimeUtil();
+
+/**
+ * Reads a CSV file, skipping '#' comment lines and lines which do not start with a number (the
+ * column header).
+ *
+ * @param ipath The file.
+ * @param orows The rows, one vector of numbers each.
+ * @return false if the file could not be opened.
+ */
+bool hostReadCsv(const std::string &ipath, std::vector<std::vector<double>> &orows);
+
+/**
+ * Compares results with their golden copy in HOST_GOLDEN_DIR, or writes them there with --update.
+ * Fails the test when a value differs by more than itolerance or the row counts differ.
+ *
+ * @param iname The golden file name.
+ * @param iheader The CSV column header.
+ * @param irows The results.
+ * @param itolerance The allowed absolute difference.
+ */
+void hostGolden(const char *iname,
+                const char *iheader,
+                const std::vector<std::vector<double>> &irows,
+                double itolerance);
+
+#endif
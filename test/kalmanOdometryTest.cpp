@@ -0,0 +1,260 @@
+// ------- kalmanOdometryTest.cpp ----------------------------------------------
+//
+// Host test and benchmark of KalmanOdometry against the tracking wheel only
+// HighRateOdometry and the complementary filter of ImuFusedOdometry, on a
+// simulated drive with the errors the Kalman filter is there for: a track
+// width 1% off, tracking wheel glitches, drive wheels which slip and an IMU
+// with noise and drift. Every odometry reads the same simulated sensors.
+
+#include "hostTest.h"
+
+#include "imuFusedOdometry.h"
+#include "kalmanOdometry.h"
+#include "trackingWheelModel.h"
+
+#include <random>
+
+#define KALMAN_TEST_RUNS 20
+#define KALMAN_TEST_SECONDS 30.0
+#define KALMAN_TEST_TRACKING_DIAMETER 0.06985 // m
+#define KALMAN_TEST_TRACKING_TRACK 0.2450     // m, the real one
+#define KALMAN_TEST_TRACKING_SCALE 0.2475     // m, what the odometry is told, 1% off
+#define KALMAN_TEST_MOTOR_DIAMETER 0.1016     // m
+#define KALMAN_TEST_MOTOR_TRACK 0.41          // m, the real one, skidding makes it wider
+#define KALMAN_TEST_MOTOR_SCALE 0.375         // m
+#define KALMAN_TEST_MOTOR_TPR 900.0           // green cartridge
+#define KALMAN_TEST_SLIP 0.03                 // relative drive wheel slip per ms
+#define KALMAN_TEST_GLITCHES 3                // 60 tick jumps of the left tracking wheel
+#define KALMAN_TEST_IMU_NOISE 0.1             // deg
+#define KALMAN_TEST_IMU_DRIFT 0.3             // deg/min
+#define KALMAN_TEST_BENCH_STEPS 200000
+
+namespace {
+/**
+ * Encoder or IMU whose reading the simulation sets.
+ */
+class SimSensor : public okapi::ContinuousRotarySensor {
+  public:
+  double value{0};
+
+  double get() const override {
+    return value;
+  }
+
+  std::int32_t reset() override {
+    value = 0;
+    return 1;
+  }
+
+  double controllerGet() override {
+    return get();
+  }
+};
+
+struct SimSensors {
+  std::shared_ptr<SimSensor> trackingLeft = std::make_shared<SimSensor>();
+  std::shared_ptr<SimSensor> trackingRight = std::make_shared<SimSensor>();
+  std::shared_ptr<SimSensor> motorLeft = std::make_shared<SimSensor>();
+  std::shared_ptr<SimSensor> motorRight = std::make_shared<SimSensor>();
+  std::shared_ptr<SimSensor> imu = std::make_shared<SimSensor>();
+  std::shared_ptr<TrackingWheelModel> tracking =
+    std::make_shared<TrackingWheelModel>(trackingLeft, trackingRight);
+  std::shared_ptr<TrackingWheelModel> motors =
+    std::make_shared<TrackingWheelModel>(motorLeft, motorRight);
+};
+
+okapi::ChassisScales trackingScales() {
+  return okapi::ChassisScales({KALMAN_TEST_TRACKING_DIAMETER * okapi::meter,
+                               KALMAN_TEST_TRACKING_SCALE * okapi::meter},
+                              okapi::quadEncoderTPR);
+}
+
+okapi::ChassisScales motorScales() {
+  return okapi::ChassisScales({KALMAN_TEST_MOTOR_DIAMETER * okapi::meter,
+                               KALMAN_TEST_MOTOR_SCALE * okapi::meter},
+                              KALMAN_TEST_MOTOR_TPR);
+}
+
+enum class Estimator { wheels, imuFused, kalmanImu, kalmanMotors, kalmanAll };
+constexpr int estimatorCount = 5;
+const char *const estimatorNames[] = {"HighRateOdometry", "ImuFusedOdometry", "Kalman wheels+IMU",
+                                      "Kalman wheels+motors", "Kalman all three"};
+
+std::shared_ptr<HighRateOdometry> makeOdometry(const Estimator iestimator,
+                                               const SimSensors &isensors) {
+  switch (iestimator) {
+  case Estimator::wheels:
+    return std::make_shared<HighRateOdometry>(hostTimeUtil(), isensors.tracking, trackingScales());
+  case Estimator::imuFused:
+    return std::make_shared<ImuFusedOdometry>(hostTimeUtil(), isensors.tracking, isensors.imu,
+                                              trackingScales());
+  case Estimator::kalmanImu:
+    return std::make_shared<KalmanOdometry>(hostTimeUtil(), isensors.tracking, trackingScales(),
+                                            nullptr, motorScales(), isensors.imu);
+  case Estimator::kalmanMotors:
+    return std::make_shared<KalmanOdometry>(hostTimeUtil(), isensors.tracking, trackingScales(),
+                                            isensors.motors, motorScales(), nullptr);
+  case Estimator::kalmanAll:
+    return std::make_shared<KalmanOdometry>(hostTimeUtil(), isensors.tracking, trackingScales(),
+                                            isensors.motors, motorScales(), isensors.imu);
+  }
+  return nullptr;
+}
+
+/**
+ * Squared errors against the true motion, added up over all samples of all runs.
+ */
+struct EstimatorError {
+  double position{0};                 // m^2
+  double heading{0};                  // rad^2
+  double speed{0};                    // (m/s)^2
+  double finalPosition{0};            // m, added up over the runs
+  double maxPosition{0};              // m
+};
+
+/**
+ * Drives a random weaving path and steps every estimator on the same sensor readings.
+ *
+ * @param iseed The random seed of the run.
+ * @param oerrors The errors of every estimator are added to these.
+ * @return The number of samples.
+ */
+int simulateRun(const unsigned iseed, std::array<EstimatorError, estimatorCount> &oerrors) {
+  std::mt19937 generator(iseed);
+  std::normal_distribution<double> gauss(0, 1);
+  std::uniform_real_distribution<double> uniform(0, 1);
+
+  SimSensors sensors;
+  std::array<std::shared_ptr<HighRateOdometry>, estimatorCount> odometries;
+  for (int e = 0; e < estimatorCount; e++) {
+    odometries[e] = makeOdometry(static_cast<Estimator>(e), sensors);
+    odometries[e]->step();
+  }
+
+  double glitchAt[KALMAN_TEST_GLITCHES];
+  for (double &at : glitchAt) {
+    at = 5 + 20 * uniform(generator);
+  }
+  const double turnAmplitude = 0.5 + uniform(generator);
+  const double turnFrequency = 0.3 + 0.5 * uniform(generator);
+  const double phase = 6 * uniform(generator);
+
+  double x = 0, y = 0, theta = 0;
+  double trackingLeft = 0, trackingRight = 0, motorLeft = 0, motorRight = 0;
+  double glitchTicks = 0;
+  double t = 0;
+  int samples = 0;
+  while (t < KALMAN_TEST_SECONDS) {
+    // the odometry task runs every 5 ms, sometimes a ms late; the robot moves in 1 ms steps
+    const int stepMillis = uniform(generator) < 0.1 ? 6 : 5;
+    double v = 0;
+    for (int k = 0; k < stepMillis; k++) {
+      const double dt = 0.001;
+      v = std::sin(0.4 * t + phase) * std::min(1.0, t) + 0.3 * std::sin(2.3 * t);
+      const double omega = turnAmplitude * std::sin(turnFrequency * t) +
+                           (std::fmod(t, 6) < 2 ? 1.5 * std::sin(1.7 * t + phase) : 0);
+      x += v * dt * std::cos(theta + omega * dt / 2);
+      y += v * dt * std::sin(theta + omega * dt / 2);
+      theta += omega * dt;
+      trackingLeft += (v + omega * KALMAN_TEST_TRACKING_TRACK / 2) * dt;
+      trackingRight += (v - omega * KALMAN_TEST_TRACKING_TRACK / 2) * dt;
+      const double slip = 1 + KALMAN_TEST_SLIP * gauss(generator);
+      motorLeft += (v + omega * KALMAN_TEST_MOTOR_TRACK / 2) * dt * slip;
+      motorRight += (v - omega * KALMAN_TEST_MOTOR_TRACK / 2) * dt * slip;
+      t += dt;
+    }
+    hostMicros += stepMillis * 1000;
+
+    for (double &at : glitchAt) {
+      if (at > 0 && t >= at) {
+        glitchTicks += 60;
+        at = -1;
+      }
+    }
+    const double trackingTicks =
+      okapi::quadEncoderTPR / (okapi::pi * KALMAN_TEST_TRACKING_DIAMETER);
+    const double motorTicks = KALMAN_TEST_MOTOR_TPR / (okapi::pi * KALMAN_TEST_MOTOR_DIAMETER);
+    sensors.trackingLeft->value = std::floor(trackingLeft * trackingTicks) + glitchTicks;
+    sensors.trackingRight->value = std::floor(trackingRight * trackingTicks);
+    sensors.motorLeft->value = std::floor(motorLeft * motorTicks);
+    sensors.motorRight->value = std::floor(motorRight * motorTicks);
+    sensors.imu->value = theta * 180 / okapi::pi + KALMAN_TEST_IMU_DRIFT / 60 * t +
+                         KALMAN_TEST_IMU_NOISE * gauss(generator);
+
+    for (int e = 0; e < estimatorCount; e++) {
+      odometries[e]->step();
+      const OdomSample sample = odometries[e]->getSample();
+      const auto *kalman = dynamic_cast<const KalmanOdometry *>(odometries[e].get());
+      const double speed =
+        kalman != nullptr ? kalman->getVelocityEstimate()[0] : sample.linearVelocity;
+      const double error = std::hypot(sample.pose.x - x, sample.pose.y - y);
+      oerrors[e].position += error * error;
+      oerrors[e].heading += std::pow(std::remainder(sample.pose.theta - theta, 2 * okapi::pi), 2);
+      oerrors[e].speed += (speed - v) * (speed - v);
+      oerrors[e].maxPosition = std::max(oerrors[e].maxPosition, error);
+    }
+    samples++;
+  }
+
+  for (int e = 0; e < estimatorCount; e++) {
+    const OdomPose pose = odometries[e]->getSample().pose;
+    oerrors[e].finalPosition += std::hypot(pose.x - x, pose.y - y);
+  }
+  return samples;
+}
+} // namespace
+
+HOST_TEST(kalmanOdometryOnNoisyData) {
+  std::array<EstimatorError, estimatorCount> errors{};
+  int samples = 0;
+  for (unsigned run = 0; run < KALMAN_TEST_RUNS; run++) {
+    samples += simulateRun(run, errors);
+  }
+
+  hostReport("%d runs of %.0f s: track width 1%% off, %d tracking wheel glitches, %.0f%% drive "
+             "wheel slip, IMU %.1f deg noise and %.1f deg/min drift",
+             KALMAN_TEST_RUNS, KALMAN_TEST_SECONDS, KALMAN_TEST_GLITCHES, 100 * KALMAN_TEST_SLIP,
+             KALMAN_TEST_IMU_NOISE, KALMAN_TEST_IMU_DRIFT);
+  hostReport("%-21s %9s %9s %9s %12s %12s", "", "rms mm", "final mm", "max mm", "heading deg",
+             "speed mm/s");
+  std::array<double, estimatorCount> rmsPosition{};
+  std::array<double, estimatorCount> rmsSpeed{};
+  for (int e = 0; e < estimatorCount; e++) {
+    rmsPosition[e] = std::sqrt(errors[e].position / samples);
+    rmsSpeed[e] = std::sqrt(errors[e].speed / samples);
+    hostReport("%-21s %9.1f %9.1f %9.1f %12.2f %12.1f", estimatorNames[e], 1000 * rmsPosition[e],
+               1000 * errors[e].finalPosition / KALMAN_TEST_RUNS, 1000 * errors[e].maxPosition,
+               std::sqrt(errors[e].heading / samples) * 180 / okapi::pi, 1000 * rmsSpeed[e]);
+  }
+
+  const int wheels = static_cast<int>(Estimator::wheels);
+  const int all = static_cast<int>(Estimator::kalmanAll);
+  HOST_CHECK(rmsPosition[all] < rmsPosition[wheels] / 2);
+  HOST_CHECK(rmsPosition[all] <= rmsPosition[static_cast<int>(Estimator::imuFused)]);
+  HOST_CHECK(rmsSpeed[all] < rmsSpeed[wheels]);
+}
+
+HOST_BENCH(kalmanOdometryUpdateCost) {
+  hostReport("ns per step() with 2 tracking wheel, 2 motor encoder and 1 IMU readings");
+  for (int e = 0; e < estimatorCount; e++) {
+    SimSensors sensors;
+    const std::shared_ptr<HighRateOdometry> odometry =
+      makeOdometry(static_cast<Estimator>(e), sensors);
+    odometry->step();
+
+    const std::uint64_t allocations = hostAllocations();
+    const std::uint64_t start = hostNanos();
+    for (int i = 0; i < KALMAN_TEST_BENCH_STEPS; i++) {
+      hostMicros += 5000;
+      sensors.trackingLeft->value += 3;
+      sensors.trackingRight->value += 2 + (i & 1);
+      sensors.motorLeft->value += 7;
+      sensors.motorRight->value += 6;
+      sensors.imu->value += 0.01;
+      odometry->step();
+    }
+    const double nanos = static_cast<double>(hostNanos() - start) / KALMAN_TEST_BENCH_STEPS;
+    hostReport("%-21s %6.0f ns, %llu allocations", estimatorNames[e], nanos,
+               static_cast<unsigned long long>(hostAllocations() - allocations));
+  }
+}
@@ -0,0 +1,196 @@
+// ------- linearMotionProfileControllerTest.cpp -------------------------------
+//
+// Host tests of LinearMotionProfileController: compact storage and views of a
+// 1D profile, followed on the test's thread the way okapi's loop does, with
+// the velocity targets it writes integrated into the distance the mechanism
+// travels. okapi's linear controller generates its paths with pathfinder, so
+// these only build with the Pathfinder C sources (HOST_TEST_PATHFINDER, see
+// the Makefile).
+
+#include "hostTest.h"
+
+#ifdef HOST_TEST_PATHFINDER
+
+#include "linearMotionProfileController.h"
+
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace okapi::literals;
+
+#define LINEAR_TEST_LENGTH 0.6        // m, length of the test paths
+#define LINEAR_TEST_DIAMETER 0.05     // m, of what the motor spins
+
+namespace {
+/**
+ * Records the velocity targets, as a fraction of the gearset's speed.
+ */
+class RecordedOutput : public okapi::ControllerOutput<double> {
+  public:
+  std::vector<double> speeds;
+
+  void controllerSet(double ivalue) override {
+    speeds.push_back(ivalue);
+  }
+};
+
+class TestLinearController : public LinearMotionProfileController {
+  public:
+  using LinearMotionProfileController::LinearMotionProfileController;
+
+  /**
+   * Follows the target the way okapi's loop does once it is set, on the test's thread.
+   *
+   * @param ihook Called after every step with the number of steps before it.
+   * @return false if there was no target to follow.
+   */
+  bool follow(const std::function<void(int)> &ihook = nullptr) {
+    if (!isRunning.load(std::memory_order_acquire) || isDisabled()) {
+      return false;
+    }
+
+    auto path = paths.find(getTarget());
+    if (path != paths.end()) {
+      executeSinglePath(path->second, std::make_unique<HookedRate>(ihook));
+      output->controllerSet(0);
+    }
+    isRunning.store(false, std::memory_order_release);
+    return true;
+  }
+
+  protected:
+  class HookedRate : public okapi::AbstractRate {
+    public:
+    explicit HookedRate(std::function<void(int)> ihook) : hook(std::move(ihook)) {
+    }
+
+    void delay(const okapi::QFrequency) override {
+      next();
+    }
+
+    void delayUntil(const okapi::QTime) override {
+      next();
+    }
+
+    void delayUntil(const uint32_t) override {
+      next();
+    }
+
+    protected:
+    std::function<void(int)> hook;
+    int step{0};
+
+    void next() {
+      if (hook) {
+        hook(step);
+      }
+      step++;
+    }
+  };
+};
+
+struct LinearRig {
+  std::shared_ptr<RecordedOutput> output;
+  std::shared_ptr<TestLinearController> profile;
+};
+
+LinearRig linearRig() {
+  LinearRig rig;
+  rig.output = std::make_shared<RecordedOutput>();
+  rig.profile = std::make_shared<TestLinearController>(
+    hostTimeUtil(), okapi::PathfinderLimits{1.0, 2.0, 10.0}, rig.output,
+    LINEAR_TEST_DIAMETER * okapi::meter,
+    okapi::AbstractMotor::GearsetRatioPair(okapi::AbstractMotor::gearset::green));
+  return rig;
+}
+
+/**
+ * Follows the target and empties the recorded targets.
+ *
+ * @return The distance travelled in m, with 10 ms per recorded target.
+ */
+double followDistance(LinearRig &irig, const std::function<void(int)> &ihook = nullptr) {
+  irig.output->speeds.clear();
+  irig.profile->follow(ihook);
+
+  const double rpm = okapi::toUnderlyingType(okapi::AbstractMotor::gearset::green);
+  double distance = 0;
+  for (double speed : irig.output->speeds) {
+    distance += speed * rpm / 60 * okapi::pi * LINEAR_TEST_DIAMETER * 0.010;
+  }
+  irig.output->speeds.clear();
+  return distance;
+}
+} // namespace
+
+HOST_TEST(linearCompactPaths) {
+  auto rig = linearRig();
+  rig.profile->generatePath({0_m, LINEAR_TEST_LENGTH * okapi::meter}, "full");
+  rig.profile->setTrajectoryStorage(TrajectoryStorage::fixed16);
+  rig.profile->generatePath({0_m, LINEAR_TEST_LENGTH * okapi::meter}, "compact");
+  HOST_CHECK(rig.profile->getTrajectoryStorage() == TrajectoryStorage::fixed16);
+
+  const std::size_t full = rig.profile->getPathMemory("full");
+  const std::size_t compact = rig.profile->getPathMemory("compact");
+  hostReport("full %zu bytes, fixed16 %zu bytes", full, compact);
+  HOST_CHECK(compact > 0 && compact * 4 < full);
+
+  rig.profile->setTarget("full");
+  const double fullDistance = followDistance(rig);
+  rig.profile->setTarget("compact");
+  const double compactDistance = followDistance(rig);
+  HOST_CHECK_NEAR(fullDistance, LINEAR_TEST_LENGTH, 0.01);
+  HOST_CHECK_NEAR(compactDistance, fullDistance, 1e-3);
+
+  rig.profile->setTarget("compact", true);
+  HOST_CHECK_NEAR(followDistance(rig), -compactDistance, 1e-9);
+
+  HOST_CHECK(rig.profile->removePath("compact"));
+  HOST_CHECK(rig.profile->getPathMemory("compact") == 0);
+  HOST_CHECK(rig.profile->getPaths() == std::vector<std::string>({"full"}));
+}
+
+HOST_TEST(linearViewsOutliveTheirPaths) {
+  auto rig = linearRig();
+  rig.profile->generatePath({0_m, LINEAR_TEST_LENGTH * okapi::meter}, "A");
+  const int steps = rig.profile->getView("A").size();
+  HOST_CHECK(steps > 0);
+
+  // a view of the running path takes its segments over, the path is followed
+  // on from the view's trajectory and can not be removed meanwhile
+  TrajectoryView view;
+  rig.profile->setTarget("A");
+  const double distance = followDistance(rig, [&](int istep) {
+    if (istep == steps / 3) {
+      view = rig.profile->getView("A");
+      HOST_CHECK(rig.profile->storeView("R", view.reversed()));
+      HOST_CHECK(rig.profile->storeView("AA", view.concat(view)));
+      HOST_CHECK(!rig.profile->storeView("A", view.scaled(0.5)));
+      HOST_CHECK(!rig.profile->removePath("A"));
+    }
+  });
+  HOST_CHECK_NEAR(distance, LINEAR_TEST_LENGTH, 0.01);
+  HOST_CHECK(!rig.profile->storeView("E", TrajectoryView()));
+
+  // the views keep A's trajectory after A is removed, also while they run
+  HOST_CHECK(rig.profile->removePath("A"));
+  view = TrajectoryView();
+  rig.profile->setTarget("R");
+  HOST_CHECK_NEAR(followDistance(rig), -distance, 1e-6);
+
+  rig.profile->setTarget("AA");
+  HOST_CHECK_NEAR(followDistance(rig, [&](int istep) {
+                    if (istep == 0) {
+                      HOST_CHECK(rig.profile->removePath("R"));
+                    }
+                  }),
+                  2 * distance, 1e-6);
+  HOST_CHECK(rig.profile->getPaths() == std::vector<std::string>({"AA"}));
+}
+
+#else
+HOST_SKIP(linearMotionProfileControllerTest, "no PATHFINDER_DIR");
+#endif
@@ -0,0 +1,532 @@
+// ------- motionProfileControllerTest.cpp -------------------------------------
+//
+// Host tests of MotionProfileController driving the simulated skid steer
+// chassis of hostChassis.h, and of HolonomicMotionProfileController driving an
+// X or H drive whose motors' speeds the test turns into the robot's motion. A
+// test does what okapi's loop does once a target is set on its own thread
+// (FollowedController::follow()), with a rate that calls back after every
+// step, so paths can be queued or set at an exact step of the running one.
+// Paths are generated with PathGeneration, so like its tests these only build
+// with the Pathfinder C sources (HOST_TEST_PATHFINDER, see the Makefile).
+
+#include "hostTest.h"
+
+#ifdef HOST_TEST_PATHFINDER
+
+#include "hostChassis.h"
+#include "holonomicMotionProfileController.h"
+#include "motionProfileController.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace okapi::literals;
+
+#define PROFILE_TEST_LENGTH 0.6       // m, length of the straight test paths
+#define PROFILE_TEST_OFFSET 0.3       // m, sideways offset of the S shaped test paths
+#define PROFILE_TEST_TAIL_MS 50       // real time okapi's loop takes after a chain in the tests
+
+namespace {
+using StepHook = std::function<void(int)>;
+
+/**
+ * The rate of a followed path: moves the simulated clock and calls back after every step.
+ */
+class StepRate : public okapi::AbstractRate {
+  public:
+  explicit StepRate(StepHook ihook) : hook(std::move(ihook)) {
+  }
+
+  void delay(const okapi::QFrequency ihz) override {
+    delayUntil(okapi::QTime(1.0 / ihz.convert(okapi::Hz)));
+  }
+
+  void delayUntil(const okapi::QTime itime) override {
+    hostMicros += static_cast<std::uint64_t>(itime.convert(okapi::millisecond) * 1000);
+    if (hook) {
+      hook(step);
+    }
+    step++;
+  }
+
+  void delayUntil(const uint32_t ims) override {
+    delayUntil(ims * okapi::millisecond);
+  }
+
+  protected:
+  StepHook hook;
+  int step{0};
+};
+
+template <typename Controller> class FollowedController : public Controller {
+  public:
+  using Controller::Controller;
+
+  /**
+   * Follows the target the way okapi's loop does once it is set, on the test's thread.
+   *
+   * @param ihook Called after every step with the number of steps before it.
+   * @param itail Called after the chain, before isRunning is cleared.
+   * @return false if there was no target to follow.
+   */
+  bool follow(const StepHook &ihook = nullptr, const std::function<void()> &itail = nullptr) {
+    if (!this->isRunning.load(std::memory_order_acquire) || this->isDisabled()) {
+      return false;
+    }
+
+    auto path = this->paths.find(this->getTarget());
+    if (path != this->paths.end()) {
+      this->executeSinglePath(path->second, std::make_unique<StepRate>(ihook));
+      this->model->stop();
+    }
+    if (itail) {
+      itail();
+    }
+    this->isRunning.store(false, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Holds the paths, so the background generator can not store a path it generated.
+   */
+  std::unique_lock<CrossplatformMutex> holdPaths() {
+    return std::unique_lock<CrossplatformMutex>(this->currentPathMutex);
+  }
+
+  /**
+   * Follows the target on the test's thread instead of waiting for okapi's loop.
+   */
+  void waitUntilSettled() override {
+    follow();
+  }
+};
+
+using TestProfileController = FollowedController<MotionProfileController>;
+using TestHolonomicController = FollowedController<HolonomicMotionProfileController>;
+
+struct ProfileRig {
+  std::shared_ptr<SimDrive> drive;
+  std::shared_ptr<SimChassisController> chassis;
+  std::shared_ptr<TestProfileController> profile;
+};
+
+ProfileRig profileRig() {
+  ProfileRig rig;
+  rig.drive = std::make_shared<SimDrive>();
+  rig.chassis = std::make_shared<SimChassisController>(rig.drive);
+  rig.profile = std::make_shared<TestProfileController>(
+    hostTimeUtil(), okapi::PathfinderLimits{0.8, 2.0, 10.0}, rig.chassis->getModel(),
+    rig.chassis->getChassisScales(), rig.chassis->getGearsetRatioPair());
+  return rig;
+}
+
+struct HolonomicRig {
+  std::shared_ptr<SimDrive> sim;      // only holds the motors, holonomicStep() moves the robot
+  std::vector<std::shared_ptr<SimMotor>> motors; // in HolonomicTrajectory order
+  std::shared_ptr<TestHolonomicController> profile;
+};
+
+HolonomicRig holonomicRig(const HolonomicDrive idrive) {
+  HolonomicRig rig;
+  rig.sim = std::make_shared<SimDrive>();
+  for (int w = 0; w < HolonomicTrajectory::wheelCount(idrive); w++) {
+    rig.motors.push_back(std::make_shared<SimMotor>(*rig.sim));
+  }
+
+  SimChassisController chassis(rig.sim);
+  const double maxRpm = okapi::toUnderlyingType(rig.sim->config.gearset);
+  const okapi::PathfinderLimits limits{0.8, 2.0, 10.0};
+  if (idrive == HolonomicDrive::xDrive) {
+    rig.profile = std::make_shared<TestHolonomicController>(
+      hostTimeUtil(), limits,
+      std::make_shared<okapi::XDriveModel>(rig.motors[0], rig.motors[1], rig.motors[2],
+                                           rig.motors[3], rig.motors[0]->getEncoder(),
+                                           rig.motors[1]->getEncoder(), maxRpm, 12000),
+      chassis.getChassisScales(), chassis.getGearsetRatioPair());
+  } else {
+    rig.profile = std::make_shared<TestHolonomicController>(
+      hostTimeUtil(), limits,
+      std::make_shared<okapi::HDriveModel>(rig.motors[0], rig.motors[1], rig.motors[2],
+                                           rig.motors[0]->getEncoder(),
+                                           rig.motors[1]->getEncoder(),
+                                           rig.motors[2]->getEncoder(), maxRpm, 12000),
+      chassis.getChassisScales(), chassis.getGearsetRatioPair());
+  }
+  return rig;
+}
+
+/**
+ * Moves a pose on by idt seconds at the target speeds of the motors, HolonomicTrajectory's
+ * wheelSpeeds() solved for the chassis motion. The pose is in okapi's frame like SimDrive's,
+ * y to the right and theta clockwise.
+ */
+void holonomicStep(const HolonomicRig &irig, const double idt, OdomPose &iopose) {
+  const SimDriveConfig &config = irig.sim->config;
+  double wheels[HOLONOMIC_MAX_WHEELS];
+  for (std::size_t w = 0; w < irig.motors.size(); w++) {
+    wheels[w] = irig.motors[w]->getTargetVelocity() / 60.0 * okapi::pi * config.wheelDiameter;
+  }
+
+  double forward, left, turn;
+  if (irig.profile->getDrive() == HolonomicDrive::xDrive) {
+    forward = (wheels[0] + wheels[1] + wheels[2] + wheels[3]) / 4 / M_SQRT1_2;
+    left = (wheels[1] + wheels[3] - wheels[0] - wheels[2]) / 4 / M_SQRT1_2;
+    turn = (wheels[1] + wheels[2] - wheels[0] - wheels[3]) / 4 / (config.track * M_SQRT1_2);
+  } else {
+    forward = (wheels[0] + wheels[1]) / 2;
+    left = -wheels[2];
+    turn = (wheels[1] - wheels[0]) / config.track;
+  }
+
+  iopose.x += (forward * std::cos(iopose.theta) + left * std::sin(iopose.theta)) * idt;
+  iopose.y += (forward * std::sin(iopose.theta) - left * std::cos(iopose.theta)) * idt;
+  iopose.theta -= turn * idt;
+}
+
+/**
+ * Follows the target of a holonomic controller.
+ *
+ * @param omaxTurn The largest heading change on the way, in radians.
+ * @return The pose the robot ends at.
+ */
+OdomPose holonomicFollow(HolonomicRig &irig, double &omaxTurn) {
+  OdomPose pose;
+  omaxTurn = 0;
+  std::uint64_t last = hostMicros;
+  irig.profile->follow([&](int) {
+    holonomicStep(irig, (hostMicros - last) / 1e6, pose);
+    last = hostMicros;
+    omaxTurn = std::max(omaxTurn, std::abs(pose.theta));
+  });
+  return pose;
+}
+
+/**
+ * Generates a path to PROFILE_TEST_LENGTH ahead and PROFILE_TEST_OFFSET to the side, with the
+ * heading it starts with.
+ */
+template <typename Controller> void sidePath(Controller &iprofile, const std::string &ipathId) {
+  iprofile.generatePath({{0_m, 0_m, 0_deg},
+                         {PROFILE_TEST_LENGTH * okapi::meter, PROFILE_TEST_OFFSET * okapi::meter,
+                          0_deg}},
+                        ipathId);
+}
+
+/**
+ * Generates a straight path of PROFILE_TEST_LENGTH.
+ *
+ * @return The number of steps of the path.
+ */
+int straightPath(TestProfileController &iprofile, const std::string &ipathId) {
+  iprofile.generatePath({{0_m, 0_m, 0_deg}, {PROFILE_TEST_LENGTH * okapi::meter, 0_m, 0_deg}},
+                        ipathId);
+  return iprofile.getView(ipathId).size();
+}
+
+/**
+ * @return How many steps in a row of itargets are ipathId, from ifirst on.
+ */
+int runLength(const std::vector<std::string> &itargets, std::size_t ifirst, const char *ipathId) {
+  int steps = 0;
+  while (ifirst + steps < itargets.size() && itargets[ifirst + steps] == ipathId) {
+    steps++;
+  }
+  return steps;
+}
+} // namespace
+
+HOST_TEST(generatePathAsyncReadiness) {
+  auto rig = profileRig();
+  const std::vector<okapi::PathfinderPoint> straight{
+    {0_m, 0_m, 0_deg}, {PROFILE_TEST_LENGTH * okapi::meter, 0_m, 0_deg}};
+
+  // pending until the generator has stored the path
+  PathHandle handle;
+  {
+    auto hold = rig.profile->holdPaths();
+    handle = rig.profile->generatePathAsync(straight, "A");
+    HOST_CHECK(handle.getStatus() == PathHandle::status::pending);
+    HOST_CHECK(!handle.isReady());
+  }
+  HOST_CHECK(handle.waitUntilReady());
+  HOST_CHECK(handle.getStatus() == PathHandle::status::ready);
+  HOST_CHECK(rig.profile->getPaths() == std::vector<std::string>({"A"}));
+
+  // setTarget() waits for a path which is still being generated
+  rig.profile->generatePathAsync(straight, "B");
+  rig.profile->setTarget("B");
+  HOST_CHECK(rig.profile->getPathMemory("B") > 0);
+  int steps = 0;
+  HOST_CHECK(rig.profile->follow([&](int) { steps++; }));
+  HOST_CHECK(steps == rig.profile->getView("B").size());
+  rig.drive->settle();
+  HOST_CHECK_NEAR(rig.drive->getPose().x, PROFILE_TEST_LENGTH, 0.02);
+
+  // a running path is not replaced, and no waypoints make no path
+  PathHandle replaced;
+  rig.profile->setTarget("A");
+  rig.profile->follow([&](int istep) {
+    if (istep == 0) {
+      replaced = rig.profile->generatePathAsync(straight, "A");
+      replaced.waitUntilReady();
+    }
+  });
+  HOST_CHECK(replaced.getStatus() == PathHandle::status::failed);
+  HOST_CHECK(rig.profile->generatePathAsync({}, "C").getStatus() == PathHandle::status::failed);
+  HOST_CHECK(PathHandle().getStatus() == PathHandle::status::failed);
+  HOST_CHECK(rig.profile->getPaths().size() == 2);
+}
+
+HOST_TEST(queuePathBlendsPaths) {
+  auto rig = profileRig();
+  const int stepsA = straightPath(*rig.profile, "A");
+  const int stepsB = straightPath(*rig.profile, "B");
+
+  // the fastest a wheel turns on one path
+  int peak = 0;
+  rig.profile->setTarget("A");
+  rig.profile->follow(
+    [&](int) { peak = std::max(peak, std::abs(rig.drive->leftMotor->getTargetVelocity())); });
+  rig.drive->settle();
+  rig.drive->setPose(OdomPose{});
+  HOST_CHECK(peak > 0);
+
+  // A slows down while B speeds up: no wheel goes faster than on one path and
+  // the robot does not slow down much in between
+  std::vector<int> rpm;
+  rig.profile->setTarget("A");
+  rig.profile->queuePath("B");
+  HOST_CHECK(rig.profile->getQueueSize() == 1);
+  rig.profile->follow([&](int) { rpm.push_back(rig.drive->leftMotor->getTargetVelocity()); });
+  const int overlap = stepsA + stepsB - static_cast<int>(rpm.size());
+  hostReport("%d + %d steps, %d blended, peak %d rpm", stepsA, stepsB, overlap, peak);
+  HOST_CHECK(overlap > 0);
+  HOST_CHECK(*std::max_element(rpm.begin(), rpm.end()) <= peak);
+  HOST_CHECK(*std::min_element(rpm.begin() + stepsA / 2, rpm.end() - stepsB / 2) >= peak / 2);
+  HOST_CHECK(rig.profile->getQueueSize() == 0);
+
+  // each wheel still travels both paths
+  rig.drive->settle();
+  HOST_CHECK_NEAR(rig.drive->getPose().x, 2 * PROFILE_TEST_LENGTH, 0.02);
+}
+
+HOST_TEST(queuePathChainsPaths) {
+  auto rig = profileRig();
+  const int stepsA = straightPath(*rig.profile, "A");
+  straightPath(*rig.profile, "B");
+  straightPath(*rig.profile, "C");
+
+  // with nothing running queuePath() starts the path like setTarget()
+  rig.profile->queuePath("A");
+  HOST_CHECK(rig.profile->getTarget() == "A");
+  HOST_CHECK(rig.profile->getQueueSize() == 0);
+
+  // a queued path keeps its trajectory when it is removed before it runs
+  rig.profile->queuePath("B");
+  rig.profile->queuePath("C");
+  HOST_CHECK(rig.profile->getQueueSize() == 2);
+  HOST_CHECK(rig.profile->removePath("B"));
+
+  std::vector<std::string> order;
+  std::size_t queued = 0;
+  rig.profile->follow([&](int istep) {
+    if (order.empty() || order.back() != rig.profile->getTarget()) {
+      order.push_back(rig.profile->getTarget());
+    }
+    if (istep == stepsA / 2) {
+      queued = rig.profile->getQueueSize();
+    }
+  });
+  HOST_CHECK(queued == 1);                 // B is taken for blending before A ends
+  HOST_CHECK(order == std::vector<std::string>({"A", "B", "C"}));
+  HOST_CHECK(rig.profile->getQueueSize() == 0);
+  HOST_CHECK(rig.profile->isSettled());
+  rig.drive->settle();
+  HOST_CHECK_NEAR(rig.drive->getPose().x, 3 * PROFILE_TEST_LENGTH, 0.03);
+}
+
+HOST_TEST(queuePathDuringFinalPath) {
+  auto rig = profileRig();
+  const int stepsA = straightPath(*rig.profile, "A");
+  const int stepsB = straightPath(*rig.profile, "B");
+  HOST_CHECK(stepsA > 0 && stepsB > 0);
+
+  // queued at the last step of the last path: too late to blend, followed after it
+  std::vector<std::string> targets;
+  rig.profile->setTarget("A");
+  rig.profile->follow([&](int istep) {
+    targets.push_back(rig.profile->getTarget());
+    if (istep == stepsA - 1) {
+      rig.profile->queuePath("B");
+    }
+  });
+  HOST_CHECK(runLength(targets, 0, "A") == stepsA);
+  HOST_CHECK(runLength(targets, stepsA, "B") == stepsB);
+  HOST_CHECK(targets.size() == static_cast<std::size_t>(stepsA + stepsB));
+  HOST_CHECK(rig.profile->getQueueSize() == 0);
+  rig.drive->settle();
+  HOST_CHECK_NEAR(rig.drive->getPose().x, 2 * PROFILE_TEST_LENGTH, 0.02);
+
+  // queued from another task after the chain ran out of paths, while okapi's
+  // loop still has to clear isRunning: starts a new chain instead of being
+  // cleared with the old one
+  std::thread queuer;
+  rig.profile->setTarget("A");
+  HOST_CHECK(rig.profile->follow(nullptr, [&] {
+    queuer = std::thread([&] { rig.profile->queuePath("B"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(PROFILE_TEST_TAIL_MS));
+  }));
+  queuer.join();
+
+  targets.clear();
+  HOST_CHECK(rig.profile->follow([&](int) { targets.push_back(rig.profile->getTarget()); }));
+  HOST_CHECK(runLength(targets, 0, "B") == stepsB);
+  HOST_CHECK(!rig.profile->follow());
+}
+
+HOST_TEST(setTargetWhilePathRuns) {
+  auto rig = profileRig();
+  const int stepsA = straightPath(*rig.profile, "A");
+  straightPath(*rig.profile, "B");
+  const int stepsC = straightPath(*rig.profile, "C");
+
+  // okapi drops a target set while a path runs: A is finished, then C
+  // follows, and B queued before it is dropped
+  std::vector<std::string> targets;
+  rig.profile->setTarget("A");
+  rig.profile->queuePath("B");
+  rig.profile->follow([&](int istep) {
+    targets.push_back(rig.profile->getTarget());
+    if (istep == stepsA / 2) {
+      rig.profile->setTarget("C");
+      HOST_CHECK(rig.profile->getQueueSize() == 1);
+    }
+  });
+  HOST_CHECK(runLength(targets, 0, "A") == stepsA);
+  HOST_CHECK(runLength(targets, stepsA, "C") == stepsC);
+  HOST_CHECK(targets.size() == static_cast<std::size_t>(stepsA + stepsC));
+  HOST_CHECK(!rig.profile->follow());
+}
+
+HOST_TEST(viewsOutliveTheirPaths) {
+  auto rig = profileRig();
+  const int stepsA = straightPath(*rig.profile, "A");
+
+  // a view of the running path takes its segments over, A is followed on from
+  // the view's trajectory and can not be replaced or removed meanwhile
+  TrajectoryView view;
+  int steps = 0;
+  rig.profile->setTarget("A");
+  rig.profile->follow([&](int istep) {
+    steps++;
+    if (istep == stepsA / 3) {
+      view = rig.profile->getView("A");
+      HOST_CHECK(rig.profile->storeView("R", view.reversed()));
+      HOST_CHECK(rig.profile->storeView("AA", view.concat(view)));
+      HOST_CHECK(!rig.profile->storeView("A", view.scaled(0.5)));
+      HOST_CHECK(!rig.profile->removePath("A"));
+    }
+  });
+  HOST_CHECK(steps == stepsA);
+  HOST_CHECK(view.size() == stepsA);
+  rig.drive->settle();
+  HOST_CHECK_NEAR(rig.drive->getPose().x, PROFILE_TEST_LENGTH, 0.02);
+
+  // the views keep A's trajectory after A is removed, also while they run
+  HOST_CHECK(rig.profile->removePath("A"));
+  HOST_CHECK(rig.profile->getPathMemory("A") == 0);
+  steps = 0;
+  rig.profile->setTarget("R");
+  rig.profile->follow([&](int istep) {
+    steps++;
+    if (istep == 0) {
+      HOST_CHECK(!rig.profile->removePath("R"));
+      view = TrajectoryView();
+    }
+  });
+  HOST_CHECK(steps == stepsA);
+  rig.drive->settle();
+  HOST_CHECK_NEAR(rig.drive->getPose().x, 0, 0.02);
+
+  rig.profile->setTarget("AA");
+  rig.profile->follow([&](int istep) {
+    if (istep == 0) {
+      HOST_CHECK(rig.profile->removePath("R"));
+    }
+  });
+  rig.drive->settle();
+  HOST_CHECK_NEAR(rig.drive->getPose().x, 2 * PROFILE_TEST_LENGTH, 0.03);
+  HOST_CHECK(rig.profile->getPaths() == std::vector<std::string>({"AA"}));
+}
+
+HOST_TEST(moveToCompactPath) {
+  // okapi's own storePath() or moveTo() would read the segments of a compact path
+  static_assert(
+    !std::is_convertible<MotionProfileController *, okapi::AsyncMotionProfileController *>::value,
+    "okapi's path functions are reachable through a base pointer");
+
+  auto rig = profileRig();
+  rig.profile->setTrajectoryStorage(TrajectoryStorage::fixed16);
+  rig.profile->moveTo({{0_m, 0_m, 0_deg}, {PROFILE_TEST_LENGTH * okapi::meter, 0_m, 0_deg}});
+  HOST_CHECK(rig.profile->getPaths().empty());
+  HOST_CHECK(rig.profile->getPathMemory(MOVE_TO_PATH_ID) == 0);
+  rig.drive->settle();
+  HOST_CHECK_NEAR(rig.drive->getPose().x, PROFILE_TEST_LENGTH, 0.02);
+}
+
+HOST_TEST(holonomicFollowsTankPaths) {
+  // where a skid steer ends up on the path
+  auto tank = profileRig();
+  sidePath(*tank.profile, "S");
+  tank.profile->setTarget("S");
+  tank.profile->follow();
+  tank.drive->settle();
+  const OdomPose end = tank.drive->getPose();
+  HOST_CHECK(std::abs(end.y) > PROFILE_TEST_OFFSET / 2);
+
+  // a holonomic chassis ends there too, strafing without turning
+  for (HolonomicDrive drive : {HolonomicDrive::xDrive, HolonomicDrive::hDrive}) {
+    auto rig = holonomicRig(drive);
+    sidePath(*rig.profile, "S");
+    double maxTurn;
+    rig.profile->setTarget("S");
+    OdomPose pose = holonomicFollow(rig, maxTurn);
+    hostReport("%s drive ends at (%.4f, %.4f) m, tank at (%.4f, %.4f) m, turned %.3f deg at most",
+               drive == HolonomicDrive::xDrive ? "X" : "H", pose.x, pose.y, end.x, end.y,
+               maxTurn * 180 / okapi::pi);
+    HOST_CHECK_NEAR(pose.x, end.x, 0.02);
+    HOST_CHECK_NEAR(pose.y, end.y, 0.02);
+    HOST_CHECK(maxTurn < 1e-3);
+    for (const auto &motor : rig.motors) {
+      HOST_CHECK(motor->getTargetVelocity() == 0);
+    }
+
+    // mirrored it goes to the other side
+    rig.profile->setTarget("S", false, true);
+    pose = holonomicFollow(rig, maxTurn);
+    HOST_CHECK_NEAR(pose.x, end.x, 0.02);
+    HOST_CHECK_NEAR(pose.y, -end.y, 0.02);
+
+    // a queued path follows from where the first one ends, with the same heading
+    rig.profile->setTarget("S");
+    rig.profile->queuePath("S");
+    pose = holonomicFollow(rig, maxTurn);
+    HOST_CHECK_NEAR(pose.x, 2 * end.x, 0.04);
+    HOST_CHECK_NEAR(pose.y, 2 * end.y, 0.04);
+    HOST_CHECK(maxTurn < 1e-3);
+    HOST_CHECK(rig.profile->getQueueSize() == 0);
+  }
+}
+
+#else
+HOST_SKIP(motionProfileControllerTest, "no PATHFINDER_DIR");
+#endif
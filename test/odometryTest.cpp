@@ -0,0 +1,543 @@
+// ------- odometryTest.cpp ----------------------------------------------------
+//
+// Host tests of the odometry math and the lock free containers it publishes
+// through: OdomArcMath, HighRateOdometry replaying a recorded tick trace,
+// PoseHistory, SeqLock and RingBuffer. okapi's TwoEncoderOdometry,
+// ThreeEncoderOdometry and OdomMath (the hostOkapi.cpp stand-ins) replay the
+// same traces, so the two integrations are checked against each other.
+//
+// The trace (test/golden/odomTrace.csv) has the columns tools/dataLogDecode
+// writes, so a MARK_TRACE recording from the robot can be dropped in; its
+// x/y/theta columns are what the pose error is measured against. The
+// odometry under test also runs on a trace built here from straight lines,
+// arcs and turns in place, whose true pose is known in closed form.
+
+#include "hostTest.h"
+
+#include "dataLoggerFormat.h"
+#include "highRateOdometry.h"
+#include "poseHistory.h"
+#include "ringBuffer.h"
+#include "seqLock.h"
+
+#include "okapi/api/chassis/model/readOnlyChassisModel.hpp"
+#include "okapi/api/odometry/odomMath.hpp"
+#include "okapi/api/odometry/threeEncoderOdometry.hpp"
+#include "okapi/api/odometry/twoEncoderOdometry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#define ODOM_TEST_TRACE HOST_GOLDEN_DIR "/odomTrace.csv"
+#define ODOM_TEST_WHEEL_DIAMETER 0.06985  // m, the trace's tracking wheels
+#define ODOM_TEST_TRACK 0.2450            // m
+#define ODOM_TEST_POSE_EVERY 50           // trace samples per golden pose
+#define ODOM_TEST_MIDDLE_DISTANCE 0.12    // m, the middle wheel of the closed form trace, behind
+#define ODOM_TEST_PERIOD_MS 5             // closed form trace sample period
+
+namespace {
+// dataLogDecode CSV columns
+enum TraceColumn { timestampMs, marker, xM, yM, thetaDeg, encoderLeft, encoderRight };
+
+/**
+ * Chassis model handing out the encoder counts of the current trace sample.
+ */
+class TraceModel : public okapi::ReadOnlyChassisModel, public SensorSnapshotSource {
+  public:
+  std::int32_t left{0};
+  std::int32_t right{0};
+  std::int32_t middle{0};   // only ThreeEncoderOdometry reads it
+
+  std::valarray<std::int32_t> getSensorVals() const override {
+    return std::valarray<std::int32_t>{left, right, middle};
+  }
+
+  void getSensorVals(SensorSnapshot &out) const override {
+    out.vals[0] = left;
+    out.vals[1] = right;
+    out.count = 2;
+  }
+};
+
+okapi::ChassisScales traceScales() {
+  return okapi::ChassisScales({ODOM_TEST_WHEEL_DIAMETER * okapi::meter,
+                               ODOM_TEST_TRACK * okapi::meter},
+                              okapi::quadEncoderTPR);
+}
+
+okapi::ChassisScales middleWheelScales() {
+  return okapi::ChassisScales({ODOM_TEST_WHEEL_DIAMETER * okapi::meter,
+                               ODOM_TEST_TRACK * okapi::meter,
+                               ODOM_TEST_MIDDLE_DISTANCE * okapi::meter,
+                               ODOM_TEST_WHEEL_DIAMETER * okapi::meter},
+                              okapi::quadEncoderTPR);
+}
+
+/**
+ * One piece of the closed form trace: the center of the robot moves along a circular arc
+ * (a line if iturn is 0, a turn in place if ilength is 0), easing in and out.
+ */
+struct TraceSegment {
+  double length;                      // m, along the path of the center
+  double turn;                        // rad, clockwise
+  std::uint32_t ms;
+};
+
+struct ClosedFormSample {
+  std::uint32_t timestamp;
+  std::int32_t left, right, middle;   // ticks
+  OdomPose truth;
+};
+
+/**
+ * The pose after moving ilength along an arc turning by iturn, in closed form.
+ */
+OdomPose alongArc(const OdomPose &istart, const double ilength, const double iturn) {
+  OdomPose end{istart.x, istart.y, istart.theta + iturn};
+  if (iturn == 0) {
+    end.x += std::cos(istart.theta) * ilength;
+    end.y += std::sin(istart.theta) * ilength;
+  } else if (ilength != 0) {
+    const double curvature = iturn / ilength;
+    end.x += (std::sin(end.theta) - std::sin(istart.theta)) / curvature;
+    end.y -= (std::cos(end.theta) - std::cos(istart.theta)) / curvature;
+  }
+  return end;
+}
+
+/**
+ * Builds the encoder counts a skid steer chassis with a middle wheel reads every
+ * ODOM_TEST_PERIOD_MS while it drives isegments, with the true pose of each sample.
+ */
+std::vector<ClosedFormSample> closedFormTrace(const std::vector<TraceSegment> &isegments) {
+  const okapi::ChassisScales scales = middleWheelScales();
+  const double halfTrack = ODOM_TEST_TRACK / 2;
+  std::vector<ClosedFormSample> samples;
+  OdomPose start;
+  double left = 0, right = 0, middle = 0;   // m at the start of the segment
+  std::uint32_t timestamp = 0;
+
+  for (const auto &segment : isegments) {
+    for (std::uint32_t ms = ODOM_TEST_PERIOD_MS; ms <= segment.ms; ms += ODOM_TEST_PERIOD_MS) {
+      const double f = (1 - std::cos(okapi::pi * ms / segment.ms)) / 2;
+      const double turn = f * segment.turn;
+      ClosedFormSample sample;
+      sample.timestamp = timestamp + ms;
+      sample.left = static_cast<std::int32_t>(
+        std::lround((left + f * segment.length + turn * halfTrack) * scales.straight));
+      sample.right = static_cast<std::int32_t>(
+        std::lround((right + f * segment.length - turn * halfTrack) * scales.straight));
+      sample.middle = static_cast<std::int32_t>(
+        std::lround((middle - turn * ODOM_TEST_MIDDLE_DISTANCE) * scales.middle));
+      sample.truth = alongArc(start, f * segment.length, turn);
+      samples.push_back(sample);
+    }
+    start = alongArc(start, segment.length, segment.turn);
+    left += segment.length + segment.turn * halfTrack;
+    right += segment.length - segment.turn * halfTrack;
+    middle -= segment.turn * ODOM_TEST_MIDDLE_DISTANCE;
+    timestamp += segment.ms;
+  }
+  return samples;
+}
+
+struct PoseError {
+  double max{0};                      // m
+  double heading{0};                  // rad, the largest heading error
+};
+
+void addError(PoseError &oerror, const OdomPose &iestimate, const OdomPose &itruth) {
+  oerror.max = std::max(oerror.max, std::hypot(iestimate.x - itruth.x, iestimate.y - itruth.y));
+  oerror.heading = std::max(oerror.heading, std::abs(iestimate.theta - itruth.theta));
+}
+
+OdomPose okapiPose(const okapi::Odometry &iodom) {
+  return OdomArcMath::fromState(iodom.getState(), okapi::StateMode::FRAME_TRANSFORMATION);
+}
+
+struct TestValue {
+  std::uint32_t a;
+  std::uint32_t b;
+  std::uint64_t c;
+};
+} // namespace
+
+HOST_TEST(odomArcMathMatchesArcs) {
+  const double track = ODOM_TEST_TRACK;
+
+  const OdomPose straight = OdomArcMath::step(OdomPose{1, 2, 0}, 0.5, 0.5, 0, track);
+  HOST_CHECK_NEAR(straight.x, 1.5, 1e-12);
+  HOST_CHECK_NEAR(straight.y, 2, 1e-12);
+
+  // turning in place does not move the center
+  const OdomPose spin = OdomArcMath::step(OdomPose{}, 0.1, -0.1, 0.2 / track, track);
+  HOST_CHECK_NEAR(spin.x, 0, 1e-12);
+  HOST_CHECK_NEAR(spin.y, 0, 1e-12);
+  HOST_CHECK_NEAR(spin.theta, 0.2 / track, 1e-12);
+
+  // a clockwise quarter circle of radius 1 in one step ends at (1, 1) facing +y
+  const double radius = 1;
+  const double left = (radius + track / 2) * okapi::pi / 2;
+  const double right = (radius - track / 2) * okapi::pi / 2;
+  const OdomPose arc = OdomArcMath::step(OdomPose{}, left, right, (left - right) / track, track);
+  HOST_CHECK_NEAR(arc.x, 1, 1e-12);
+  HOST_CHECK_NEAR(arc.y, 1, 1e-12);
+  HOST_CHECK_NEAR(arc.theta, okapi::pi / 2, 1e-12);
+
+  // the same arc in 1000 small steps ends in the same place
+  OdomPose pieces;
+  for (int i = 0; i < 1000; i++) {
+    pieces = OdomArcMath::step(pieces, left / 1000, right / 1000, (left - right) / track / 1000,
+                               track);
+  }
+  HOST_CHECK_NEAR(pieces.x, 1, 1e-9);
+  HOST_CHECK_NEAR(pieces.y, 1, 1e-9);
+
+  const auto scales = traceScales();
+  const OdomPose ticks = OdomArcMath::stepTicks(OdomPose{}, 360, 360, scales);
+  HOST_CHECK_NEAR(ticks.x, ODOM_TEST_WHEEL_DIAMETER * okapi::pi, 1e-12);
+
+  const OdomPose pose{0.25, -0.5, 1};
+  const OdomPose cartesian =
+    OdomArcMath::fromState(OdomArcMath::toState(pose, okapi::StateMode::CARTESIAN),
+                           okapi::StateMode::CARTESIAN);
+  HOST_CHECK_NEAR(OdomArcMath::toState(pose, okapi::StateMode::CARTESIAN).x.convert(okapi::meter),
+                  -0.5, 1e-12);
+  HOST_CHECK_NEAR(cartesian.x, pose.x, 1e-12);
+  HOST_CHECK_NEAR(cartesian.y, pose.y, 1e-12);
+  HOST_CHECK_NEAR(cartesian.theta, pose.theta, 1e-12);
+}
+
+HOST_TEST(highRateOdometryReplaysTrace) {
+  std::vector<std::vector<double>> trace;
+  HOST_CHECK(hostReadCsv(ODOM_TEST_TRACE, trace));
+  if (trace.empty()) {
+    return;
+  }
+
+  hostMicros = 0;
+  auto model = std::make_shared<TraceModel>();
+  HighRateOdometry odom(hostTimeUtil(), model, traceScales());
+
+  std::vector<std::vector<double>> poses;
+  double squaredError = 0;
+  double maxError = 0;
+  std::size_t samples = 0;
+  std::uint64_t nanos = 0;
+  std::uint64_t allocations = 0;
+
+  for (const auto &row : trace) {
+    if (static_cast<int>(row.at(marker)) != MARK_TRACE) {
+      continue;
+    }
+    hostMicros = static_cast<std::uint64_t>(row[timestampMs]) * 1000;
+    model->left = static_cast<std::int32_t>(row[encoderLeft]);
+    model->right = static_cast<std::int32_t>(row[encoderRight]);
+
+    const std::uint64_t allocationsBefore = hostAllocations();
+    const std::uint64_t start = hostNanos();
+    odom.step();
+    nanos += hostNanos() - start;
+    allocations += hostAllocations() - allocationsBefore;
+
+    const OdomSample sample = odom.getSample();
+    const double error = std::hypot(sample.pose.x - row[xM], sample.pose.y - row[yM]);
+    squaredError += error * error;
+    maxError = std::max(maxError, error);
+    if (samples++ % ODOM_TEST_POSE_EVERY == 0) {
+      poses.push_back({row[timestampMs], sample.pose.x, sample.pose.y, sample.pose.theta,
+                       sample.linearVelocity, sample.angularVelocity});
+    }
+  }
+  const OdomSample last = odom.getSample();
+  const auto &end = trace.back();
+  const double headingError = std::abs(last.pose.theta * 180 / okapi::pi - end[thetaDeg]);
+  hostReport("%zu samples: rms pose error %.1f mm, max %.1f mm, final heading error %.2f deg",
+             samples, 1000 * std::sqrt(squaredError / samples), 1000 * maxError, headingError);
+  hostReport("%.0f ns per sample, %llu allocations", static_cast<double>(nanos) / samples,
+             static_cast<unsigned long long>(allocations));
+
+  HOST_CHECK(allocations == 0);
+  HOST_CHECK(maxError < 0.02);
+  HOST_CHECK(headingError < 0.5);
+  hostGolden("odomTracePoses.csv", "timestamp_ms,x_m,y_m,theta_rad,v_mps,omega_radps", poses, 1e-6);
+
+  // the history answers for the middle of the trace like the published poses did
+  const auto &middle = poses[poses.size() - 2];
+  const okapi::OdomState past = odom.getStateAt(middle[0] * okapi::millisecond);
+  HOST_CHECK_NEAR(past.x.convert(okapi::meter), middle[1], 1e-9);
+  HOST_CHECK_NEAR(past.y.convert(okapi::meter), middle[2], 1e-9);
+}
+
+HOST_TEST(okapiOdometryReplaysTrace) {
+  std::vector<std::vector<double>> trace;
+  HOST_CHECK(hostReadCsv(ODOM_TEST_TRACE, trace));
+  if (trace.empty()) {
+    return;
+  }
+
+  hostMicros = 0;
+  auto model = std::make_shared<TraceModel>();
+  HighRateOdometry highRate(hostTimeUtil(), model, traceScales());
+  okapi::TwoEncoderOdometry twoEncoder(hostTimeUtil(), model, traceScales());
+
+  PoseError truthError, difference;
+  std::size_t samples = 0;
+  for (const auto &row : trace) {
+    if (static_cast<int>(row.at(marker)) != MARK_TRACE) {
+      continue;
+    }
+    hostMicros = static_cast<std::uint64_t>(row[timestampMs]) * 1000;
+    model->left = static_cast<std::int32_t>(row[encoderLeft]);
+    model->right = static_cast<std::int32_t>(row[encoderRight]);
+    highRate.step();
+    twoEncoder.step();
+    samples++;
+
+    const OdomPose pose = okapiPose(twoEncoder);
+    addError(truthError, pose, OdomPose{row[xM], row[yM], row[thetaDeg] * okapi::pi / 180});
+    addError(difference, pose, highRate.getSample().pose);
+  }
+  hostReport("%zu samples: TwoEncoderOdometry max pose error %.1f mm, %.1f mm from "
+             "HighRateOdometry, heading %.3f deg",
+             samples, 1000 * truthError.max, 1000 * difference.max,
+             difference.heading * 180 / okapi::pi);
+
+  // both integrate the same arcs, at most a rounding apart
+  HOST_CHECK(truthError.max < 0.02);
+  HOST_CHECK(difference.max < 1e-3);
+  HOST_CHECK(difference.heading < 1e-6);
+}
+
+HOST_TEST(odometryMatchesClosedFormTrace) {
+  const double pi = okapi::pi;
+  const std::vector<TraceSegment> segments{
+    {1.0, 0, 1500},                   // straight ahead
+    {0.6 * pi / 2, pi / 2, 1500},     // clockwise quarter circle of radius 0.6
+    {0, -pi / 2, 800},                // turn left in place
+    {0.4 * pi, -pi, 2000},            // counterclockwise half circle of radius 0.4
+    {0.5, 0, 800}};
+  const auto trace = closedFormTrace(segments);
+
+  // the closed form itself, checked by hand at the end of each segment
+  const auto truthAt = [&](std::uint32_t itimestamp) {
+    return std::find_if(trace.begin(), trace.end(), [&](const ClosedFormSample &sample) {
+             return sample.timestamp == itimestamp;
+           })->truth;
+  };
+  const OdomPose corner = truthAt(3000);
+  HOST_CHECK_NEAR(truthAt(1500).x, 1, 1e-12);
+  HOST_CHECK_NEAR(corner.x, 1.6, 1e-12);
+  HOST_CHECK_NEAR(corner.y, 0.6, 1e-12);
+  HOST_CHECK_NEAR(corner.theta, pi / 2, 1e-12);
+  HOST_CHECK_NEAR(truthAt(3800).theta, 0, 1e-12);
+  HOST_CHECK_NEAR(truthAt(5800).y, -0.2, 1e-12);
+  const OdomPose end = trace.back().truth;
+  HOST_CHECK_NEAR(end.x, 1.1, 1e-12);
+  HOST_CHECK_NEAR(end.y, -0.2, 1e-12);
+  HOST_CHECK_NEAR(end.theta, -pi, 1e-12);
+
+  hostMicros = 0;
+  auto model = std::make_shared<TraceModel>();
+  HighRateOdometry highRate(hostTimeUtil(), model, traceScales());
+  okapi::TwoEncoderOdometry twoEncoder(hostTimeUtil(), model, traceScales());
+  okapi::ThreeEncoderOdometry threeEncoder(hostTimeUtil(), model, middleWheelScales());
+
+  PoseError highRateError, twoEncoderError, threeEncoderError;
+  for (const auto &sample : trace) {
+    hostMicros = static_cast<std::uint64_t>(sample.timestamp) * 1000;
+    model->left = sample.left;
+    model->right = sample.right;
+    model->middle = sample.middle;
+    highRate.step();
+    twoEncoder.step();
+    threeEncoder.step();
+
+    addError(highRateError, highRate.getSample().pose, sample.truth);
+    addError(twoEncoderError, okapiPose(twoEncoder), sample.truth);
+    addError(threeEncoderError, okapiPose(threeEncoder), sample.truth);
+  }
+  hostReport("%zu samples over %.2f m, max error against the closed form:", trace.size(),
+             1.0 + 0.6 * pi / 2 + 0.4 * pi + 0.5);
+  hostReport("%-22s %8s %11s", "", "pose mm", "heading deg");
+  hostReport("%-22s %8.2f %11.3f", "HighRateOdometry", 1000 * highRateError.max,
+             highRateError.heading * 180 / pi);
+  hostReport("%-22s %8.2f %11.3f", "TwoEncoderOdometry", 1000 * twoEncoderError.max,
+             twoEncoderError.heading * 180 / pi);
+  hostReport("%-22s %8.2f %11.3f", "ThreeEncoderOdometry", 1000 * threeEncoderError.max,
+             threeEncoderError.heading * 180 / pi);
+
+  // what is left is the rounding of the counts to whole ticks
+  const double tick = 1 / traceScales().straight;
+  const double tickHeading = tick / ODOM_TEST_TRACK;
+  HOST_CHECK(highRateError.max < 5 * tick);
+  HOST_CHECK(twoEncoderError.max < 5 * tick);
+  HOST_CHECK(threeEncoderError.max < 5 * tick);
+  HOST_CHECK(highRateError.heading <= tickHeading);
+  HOST_CHECK(twoEncoderError.heading <= tickHeading);
+  HOST_CHECK(threeEncoderError.heading <= tickHeading);
+}
+
+HOST_TEST(odomMathFindsPoints) {
+  using namespace okapi;
+  const OdomState facingRight{1_m, 1_m, 90_deg};
+
+  const auto [distance, angle] = OdomMath::computeDistanceAndAngleToPoint({1_m, 3_m}, facingRight);
+  HOST_CHECK_NEAR(distance.convert(meter), 2, 1e-12);
+  HOST_CHECK_NEAR(angle.convert(degree), 0, 1e-9);
+
+  // x is forward and y to the right, so facing +y the point at lower x is on the right
+  HOST_CHECK_NEAR(OdomMath::computeAngleToPoint({0_m, 1_m}, facingRight).convert(degree), 90,
+                  1e-9);
+  HOST_CHECK_NEAR(OdomMath::computeAngleToPoint({2_m, 0_m}, facingRight).convert(degree), -135,
+                  1e-9);
+  HOST_CHECK_NEAR(OdomMath::computeDistanceToPoint({4_m, 5_m}, facingRight).convert(meter), 5,
+                  1e-12);
+
+  HOST_CHECK_NEAR(OdomMath::constrainAngle180(270_deg).convert(degree), -90, 1e-9);
+  HOST_CHECK_NEAR(OdomMath::constrainAngle180(-190_deg).convert(degree), 170, 1e-9);
+  HOST_CHECK_NEAR(OdomMath::constrainAngle360(-90_deg).convert(degree), 270, 1e-9);
+  HOST_CHECK_NEAR(OdomMath::constrainAngle360(720_deg).convert(degree), 0, 1e-9);
+}
+
+HOST_TEST(highRateOdometryDropsGlitches) {
+  hostMicros = 0;
+  auto model = std::make_shared<TraceModel>();
+  HighRateOdometry odom(hostTimeUtil(), model, traceScales(), 200 * okapi::Hz, 10000);
+  odom.step();
+
+  // 40 ticks in 5ms is within 10000 ticks/s
+  hostMicros += 5000;
+  model->left = model->right = 40;
+  odom.step();
+  const double afterGood = odom.getSample().pose.x;
+  HOST_CHECK(afterGood > 0);
+
+  // a jump of 1000 ticks in 5ms is a glitch, the pose stays
+  hostMicros += 5000;
+  model->left = model->right = 1040;
+  odom.step();
+  HOST_CHECK_NEAR(odom.getSample().pose.x, afterGood, 1e-12);
+
+  // a late sample may carry more ticks: 150 ticks in 20ms is fine
+  hostMicros += 20000;
+  model->left = model->right = 1190;
+  odom.step();
+  HOST_CHECK_NEAR(odom.getSample().pose.x, afterGood * 150 / 40 + afterGood, 1e-9);
+  HOST_CHECK_NEAR(odom.getSample().linearVelocity, 150 / traceScales().straight / 0.02, 1e-9);
+
+  odom.setState(okapi::OdomState{1 * okapi::meter, 2 * okapi::meter, 90 * okapi::degree});
+  HOST_CHECK_NEAR(odom.getState().y.convert(okapi::meter), 2, 1e-12);
+  HOST_CHECK_NEAR(odom.getState().theta.convert(okapi::degree), 90, 1e-9);
+}
+
+HOST_TEST(poseHistoryInterpolates) {
+  PoseHistory<8> history;
+  OdomPose out;
+  HOST_CHECK(!history.getPoseAt(0, out));
+
+  for (std::uint32_t i = 0; i < 20; i++) {
+    history.push(100 + 10 * i, OdomPose{static_cast<double>(i), 2.0 * i, 0.1 * i});
+  }
+  HOST_CHECK(history.size() == 8);
+
+  // between the samples at 270 and 280
+  HOST_CHECK(history.getPoseAt(274, out));
+  HOST_CHECK_NEAR(out.x, 17.4, 1e-12);
+  HOST_CHECK_NEAR(out.y, 34.8, 1e-12);
+  HOST_CHECK_NEAR(out.theta, 1.74, 1e-12);
+
+  // newer than the last sample
+  HOST_CHECK(history.getPoseAt(1000, out));
+  HOST_CHECK_NEAR(out.x, 19, 1e-12);
+
+  // older than the history: the oldest sample kept, one slot is left for the writer
+  HOST_CHECK(!history.getPoseAt(100, out));
+  HOST_CHECK_NEAR(out.x, 13, 1e-12);
+}
+
+HOST_TEST(seqLockReadsAreConsistent) {
+  SeqLock<TestValue> lock(TestValue{0, 0, 0});
+  HOST_CHECK(lock.version() == 0);
+
+  std::atomic_bool done{false};
+  std::atomic<int> torn{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; i++) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        const TestValue value = lock.read();
+        if (value.b != value.a * 3 || value.c != static_cast<std::uint64_t>(value.a) * 7) {
+          torn++;
+        }
+        std::this_thread::yield();
+      }
+    });
+  }
+
+  const std::uint32_t writes = 200000;
+  for (std::uint32_t i = 1; i <= writes; i++) {
+    lock.write(TestValue{i, i * 3, static_cast<std::uint64_t>(i) * 7});
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  HOST_CHECK(torn == 0);
+  HOST_CHECK(lock.version() == writes);
+  HOST_CHECK(lock.read().a == writes);
+}
+
+HOST_TEST(ringBufferKeepsOrder) {
+  RingBuffer<int, 4> ring;
+  int item = 0;
+  HOST_CHECK(ring.empty());
+  HOST_CHECK(!ring.pop(item));
+
+  for (int i = 0; i < 4; i++) {
+    HOST_CHECK(ring.push(i));
+  }
+  HOST_CHECK(!ring.push(4));
+  HOST_CHECK(ring.pop(item) && item == 0);
+  HOST_CHECK(ring.push(4));
+
+  int block[8];
+  HOST_CHECK(ring.popBlock(block, 8) == 4);
+  HOST_CHECK(block[0] == 1 && block[3] == 4);
+  HOST_CHECK(ring.empty());
+
+  // one producer and one consumer thread, nothing lost or reordered
+  RingBuffer<std::uint32_t, 64> shared;
+  const std::uint32_t count = 100000;
+  std::thread producer([&] {
+    for (std::uint32_t i = 0; i < count;) {
+      if (shared.push(i)) {
+        i++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  std::uint32_t expected = 0;
+  bool inOrder = true;
+  const std::uint64_t allocationsBefore = hostAllocations();
+  while (expected < count) {
+    std::uint32_t items[16];
+    const std::size_t popped = shared.popBlock(items, 16);
+    if (popped == 0) {
+      std::this_thread::yield();
+    }
+    for (std::size_t i = 0; i < popped; i++) {
+      inOrder = inOrder && items[i] == expected;
+      expected++;
+    }
+  }
+  const std::uint64_t allocations = hostAllocations() - allocationsBefore;
+  producer.join();
+
+  HOST_CHECK(inOrder);
+  HOST_CHECK(allocations == 0);
+}
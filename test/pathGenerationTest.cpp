@@ -0,0 +1,218 @@
+// ------- pathGenerationTest.cpp ----------------------------------------------
+//
+// Host tests and benchmarks of PathGeneration. They link the Pathfinder C
+// sources like "make paths" does and are left out when PATHFINDER_DIR does not
+// have them (HOST_TEST_PATHFINDER, see the Makefile); the run then lists them
+// as skipped.
+
+#include "hostTest.h"
+
+#ifdef HOST_TEST_PATHFINDER
+
+#include "pathGeneration.h"
+
+#include <cstdio>
+
+#define PATH_TEST_TRACK 0.375         // m
+#define PATH_TEST_VEL 1.0             // m/s
+#define PATH_TEST_ACCEL 2.0           // m/s^2
+#define PATH_TEST_JERK 10.0           // m/s^3
+
+namespace {
+/**
+ * A path weaving 0.3 m left and right of a straight line, one waypoint every 0.6 m.
+ *
+ * @param icount The number of waypoints.
+ */
+std::vector<Waypoint> weave(const int icount) {
+  std::vector<Waypoint> points;
+  for (int i = 0; i < icount; i++) {
+    points.push_back(Waypoint{0.6 * i, i % 2 == 0 ? 0.0 : 0.3, 0});
+  }
+  return points;
+}
+
+/**
+ * @return The time PathGeneration::tank() takes in ms, or -1 if the path is impossible.
+ */
+double generationMillis(const std::vector<Waypoint> &iwaypoints,
+                        const int isamples,
+                        const PathGenerator igenerator,
+                        int &olength) {
+  std::vector<Segment> left, right;
+  const std::uint64_t start = hostNanos();
+  olength = PathGeneration::tank(iwaypoints, PATH_TEST_VEL, PATH_TEST_ACCEL, PATH_TEST_JERK,
+                                 PATH_TEST_TRACK, left, right, isamples, igenerator);
+  const std::uint64_t nanos = hostNanos() - start;
+  return olength > 0 ? nanos / 1e6 : -1;
+}
+
+struct TestPath {
+  const char *name;
+  std::vector<Waypoint> waypoints;
+};
+
+std::vector<TestPath> testPaths() {
+  return {{"straight 3 m", {Waypoint{0, 0, 0}, Waypoint{3, 0, 0}}},
+          {"90 deg turn", {Waypoint{0, 0, 0}, Waypoint{1, 1, PI / 2}}},
+          {"S curve", {Waypoint{0, 0, 0}, Waypoint{1.5, 0.6, 0}, Waypoint{3, 0, 0}}},
+          {"weave x9", weave(9)}};
+}
+
+/**
+ * @return The largest wheel velocity of a tank path.
+ */
+double fastestWheel(const std::vector<Segment> &ileft, const std::vector<Segment> &iright) {
+  double fastest = 0;
+  for (std::size_t i = 0; i < ileft.size(); i++) {
+    fastest = std::max({fastest, std::abs(ileft[i].velocity), std::abs(iright[i].velocity)});
+  }
+  return fastest;
+}
+} // namespace
+
+HOST_TEST(pathFromPoseIsRobotRelative) {
+  // the robot at (1, 2) facing +y in okapi's frame, so +x is on its left
+  const std::vector<Waypoint> path = PathGeneration::fromPose(
+    1, 2, PI / 2, {Waypoint{1, 3, PI / 2}, Waypoint{2, 2, PI}});
+
+  HOST_CHECK(path.size() == 3);
+  HOST_CHECK_NEAR(path[0].x, 0, 1e-12);
+  HOST_CHECK_NEAR(path[0].angle, 0, 1e-12);
+  // 1 m straight ahead, same heading
+  HOST_CHECK_NEAR(path[1].x, 1, 1e-12);
+  HOST_CHECK_NEAR(path[1].y, 0, 1e-12);
+  HOST_CHECK_NEAR(path[1].angle, 0, 1e-12);
+  // 1 m to the left, facing right: pathfinder's y is left and its angles counterclockwise
+  HOST_CHECK_NEAR(path[2].x, 0, 1e-12);
+  HOST_CHECK_NEAR(path[2].y, 1, 1e-12);
+  HOST_CHECK_NEAR(path[2].angle, -PI / 2, 1e-12);
+
+  // the generated path ends at the waypoint
+  std::vector<Segment> left, right;
+  const int length = PathGeneration::tank({path[0], path[1]}, PATH_TEST_VEL, PATH_TEST_ACCEL,
+                                          PATH_TEST_JERK, PATH_TEST_TRACK, left, right);
+  HOST_CHECK(length > 0);
+  if (length > 0) {
+    HOST_CHECK_NEAR((left.back().x + right.back().x) / 2, 1, 1e-3);
+    HOST_CHECK_NEAR((left.back().y + right.back().y) / 2, 0, 1e-3);
+  }
+}
+
+HOST_TEST(curvatureProfileKeepsLimits) {
+  for (const auto &path : testPaths()) {
+    std::vector<Segment> center;
+    const int length = PathGeneration::curvatureLimited(
+      path.waypoints, PATH_TEST_VEL, PATH_TEST_ACCEL, PATH_TEST_TRACK, PATH_SAMPLES_QUADRATURE,
+      center);
+    std::vector<Segment> left, right;
+    const int tankLength =
+      PathGeneration::tank(path.waypoints, PATH_TEST_VEL, PATH_TEST_ACCEL, PATH_TEST_JERK,
+                           PATH_TEST_TRACK, left, right, PATH_SAMPLES_QUADRATURE,
+                           PathGenerator::curvature);
+    std::vector<Segment> pathfinderLeft, pathfinderRight;
+    const int pathfinderLength =
+      PathGeneration::tank(path.waypoints, PATH_TEST_VEL, PATH_TEST_ACCEL, PATH_TEST_JERK,
+                           PATH_TEST_TRACK, pathfinderLeft, pathfinderRight);
+    HOST_CHECK(length > 0 && tankLength == length && pathfinderLength > 0);
+    if (length <= 0 || tankLength != length || pathfinderLength <= 0) {
+      continue;
+    }
+
+    // speed and sideways acceleration of the center
+    double worstAccel = 0;
+    double worstSideways = 0;
+    for (int i = 1; i < length; i++) {
+      const double ds = center[i].position - center[i - 1].position;
+      worstAccel = std::max(worstAccel, std::abs(center[i].acceleration));
+      if (ds > 1e-4) {
+        const double curvature =
+          std::abs(std::remainder(center[i].heading - center[i - 1].heading, 2 * PI)) / ds;
+        worstSideways = std::max(worstSideways, center[i].velocity * center[i].velocity * curvature);
+      }
+    }
+    const double wheel = fastestWheel(left, right);
+    const double pathfinderWheel = fastestWheel(pathfinderLeft, pathfinderRight);
+
+    hostReport("%-13s curvature %5.2f s (wheels up to %.2f m/s, sideways %.2f m/s^2), "
+               "pathfinder %5.2f s (wheels up to %.2f m/s)",
+               path.name, length * PATH_GENERATION_DT, wheel, worstSideways,
+               pathfinderLength * PATH_GENERATION_DT, pathfinderWheel);
+
+    HOST_CHECK(worstAccel <= PATH_TEST_ACCEL * 1.001);
+    HOST_CHECK(worstSideways <= PATH_TEST_ACCEL * 1.05);
+    HOST_CHECK(wheel <= PATH_TEST_VEL * 1.02);
+    HOST_CHECK_NEAR(center.back().velocity, 0, 1e-9);
+  }
+
+  // without curves it is never slower, pathfinder also limits jerk
+  std::vector<Segment> left, right;
+  const int straight = PathGeneration::tank(testPaths()[0].waypoints, PATH_TEST_VEL,
+                                            PATH_TEST_ACCEL, PATH_TEST_JERK, PATH_TEST_TRACK,
+                                            left, right, PATH_SAMPLES_QUADRATURE,
+                                            PathGenerator::curvature);
+  const int pathfinderStraight =
+    PathGeneration::tank(testPaths()[0].waypoints, PATH_TEST_VEL, PATH_TEST_ACCEL,
+                         PATH_TEST_JERK, PATH_TEST_TRACK, left, right);
+  HOST_CHECK(straight <= pathfinderStraight);
+}
+
+HOST_TEST(curvatureProfileOfShortPaths) {
+  // no longer than PATH_CURVATURE_STEP, down to a fraction of a millimeter
+  for (const double distance : {0.005, 0.004, 0.0001}) {
+    std::vector<Segment> center;
+    const int length = PathGeneration::curvatureLimited(
+      {Waypoint{0, 0, 0}, Waypoint{distance, 0, 0}}, PATH_TEST_VEL, PATH_TEST_ACCEL,
+      PATH_TEST_TRACK, PATH_SAMPLES_QUADRATURE, center);
+    HOST_CHECK(length > 0);
+    if (length <= 0) {
+      continue;
+    }
+    bool finite = true;
+    for (const auto &segment : center) {
+      finite = finite && std::isfinite(segment.position) && std::isfinite(segment.velocity) &&
+               std::isfinite(segment.acceleration) && std::isfinite(segment.heading);
+    }
+    HOST_CHECK(finite);
+    HOST_CHECK_NEAR(center.back().position, distance, 1e-9);
+    // a triangle profile: 2 * sqrt(distance / accel)
+    HOST_CHECK(length * PATH_GENERATION_DT < 2 * std::sqrt(distance / PATH_TEST_ACCEL) + 0.02);
+  }
+}
+
+HOST_BENCH(pathGenerationTimeVsWaypoints) {
+  struct Setting {
+    const char *name;
+    int samples;
+    PathGenerator generator;
+  } settings[] = {{"pathfinder 1k", PATHFINDER_SAMPLES_FAST, PathGenerator::pathfinder},
+                  {"pathfinder 10k", PATHFINDER_SAMPLES_LOW, PathGenerator::pathfinder},
+                  {"pathfinder 100k", PATHFINDER_SAMPLES_HIGH, PathGenerator::pathfinder},
+                  {"quadrature", PATH_SAMPLES_QUADRATURE, PathGenerator::pathfinder},
+                  {"curvature", PATH_SAMPLES_QUADRATURE, PathGenerator::curvature}};
+
+  hostReport("waypoints  segments  generation time in ms");
+  hostReport("%19s%17s%17s%17s%17s%17s", "", settings[0].name, settings[1].name,
+             settings[2].name, settings[3].name, settings[4].name);
+  for (const int count : {2, 3, 5, 9, 17, 33}) {
+    const std::vector<Waypoint> waypoints = weave(count);
+    char line[256];
+    int used = 0;
+    int segments = 0;
+    for (const auto &setting : settings) {
+      int length = 0;
+      const double ms = generationMillis(waypoints, setting.samples, setting.generator, length);
+      if (setting.generator == PathGenerator::pathfinder) {
+        segments = length;
+      }
+      used += std::snprintf(line + used, sizeof(line) - used, "%17.2f", ms);
+    }
+    hostReport("%9d  %8d%s", count, segments, line);
+  }
+}
+
+#else
+
+HOST_SKIP(pathGenerationTest, "no PATHFINDER_DIR");
+
+#endif
@@ -0,0 +1,341 @@
+// ------- purePursuitTest.cpp -------------------------------------------------
+//
+// Host tests of the pure pursuit follower: the path PursuitPath prepares
+// (spacing, curvature, speed limits), how PurePursuitController places its
+// lookahead point, and the follower driving the simulated skid steer chassis
+// of hostChassis.h around a circle and an L shaped corner. The benchmark
+// drives the same waypoints once along a pursuit path and once the okapi way,
+// turning on the spot and driving to one waypoint after the other with
+// driveToPoint(), and compares the time each takes.
+
+#include "hostChassis.h"
+#include "hostTest.h"
+
+#include "purePursuitController.h"
+#include "telemetry.h"
+
+#include "okapi/api/odometry/odomMath.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace okapi::literals;
+
+#define PURSUIT_TEST_RADIUS 0.8        // m, the circle followed
+#define PURSUIT_TEST_ARC_POINTS 24     // waypoints on the half circle
+#define PURSUIT_TEST_SPEED 0.8         // m/s
+#define PURSUIT_TEST_CORNER 1.2        // m, leg length of the L shaped path
+
+namespace {
+/**
+ * Exposes the follower's lookahead search.
+ */
+class TestPursuitController : public PurePursuitController {
+  public:
+  using PurePursuitController::PurePursuitController;
+
+  void start(const std::vector<PursuitPoint> &ipath) {
+    closestIndex = 0;
+    lookaheadIndex = 0;
+    lookaheadX = ipath[0].x;
+    lookaheadY = ipath[0].y;
+  }
+
+  void lookAhead(const std::vector<PursuitPoint> &ipath,
+                 double ix,
+                 double iy,
+                 double ilookahead) {
+    updateClosest(ipath, ix, iy);
+    updateLookahead(ipath, ix, iy, ilookahead);
+  }
+
+  double getLookaheadIndex() const {
+    return lookaheadIndex;
+  }
+
+  double getLookaheadX() const {
+    return lookaheadX;
+  }
+
+  double getLookaheadY() const {
+    return lookaheadY;
+  }
+};
+
+PursuitPathLimits testLimits(double ismoothing = 0.8) {
+  PursuitPathLimits limits;
+  limits.maxVelocity = PURSUIT_TEST_SPEED;
+  limits.smoothing = ismoothing;
+  return limits;
+}
+
+/**
+ * Waypoints on a clockwise half circle starting at the origin heading along +x.
+ */
+std::vector<okapi::Point> halfCircle() {
+  std::vector<okapi::Point> waypoints;
+  for (int i = 0; i <= PURSUIT_TEST_ARC_POINTS; i++) {
+    const double angle = okapi::pi * i / PURSUIT_TEST_ARC_POINTS;
+    waypoints.push_back({PURSUIT_TEST_RADIUS * std::sin(angle) * okapi::meter,
+                         PURSUIT_TEST_RADIUS * (1 - std::cos(angle)) * okapi::meter});
+  }
+  return waypoints;
+}
+
+std::vector<okapi::Point> lCorner() {
+  return {{0_m, 0_m},
+          {PURSUIT_TEST_CORNER * okapi::meter, 0_m},
+          {PURSUIT_TEST_CORNER * okapi::meter, PURSUIT_TEST_CORNER * okapi::meter}};
+}
+
+/**
+ * A simulated chassis standing at the origin, facing +x.
+ */
+struct TestRobot {
+  std::shared_ptr<SimDrive> drive;
+  std::shared_ptr<SimChassisController> chassis;
+
+  TestRobot() {
+    hostMicros = 0;
+    drive = std::make_shared<SimDrive>();
+    chassis = std::make_shared<SimChassisController>(drive);
+    hostTelemetryReset();
+  }
+};
+
+/**
+ * @return The largest distance of a pose in itrace from the polyline through iwaypoints.
+ */
+double largestDeviation(const std::vector<OdomPose> &itrace,
+                        const std::vector<okapi::Point> &iwaypoints) {
+  double largest = 0;
+  for (const auto &pose : itrace) {
+    double nearest = INFINITY;
+    for (std::size_t i = 0; i + 1 < iwaypoints.size(); i++) {
+      const double ax = iwaypoints[i].x.convert(okapi::meter);
+      const double ay = iwaypoints[i].y.convert(okapi::meter);
+      const double dx = iwaypoints[i + 1].x.convert(okapi::meter) - ax;
+      const double dy = iwaypoints[i + 1].y.convert(okapi::meter) - ay;
+      const double t =
+        std::clamp(((pose.x - ax) * dx + (pose.y - ay) * dy) / (dx * dx + dy * dy), 0.0, 1.0);
+      nearest = std::min(nearest, std::hypot(pose.x - ax - t * dx, pose.y - ay - t * dy));
+    }
+    largest = std::max(largest, nearest);
+  }
+  return largest;
+}
+} // namespace
+
+HOST_TEST(pursuitPathProfile) {
+  const PursuitPathLimits limits = testLimits();
+  const auto path = PursuitPath::generate(lCorner(), limits);
+  HOST_CHECK(path.size() > 2 * PURSUIT_TEST_CORNER / limits.spacing);
+  HOST_CHECK(PursuitPath::generate({{0_m, 0_m}}, limits).empty());
+  if (path.size() < 3) {
+    return;
+  }
+
+  bool spaced = true, slowInCurves = true, rampsDown = true;
+  std::size_t sharpest = 0;
+  for (std::size_t i = 1; i < path.size(); i++) {
+    const double gap = path[i].distance - path[i - 1].distance;
+    // smoothing may pull a point a little off the even spacing
+    spaced = spaced && gap > 0 && gap <= 1.01 * limits.spacing;
+    if (path[i].curvature > path[sharpest].curvature) {
+      sharpest = i;
+    }
+    if (path[i].curvature > 0) {
+      slowInCurves =
+        slowInCurves && path[i].velocity <= limits.turnConstant / path[i].curvature + 1e-9;
+    }
+    // never slower than braking at maxAcceleration allows
+    rampsDown = rampsDown && path[i - 1].velocity * path[i - 1].velocity <=
+                               path[i].velocity * path[i].velocity +
+                                 2 * limits.maxAcceleration * gap + 1e-9;
+  }
+  hostReport("%zu points over %.3f m, sharpest curvature %.2f 1/m at %.3f m, %.2f m/s there",
+             path.size(), path.back().distance, path[sharpest].curvature,
+             path[sharpest].distance, path[sharpest].velocity);
+
+  HOST_CHECK(spaced);
+  HOST_CHECK(slowInCurves);
+  HOST_CHECK(rampsDown);
+  HOST_CHECK_NEAR(path.front().x, 0, 1e-12);
+  HOST_CHECK_NEAR(path.back().y, PURSUIT_TEST_CORNER, 1e-12);
+  HOST_CHECK(path.back().velocity == 0);
+  HOST_CHECK(path.front().velocity == limits.maxVelocity);
+
+  // the corner is rounded off: the sharpest curve is at the corner, the legs stay straight
+  HOST_CHECK_NEAR(path[sharpest].distance, PURSUIT_TEST_CORNER, 0.15);
+  HOST_CHECK(path[sharpest].velocity < limits.maxVelocity);
+  HOST_CHECK(path[path.size() / 6].curvature < 0.05);
+
+  // waypoints on a circle: without smoothing the turning happens at the waypoints, the points
+  // filled in between are straight; smoothed, it spreads out. Both turn by as much.
+  for (const double smoothing : {0.0, 0.8}) {
+    const auto arc = PursuitPath::generate(halfCircle(), testLimits(smoothing));
+    double turn = 0, least = INFINITY, most = 0;
+    const std::size_t from = arc.size() / 4, to = 3 * arc.size() / 4;
+    for (std::size_t i = from; i < to; i++) {
+      turn += arc[i].curvature * (arc[i + 1].distance - arc[i - 1].distance) / 2;
+      least = std::min(least, arc[i].curvature);
+      most = std::max(most, arc[i].curvature);
+    }
+    const double curvature = turn / (arc[to].distance - arc[from].distance);
+    hostReport("half circle, smoothing %.1f: curvature %.3f 1/m on average, %.3f .. %.3f",
+               smoothing, curvature, least, most);
+    HOST_CHECK_NEAR(curvature, 1 / PURSUIT_TEST_RADIUS, 0.05 / PURSUIT_TEST_RADIUS);
+    HOST_CHECK_NEAR(arc.back().distance, okapi::pi * PURSUIT_TEST_RADIUS, 0.03);
+    if (smoothing > 0) {
+      HOST_CHECK(most < 1.5 / PURSUIT_TEST_RADIUS && least > 0.5 / PURSUIT_TEST_RADIUS);
+    } else {
+      HOST_CHECK(least < 0.01 && most > 2 / PURSUIT_TEST_RADIUS);
+    }
+  }
+
+  // StateMode::CARTESIAN waypoints are swapped into x forward, y right
+  const auto cartesian =
+    PursuitPath::generate({{0_m, 0_m}, {0_m, 1_m}}, limits, okapi::StateMode::CARTESIAN);
+  HOST_CHECK_NEAR(cartesian.back().x, 1, 1e-12);
+  HOST_CHECK_NEAR(cartesian.back().y, 0, 1e-12);
+}
+
+HOST_TEST(purePursuitLookahead) {
+  TestRobot robot;
+  TestPursuitController pursuit(hostTimeUtil(), robot.chassis);
+  const auto path = PursuitPath::generate({{0_m, 0_m}, {2_m, 0_m}}, testLimits(0));
+  pursuit.start(path);
+
+  // the point one lookahead from the robot, ahead on the path
+  pursuit.lookAhead(path, 0.3, 0.1, 0.5);
+  HOST_CHECK_NEAR(pursuit.getLookaheadX(), 0.3 + std::sqrt(0.5 * 0.5 - 0.1 * 0.1), 1e-9);
+  HOST_CHECK_NEAR(pursuit.getLookaheadY(), 0, 1e-12);
+  const double index = pursuit.getLookaheadIndex();
+
+  // it never goes back along the path, even when the robot does
+  pursuit.lookAhead(path, 0.1, 0, 0.5);
+  HOST_CHECK(pursuit.getLookaheadIndex() == index);
+
+  // a robot far off the path keeps the last point, the circle does not reach the path
+  pursuit.lookAhead(path, 1.0, 1.0, 0.5);
+  HOST_CHECK(pursuit.getLookaheadIndex() == index);
+
+  // a longer lookahead reaches further
+  pursuit.lookAhead(path, 0.3, 0, 0.8);
+  HOST_CHECK_NEAR(pursuit.getLookaheadX(), 1.1, 1e-9);
+
+  // driving on, once the robot is a lookahead behind that point again it stays one lookahead
+  // ahead until the circle passes the end of the path, then the end itself is aimed at
+  bool ahead = true;
+  for (double x = 0.6; x < 1.85; x += 0.05) {
+    pursuit.lookAhead(path, x, 0, 0.5);
+    ahead = ahead && std::abs(pursuit.getLookaheadX() - std::min(x + 0.5, 2.0)) < 1e-9;
+  }
+  HOST_CHECK(ahead);
+  HOST_CHECK(pursuit.getLookaheadIndex() == path.size() - 1);
+  HOST_CHECK_NEAR(pursuit.getLookaheadX(), 2, 1e-12);
+}
+
+HOST_TEST(purePursuitFollowsCircle) {
+  TestRobot robot;
+  PurePursuitController pursuit(hostTimeUtil(), robot.chassis);
+  robot.drive->startTrace();
+  const bool reached = pursuit.followPath(halfCircle(), testLimits());
+  const std::uint64_t micros = hostMicros;
+  const auto &trace = robot.drive->getTrace();
+  HOST_CHECK(reached);
+  if (trace.size() < 100) {
+    return;
+  }
+
+  // the curvature driven over the middle third, from the heading change per distance
+  const OdomPose &from = trace[trace.size() / 3];
+  const OdomPose &to = trace[2 * trace.size() / 3];
+  double distance = 0;
+  for (std::size_t i = trace.size() / 3 + 1; i <= 2 * trace.size() / 3; i++) {
+    distance += std::hypot(trace[i].x - trace[i - 1].x, trace[i].y - trace[i - 1].y);
+  }
+  const double curvature = (to.theta - from.theta) / distance;
+  const OdomPose end = robot.drive->getPose();
+  hostReport("%.2f s, curvature %.3f 1/m (circle %.3f), max cross track error %.1f mm, "
+             "end %.1f mm off",
+             micros / 1e6, curvature, 1 / PURSUIT_TEST_RADIUS,
+             1000 * hostTelemetryMaxError(TELEMETRY_ID_PURSUIT),
+             1000 * std::hypot(end.x, end.y - 2 * PURSUIT_TEST_RADIUS));
+
+  HOST_CHECK_NEAR(curvature, 1 / PURSUIT_TEST_RADIUS, 0.05 / PURSUIT_TEST_RADIUS);
+  HOST_CHECK(hostTelemetryMaxError(TELEMETRY_ID_PURSUIT) < 0.03);
+  HOST_CHECK(std::hypot(end.x, end.y - 2 * PURSUIT_TEST_RADIUS) < 0.05);
+  HOST_CHECK_NEAR(end.theta, okapi::pi, 0.15);
+
+  // stopped, and the distance driven is the half circle's
+  HOST_CHECK(robot.drive->leftMotor->getTargetVelocity() == 0);
+  HOST_CHECK_NEAR(robot.drive->getTravel(), okapi::pi * PURSUIT_TEST_RADIUS, 0.1);
+}
+
+HOST_TEST(purePursuitLookaheadCutsCorners) {
+  const double lookaheads[] = {0.15, 0.3, 0.6};
+  double deviations[3];
+  for (int i = 0; i < 3; i++) {
+    TestRobot robot;
+    PurePursuitController pursuit(hostTimeUtil(), robot.chassis, lookaheads[i] * okapi::meter,
+                                  lookaheads[i] * okapi::meter, 0_s);
+    robot.drive->startTrace();
+    HOST_CHECK(pursuit.followPath(lCorner(), testLimits(0.3)));
+    deviations[i] = largestDeviation(robot.drive->getTrace(), lCorner());
+    hostReport("lookahead %.2f m: %.2f s, %.1f mm inside the corner at most", lookaheads[i],
+               hostMicros / 1e6, 1000 * deviations[i]);
+  }
+
+  // a longer lookahead steers into the corner earlier and cuts it more
+  HOST_CHECK(deviations[0] < deviations[1]);
+  HOST_CHECK(deviations[1] < deviations[2]);
+  HOST_CHECK(deviations[0] < 0.1);
+}
+
+HOST_BENCH(purePursuitVsTurnThenDrive) {
+  const std::vector<okapi::Point> waypoints{
+    {0_m, 0_m}, {1.2_m, 0_m}, {1.8_m, 0.6_m}, {1.8_m, 1.5_m}, {0.9_m, 1.8_m}, {0.3_m, 1.2_m}};
+  double length = 0;
+  for (std::size_t i = 1; i < waypoints.size(); i++) {
+    length += okapi::OdomMath::computeDistanceToPoint(waypoints[i],
+                                                      {waypoints[i - 1].x, waypoints[i - 1].y})
+                .convert(okapi::meter);
+  }
+  hostReport("%zu waypoints, %.2f m of straight legs, %.2f m/s max, %.1f m/s^2", waypoints.size(),
+             length, PURSUIT_TEST_SPEED, testLimits().maxAcceleration);
+  hostReport("%-18s %8s %10s %12s %14s", "", "time s", "driven m", "end off mm",
+             "wall us/cycle");
+
+  const auto report = [&](const char *iname, TestRobot &irobot, std::uint64_t inanos) {
+    irobot.drive->settle();
+    const OdomPose end = irobot.drive->getPose();
+    const double endOff = std::hypot(end.x - waypoints.back().x.convert(okapi::meter),
+                                     end.y - waypoints.back().y.convert(okapi::meter));
+    const double cycles = hostMicros / 1000.0 / 10;
+    hostReport("%-18s %8.2f %10.2f %12.1f %14.2f", iname, hostMicros / 1e6,
+               irobot.drive->getTravel(), 1000 * endOff, inanos / 1000.0 / cycles);
+    return hostMicros / 1e6;
+  };
+
+  double pursuitTime, chainTime;
+  {
+    TestRobot robot;
+    PurePursuitController pursuit(hostTimeUtil(), robot.chassis);
+    const std::uint64_t start = hostNanos();
+    HOST_CHECK(pursuit.followPath(waypoints, testLimits()));
+    pursuitTime = report("pure pursuit", robot, hostNanos() - start);
+  }
+  {
+    // the same speed and acceleration limits for the chained moves
+    TestRobot robot;
+    robot.chassis->setMaxVelocity(PURSUIT_TEST_SPEED * robot.drive->rpmPerMeterPerSecond());
+    const std::uint64_t start = hostNanos();
+    for (std::size_t i = 1; i < waypoints.size(); i++) {
+      robot.chassis->driveToPoint(waypoints[i]);
+    }
+    chainTime = report("driveToPoint chain", robot, hostNanos() - start);
+  }
+  hostReport("pure pursuit takes %.0f%% of the time", 100 * pursuitTime / chainTime);
+  HOST_CHECK(pursuitTime < chainTime);
+}
@@ -0,0 +1,145 @@
+// ------- sensorSnapshotTest.cpp ----------------------------------------------
+//
+// Host tests that reading the tracking wheels through a SensorSnapshot does
+// not touch the heap, counted with the runner's operator new (hostTest.cpp),
+// while okapi's valarray getSensorVals() allocates on every read.
+
+#include "hostTest.h"
+
+#include "highRateOdometry.h"
+#include "trackingWheelModel.h"
+
+#define SNAPSHOT_TEST_READS 10000
+
+namespace {
+/**
+ * Encoder whose count the test sets.
+ */
+class FakeEncoder : public okapi::ContinuousRotarySensor {
+  public:
+  double value{0};
+
+  double get() const override {
+    return value;
+  }
+
+  std::int32_t reset() override {
+    value = 0;
+    return 1;
+  }
+
+  double controllerGet() override {
+    return get();
+  }
+};
+
+/**
+ * The same wheels without a SensorSnapshotSource, like a plain okapi model.
+ */
+class ValarrayModel : public okapi::ReadOnlyChassisModel {
+  public:
+  explicit ValarrayModel(std::shared_ptr<TrackingWheelModel> imodel) : model(std::move(imodel)) {
+  }
+
+  std::valarray<std::int32_t> getSensorVals() const override {
+    return model->getSensorVals();
+  }
+
+  protected:
+  std::shared_ptr<TrackingWheelModel> model;
+};
+
+okapi::ChassisScales wheelScales() {
+  return okapi::ChassisScales({2.75 * okapi::inch, 0.245 * okapi::meter}, okapi::quadEncoderTPR);
+}
+
+/**
+ * Steps an odometry over moving encoders.
+ *
+ * @return The allocations during the steps.
+ */
+std::uint64_t countStepAllocations(HighRateOdometry &iodom, FakeEncoder &ileft, FakeEncoder &iright) {
+  iodom.step();
+  const std::uint64_t before = hostAllocations();
+  for (int i = 0; i < SNAPSHOT_TEST_READS; i++) {
+    hostMicros += 5000;
+    ileft.value += 10;
+    iright.value += 9;
+    iodom.step();
+  }
+  return hostAllocations() - before;
+}
+} // namespace
+
+HOST_TEST(sensorSnapshotReadsWithoutAllocating) {
+  auto left = std::make_shared<FakeEncoder>();
+  auto right = std::make_shared<FakeEncoder>();
+  auto middle = std::make_shared<FakeEncoder>();
+  TrackingWheelModel twoWheels(left, right);
+  TrackingWheelModel threeWheels(left, right, middle);
+
+  SensorSnapshot snapshot;
+  bool same = true;
+  std::uint64_t before = hostAllocations();
+  const std::uint64_t startSnapshot = hostNanos();
+  for (int i = 0; i < SNAPSHOT_TEST_READS; i++) {
+    left->value = i;
+    right->value = -i;
+    middle->value = 2 * i;
+    twoWheels.getSensorVals(snapshot);
+    same = same && snapshot.count == 2 && snapshot[0] == i && snapshot[1] == -i;
+    threeWheels.getSensorVals(snapshot);
+    same = same && snapshot.count == 3 && snapshot[2] == 2 * i;
+  }
+  const std::uint64_t snapshotNanos = hostNanos() - startSnapshot;
+  const std::uint64_t snapshotAllocations = hostAllocations() - before;
+
+  before = hostAllocations();
+  const std::uint64_t startValarray = hostNanos();
+  for (int i = 0; i < SNAPSHOT_TEST_READS; i++) {
+    left->value = i;
+    const std::valarray<std::int32_t> vals = twoWheels.getSensorVals();
+    const std::valarray<std::int32_t> valsThree = threeWheels.getSensorVals();
+    same = same && vals.size() == 2 && vals[0] == i && valsThree.size() == 3;
+  }
+  const std::uint64_t valarrayNanos = hostNanos() - startValarray;
+  const std::uint64_t valarrayAllocations = hostAllocations() - before;
+
+  hostReport("SensorSnapshot: %llu allocations, %.1f ns per read",
+             static_cast<unsigned long long>(snapshotAllocations),
+             static_cast<double>(snapshotNanos) / (2 * SNAPSHOT_TEST_READS));
+  hostReport("valarray:       %llu allocations, %.1f ns per read",
+             static_cast<unsigned long long>(valarrayAllocations),
+             static_cast<double>(valarrayNanos) / (2 * SNAPSHOT_TEST_READS));
+
+  HOST_CHECK(same);
+  HOST_CHECK(snapshotAllocations == 0);
+  // shows the counter sees allocations at all
+  HOST_CHECK(valarrayAllocations >= 2 * SNAPSHOT_TEST_READS);
+}
+
+HOST_TEST(highRateOdometryStepsWithoutAllocating) {
+  auto left = std::make_shared<FakeEncoder>();
+  auto right = std::make_shared<FakeEncoder>();
+  auto wheels = std::make_shared<TrackingWheelModel>(left, right);
+
+  hostMicros = 0;
+  HighRateOdometry snapshotOdom(hostTimeUtil(), wheels, wheelScales());
+  const std::uint64_t snapshotAllocations = countStepAllocations(snapshotOdom, *left, *right);
+
+  left->reset();
+  right->reset();
+  hostMicros = 0;
+  HighRateOdometry valarrayOdom(hostTimeUtil(), std::make_shared<ValarrayModel>(wheels),
+                                wheelScales());
+  const std::uint64_t valarrayAllocations = countStepAllocations(valarrayOdom, *left, *right);
+
+  hostReport("%d steps: %llu allocations with a SensorSnapshotSource, %llu without",
+             SNAPSHOT_TEST_READS, static_cast<unsigned long long>(snapshotAllocations),
+             static_cast<unsigned long long>(valarrayAllocations));
+
+  HOST_CHECK(snapshotAllocations == 0);
+  HOST_CHECK(valarrayAllocations >= SNAPSHOT_TEST_READS);
+  HOST_CHECK_NEAR(snapshotOdom.getSample().pose.x, valarrayOdom.getSample().pose.x, 1e-12);
+  HOST_CHECK_NEAR(snapshotOdom.getSample().pose.theta, valarrayOdom.getSample().pose.theta, 1e-12);
+}
@@ -0,0 +1,110 @@
+// ------- splineArcLengthTest.cpp ---------------------------------------------
+//
+// Host test and benchmark of SplineArcLength against pathfinder's sampled arc
+// length, pf_spline_distance() and pf_spline_progress_for_distance(). Built
+// only with the Pathfinder C sources (HOST_TEST_PATHFINDER, see the Makefile),
+// listed as skipped without them.
+
+#include "hostTest.h"
+
+#ifdef HOST_TEST_PATHFINDER
+
+#include "splineArcLength.h"
+
+#include <cstdio>
+
+extern "C" {
+#include "okapi/pathfinder/include/pathfinder.h"
+}
+
+#define ARC_TEST_LOOKUPS 99           // progressForDistance() calls per spline
+
+namespace {
+struct TestSpline {
+  const char *name;
+  Spline spline;
+};
+
+std::vector<TestSpline> testSplines() {
+  const struct {
+    const char *name;
+    Waypoint from, to;
+  } ends[] = {{"straight", {0, 0, 0}, {2, 0, 0}},
+              {"90 deg", {0, 0, 0}, {1, 1, PI / 2}},
+              {"S bend", {0, 0, 0}, {1.5, 0.6, 0}},
+              {"60 deg", {0, 0, 0}, {1.2, 0.4, PI / 3}}};
+
+  std::vector<TestSpline> splines;
+  for (const auto &end : ends) {
+    Spline spline;
+    pf_fit_hermite_cubic(end.from, end.to, &spline);
+    splines.push_back(TestSpline{end.name, spline});
+  }
+  return splines;
+}
+} // namespace
+
+HOST_TEST(splineArcLengthMatchesSampling) {
+  for (auto &test : testSplines()) {
+    const SplineArcLength arcLength(test.spline);
+    const double length = arcLength.getLength();
+    const double sampled = pf_spline_distance(&test.spline, PATHFINDER_SAMPLES_HIGH);
+
+    double worstProgress = 0;
+    for (int k = 1; k <= ARC_TEST_LOOKUPS; k++) {
+      const double distance = length * k / (ARC_TEST_LOOKUPS + 1);
+      const double progress = arcLength.progressForDistance(distance);
+      const double sampledProgress =
+        pf_spline_progress_for_distance(test.spline, distance, PATHFINDER_SAMPLES_HIGH);
+      worstProgress = std::max(worstProgress, std::abs(progress - sampledProgress));
+    }
+
+    hostReport("%-9s length %.6f m, 100k samples %.6f m (%.1e apart), progress within %.1e",
+               test.name, length, sampled, std::abs(length - sampled), worstProgress);
+    // pathfinder adds one trapezoid too many, its sums are 1 / samples long
+    HOST_CHECK_NEAR(length, sampled, 1.5 * length / PATHFINDER_SAMPLES_HIGH);
+    HOST_CHECK(worstProgress < 2.0 / PATHFINDER_SAMPLES_HIGH);
+  }
+
+  // a straight spline is as long as the line, the ends map to the ends
+  HOST_CHECK_NEAR(SplineArcLength(testSplines()[0].spline).getLength(), 2, 1e-12);
+  const SplineArcLength arcLength(testSplines()[1].spline);
+  HOST_CHECK_NEAR(arcLength.progressForDistance(0), 0, 1e-12);
+  HOST_CHECK_NEAR(arcLength.progressForDistance(arcLength.getLength()), 1, 1e-9);
+}
+
+HOST_BENCH(splineArcLengthCost) {
+  volatile double sink = 0;
+  hostReport("per spline: length + %d progress lookups, the work of one path spline",
+             ARC_TEST_LOOKUPS);
+  for (auto &test : testSplines()) {
+    std::uint64_t start = hostNanos();
+    const SplineArcLength arcLength(test.spline);
+    for (int k = 1; k <= ARC_TEST_LOOKUPS; k++) {
+      sink = sink +
+             arcLength.progressForDistance(arcLength.getLength() * k / (ARC_TEST_LOOKUPS + 1));
+    }
+    const double quadratureMicros = (hostNanos() - start) / 1e3;
+
+    char line[128];
+    int used = 0;
+    for (const int samples :
+         {PATHFINDER_SAMPLES_FAST, PATHFINDER_SAMPLES_LOW, PATHFINDER_SAMPLES_HIGH}) {
+      start = hostNanos();
+      const double length = pf_spline_distance(&test.spline, samples);
+      for (int k = 1; k <= ARC_TEST_LOOKUPS; k++) {
+        sink = sink + pf_spline_progress_for_distance(
+                        test.spline, length * k / (ARC_TEST_LOOKUPS + 1), samples);
+      }
+      used += std::snprintf(line + used, sizeof(line) - used, "  %6dk %9.0f us", samples / 1000,
+                            (hostNanos() - start) / 1e3);
+    }
+    hostReport("%-9s quadrature %6.1f us%s", test.name, quadratureMicros, line);
+  }
+}
+
+#else
+
+HOST_SKIP(splineArcLengthTest, "no PATHFINDER_DIR");
+
+#endif
@@ -0,0 +1,157 @@
+// ------- telemetryDecoderTest.cpp --------------------------------------------
+//
+// Host test of the Pi side telemetry decoder (tools/telemetryLink) on a real
+// serial device: a posix_openpt() pty pair stands in for the radio link. The
+// robot side writes frames built by telemetryEncodeFrame() to the slave end
+// together with log text, a frame with a bad CRC, a frame cut off mid-way, a
+// gap and a repeated frame; the decoder reads the master end like
+// "telemetryDump --pty" does.
+
+#include "hostTest.h"
+
+#include "telemetry.h"
+#include "telemetryDecoder.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define PTY_TEST_READ_TIMEOUT 200     // ms without new bytes before the stream counts as done
+
+namespace {
+/**
+ * The robot end of the link, collects the bytes it writes to the pty.
+ */
+struct TestStream {
+  std::vector<std::uint8_t> bytes;
+
+  void text(const char *itext) {
+    bytes.insert(bytes.end(), itext, itext + std::strlen(itext));
+  }
+
+  /**
+   * Adds an odometry frame whose x is seq / 10.
+   *
+   * @param iseq The frame sequence number.
+   * @param ikeep How many bytes of the frame to add, all by default.
+   * @param icorrupt Flips a payload bit after the CRC was computed.
+   */
+  void odometry(std::uint8_t iseq, std::size_t ikeep = TELEMETRY_MAX_FRAME,
+                bool icorrupt = false) {
+    const TelemetryOdometry odometry{1000u + iseq, iseq / 10.0f, 0.5f, 90.0f};
+    std::uint8_t frame[TELEMETRY_MAX_FRAME];
+    const std::size_t size =
+      telemetryEncodeFrame(frame, TELEMETRY_CHANNEL_ODOMETRY, iseq, &odometry, sizeof(odometry));
+    if (icorrupt) {
+      frame[TELEMETRY_HEADER_SIZE + 2] ^= 0x10;
+    }
+    bytes.insert(bytes.end(), frame, frame + std::min(size, ikeep));
+  }
+};
+
+/**
+ * Opens a raw pty pair like telemetryDump --pty.
+ *
+ * @param omaster The decoder end.
+ * @param oslave The robot end.
+ * @return false if the system has no ptys.
+ */
+bool openPtyPair(int &omaster, int &oslave) {
+  omaster = posix_openpt(O_RDWR | O_NOCTTY);
+  if (omaster < 0 || grantpt(omaster) != 0 || unlockpt(omaster) != 0) {
+    return false;
+  }
+
+  // raw, the line discipline must not turn \n into \r\n or eat control bytes
+  termios settings;
+  tcgetattr(omaster, &settings);
+  cfmakeraw(&settings);
+  tcsetattr(omaster, TCSANOW, &settings);
+
+  oslave = open(ptsname(omaster), O_RDWR | O_NOCTTY);
+  return oslave >= 0;
+}
+} // namespace
+
+HOST_TEST(telemetryDecoderOverPty) {
+  int master, slave;
+  HOST_CHECK(openPtyPair(master, slave));
+  if (master < 0 || slave < 0) {
+    return;
+  }
+
+  TestStream stream;
+  stream.text("Setting OKAPI log level \n");
+  stream.bytes.push_back(TELEMETRY_SYNC_0);   // a false start
+  stream.bytes.push_back(0x00);
+  for (std::uint8_t seq = 0; seq < 10; seq++) {
+    stream.odometry(seq);
+  }
+  stream.odometry(10, TELEMETRY_MAX_FRAME, true);   // bad CRC, seq 10 is lost
+  stream.odometry(11);
+  stream.text("1234 (Chassis) INFO: log text between two frames\n");
+  stream.odometry(12, 9);                           // cut off, seq 12 is lost
+  stream.odometry(13);
+  stream.odometry(17);                              // 14 .. 16 are lost
+  stream.odometry(17);                              // sent again
+  const TelemetryControllerError error{2000, TELEMETRY_ID_PURSUIT, {0, 0, 0}, 0.25f};
+  std::uint8_t frame[TELEMETRY_MAX_FRAME];
+  const std::size_t size =
+    telemetryEncodeFrame(frame, TELEMETRY_CHANNEL_CONTROLLER_ERROR, 18, &error, sizeof(error));
+  stream.bytes.insert(stream.bytes.end(), frame, frame + size);
+
+  // far less than the pty buffer holds, so it can all be written before reading
+  HOST_CHECK(write(slave, stream.bytes.data(), stream.bytes.size()) ==
+             static_cast<ssize_t>(stream.bytes.size()));
+
+  TelemetryDecoder decoder;
+  std::map<int, int> odometryFrames;
+  bool odometryIntact = true;
+  decoder.onOdometry = [&](std::uint8_t seq, const TelemetryOdometry &odometry) {
+    odometryFrames[seq]++;
+    odometryIntact = odometryIntact && odometry.timestamp == 1000u + seq &&
+                     odometry.x == seq / 10.0f && odometry.theta == 90.0f;
+  };
+  TelemetryControllerError received{};
+  decoder.onControllerError = [&](std::uint8_t, const TelemetryControllerError &ierror) {
+    received = ierror;
+  };
+
+  std::size_t total = 0;
+  pollfd readable{master, POLLIN, 0};
+  while (poll(&readable, 1, PTY_TEST_READ_TIMEOUT) > 0) {
+    std::uint8_t buffer[64];   // small reads, frames arrive split over several of them
+    const ssize_t count = read(master, buffer, sizeof(buffer));
+    if (count <= 0) {
+      break;
+    }
+    decoder.feed(buffer, static_cast<std::size_t>(count));
+    total += static_cast<std::size_t>(count);
+  }
+  close(slave);
+  close(master);
+
+  const auto &stats = decoder.getStats();
+  hostReport("%zu bytes: frames %u crc errors %u lost %u duplicates %u skipped bytes %u", total,
+             stats.frames, stats.crcErrors, stats.lostFrames, stats.duplicateFrames,
+             stats.skippedBytes);
+  HOST_CHECK(total == stream.bytes.size());
+
+  // every intact frame arrives once, the repeated one twice, none of the broken ones
+  HOST_CHECK(stats.frames == 15);
+  HOST_CHECK(odometryIntact);
+  HOST_CHECK(odometryFrames.size() == 13);
+  HOST_CHECK(odometryFrames.count(10) == 0 && odometryFrames.count(12) == 0);
+  HOST_CHECK(odometryFrames[17] == 2);
+  HOST_CHECK(received.controllerId == TELEMETRY_ID_PURSUIT && received.error == 0.25f);
+
+  // both broken frames fail their CRC, the decoder resyncs on the next frame each time
+  HOST_CHECK(stats.crcErrors == 2);
+  HOST_CHECK(stats.lostFrames == 5);
+  HOST_CHECK(stats.duplicateFrames == 1);
+  HOST_CHECK(stats.skippedBytes >= std::strlen("Setting OKAPI log level \n") + 2);
+}
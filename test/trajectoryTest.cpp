@@ -0,0 +1,182 @@
+// ------- trajectoryTest.cpp --------------------------------------------------
+//
+// Host tests of the compact trajectory storage: how much memory float32 and
+// fixed16 save against okapi's full Segments, and how far the values a
+// follower reads, and the pose it ends up at, move from the full path.
+//
+// The path is synthesized instead of generated, so the test does not need
+// pathfinder: an S curve with a trapezoid speed profile, split into the left
+// and right wheels like pathfinder's tank modifier does.
+
+#include "hostTest.h"
+
+#include "compactTrajectory.h"
+#include "odomArcMath.h"
+#include "trajectoryView.h"
+
+#include <cstdlib>
+
+#define TRAJECTORY_TEST_DT 0.01       // s, okapi's path step
+#define TRAJECTORY_TEST_TRACK 0.375   // m
+#define TRAJECTORY_TEST_SPEED 1.5     // m/s
+#define TRAJECTORY_TEST_ACCEL 2.0     // m/s^2
+#define TRAJECTORY_TEST_LENGTH 4.0    // m
+
+namespace {
+struct TankPath {
+  std::vector<Segment> left;
+  std::vector<Segment> right;
+};
+
+TankPath makeSCurve() {
+  TankPath path;
+  const double cruiseTime = TRAJECTORY_TEST_LENGTH / TRAJECTORY_TEST_SPEED -
+                            TRAJECTORY_TEST_SPEED / TRAJECTORY_TEST_ACCEL;
+  const double rampTime = TRAJECTORY_TEST_SPEED / TRAJECTORY_TEST_ACCEL;
+  const double total = cruiseTime + 2 * rampTime;
+  const int steps = static_cast<int>(std::ceil(total / TRAJECTORY_TEST_DT)) + 1;
+
+  double sides[2] = {0, 0};
+  double lastVelocity[2] = {0, 0};
+  for (int i = 0; i < steps; i++) {
+    const double t = i * TRAJECTORY_TEST_DT;
+    const double v = std::min({TRAJECTORY_TEST_ACCEL * t, TRAJECTORY_TEST_SPEED,
+                               std::max(0.0, TRAJECTORY_TEST_ACCEL * (total - t))});
+    // heading swings 45 degrees to one side and back through the other
+    const double heading = okapi::pi / 4 * std::sin(2 * okapi::pi * t / total);
+    const double omega =
+      okapi::pi / 4 * 2 * okapi::pi / total * std::cos(2 * okapi::pi * t / total);
+
+    Segment segments[2];
+    const double sideVelocity[2] = {v - omega * TRAJECTORY_TEST_TRACK / 2,
+                                    v + omega * TRAJECTORY_TEST_TRACK / 2};
+    for (int s = 0; s < 2; s++) {
+      segments[s] = Segment{TRAJECTORY_TEST_DT, 0, 0, sides[s], sideVelocity[s],
+                            (sideVelocity[s] - lastVelocity[s]) / TRAJECTORY_TEST_DT, 0, heading};
+      sides[s] += sideVelocity[s] * TRAJECTORY_TEST_DT;
+      lastVelocity[s] = sideVelocity[s];
+    }
+    path.left.push_back(segments[0]);
+    path.right.push_back(segments[1]);
+  }
+  return path;
+}
+
+SegmentTrajectory::SegmentPtr copySegments(const std::vector<Segment> &isegments) {
+  auto *copy = static_cast<Segment *>(std::malloc(isegments.size() * sizeof(Segment)));
+  std::copy(isegments.begin(), isegments.end(), copy);
+  return SegmentTrajectory::SegmentPtr(copy, std::free);
+}
+
+struct FollowError {
+  double position{0};                 // m, largest wheel position difference
+  double velocity{0};                 // m/s
+  double heading{0};                  // rad
+  OdomPose end;                       // where driving the velocities open loop ends up
+};
+
+/**
+ * Drives a trajectory's wheel velocities open loop like okapi's follower and compares every
+ * step with the full path.
+ *
+ * @param itrajectory The trajectory to follow.
+ * @param ipath The full path to compare with, nullptr to only drive.
+ */
+FollowError follow(const TrajectorySource &itrajectory, const TankPath *ipath) {
+  FollowError error;
+  for (int i = 0; i < itrajectory.size(); i++) {
+    const TrajectorySample sample = itrajectory.get(i);
+    if (ipath != nullptr) {
+      const Segment &left = ipath->left[i];
+      const Segment &right = ipath->right[i];
+      error.position = std::max({error.position, std::abs(sample.leftPosition - left.position),
+                                 std::abs(sample.rightPosition - right.position)});
+      error.velocity = std::max({error.velocity, std::abs(sample.leftVelocity - left.velocity),
+                                 std::abs(sample.rightVelocity - right.velocity)});
+      error.heading = std::max(error.heading, std::abs(sample.heading - left.heading));
+    }
+
+    const double left = sample.leftVelocity * itrajectory.getDt();
+    const double right = sample.rightVelocity * itrajectory.getDt();
+    error.end = OdomArcMath::step(error.end, left, right, (left - right) / TRAJECTORY_TEST_TRACK,
+                                  TRAJECTORY_TEST_TRACK);
+  }
+  return error;
+}
+} // namespace
+
+HOST_TEST(compactTrajectoryMemoryAndError) {
+  const TankPath path = makeSCurve();
+  const int steps = static_cast<int>(path.left.size());
+
+  const SegmentTrajectory full(copySegments(path.left), copySegments(path.right), steps);
+  const CompactTrajectory float32(path.left.data(), path.right.data(), steps,
+                                  TrajectoryStorage::float32);
+  const CompactTrajectory fixed16(path.left.data(), path.right.data(), steps,
+                                  TrajectoryStorage::fixed16);
+
+  HOST_CHECK(full.memoryUsage() == 2 * steps * sizeof(Segment));
+  HOST_CHECK(float32.memoryUsage() == steps * 7 * sizeof(float));
+  HOST_CHECK(fixed16.memoryUsage() == steps * 7 * sizeof(std::int16_t));
+
+  const FollowError fullError = follow(full, &path);
+  HOST_CHECK(fullError.position == 0 && fullError.velocity == 0 && fullError.heading == 0);
+
+  const TrajectorySource *compact[] = {&float32, &fixed16};
+  const char *names[] = {"float32", "fixed16"};
+  hostReport("%d steps, full Segments: %zu bytes, ends at (%.4f, %.4f) m", steps,
+             full.memoryUsage(), fullError.end.x, fullError.end.y);
+  for (int c = 0; c < 2; c++) {
+    const FollowError error = follow(*compact[c], &path);
+    const double endError =
+      std::hypot(error.end.x - fullError.end.x, error.end.y - fullError.end.y);
+    hostReport("%s: %zu bytes (%.0f%% saved), max error %.4f mm, %.4f mm/s, %.5f deg, "
+               "end pose %.4f mm off",
+               names[c], compact[c]->memoryUsage(),
+               100.0 - 100.0 * compact[c]->memoryUsage() / full.memoryUsage(),
+               1000 * error.position, 1000 * error.velocity, error.heading * 180 / okapi::pi,
+               1000 * endError);
+
+    // fixed16 resolution is the largest value / 32767: under 0.2 mm for a 4 m path
+    HOST_CHECK(error.position < 2e-4);
+    HOST_CHECK(error.velocity < 1e-4);
+    HOST_CHECK(error.heading < 1e-4);
+    HOST_CHECK(endError < 1e-3);
+  }
+
+  // unpacking gives the values get() reads
+  std::vector<Segment> left(steps);
+  std::vector<Segment> right(steps);
+  fixed16.toSegments(left.data(), right.data());
+  HOST_CHECK_NEAR(right[steps / 2].velocity, fixed16.get(steps / 2).rightVelocity, 0);
+  HOST_CHECK_NEAR(left[steps / 3].dt, TRAJECTORY_TEST_DT, 0);
+}
+
+HOST_TEST(trajectoryViewTransforms) {
+  const TankPath path = makeSCurve();
+  const int steps = static_cast<int>(path.left.size());
+  auto full = std::make_shared<SegmentTrajectory>(copySegments(path.left),
+                                                  copySegments(path.right), steps);
+  const TrajectoryView view(full);
+
+  // mirroring twice and scaling by 1 change nothing
+  const TrajectoryView same = view.mirrored().mirrored().scaled(1);
+  const TrajectoryView mirrored = view.mirrored();
+  bool identical = true;
+  for (int i = 0; i < steps; i++) {
+    const TrajectorySample a = view.get(i);
+    const TrajectorySample b = same.get(i);
+    identical = identical && a.leftPosition == b.leftPosition &&
+                a.rightVelocity == b.rightVelocity && a.heading == b.heading;
+    identical = identical && mirrored.get(i).leftVelocity == a.rightVelocity;
+  }
+  HOST_CHECK(identical);
+
+  // there and back again ends where it started
+  const TrajectoryView back = view.concat(view.reversed());
+  HOST_CHECK(back.size() == 2 * steps);
+  const FollowError error = follow(back, nullptr);
+  HOST_CHECK_NEAR(error.end.x, 0, 1e-9);
+  HOST_CHECK_NEAR(error.end.y, 0, 1e-9);
+  HOST_CHECK(back.memoryUsage() < 1024);
+}
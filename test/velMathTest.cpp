@@ -0,0 +1,150 @@
+// ------- velMathTest.cpp -----------------------------------------------------
+//
+// Host test of TimestampedVelMath against okapi's VelMath (the hostOkapi.cpp
+// stand-in, okapilib 4.2's step()) on a motor trace: how much velocity noise
+// each leaves at a steady speed and how far each lags behind the real speed,
+// without a filter and with EMA filters of increasing strength.
+//
+// The trace (test/golden/velTrace.csv) is synthetic, the rows are what a
+// velocity task reading getRawPosition() every 10 ms would record, so a real
+// recording in the same columns can be dropped in.
+
+#include "hostTest.h"
+
+#include "timestampedVelMath.h"
+
+#include "okapi/api/filter/emaFilter.hpp"
+
+#include <cstdio>
+
+#define VEL_TEST_TRACE HOST_GOLDEN_DIR "/velTrace.csv"
+#define VEL_TEST_TPR 900.0            // green cartridge ticks per rotation
+#define VEL_TEST_STEADY_FROM 1500     // ms, the trace runs at a steady speed from here
+#define VEL_TEST_STEADY_TO 6000       // ms
+#define VEL_TEST_LAG_FROM 700         // ms, lag is fitted after the first speed up
+#define VEL_TEST_MAX_LAG 150          // ms
+#define VEL_TEST_FILTERS 4
+
+namespace {
+// trace columns
+enum VelColumn { taskMs, motorMs, positionTicks, trueRpm };
+
+struct VelResult {
+  double noise{0};                    // rpm, standard deviation at the steady speed
+  double lag{0};                      // ms, the delay which fits the real speed best
+  double error{0};                    // rpm, rms error against the real speed delayed by lag
+};
+
+/**
+ * @return The real speed of the trace at a time, interpolated between the rows.
+ */
+double trueRpmAt(const std::vector<std::vector<double>> &itrace, const double ims) {
+  if (ims <= itrace.front()[taskMs]) {
+    return itrace.front()[trueRpm];
+  }
+  for (std::size_t i = 1; i < itrace.size(); i++) {
+    if (itrace[i][taskMs] >= ims) {
+      const double f =
+        (ims - itrace[i - 1][taskMs]) / (itrace[i][taskMs] - itrace[i - 1][taskMs]);
+      return itrace[i - 1][trueRpm] + f * (itrace[i][trueRpm] - itrace[i - 1][trueRpm]);
+    }
+  }
+  return itrace.back()[trueRpm];
+}
+
+/**
+ * Measures noise and lag of the velocities estimated for every row of the trace.
+ */
+VelResult measure(const std::vector<std::vector<double>> &itrace,
+                  const std::vector<double> &ivelocities) {
+  VelResult result;
+  double sum = 0, squares = 0;
+  int count = 0;
+  for (std::size_t i = 0; i < itrace.size(); i++) {
+    if (itrace[i][taskMs] >= VEL_TEST_STEADY_FROM && itrace[i][taskMs] < VEL_TEST_STEADY_TO) {
+      sum += ivelocities[i];
+      squares += ivelocities[i] * ivelocities[i];
+      count++;
+    }
+  }
+  const double mean = sum / count;
+  result.noise = std::sqrt(std::max(0.0, squares / count - mean * mean));
+
+  result.error = INFINITY;
+  for (int lag = 0; lag <= VEL_TEST_MAX_LAG; lag++) {
+    double error = 0;
+    int samples = 0;
+    for (std::size_t i = 0; i < itrace.size(); i++) {
+      if (itrace[i][taskMs] > VEL_TEST_LAG_FROM + lag) {
+        const double difference = ivelocities[i] - trueRpmAt(itrace, itrace[i][taskMs] - lag);
+        error += difference * difference;
+        samples++;
+      }
+    }
+    error = std::sqrt(error / samples);
+    if (error < result.error) {
+      result.error = error;
+      result.lag = lag;
+    }
+  }
+  return result;
+}
+} // namespace
+
+HOST_TEST(timestampedVelMathNoiseAndLag) {
+  std::vector<std::vector<double>> trace;
+  HOST_CHECK(hostReadCsv(VEL_TEST_TRACE, trace) && trace.size() > 100);
+  if (trace.size() <= 100) {
+    return;
+  }
+
+  hostReport("%zu readings, noise at %.0f rpm, lag and rms error against the real speed",
+             trace.size(), trueRpmAt(trace, VEL_TEST_STEADY_FROM));
+  hostReport("%-10s %28s %28s", "", "okapi VelMath", "TimestampedVelMath");
+  hostReport("%-10s %9s %8s %9s %9s %8s %9s", "filter", "noise rpm", "lag ms", "rms rpm",
+             "noise rpm", "lag ms", "rms rpm");
+  const double alphas[VEL_TEST_FILTERS] = {1.0, 0.5, 0.2, 0.1};
+  VelResult okapiResults[VEL_TEST_FILTERS], timestampedResults[VEL_TEST_FILTERS];
+  for (int f = 0; f < VEL_TEST_FILTERS; f++) {
+    const double alpha = alphas[f];
+    hostMicros = static_cast<std::uint64_t>(trace.front()[taskMs] - 10) * 1000;
+    okapi::VelMath okapiVelMath(VEL_TEST_TPR, std::make_unique<okapi::EmaFilter>(alpha),
+                                0 * okapi::millisecond, hostTimeUtil().getTimer());
+    TimestampedVelMath timestamped(VEL_TEST_TPR, std::make_unique<okapi::EmaFilter>(alpha),
+                                   0 * okapi::millisecond, hostTimeUtil().getTimer());
+
+    std::vector<double> okapiVelocities, timestampedVelocities;
+    for (const auto &row : trace) {
+      hostMicros = static_cast<std::uint64_t>(row[taskMs]) * 1000;
+      okapiVelocities.push_back(okapiVelMath.step(row[positionTicks]).convert(okapi::rpm));
+      timestampedVelocities.push_back(
+        timestamped.stepAt(row[positionTicks], static_cast<std::uint32_t>(row[motorMs]))
+          .convert(okapi::rpm));
+    }
+
+    const VelResult &okapiResult = okapiResults[f] = measure(trace, okapiVelocities);
+    const VelResult &timestampedResult = timestampedResults[f] =
+      measure(trace, timestampedVelocities);
+    char name[16] = "none";
+    if (alpha < 1) {
+      std::snprintf(name, sizeof(name), "EMA %.1f", alpha);
+    }
+    hostReport("%-10s %9.2f %8.0f %9.2f %9.2f %8.0f %9.2f", name, okapiResult.noise,
+               okapiResult.lag, okapiResult.error, timestampedResult.noise,
+               timestampedResult.lag, timestampedResult.error);
+    if (alpha == 1.0) {
+      hostReport("%u readings of a motor sample already read skipped",
+                 timestamped.getRepeatedSamples());
+      HOST_CHECK(timestamped.getRepeatedSamples() > 0);
+    }
+
+    // the same filter lags about as much, the device sample times are a few ms old
+    HOST_CHECK(timestampedResult.noise < okapiResult.noise / 2);
+    HOST_CHECK(timestampedResult.lag <= okapiResult.lag + 10);
+    HOST_CHECK(timestampedResult.error < okapiResult.error);
+  }
+
+  // without a filter it is as quiet as okapi's with EMA 0.2, at a fraction of the lag
+  HOST_CHECK(timestampedResults[0].noise < okapiResults[2].noise);
+  HOST_CHECK(timestampedResults[0].lag < okapiResults[2].lag / 2);
+}
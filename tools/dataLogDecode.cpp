@@ -0,0 +1,66 @@
+// ------- dataLogDecode.cpp ---------------------------------------------------
+//
+// Host (PC) side tool - converts the binary robot data log written by
+// robotDataLogger() to the USD card (robotData.bin) into CSV.
+//
+// Build on the PC, this file is NOT part of the robot program:
+//   g++ -std=c++17 -O2 -I../include -o dataLogDecode dataLogDecode.cpp
+//
+// Usage:
+//   dataLogDecode robotData.bin > robotData.csv
+
+#include "dataLoggerFormat.h"
+
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s robotData.bin > robotData.csv\n", argv[0]);
+    return 1;
+  }
+
+  FILE *in = std::fopen(argv[1], "rb");
+  if (in == nullptr) {
+    std::fprintf(stderr, "could not open %s\n", argv[1]);
+    return 1;
+  }
+
+  DataLogHeader header;
+  if (std::fread(&header, sizeof(header), 1, in) != 1 || header.magic != DATA_LOG_MAGIC) {
+    std::fprintf(stderr, "%s is not a robot data log\n", argv[1]);
+    std::fclose(in);
+    return 1;
+  }
+  if (header.version != DATA_LOG_VERSION || header.recordSize != sizeof(DataLogRecord)) {
+    std::fprintf(stderr, "unsupported log version %u (record size %u)\n",
+                 static_cast<unsigned>(header.version), static_cast<unsigned>(header.recordSize));
+    std::fclose(in);
+    return 1;
+  }
+
+  // make sure the version strings are terminated even if the file is damaged
+  header.programVersion[sizeof(header.programVersion) - 1] = '\0';
+  header.versionDate[sizeof(header.versionDate) - 1] = '\0';
+
+  std::printf("# Program Run: %u Program Version: %s Version Date: %s Opened at: %ums\n",
+              header.runId, header.programVersion, header.versionDate, header.openedAt);
+  std::printf("timestamp_ms,marker,x_m,y_m,theta_deg,encoder_left,encoder_right,"
+              "current_lf_ma,current_lb_ma,current_rf_ma,current_rb_ma\n");
+
+  DataLogRecord record;
+  unsigned long count = 0;
+  while (std::fread(&record, sizeof(record), 1, in) == 1) {
+    std::printf("%u,%u,%.6f,%.6f,%.4f,%d,%d,%d,%d,%d,%d\n",
+                record.timestamp, static_cast<unsigned>(record.marker),
+                record.x, record.y, record.theta,
+                record.encoderLeft, record.encoderRight,
+                record.motorCurrent[0], record.motorCurrent[1],
+                record.motorCurrent[2], record.motorCurrent[3]);
+    count++;
+  }
+
+  std::fclose(in);
+  std::fprintf(stderr, "decoded %lu records\n", count);
+  return 0;
+}
@@ -0,0 +1,238 @@
+// ------- pathGen.cpp ---------------------------------------------------------
+//
+// Host (PC) side tool - generates motion profiles offline, the same way
+// AsyncMotionProfileController::generatePath() does on the robot, and writes
+// them into a path blob (pathBlobFormat.h). The robot then loads the paths by
+// id (PathBlob, MotionProfileController) without doing any spline math.
+//
+// Needs the Pathfinder C sources (https://github.com/JacisNonsense/Pathfinder,
+// Pathfinder-Core) which okapi's pathfinder is built from. "make paths" builds
+// and runs it, or by hand:
+//   g++ -std=c++17 -O2 -I../include -o pathGen pathGen.cpp ../src/pathGeneration.cpp
+//     ../src/splineArcLength.cpp
+//     -x c -I$PF/include $PF/src/*.c $PF/src/*/*.c -x none -lm      (all on one line)
+//
+// Usage:
+//   pathGen paths.txt paths.bin                   blob file for the USD card
+//   pathGen paths.txt --cpp generatedPaths.cpp    source file linked into the program
+//
+// Path spec format, one item per line, # starts a comment:
+//   track 0.375          wheel track in m, must match the chassis
+//   limits 1.0 2.0 10.0  max velocity m/s, acceleration m/s^2, jerk m/s^3 for the paths below
+//   generator curvature  pathfinder (the default) or curvature for the paths below, see
+//                        pathGeneration.h; curvature paths also print pathfinder's time
+//   path toGoal          starts a path with this id (at most 23 characters)
+//   0 0 0                waypoint x m, y m, exit angle deg, relative to the start of the path
+//   1.2 0.5 45
+
+#include "pathBlobFormat.h"
+#include "pathGeneration.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct PathSpec {
+  std::string id;
+  double maxVel;
+  double maxAccel;
+  double maxJerk;
+  PathGenerator generator;
+  std::vector<Waypoint> waypoints;
+};
+
+struct GeneratedPath {
+  std::string id;
+  std::vector<Segment> left;
+  std::vector<Segment> right;
+};
+
+static bool parseSpec(const char *fileName, double &track, std::vector<PathSpec> &paths) {
+  std::ifstream in(fileName);
+  if (!in) {
+    std::fprintf(stderr, "could not open %s\n", fileName);
+    return false;
+  }
+
+  double maxVel = 1.0, maxAccel = 2.0, maxJerk = 10.0;
+  PathGenerator generator = PathGenerator::pathfinder;
+  track = 0;
+  std::string line;
+  int lineNumber = 0;
+
+  while (std::getline(in, line)) {
+    lineNumber++;
+    const auto comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+
+    std::istringstream words(line);
+    std::string first;
+    if (!(words >> first)) {
+      continue;
+    }
+
+    bool ok = true;
+    if (first == "track") {
+      ok = static_cast<bool>(words >> track);
+    } else if (first == "limits") {
+      ok = static_cast<bool>(words >> maxVel >> maxAccel >> maxJerk);
+    } else if (first == "generator") {
+      std::string name;
+      ok = static_cast<bool>(words >> name) && (name == "pathfinder" || name == "curvature");
+      generator = name == "curvature" ? PathGenerator::curvature : PathGenerator::pathfinder;
+    } else if (first == "path") {
+      PathSpec path{"", maxVel, maxAccel, maxJerk, generator, {}};
+      ok = static_cast<bool>(words >> path.id) && path.id.size() < PATH_BLOB_ID_SIZE;
+      paths.push_back(path);
+    } else {
+      Waypoint point;
+      double angle;
+      std::istringstream numbers(line);
+      ok = !paths.empty() && static_cast<bool>(numbers >> point.x >> point.y >> angle);
+      if (ok) {
+        point.angle = d2r(angle);
+        paths.back().waypoints.push_back(point);
+      }
+    }
+
+    if (!ok) {
+      std::fprintf(stderr, "%s:%d: can not read \"%s\"\n", fileName, lineNumber, line.c_str());
+      return false;
+    }
+  }
+
+  if (track <= 0) {
+    std::fprintf(stderr, "%s: no wheel track given\n", fileName);
+    return false;
+  }
+  return true;
+}
+
+static bool generate(const PathSpec &spec, const double track, GeneratedPath &out) {
+  const int length =
+    PathGeneration::tank(spec.waypoints, spec.maxVel, spec.maxAccel, spec.maxJerk, track, out.left,
+                         out.right, PATH_SAMPLES_QUADRATURE, spec.generator);
+  if (length <= 0) {
+    std::fprintf(stderr, "path %s: impossible with these waypoints and limits\n", spec.id.c_str());
+    return false;
+  }
+  out.id = spec.id;
+
+  std::fprintf(stderr, "path %-23s %5d segments %6.2f s", spec.id.c_str(), length,
+               length * PATH_GENERATION_DT);
+
+  if (spec.generator == PathGenerator::curvature) {
+    // the same path the way okapi would generate it, to compare the time
+    std::vector<Segment> left, right;
+    const int pathfinderLength = PathGeneration::tank(spec.waypoints, spec.maxVel, spec.maxAccel,
+                                                      spec.maxJerk, track, left, right);
+    if (pathfinderLength > 0) {
+      std::fprintf(stderr, " (pathfinder %.2f s)", pathfinderLength * PATH_GENERATION_DT);
+    }
+  }
+  std::fprintf(stderr, "\n");
+  return true;
+}
+
+static std::vector<unsigned char> buildBlob(const std::vector<GeneratedPath> &paths,
+                                            const double track) {
+  PathBlobHeader header{};
+  header.magic = PATH_BLOB_MAGIC;
+  header.version = PATH_BLOB_VERSION;
+  header.pathCount = static_cast<std::uint16_t>(paths.size());
+  header.segmentSize = sizeof(Segment);
+  header.wheelTrack = static_cast<float>(track);
+
+  std::vector<PathBlobEntry> entries(paths.size());
+  std::size_t offset = sizeof(header) + entries.size() * sizeof(PathBlobEntry);
+  for (std::size_t i = 0; i < paths.size(); i++) {
+    std::memset(&entries[i], 0, sizeof(PathBlobEntry));
+    std::strncpy(entries[i].id, paths[i].id.c_str(), PATH_BLOB_ID_SIZE - 1);
+    entries[i].offset = static_cast<std::uint32_t>(offset);
+    entries[i].length = static_cast<std::int32_t>(paths[i].left.size());
+    offset += 2 * sizeof(Segment) * paths[i].left.size();
+  }
+
+  std::vector<unsigned char> blob(offset);
+  std::memcpy(blob.data(), &header, sizeof(header));
+  std::memcpy(blob.data() + sizeof(header), entries.data(),
+              entries.size() * sizeof(PathBlobEntry));
+  for (std::size_t i = 0; i < paths.size(); i++) {
+    const std::size_t sideSize = sizeof(Segment) * paths[i].left.size();
+    std::memcpy(blob.data() + entries[i].offset, paths[i].left.data(), sideSize);
+    std::memcpy(blob.data() + entries[i].offset + sideSize, paths[i].right.data(), sideSize);
+  }
+  return blob;
+}
+
+static bool writeBinary(const char *fileName, const std::vector<unsigned char> &blob) {
+  FILE *out = std::fopen(fileName, "wb");
+  if (out == nullptr) {
+    std::fprintf(stderr, "could not create %s\n", fileName);
+    return false;
+  }
+  const bool ok = std::fwrite(blob.data(), 1, blob.size(), out) == blob.size();
+  std::fclose(out);
+  return ok;
+}
+
+static bool writeSource(const char *fileName, const std::vector<unsigned char> &blob) {
+  FILE *out = std::fopen(fileName, "w");
+  if (out == nullptr) {
+    std::fprintf(stderr, "could not create %s\n", fileName);
+    return false;
+  }
+
+  std::fprintf(out, "// ------- generatedPaths.cpp ---------------------------------------------------\n"
+                    "//\n"
+                    "// GENERATED by tools/pathGen (\"make paths\") - do not edit.\n"
+                    "// Precomputed motion profiles, see pathBlob.h\n\n"
+                    "#include \"pathBlob.h\"\n\n"
+                    "alignas(8) const unsigned char generatedPathBlob[] = {");
+  for (std::size_t i = 0; i < blob.size(); i++) {
+    std::fprintf(out, "%s0x%02x,", i % 16 == 0 ? "\n  " : " ", blob[i]);
+  }
+  std::fprintf(out, "\n};\n\nconst std::size_t generatedPathBlobSize = sizeof(generatedPathBlob);\n");
+
+  const bool ok = std::ferror(out) == 0;
+  std::fclose(out);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const bool source = argc == 4 && std::strcmp(argv[2], "--cpp") == 0;
+  if (argc != 3 && !source) {
+    std::fprintf(stderr, "usage: %s paths.txt paths.bin\n"
+                         "       %s paths.txt --cpp generatedPaths.cpp\n",
+                 argv[0], argv[0]);
+    return 1;
+  }
+
+  double track;
+  std::vector<PathSpec> specs;
+  if (!parseSpec(argv[1], track, specs)) {
+    return 1;
+  }
+
+  std::vector<GeneratedPath> paths(specs.size());
+  for (std::size_t i = 0; i < specs.size(); i++) {
+    if (!generate(specs[i], track, paths[i])) {
+      return 1;
+    }
+  }
+
+  const std::vector<unsigned char> blob = buildBlob(paths, track);
+  const char *outName = source ? argv[3] : argv[2];
+  if (!(source ? writeSource(outName, blob) : writeBinary(outName, blob))) {
+    std::fprintf(stderr, "could not write %s\n", outName);
+    return 1;
+  }
+
+  std::fprintf(stderr, "%zu paths, %zu bytes written to %s\n", paths.size(), blob.size(), outName);
+  return 0;
+}
@@ -0,0 +1,141 @@
+// ------- telemetryDecoder.cpp ------------------------------------------------
+//
+// Stream decoder for the robot telemetry frames, see telemetryDecoder.h
+
+#include "telemetryDecoder.h"
+
+#include <cstring>
+
+void TelemetryDecoder::feed(const std::uint8_t *data, std::size_t length) {
+  for (std::size_t i = 0; i < length; i++) {
+    const std::uint8_t byte = data[i];
+
+    switch (state) {
+    case State::sync0:
+      if (byte == TELEMETRY_SYNC_0) {
+        frame[0] = byte;
+        received = 1;
+        state = State::sync1;
+      } else {
+        stats.skippedBytes++;
+      }
+      break;
+
+    case State::sync1:
+      if (byte == TELEMETRY_SYNC_1) {
+        frame[received++] = byte;
+        state = State::header;
+      } else if (byte == TELEMETRY_SYNC_0) {
+        stats.skippedBytes++;         // the previous 0xA5 was noise, this one may start a frame
+      } else {
+        stats.skippedBytes += 2;
+        state = State::sync0;
+      }
+      break;
+
+    case State::header:
+      frame[received++] = byte;
+      if (received == TELEMETRY_HEADER_SIZE) {
+        payloadLength = frame[4];
+        if (payloadLength > TELEMETRY_MAX_PAYLOAD) {
+          // can not be a frame, look for the next sync in what we already have
+          stats.skippedBytes++;
+          std::uint8_t rest[TELEMETRY_HEADER_SIZE - 1];
+          std::memcpy(rest, frame + 1, sizeof(rest));
+          state = State::sync0;
+          feed(rest, sizeof(rest));
+        } else {
+          state = payloadLength > 0 ? State::payload : State::crc;
+        }
+      }
+      break;
+
+    case State::payload:
+      frame[received++] = byte;
+      if (received == TELEMETRY_HEADER_SIZE + payloadLength) {
+        state = State::crc;
+      }
+      break;
+
+    case State::crc:
+      frame[received++] = byte;
+      if (received == TELEMETRY_HEADER_SIZE + payloadLength + TELEMETRY_CRC_SIZE) {
+        const std::uint16_t expected = telemetryCrc16(frame + 2, 3 + payloadLength);
+        const std::uint16_t actual =
+          static_cast<std::uint16_t>(frame[received - 2] | (frame[received - 1] << 8));
+        state = State::sync0;
+
+        if (expected == actual) {
+          dispatch();
+        } else {
+          // a corrupted frame may hide the start of the next one - rescan it
+          stats.crcErrors++;
+          std::uint8_t rest[TELEMETRY_MAX_FRAME];
+          const std::size_t restLength = received - 1;
+          std::memcpy(rest, frame + 1, restLength);
+          feed(rest, restLength);
+        }
+      }
+      break;
+    }
+  }
+}
+
+void TelemetryDecoder::reset() {
+  state = State::sync0;
+  received = 0;
+  payloadLength = 0;
+  haveSeq = false;
+}
+
+void TelemetryDecoder::dispatch() {
+  const std::uint8_t channel = frame[2];
+  const std::uint8_t seq = frame[3];
+  const std::uint8_t *payload = frame + TELEMETRY_HEADER_SIZE;
+
+  // seq wraps at 255, a step of 128 or more is taken as a step backwards
+  const std::uint8_t step = static_cast<std::uint8_t>(seq - lastSeq);
+  if (!haveSeq || (step > 0 && step < 128)) {
+    if (haveSeq) {
+      stats.lostFrames += step - 1u;
+    }
+    haveSeq = true;
+    lastSeq = seq;
+  } else {
+    // sent again or out of order, lastSeq stays so the next frame is not counted lost
+    stats.duplicateFrames++;
+  }
+  stats.frames++;
+
+  switch (channel) {
+  case TELEMETRY_CHANNEL_ODOMETRY:
+    if (payloadLength == sizeof(TelemetryOdometry) && onOdometry) {
+      TelemetryOdometry odometry;
+      std::memcpy(&odometry, payload, sizeof(odometry));
+      onOdometry(seq, odometry);
+    }
+    break;
+
+  case TELEMETRY_CHANNEL_MOTOR_STATE:
+    if (payloadLength == sizeof(TelemetryMotorState) && onMotorState) {
+      TelemetryMotorState motorState;
+      std::memcpy(&motorState, payload, sizeof(motorState));
+      onMotorState(seq, motorState);
+    }
+    break;
+
+  case TELEMETRY_CHANNEL_CONTROLLER_ERROR:
+    if (payloadLength == sizeof(TelemetryControllerError) && onControllerError) {
+      TelemetryControllerError error;
+      std::memcpy(&error, payload, sizeof(error));
+      onControllerError(seq, error);
+    }
+    break;
+
+  default:
+    if (onUnknown) {
+      onUnknown(channel, seq, payload, payloadLength);
+    }
+    break;
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef TELEMETRY_DECODER_H_
+#define TELEMETRY_DECODER_H_
+
+// ------- telemetryDecoder.h --------------------------------------------------
+//
+// Linux (Raspberry Pi) side decoder for the robot's binary telemetry stream.
+// Feed it the raw bytes read from the serial link - in any chunk size - and it
+// calls back once per valid frame. Bytes which are not part of a valid frame
+// (okapi log text, line noise, frames with a bad CRC) are skipped.
+//
+// The decoder does no I/O itself, so it works the same on the radio's serial
+// port, on a recorded file or on one end of a pty pair standing in for the
+// radio (see telemetryDump.cpp).
+
+#include "telemetryProtocol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class TelemetryDecoder {
+  public:
+  struct Stats {
+    std::uint32_t frames = 0;         // valid frames decoded
+    std::uint32_t crcErrors = 0;      // frames dropped because of a CRC mismatch
+    std::uint32_t lostFrames = 0;     // frames missing according to the sequence numbers
+    std::uint32_t duplicateFrames = 0; // frames whose seq did not move forward (sent again)
+    std::uint32_t skippedBytes = 0;   // bytes outside of any frame
+  };
+
+  std::function<void(std::uint8_t seq, const TelemetryOdometry &)> onOdometry;
+  std::function<void(std::uint8_t seq, const TelemetryMotorState &)> onMotorState;
+  std::function<void(std::uint8_t seq, const TelemetryControllerError &)> onControllerError;
+
+  /**
+   * Called for valid frames on channels this decoder does not know.
+   */
+  std::function<void(std::uint8_t channel, std::uint8_t seq, const std::uint8_t *payload,
+                     std::size_t length)>
+    onUnknown;
+
+  /**
+   * Decodes received bytes, calling the callbacks for every complete frame.
+   *
+   * @param data The received bytes.
+   * @param length The number of bytes.
+   */
+  void feed(const std::uint8_t *data, std::size_t length);
+
+  /**
+   * Drops any partially received frame and resets the sequence tracking.
+   */
+  void reset();
+
+  const Stats &getStats() const {
+    return stats;
+  }
+
+  protected:
+  enum class State { sync0, sync1, header, payload, crc };
+
+  State state = State::sync0;
+  std::uint8_t frame[TELEMETRY_MAX_FRAME];
+  std::size_t received = 0;
+  std::size_t payloadLength = 0;
+  bool haveSeq = false;
+  std::uint8_t lastSeq = 0;
+  Stats stats;
+
+  void dispatch();
+};
+
+#endif
@@ -0,0 +1,109 @@
+// ------- telemetryDump.cpp ---------------------------------------------------
+//
+// Linux (Raspberry Pi) tool - reads the robot's binary telemetry from a serial
+// device and prints one line per frame.
+//
+// Build on the Pi / PC, this is NOT part of the robot program:
+//   g++ -std=c++17 -O2 -I../../include -o telemetryDump telemetryDump.cpp telemetryDecoder.cpp
+//
+// Usage:
+//   telemetryDump /dev/ttyACM0     decode the V5 USB link (TELEMETRY_PORT 0, /ser/sout)
+//   telemetryDump /dev/serial0     decode the RS-485 link from a smart TELEMETRY_PORT
+//                                  (set to raw 115200 baud)
+//   telemetryDump recording.bin    decode a recorded stream
+//   telemetryDump --pty            create a pty and decode what is written to it;
+//                                  the slave path is printed so a replay script
+//                                  (or the radio bridge) can stand in for the robot
+
+#include "telemetryDecoder.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static int openPty() {
+  const int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+    std::perror("posix_openpt");
+    std::exit(1);
+  }
+
+  termios settings;
+  tcgetattr(fd, &settings);
+  cfmakeraw(&settings);
+  tcsetattr(fd, TCSANOW, &settings);
+
+  std::fprintf(stderr, "write telemetry to %s\n", ptsname(fd));
+  return fd;
+}
+
+static int openDevice(const char *path) {
+  const int fd = open(path, O_RDONLY | O_NOCTTY);
+  if (fd < 0) {
+    std::perror(path);
+    std::exit(1);
+  }
+
+  // serial ports must be raw, files are read as they are
+  if (isatty(fd)) {
+    termios settings;
+    tcgetattr(fd, &settings);
+    cfmakeraw(&settings);
+    cfsetispeed(&settings, B115200);
+    cfsetospeed(&settings, B115200);
+    tcsetattr(fd, TCSANOW, &settings);
+  }
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s <device|file|--pty>\n", argv[0]);
+    return 1;
+  }
+
+  const int fd = std::strcmp(argv[1], "--pty") == 0 ? openPty() : openDevice(argv[1]);
+
+  TelemetryDecoder decoder;
+  decoder.onOdometry = [](std::uint8_t seq, const TelemetryOdometry &odometry) {
+    std::printf("%u odom seq %u x %.4f m y %.4f m theta %.2f deg\n", odometry.timestamp, seq,
+                odometry.x, odometry.y, odometry.theta);
+  };
+  decoder.onMotorState = [](std::uint8_t seq, const TelemetryMotorState &state) {
+    std::printf("%u motors seq %u", state.timestamp, seq);
+    for (const auto &motor : state.motors) {
+      std::printf(" [%d rpm %d mA %u C]", motor.velocity, motor.current, motor.temperature);
+    }
+    std::printf("\n");
+  };
+  decoder.onControllerError = [](std::uint8_t seq, const TelemetryControllerError &error) {
+    std::printf("%u error seq %u controller %u error %f\n", error.timestamp, seq,
+                error.controllerId, error.error);
+  };
+  decoder.onUnknown = [](std::uint8_t channel, std::uint8_t seq, const std::uint8_t *,
+                         std::size_t length) {
+    std::printf("unknown channel %u seq %u (%zu bytes)\n", channel, seq, length);
+  };
+
+  std::uint8_t buffer[512];
+  for (;;) {
+    const ssize_t count = read(fd, buffer, sizeof(buffer));
+    if (count > 0) {
+      decoder.feed(buffer, static_cast<std::size_t>(count));
+      std::fflush(stdout);
+    } else if (count == 0 || errno != EINTR) {
+      break;
+    }
+  }
+
+  const auto &stats = decoder.getStats();
+  std::fprintf(stderr, "frames %u crc errors %u lost %u duplicates %u skipped bytes %u\n",
+               stats.frames, stats.crcErrors, stats.lostFrames, stats.duplicateFrames,
+               stats.skippedBytes);
+  close(fd);
+  return 0;
+}